@@ -548,7 +548,7 @@ end
 				GetPlayer = { Params = "", Return = "{{cPlayer|cPlayer}}", Notes = "Returns the player object connected to this client. Note that this may be nil, for example if the player object is not yet spawned." },
 				GetUniqueID = { Params = "", Return = "number", Notes = "Returns the UniqueID of the client used to identify the client in the server" },
 				GetUsername = { Params = "", Return = "string", Notes = "Returns the username that the client has provided" },
-				GetViewDistance = { Params = "", Return = "number", Notes = "Returns the viewdistance (number of chunks loaded for the player in each direction)" },
+				GetViewDistance = { Params = "", Return = "number", Notes = "Returns the viewdistance (number of chunks loaded for the player in each direction). This may be lower than the value set by SetViewDistance() while the server's load governor limits the view distance." },
 				Kick = { Params = "Reason", Return = "", Notes = "Kicks the user with the specified reason" },
 				SetUsername = { Params = "Name", Return = "", Notes = "Sets the username" },
 				SetViewDistance = { Params = "ViewDistance", Return = "", Notes = "Sets the viewdistance (number of chunks loaded for the player in each direction)" },
@@ -2318,6 +2318,7 @@ cPluginManager.AddHook(cPluginManager.HOOK_CHAT, OnChatMessage);
 				RegenerateChunk = { Params = "ChunkX, ChunkZ", Return = "", Notes = "Queues the specified chunk to be re-generated, overwriting the current data. To queue a chunk for generating only if it doesn't exist, use the GenerateChunk() instead." },
 				SendBlockTo = { Params = "BlockX, BlockY, BlockZ, {{cPlayer|Player}}", Return = "", Notes = "Sends the block at the specified coords to the specified player's client, as an UpdateBlock packet." },
 				SetBlock = { Params = "BlockX, BlockY, BlockZ, BlockType, BlockMeta", Return = "", Notes = "Sets the block at the specified coords, replaces the block entities for the previous block type, creates a new block entity for the new block, if appropriate, and wakes up the simulators. This is the preferred way to set blocks, as opposed to FastSetBlock(), which is only to be used under special circumstances." },
+				SetBlocks = { Params = "BlockTable, [ShouldFastSet]", Return = "number", Notes = "Sets many blocks at once. BlockTable is an array of {BlockX, BlockY, BlockZ, BlockType, [BlockMeta]} tables. The changes are grouped by chunk and each chunk is locked only once, which is much faster than calling SetBlock() for each block. If ShouldFastSet is true, the blocks are set as with FastSetBlock(), otherwise as with SetBlock(). Returns the number of blocks that weren't set because their chunk isn't loaded, their coords or block type aren't numbers, or their Y coord is out of range." },
 				SetBlockMeta =
 				{
 					{ Params = "BlockX, BlockY, BlockZ, BlockMeta", Return = "", Notes = "Sets the meta for the block at the specified coords." },
@@ -3170,7 +3171,9 @@ end;
 			CalledWhen = "An explosion has happened",
 			DefaultFnName = "OnExploded",  -- also used as pagename
 			Desc = [[
-				This hook is called after an explosion has been processed in a world.</p>
+				This hook is called after an explosion has been processed in a world. The explosions are processed
+				in batches at the end of the world tick, so this hook may be called a few ticks after the
+				{{OnExploding|HOOK_EXPLODING}} hook for the same explosion, if many explosions happen at once.</p>
 				<p>
 				See also {{OnExploding|HOOK_EXPLODING}} for a similar hook called before the explosion.</p>
 				<p>
@@ -3190,6 +3193,9 @@ end;
 				<tr><td>esOther</td><td><i>TBD</i></td><td>Any other previously unspecified type.</td></tr>
 				<tr><td>esPlugin</td><td>object</td><td>An explosion created by a plugin. The plugin may specify any kind of data.</td></tr>
 				</table></p>
+				<p>
+				Because the source entity may have been destroyed in the meantime, this hook receives nil as the
+				SourceData for all sources except esBed and esEnderCrystal.</p>
 			]],
 			Params =
 			{
@@ -434,6 +434,9 @@ function ShowPage(WebAdmin, TemplateRequest)
 			end
 		end
 	end
+	
+	Output("<li>Server</li>")
+	Output("<li><a href='" .. BaseURL .. "Server/PluginStats'>Plugin statistics</a></li>")
 
 	
 	Output([[
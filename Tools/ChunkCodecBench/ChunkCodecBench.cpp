@@ -0,0 +1,535 @@
+
+// ChunkCodecBench.cpp
+
+// Implements the main app entrypoint: compares the generic-NBT chunk loading and saving with the cAnvilChunkCodec
+
+#include "Globals.h"
+#include "BlockID.h"
+#include "MCLogger.h"
+#include "OSSupport/File.h"
+#include "OSSupport/Timer.h"
+#include "WorldStorage/FastNBT.h"
+#include "WorldStorage/AnvilChunkCodec.h"
+#include "zlib.h"
+
+
+
+
+
+/// The maximum size of an inflated chunk, the same as the server uses
+static const int CHUNK_INFLATE_MAX = 256 KiB;
+
+/// Number of chunks generated when no MCA files are given
+static const int NUM_SYNTHETIC_CHUNKS = 256;
+
+/// Sizes of the per-section arrays
+static const int SECTION_BLOCK_SIZE  = cChunkDef::Width * cChunkDef::Width * 16;
+static const int SECTION_NIBBLE_SIZE = SECTION_BLOCK_SIZE / 2;
+
+
+
+
+
+/// The chunk data, decoded by either path
+struct sChunkData
+{
+	cChunkDef::BlockTypes   m_BlockTypes;
+	cChunkDef::BlockNibbles m_BlockMetas;
+	cChunkDef::BlockNibbles m_BlockLight;
+	cChunkDef::BlockNibbles m_SkyLight;
+	cChunkDef::BiomeMap     m_Biomes;
+	unsigned char           m_VanillaBiomes[cChunkDef::Width * cChunkDef::Width];
+	bool                    m_HasBiomes;
+	bool                    m_IsLightValid;
+	int                     m_ChunkX, m_ChunkZ;
+
+	/// Sets the defaults for the data not present in the NBT, the same as the server does
+	void Clear(void)
+	{
+		memset(m_BlockTypes, 0,    sizeof(m_BlockTypes));
+		memset(m_BlockMetas, 0,    sizeof(m_BlockMetas));
+		memset(m_SkyLight,   0xff, sizeof(m_SkyLight));
+		memset(m_BlockLight, 0,    sizeof(m_BlockLight));
+		m_HasBiomes = false;
+		m_IsLightValid = false;
+	}
+
+	bool IsSameAs(const sChunkData & a_Other) const
+	{
+		return (
+			(memcmp(m_BlockTypes, a_Other.m_BlockTypes, sizeof(m_BlockTypes)) == 0) &&
+			(memcmp(m_BlockMetas, a_Other.m_BlockMetas, sizeof(m_BlockMetas)) == 0) &&
+			(memcmp(m_BlockLight, a_Other.m_BlockLight, sizeof(m_BlockLight)) == 0) &&
+			(memcmp(m_SkyLight,   a_Other.m_SkyLight,   sizeof(m_SkyLight))   == 0) &&
+			(m_HasBiomes == a_Other.m_HasBiomes) &&
+			(!m_HasBiomes || (memcmp(m_Biomes, a_Other.m_Biomes, sizeof(m_Biomes)) == 0)) &&
+			(m_IsLightValid == a_Other.m_IsLightValid)
+		);
+	}
+
+	/// Fills in the vanilla biomes from the MCS ones, the same as cNBTChunkSerializer does
+	void MakeVanillaBiomes(void)
+	{
+		for (int i = 0; i < ARRAYCOUNT(m_Biomes); i++)
+		{
+			m_VanillaBiomes[i] = ((m_Biomes[i] >= 0) && (m_Biomes[i] < 256)) ? (unsigned char)m_Biomes[i] : 0;
+		}
+	}
+} ;
+
+
+
+
+
+/// Total time and data processed by one of the measured operations
+struct sMeasurement
+{
+	const char * m_Name;
+	long long    m_TotalUSec;
+	Int64        m_TotalBytes;
+	int          m_Count;
+
+	sMeasurement(const char * a_Name) : m_Name(a_Name), m_TotalUSec(0), m_TotalBytes(0), m_Count(0) {}
+
+	void Add(long long a_USec, size_t a_NumBytes)
+	{
+		m_TotalUSec += a_USec;
+		m_TotalBytes += a_NumBytes;
+		m_Count += 1;
+	}
+
+	void Print(void) const
+	{
+		double USec = (m_TotalUSec > 0) ? (double)m_TotalUSec : 1;
+		printf("  %-28s %9.1f usec / chunk, %8.1f MiB/s\n",
+			m_Name, USec / std::max(m_Count, 1), (double)m_TotalBytes / USec * 1000000 / (1024 * 1024)
+		);
+	}
+} ;
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The generic path, as used by cWSSAnvil before the codec:
+
+static void CopyNBTData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, char * a_Destination, int a_Length)
+{
+	int Child = a_NBT.FindChildByName(a_Tag, a_ChildName);
+	if ((Child >= 0) && (a_NBT.GetType(Child) == TAG_ByteArray) && (a_NBT.GetDataLength(Child) == a_Length))
+	{
+		memcpy(a_Destination, a_NBT.GetData(Child), a_Length);
+	}
+}
+
+
+
+
+
+static bool LoadBiomesFromNBT(sChunkData & a_Chunk, const cParsedNBT & a_NBT, int a_Level)
+{
+	int MCSBiomes = a_NBT.FindChildByName(a_Level, "MCSBiomes");
+	if ((MCSBiomes >= 0) && (a_NBT.GetType(MCSBiomes) == TAG_IntArray) && (a_NBT.GetDataLength(MCSBiomes) == sizeof(a_Chunk.m_Biomes)))
+	{
+		const int * BiomeData = (const int *)(a_NBT.GetData(MCSBiomes));
+		bool IsValid = true;
+		for (int i = 0; i < ARRAYCOUNT(a_Chunk.m_Biomes); i++)
+		{
+			a_Chunk.m_Biomes[i] = (EMCSBiome)(ntohl(BiomeData[i]));
+			if (a_Chunk.m_Biomes[i] == 0xff)
+			{
+				IsValid = false;
+				break;
+			}
+		}
+		if (IsValid)
+		{
+			return true;
+		}
+	}
+	int Biomes = a_NBT.FindChildByName(a_Level, "Biomes");
+	if ((Biomes < 0) || (a_NBT.GetType(Biomes) != TAG_ByteArray) || (a_NBT.GetDataLength(Biomes) != 16 * 16))
+	{
+		return false;
+	}
+	const unsigned char * VanillaBiomeData = (const unsigned char *)(a_NBT.GetData(Biomes));
+	for (int i = 0; i < ARRAYCOUNT(a_Chunk.m_Biomes); i++)
+	{
+		if (VanillaBiomeData[i] == 0xff)
+		{
+			return false;
+		}
+		a_Chunk.m_Biomes[i] = (EMCSBiome)(VanillaBiomeData[i]);
+	}
+	return true;
+}
+
+
+
+
+
+static bool GenericDecode(const AString & a_Data, sChunkData & a_Chunk)
+{
+	cParsedNBT NBT(a_Data.data(), a_Data.size());
+	if (!NBT.IsValid())
+	{
+		return false;
+	}
+	int Level = NBT.FindChildByName(0, "Level");
+	if (Level < 0)
+	{
+		return false;
+	}
+	int Sections = NBT.FindChildByName(Level, "Sections");
+	if ((Sections < 0) || (NBT.GetType(Sections) != TAG_List) || (NBT.GetChildrenType(Sections) != TAG_Compound))
+	{
+		return false;
+	}
+	for (int Child = NBT.GetFirstChild(Sections); Child >= 0; Child = NBT.GetNextSibling(Child))
+	{
+		int SectionY = NBT.FindChildByName(Child, "Y");
+		if ((SectionY < 0) || (NBT.GetType(SectionY) != TAG_Byte))
+		{
+			continue;
+		}
+		int y = NBT.GetByte(SectionY);
+		if ((y < 0) || (y > 15))
+		{
+			continue;
+		}
+		CopyNBTData(NBT, Child, "Blocks",     (char *)&(a_Chunk.m_BlockTypes[y * 4096]), 4096);
+		CopyNBTData(NBT, Child, "Data",       (char *)&(a_Chunk.m_BlockMetas[y * 2048]), 2048);
+		CopyNBTData(NBT, Child, "SkyLight",   (char *)&(a_Chunk.m_SkyLight[y   * 2048]), 2048);
+		CopyNBTData(NBT, Child, "BlockLight", (char *)&(a_Chunk.m_BlockLight[y * 2048]), 2048);
+	}
+	a_Chunk.m_HasBiomes = LoadBiomesFromNBT(a_Chunk, NBT, Level);
+	a_Chunk.m_IsLightValid = (NBT.FindChildByName(Level, "MCSIsLightValid") > 0);
+	return true;
+}
+
+
+
+
+
+static void GenericEncode(const sChunkData & a_Chunk, cFastNBTWriter & a_Writer)
+{
+	a_Writer.BeginCompound("Level");
+	a_Writer.AddInt("xPos", a_Chunk.m_ChunkX);
+	a_Writer.AddInt("zPos", a_Chunk.m_ChunkZ);
+	if (a_Chunk.m_HasBiomes)
+	{
+		a_Writer.AddByteArray("Biomes",    (const char *)(a_Chunk.m_VanillaBiomes), ARRAYCOUNT(a_Chunk.m_VanillaBiomes));
+		a_Writer.AddIntArray ("MCSBiomes", (const int *)(a_Chunk.m_Biomes),         ARRAYCOUNT(a_Chunk.m_Biomes));
+	}
+	a_Writer.BeginList("Sections", TAG_Compound);
+	for (int Y = 0; Y < 16; Y++)
+	{
+		a_Writer.BeginCompound("");
+		a_Writer.AddByteArray("Blocks",     (const char *)a_Chunk.m_BlockTypes + Y * SECTION_BLOCK_SIZE,  SECTION_BLOCK_SIZE);
+		a_Writer.AddByteArray("Data",       (const char *)a_Chunk.m_BlockMetas + Y * SECTION_NIBBLE_SIZE, SECTION_NIBBLE_SIZE);
+		a_Writer.AddByteArray("SkyLight",   (const char *)a_Chunk.m_SkyLight   + Y * SECTION_NIBBLE_SIZE, SECTION_NIBBLE_SIZE);
+		a_Writer.AddByteArray("BlockLight", (const char *)a_Chunk.m_BlockLight + Y * SECTION_NIBBLE_SIZE, SECTION_NIBBLE_SIZE);
+		a_Writer.AddByte("Y", (unsigned char)Y);
+		a_Writer.EndCompound();
+	}
+	a_Writer.EndList();
+	if (a_Chunk.m_IsLightValid)
+	{
+		a_Writer.AddByte("MCSIsLightValid", 1);
+	}
+	a_Writer.EndCompound();
+	a_Writer.Finish();
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The codec path, as used by cWSSAnvil now:
+
+static bool CodecDecode(cAnvilChunkCodec & a_Codec, const AString & a_Data, sChunkData & a_Chunk)
+{
+	if (!a_Codec.Decode(a_Data.data(), a_Data.size(), a_Chunk.m_BlockTypes, a_Chunk.m_BlockMetas, a_Chunk.m_BlockLight, a_Chunk.m_SkyLight))
+	{
+		return false;
+	}
+	a_Chunk.m_HasBiomes = a_Codec.GetBiomes(a_Chunk.m_Biomes);
+	a_Chunk.m_IsLightValid = a_Codec.IsLightValid();
+
+	// The server parses the entities with the generic parser; include that in the measurement:
+	if (a_Codec.HasEntities())
+	{
+		const AString & Entities = a_Codec.GetEntitiesNBT();
+		cParsedNBT NBT(Entities.data(), Entities.size());
+		if (!NBT.IsValid())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+static const AString & CodecEncode(cAnvilChunkCodec & a_Codec, const sChunkData & a_Chunk)
+{
+	a_Codec.GetEntitiesWriter();  // No entities, but the writer needs to be emptied
+	return a_Codec.Encode(
+		a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ,
+		a_Chunk.m_BlockTypes, a_Chunk.m_BlockMetas, a_Chunk.m_BlockLight, a_Chunk.m_SkyLight,
+		a_Chunk.m_VanillaBiomes, a_Chunk.m_HasBiomes ? &a_Chunk.m_Biomes : NULL,
+		a_Chunk.m_IsLightValid
+	);
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Getting the test data:
+
+/// Reads all the chunks from the MCA file and appends their inflated NBT data to a_Chunks; returns false if the file cannot be read
+static bool LoadMCAFile(const AString & a_FileName, std::vector<AString> & a_Chunks)
+{
+	cFile f;
+	if (!f.Open(a_FileName, cFile::fmRead))
+	{
+		return false;
+	}
+	AString Contents;
+	if (f.ReadRestOfFile(Contents) < 8192)
+	{
+		return false;
+	}
+	std::vector<char> Inflated(CHUNK_INFLATE_MAX);
+	for (int i = 0; i < 1024; i++)
+	{
+		UInt32 Location = ntohl(*((const UInt32 *)(Contents.data() + 4 * i)));
+		size_t Offset = (Location >> 8) * 4096;
+		if ((Location == 0) || (Offset + 5 > Contents.size()))
+		{
+			continue;
+		}
+		UInt32 Length = ntohl(*((const UInt32 *)(Contents.data() + Offset)));
+		if ((Length < 1) || (Offset + 4 + Length > Contents.size()) || (Contents[Offset + 4] != 2))
+		{
+			// Unsupported compression, or a broken file
+			continue;
+		}
+		uLongf InflatedSize = (uLongf)Inflated.size();
+		if (uncompress((Bytef *)&Inflated[0], &InflatedSize, (const Bytef *)Contents.data() + Offset + 5, Length - 1) != Z_OK)
+		{
+			continue;
+		}
+		a_Chunks.push_back(AString(&Inflated[0], InflatedSize));
+	}
+	return true;
+}
+
+
+
+
+
+/// Generates a simple terrain with some block entities, in the format that the server writes
+static void GenerateChunks(std::vector<AString> & a_Chunks)
+{
+	for (int i = 0; i < NUM_SYNTHETIC_CHUNKS; i++)
+	{
+		sChunkData * Chunk = new sChunkData;
+		Chunk->Clear();
+		Chunk->m_ChunkX = i % 16;
+		Chunk->m_ChunkZ = i / 16;
+		for (int z = 0; z < cChunkDef::Width; z++) for (int x = 0; x < cChunkDef::Width; x++)
+		{
+			int Height = 60 + ((x * 7 + z * 13 + i * 5) % 11);
+			for (int y = 0; y <= Height; y++)
+			{
+				int Idx = cChunkDef::MakeIndexNoCheck(x, y, z);
+				Chunk->m_BlockTypes[Idx] = (y == Height) ? E_BLOCK_GRASS : ((y + 3 > Height) ? E_BLOCK_DIRT : E_BLOCK_STONE);
+				cChunkDef::SetNibble(Chunk->m_SkyLight, Idx, 0);
+				if ((y < Height - 5) && (((x + y + z) % 37) == 0))
+				{
+					Chunk->m_BlockTypes[Idx] = E_BLOCK_COAL_ORE;
+					cChunkDef::SetNibble(Chunk->m_BlockMetas, Idx, (NIBBLETYPE)(y & 0x0f));
+				}
+			}
+			Chunk->m_Biomes[x + z * cChunkDef::Width] = (EMCSBiome)((i + x / 4) % 20);
+		}
+		Chunk->m_HasBiomes = true;
+		Chunk->m_IsLightValid = true;
+		Chunk->MakeVanillaBiomes();
+
+		// Write the chunk, with a few block entities to exercise the entity path:
+		cFastNBTWriter ChunkWriter;
+		GenericEncode(*Chunk, ChunkWriter);
+		AString Data = ChunkWriter.GetResult();
+		cFastNBTWriter Writer;
+		Writer.BeginList("TileEntities", TAG_Compound);
+		for (int j = 0; j < 4; j++)
+		{
+			Writer.BeginCompound("");
+			Writer.AddString("id", "Chest");
+			Writer.AddInt("x", Chunk->m_ChunkX * 16 + j);
+			Writer.AddInt("y", 70);
+			Writer.AddInt("z", Chunk->m_ChunkZ * 16);
+			Writer.BeginList("Items", TAG_Compound);
+			Writer.EndList();
+			Writer.EndCompound();
+		}
+		Writer.EndList();
+
+		// Splice the block entities after the xPos and zPos tags, where the server writes them:
+		size_t InsertPos = 3 + 8 + 2 * 11;
+		Data.insert(InsertPos, Writer.GetResult().substr(3));
+		a_Chunks.push_back(Data);
+		delete Chunk;
+	}
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// main:
+
+int main(int argc, char ** argv)
+{
+	int NumRepeats = 5;
+	AStringVector FileNames;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((NoCaseCompare(argv[i], "-n") == 0) && (i < argc - 1))
+		{
+			NumRepeats = std::max(atoi(argv[++i]), 1);
+		}
+		else if (argv[i][0] == '-')
+		{
+			printf("Usage: ChunkCodecBench [-n <repeats>] [<file.mca> ...]\n");
+			printf("Without any files, synthetic chunks are used.\n");
+			return 1;
+		}
+		else
+		{
+			FileNames.push_back(argv[i]);
+		}
+	}
+
+	// The server sources linked in report their errors through the logger:
+	cMCLogger Logger("ChunkCodecBench.log");
+
+	std::vector<AString> Chunks;
+	for (AStringVector::const_iterator itr = FileNames.begin(), end = FileNames.end(); itr != end; ++itr)
+	{
+		if (!LoadMCAFile(*itr, Chunks))
+		{
+			printf("Cannot read file %s, skipping\n", itr->c_str());
+		}
+	}
+	if (FileNames.empty())
+	{
+		GenerateChunks(Chunks);
+	}
+	if (Chunks.empty())
+	{
+		printf("No chunks to measure\n");
+		return 1;
+	}
+	printf("Measuring %u chunks, %d times\n", (unsigned)Chunks.size(), NumRepeats);
+
+	sMeasurement GenericDecodeTime("decode, cParsedNBT");
+	sMeasurement CodecDecodeTime  ("decode, cAnvilChunkCodec");
+	sMeasurement GenericEncodeTime("encode, cFastNBTWriter");
+	sMeasurement CodecEncodeTime  ("encode, cAnvilChunkCodec");
+	int NumFailed = 0;
+	int NumDecodeMismatches = 0;
+	int NumEncodeMismatches = 0;
+
+	cTimer Timer;
+	cAnvilChunkCodec Codec;
+	sChunkData * GenericChunk = new sChunkData;
+	sChunkData * CodecChunk = new sChunkData;
+	AString GenericData;
+	for (int Repeat = 0; Repeat < NumRepeats; Repeat++)
+	{
+		for (std::vector<AString>::const_iterator itr = Chunks.begin(), end = Chunks.end(); itr != end; ++itr)
+		{
+			long long Start = Timer.GetNowTimeUSec();
+			GenericChunk->Clear();
+			bool GenericOK = GenericDecode(*itr, *GenericChunk);
+			long long End = Timer.GetNowTimeUSec();
+			GenericDecodeTime.Add(End - Start, itr->size());
+
+			Start = Timer.GetNowTimeUSec();
+			CodecChunk->Clear();
+			bool CodecOK = CodecDecode(Codec, *itr, *CodecChunk);
+			End = Timer.GetNowTimeUSec();
+			CodecDecodeTime.Add(End - Start, itr->size());
+
+			if (!GenericOK || !CodecOK)
+			{
+				if (Repeat == 0)
+				{
+					NumFailed += 1;
+					if (GenericOK != CodecOK)
+					{
+						NumDecodeMismatches += 1;
+					}
+				}
+				continue;
+			}
+			if ((Repeat == 0) && !GenericChunk->IsSameAs(*CodecChunk))
+			{
+				NumDecodeMismatches += 1;
+			}
+
+			// Both encoders get the same data, so that their outputs can be compared:
+			GenericChunk->m_ChunkX = CodecChunk->m_ChunkX = (int)(itr - Chunks.begin());
+			GenericChunk->m_ChunkZ = CodecChunk->m_ChunkZ = Repeat;
+			GenericChunk->MakeVanillaBiomes();
+			CodecChunk->MakeVanillaBiomes();
+
+			Start = Timer.GetNowTimeUSec();
+			cFastNBTWriter * Writer = new cFastNBTWriter;  // The writer's stack is too large for comfort on the stack
+			GenericEncode(*GenericChunk, *Writer);
+			End = Timer.GetNowTimeUSec();
+			GenericEncodeTime.Add(End - Start, Writer->GetResult().size());
+			GenericData = Writer->GetResult();
+			delete Writer;
+
+			Start = Timer.GetNowTimeUSec();
+			const AString & CodecData = CodecEncode(Codec, *CodecChunk);
+			End = Timer.GetNowTimeUSec();
+			CodecEncodeTime.Add(End - Start, CodecData.size());
+
+			if ((Repeat == 0) && (CodecData != GenericData))
+			{
+				NumEncodeMismatches += 1;
+			}
+		}  // for itr - Chunks[]
+	}  // for Repeat
+	delete GenericChunk;
+	delete CodecChunk;
+
+	printf("Results (throughput is of the inflated NBT data):\n");
+	GenericDecodeTime.Print();
+	CodecDecodeTime.Print();
+	GenericEncodeTime.Print();
+	CodecEncodeTime.Print();
+	printf("Decode speedup: %.2fx, encode speedup: %.2fx\n",
+		(double)GenericDecodeTime.m_TotalUSec / std::max(CodecDecodeTime.m_TotalUSec, 1LL),
+		(double)GenericEncodeTime.m_TotalUSec / std::max(CodecEncodeTime.m_TotalUSec, 1LL)
+	);
+	printf("Chunks that failed to decode: %d; decode mismatches: %d; encode mismatches: %d\n", NumFailed, NumDecodeMismatches, NumEncodeMismatches);
+
+	return ((NumDecodeMismatches > 0) || (NumEncodeMismatches > 0)) ? 2 : 0;
+}
+
+
+
+
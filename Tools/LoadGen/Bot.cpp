@@ -0,0 +1,694 @@
+
+// Bot.cpp
+
+// Implements the cBot class representing a single headless 1.7 client
+
+#include "Globals.h"
+#include "Bot.h"
+
+
+
+
+
+/// The protocol version sent in the handshake (1.7.2)
+static const UInt32 PROTOCOL_VERSION = 4;
+
+/// Height of the player's eyes above their feet, sent as the "stance"
+static const double EYE_HEIGHT = 1.62;
+
+/// The block that the bots place, and put into their hotbar upon spawning
+static const short BUILD_BLOCK_TYPE = 1;  // Stone
+
+/// How long a chat message is waited for before it is considered lost, in msec
+static const int CHAT_TIMEOUT = 30000;
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// sBotSettings:
+
+sBotSettings::sBotSettings(void) :
+	m_ServerAddress("localhost"),
+	m_ServerPort(25565),
+	m_ViewDistance(10),
+	m_Path(pathCircle),
+	m_PathRadius(16),
+	m_Speed(4.3),
+	m_ShouldFly(false),
+	m_FlyHeight(10),
+	m_ChatInterval(10000),
+	m_BuildInterval(2000)
+{
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// sBotStats:
+
+sBotStats::sBotStats(void) :
+	m_NumChunks(0),
+	m_NumBytesReceived(0),
+	m_NumLoginFailures(0),
+	m_NumDisconnects(0),
+	m_NumChatsSent(0),
+	m_NumBlocksPlaced(0),
+	m_NumBlocksBroken(0),
+	m_FirstWorldAge(0),
+	m_FirstWorldAgeTime(0),
+	m_LastWorldAge(0),
+	m_LastWorldAgeTime(0)
+{
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cBot:
+
+cBot::cBot(int a_Index, const sBotSettings & a_Settings, sBotStats & a_Stats) :
+	m_Index(a_Index),
+	m_Name(Printf("LoadGen%d", a_Index)),
+	m_Settings(a_Settings),
+	m_Stats(a_Stats),
+	m_ConnectTime(0),
+	m_IsLoggedIn(false),
+	m_HasSpawned(false),
+	m_SpawnX(0), m_SpawnY(0), m_SpawnZ(0),
+	m_PosX(0), m_PosY(0), m_PosZ(0),
+	m_Yaw(0),
+	m_TargetX(0), m_TargetZ(0),
+	m_PathParam(0),
+	m_LineDirection(1),
+	m_LastTickTime(0),
+	m_NextChatTime(0),
+	m_NextBuildTime(0),
+	m_HasPlacedBlock(false),
+	m_PlacedX(0), m_PlacedY(0), m_PlacedZ(0),
+	m_ChatSequence(0),
+	m_RandomSeed(0x9e3779b9u * (unsigned)(a_Index + 1))
+{
+}
+
+
+
+
+
+cBot::~cBot()
+{
+	Disconnect();
+}
+
+
+
+
+
+bool cBot::Connect(long long a_Now)
+{
+	m_ConnectTime = a_Now;
+	m_Socket = cSocket::CreateSocket(cSocket::IPv4);
+	if (!m_Socket.IsValid() || !m_Socket.ConnectIPv4(m_Settings.m_ServerAddress, m_Settings.m_ServerPort))
+	{
+		m_Socket.CloseSocket();
+		m_Stats.m_NumLoginFailures += 1;
+		return false;
+	}
+
+	// Handshake, switching to the login state:
+	cByteBuffer Handshake(512);
+	Handshake.WriteVarInt(PROTOCOL_VERSION);
+	Handshake.WriteVarUTF8String(m_Settings.m_ServerAddress);
+	Handshake.WriteBEShort((short)m_Settings.m_ServerPort);
+	Handshake.WriteVarInt(2);
+	SendPacket(0x00, Handshake);
+
+	// Login start:
+	cByteBuffer LoginStart(64);
+	LoginStart.WriteVarUTF8String(m_Name);
+	SendPacket(0x00, LoginStart);
+	return true;
+}
+
+
+
+
+
+void cBot::ReceiveData(long long a_Now)
+{
+	char Buffer[64 KiB];
+	int Received = m_Socket.Receive(Buffer, sizeof(Buffer), 0);
+	if (Received <= 0)
+	{
+		if (m_IsLoggedIn)
+		{
+			printf("%s: connection closed by the server\n", m_Name.c_str());
+			m_Stats.m_NumDisconnects += 1;
+		}
+		else
+		{
+			printf("%s: connection closed by the server while logging in\n", m_Name.c_str());
+			m_Stats.m_NumLoginFailures += 1;
+		}
+		Disconnect();
+		return;
+	}
+	m_Stats.m_NumBytesReceived += Received;
+	m_IncomingData.append(Buffer, Received);
+
+	// Process all the complete packets:
+	cPacketReader Reader(m_IncomingData.data(), (int)m_IncomingData.size());
+	cPacketReader Packet;
+	while (IsConnected() && Reader.ReadPacket(Packet))
+	{
+		HandlePacket(Packet, a_Now);
+	}
+	m_IncomingData.erase(0, Reader.GetReadPos());
+}
+
+
+
+
+
+void cBot::Tick(long long a_Now)
+{
+	if (!m_HasSpawned)
+	{
+		return;
+	}
+	float Dt = (float)(a_Now - m_LastTickTime);
+	m_LastTickTime = a_Now;
+
+	Move(Dt);
+
+	if ((m_Settings.m_ChatInterval > 0) && (a_Now >= m_NextChatTime))
+	{
+		Chat(a_Now);
+		m_NextChatTime = a_Now + m_Settings.m_ChatInterval;
+	}
+	if ((m_Settings.m_BuildInterval > 0) && (a_Now >= m_NextBuildTime))
+	{
+		Build();
+		m_NextBuildTime = a_Now + m_Settings.m_BuildInterval;
+	}
+
+	// Forget the chat messages that haven't come back:
+	while (!m_PendingChats.empty() && (a_Now - m_PendingChats.begin()->second > CHAT_TIMEOUT))
+	{
+		m_PendingChats.erase(m_PendingChats.begin());
+	}
+}
+
+
+
+
+
+void cBot::Disconnect(void)
+{
+	if (m_Socket.IsValid())
+	{
+		m_Socket.CloseSocket();
+	}
+	m_IncomingData.clear();
+	m_IsLoggedIn = false;
+	m_HasSpawned = false;
+}
+
+
+
+
+
+void cBot::HandlePacket(cPacketReader & a_Packet, long long a_Now)
+{
+	UInt32 PacketType;
+	if (!a_Packet.ReadVarInt(PacketType))
+	{
+		return;
+	}
+
+	if (!m_IsLoggedIn)
+	{
+		// Login state:
+		switch (PacketType)
+		{
+			case 0x00: HandleDisconnect(a_Packet); break;
+			case 0x02: HandleLoginSuccess(a_Now);  break;
+		}
+		return;
+	}
+
+	// Game state:
+	switch (PacketType)
+	{
+		case 0x00: HandleKeepAlive     (a_Packet);        break;
+		case 0x02: HandleChat          (a_Packet, a_Now); break;
+		case 0x03: HandleTimeUpdate    (a_Packet, a_Now); break;
+		case 0x08: HandlePosition      (a_Packet, a_Now); break;
+		case 0x21: HandleChunkData     (a_Packet);        break;
+		case 0x26: HandleMapChunkBulk  (a_Packet);        break;
+		case 0x38: HandlePlayerListItem(a_Packet);        break;
+		case 0x40: HandleDisconnect    (a_Packet);        break;
+	}
+}
+
+
+
+
+
+void cBot::HandleLoginSuccess(long long a_Now)
+{
+	m_IsLoggedIn = true;
+	m_Stats.m_LoginLatencies.push_back((int)(a_Now - m_ConnectTime));
+
+	// Client settings, with the requested view distance:
+	cByteBuffer Settings(64);
+	Settings.WriteVarUTF8String("en_US");
+	Settings.WriteByte((unsigned char)m_Settings.m_ViewDistance);
+	Settings.WriteByte(0);     // Chat flags: chat enabled
+	Settings.WriteBool(true);  // Chat colors
+	Settings.WriteByte(2);     // Difficulty
+	Settings.WriteBool(true);  // Show cape
+	SendPacket(0x15, Settings);
+}
+
+
+
+
+
+void cBot::HandleKeepAlive(cPacketReader & a_Packet)
+{
+	int KeepAliveID;
+	if (!a_Packet.ReadBEInt(KeepAliveID))
+	{
+		return;
+	}
+	cByteBuffer Response(8);
+	Response.WriteBEInt(KeepAliveID);
+	SendPacket(0x00, Response);
+}
+
+
+
+
+
+void cBot::HandleChat(cPacketReader & a_Packet, long long a_Now)
+{
+	AString Message;
+	if (!a_Packet.ReadVarUTF8String(Message))
+	{
+		return;
+	}
+
+	// Look for our own tag, "#<index>-<sequence>":
+	AString Tag = Printf("#%d-", m_Index);
+	size_t idx = Message.find(Tag);
+	if (idx == AString::npos)
+	{
+		return;
+	}
+	int Sequence = atoi(Message.c_str() + idx + Tag.size());
+	std::map<int, long long>::iterator itr = m_PendingChats.find(Sequence);
+	if (itr != m_PendingChats.end())
+	{
+		m_Stats.m_ChatRTTs.push_back((int)(a_Now - itr->second));
+		m_PendingChats.erase(itr);
+	}
+}
+
+
+
+
+
+void cBot::HandleTimeUpdate(cPacketReader & a_Packet, long long a_Now)
+{
+	Int64 WorldAge;
+	if (!a_Packet.ReadBEInt64(WorldAge))
+	{
+		return;
+	}
+	if (m_Stats.m_FirstWorldAgeTime == 0)
+	{
+		m_Stats.m_FirstWorldAge = WorldAge;
+		m_Stats.m_FirstWorldAgeTime = a_Now;
+	}
+	if (WorldAge > m_Stats.m_LastWorldAge)
+	{
+		m_Stats.m_LastWorldAge = WorldAge;
+		m_Stats.m_LastWorldAgeTime = a_Now;
+	}
+}
+
+
+
+
+
+void cBot::HandlePosition(cPacketReader & a_Packet, long long a_Now)
+{
+	double PosX, PosY, PosZ;
+	float Yaw, Pitch;
+	bool IsOnGround;
+	if (
+		!a_Packet.ReadBEDouble(PosX) ||
+		!a_Packet.ReadBEDouble(PosY) ||
+		!a_Packet.ReadBEDouble(PosZ) ||
+		!a_Packet.ReadBEFloat(Yaw) ||
+		!a_Packet.ReadBEFloat(Pitch) ||
+		!a_Packet.ReadBool(IsOnGround)
+	)
+	{
+		return;
+	}
+
+	// The server either spawns us or "repairs" our position; in both cases continue the path from there:
+	m_PosX = PosX;
+	m_PosY = PosY;
+	m_PosZ = PosZ;
+	m_Yaw = Yaw;
+
+	// Confirm the position, the same way the vanilla client does:
+	cByteBuffer Confirm(64);
+	Confirm.WriteBEDouble(m_PosX);
+	Confirm.WriteBEDouble(m_PosY);
+	Confirm.WriteBEDouble(m_PosY + EYE_HEIGHT);
+	Confirm.WriteBEDouble(m_PosZ);
+	Confirm.WriteBEFloat(Yaw);
+	Confirm.WriteBEFloat(Pitch);
+	Confirm.WriteBool(IsOnGround);
+	SendPacket(0x06, Confirm);
+
+	if (m_HasSpawned)
+	{
+		return;
+	}
+	m_HasSpawned = true;
+	m_Stats.m_SpawnLatencies.push_back((int)(a_Now - m_ConnectTime));
+	m_SpawnX = m_PosX;
+	m_SpawnY = m_PosY;
+	m_SpawnZ = m_PosZ;
+	m_TargetX = m_PosX;
+	m_TargetZ = m_PosZ;
+	m_PathParam = (m_Settings.m_Path == sBotSettings::pathCircle) ? (m_Index * 2.39996) : 0;  // Golden angle spreads the bots evenly
+	m_LastTickTime = a_Now;
+
+	// Spread the periodic actions of the bots over their intervals:
+	m_NextChatTime  = a_Now + (long long)(Random() * m_Settings.m_ChatInterval);
+	m_NextBuildTime = a_Now + (long long)(Random() * m_Settings.m_BuildInterval);
+
+	// Put the building block into the first hotbar slot and hold it (only has effect in creative mode):
+	cByteBuffer Creative(32);
+	Creative.WriteBEShort(36);  // First hotbar slot
+	Creative.WriteBEShort(BUILD_BLOCK_TYPE);
+	Creative.WriteChar(64);
+	Creative.WriteBEShort(0);   // Damage
+	Creative.WriteBEShort(-1);  // No NBT
+	SendPacket(0x10, Creative);
+	cByteBuffer SlotSelect(8);
+	SlotSelect.WriteBEShort(0);
+	SendPacket(0x09, SlotSelect);
+}
+
+
+
+
+
+void cBot::HandleChunkData(cPacketReader & a_Packet)
+{
+	int ChunkX, ChunkZ;
+	bool IsGroundUp;
+	short PrimaryBitmap;
+	if (
+		!a_Packet.ReadBEInt(ChunkX) ||
+		!a_Packet.ReadBEInt(ChunkZ) ||
+		!a_Packet.ReadBool(IsGroundUp) ||
+		!a_Packet.ReadBEShort(PrimaryBitmap)
+	)
+	{
+		return;
+	}
+
+	// An empty bitmap means the chunk is being unloaded:
+	if (PrimaryBitmap != 0)
+	{
+		m_Stats.m_NumChunks += 1;
+	}
+}
+
+
+
+
+
+void cBot::HandleMapChunkBulk(cPacketReader & a_Packet)
+{
+	short NumChunks;
+	if (a_Packet.ReadBEShort(NumChunks) && (NumChunks > 0))
+	{
+		m_Stats.m_NumChunks += NumChunks;
+	}
+}
+
+
+
+
+
+void cBot::HandlePlayerListItem(cPacketReader & a_Packet)
+{
+	AString Name;
+	bool IsOnline;
+	short Ping;
+	if (
+		!a_Packet.ReadVarUTF8String(Name) ||
+		!a_Packet.ReadBool(IsOnline) ||
+		!a_Packet.ReadBEShort(Ping)
+	)
+	{
+		return;
+	}
+
+	// The server reports half of the keep-alive round trip as the ping:
+	if (IsOnline && (Ping > 0) && (Name == m_Name))
+	{
+		m_Stats.m_KeepAliveRTTs.push_back(Ping * 2);
+	}
+}
+
+
+
+
+
+void cBot::HandleDisconnect(cPacketReader & a_Packet)
+{
+	AString Reason;
+	a_Packet.ReadVarUTF8String(Reason);
+	printf("%s: disconnected by the server: %s\n", m_Name.c_str(), Reason.c_str());
+	if (m_IsLoggedIn)
+	{
+		m_Stats.m_NumDisconnects += 1;
+	}
+	else
+	{
+		m_Stats.m_NumLoginFailures += 1;
+	}
+	Disconnect();
+}
+
+
+
+
+
+void cBot::Move(float a_Dt)
+{
+	double Distance = m_Settings.m_Speed * a_Dt / 1000;
+	double Radius = std::max(m_Settings.m_PathRadius, 1.0);
+	double NewX = m_PosX;
+	double NewZ = m_PosZ;
+	switch (m_Settings.m_Path)
+	{
+		case sBotSettings::pathStand:
+		{
+			break;
+		}
+
+		case sBotSettings::pathCircle:
+		{
+			// The circle passes through the spawn, its center is one radius away in the direction given by the starting angle:
+			double StartAngle = m_Index * 2.39996;
+			double CenterX = m_SpawnX - Radius * cos(StartAngle);
+			double CenterZ = m_SpawnZ - Radius * sin(StartAngle);
+			m_PathParam += Distance / Radius;
+			NewX = CenterX + Radius * cos(m_PathParam);
+			NewZ = CenterZ + Radius * sin(m_PathParam);
+			break;
+		}
+
+		case sBotSettings::pathLine:
+		{
+			m_PathParam += Distance * m_LineDirection;
+			if (fabs(m_PathParam) >= Radius)
+			{
+				m_PathParam = (m_PathParam > 0) ? Radius : -Radius;
+				m_LineDirection = -m_LineDirection;
+			}
+			double Angle = m_Index * 2.39996;
+			NewX = m_SpawnX + m_PathParam * cos(Angle);
+			NewZ = m_SpawnZ + m_PathParam * sin(Angle);
+			break;
+		}
+
+		case sBotSettings::pathRandom:
+		{
+			double DiffX = m_TargetX - m_PosX;
+			double DiffZ = m_TargetZ - m_PosZ;
+			double Len = sqrt(DiffX * DiffX + DiffZ * DiffZ);
+			if (Len <= Distance)
+			{
+				NewX = m_TargetX;
+				NewZ = m_TargetZ;
+				m_TargetX = m_SpawnX + (Random() * 2 - 1) * Radius;
+				m_TargetZ = m_SpawnZ + (Random() * 2 - 1) * Radius;
+			}
+			else
+			{
+				NewX = m_PosX + DiffX * Distance / Len;
+				NewZ = m_PosZ + DiffZ * Distance / Len;
+			}
+			break;
+		}
+	}
+
+	if ((NewX != m_PosX) || (NewZ != m_PosZ))
+	{
+		m_Yaw = (float)(atan2(m_PosX - NewX, NewZ - m_PosZ) * 180 / 3.14159265358979);
+	}
+	m_PosX = NewX;
+	m_PosZ = NewZ;
+	m_PosY = m_Settings.m_ShouldFly ? (m_SpawnY + m_Settings.m_FlyHeight) : m_SpawnY;
+
+	// Send the position each tick, like the vanilla client does:
+	cByteBuffer PosLook(64);
+	PosLook.WriteBEDouble(m_PosX);
+	PosLook.WriteBEDouble(m_PosY);
+	PosLook.WriteBEDouble(m_PosY + EYE_HEIGHT);
+	PosLook.WriteBEDouble(m_PosZ);
+	PosLook.WriteBEFloat(m_Yaw);
+	PosLook.WriteBEFloat(0);  // Pitch
+	PosLook.WriteBool(!m_Settings.m_ShouldFly);
+	SendPacket(0x06, PosLook);
+}
+
+
+
+
+
+void cBot::Chat(long long a_Now)
+{
+	m_ChatSequence += 1;
+	m_PendingChats[m_ChatSequence] = a_Now;
+	m_Stats.m_NumChatsSent += 1;
+
+	cByteBuffer Msg(128);
+	Msg.WriteVarUTF8String(Printf("Load test message #%d-%d", m_Index, m_ChatSequence));
+	SendPacket(0x01, Msg);
+}
+
+
+
+
+
+void cBot::Build(void)
+{
+	if (!m_HasPlacedBlock)
+	{
+		// Place a block on top of the block two blocks east of the bot's feet:
+		m_PlacedX = (int)floor(m_PosX) + 2;
+		m_PlacedY = (int)floor(m_PosY);
+		m_PlacedZ = (int)floor(m_PosZ);
+		if ((m_PlacedY < 1) || (m_PlacedY > 255))
+		{
+			return;
+		}
+		cByteBuffer Place(64);
+		Place.WriteBEInt(m_PlacedX);
+		Place.WriteByte((unsigned char)(m_PlacedY - 1));
+		Place.WriteBEInt(m_PlacedZ);
+		Place.WriteByte(1);  // Face: top
+		Place.WriteBEShort(BUILD_BLOCK_TYPE);  // Held item
+		Place.WriteChar(64);
+		Place.WriteBEShort(0);
+		Place.WriteBEShort(-1);
+		Place.WriteByte(8);  // Cursor position within the face
+		Place.WriteByte(16);
+		Place.WriteByte(8);
+		SendPacket(0x08, Place);
+		m_HasPlacedBlock = true;
+		m_Stats.m_NumBlocksPlaced += 1;
+		return;
+	}
+
+	// Break the block placed last time; in creative mode starting to dig is enough, in survival the finish is needed as well:
+	for (int Status = 0; Status <= 2; Status += 2)
+	{
+		cByteBuffer Dig(32);
+		Dig.WriteByte((unsigned char)Status);
+		Dig.WriteBEInt(m_PlacedX);
+		Dig.WriteByte((unsigned char)m_PlacedY);
+		Dig.WriteBEInt(m_PlacedZ);
+		Dig.WriteByte(1);
+		SendPacket(0x07, Dig);
+	}
+	m_HasPlacedBlock = false;
+	m_Stats.m_NumBlocksBroken += 1;
+}
+
+
+
+
+
+double cBot::Random(void)
+{
+	m_RandomSeed = m_RandomSeed * 1103515245u + 12345u;
+	return (double)((m_RandomSeed >> 8) & 0xffffff) / (double)0x1000000;
+}
+
+
+
+
+
+void cBot::SendPacket(UInt32 a_PacketType, cByteBuffer & a_Body)
+{
+	if (!m_Socket.IsValid())
+	{
+		return;
+	}
+
+	AString Body;
+	a_Body.ReadAll(Body);
+	a_Body.CommitRead();
+
+	// The length covers the packet type VarInt, too:
+	cByteBuffer TypeBuf(8);
+	TypeBuf.WriteVarInt(a_PacketType);
+	AString Type;
+	TypeBuf.ReadAll(Type);
+	cByteBuffer LenBuf(8);
+	LenBuf.WriteVarInt((UInt32)(Type.size() + Body.size()));
+	AString Packet;
+	LenBuf.ReadAll(Packet);
+	Packet.append(Type);
+	Packet.append(Body);
+
+	if (m_Socket.Send(Packet.data(), Packet.size()) != (int)Packet.size())
+	{
+		printf("%s: failed to send data to the server\n", m_Name.c_str());
+		m_Stats.m_NumDisconnects += m_IsLoggedIn ? 1 : 0;
+		Disconnect();
+	}
+}
+
+
+
+
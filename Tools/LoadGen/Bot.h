@@ -0,0 +1,188 @@
+
+// Bot.h
+
+// Interfaces to the cBot class representing a single headless 1.7 client, and the structures shared by all bots
+
+
+
+
+
+#pragma once
+
+#include "ByteBuffer.h"
+#include "OSSupport/Socket.h"
+#include "Protocol/PacketReader.h"
+
+
+
+
+
+/// The behavior of the bots, as given on the command line
+struct sBotSettings
+{
+	enum ePath
+	{
+		pathStand,   ///< Don't move at all
+		pathCircle,  ///< Circle around the spawn, each bot starting at a different angle
+		pathLine,    ///< Walk back and forth along a line through the spawn, each bot in a different direction
+		pathRandom,  ///< Walk to random points around the spawn
+	} ;
+
+	AString        m_ServerAddress;
+	unsigned short m_ServerPort;
+	int            m_ViewDistance;
+	ePath          m_Path;
+	double         m_PathRadius;     ///< Size of the path around the spawn, in blocks
+	double         m_Speed;          ///< Movement speed, in blocks per second
+	bool           m_ShouldFly;      ///< If true, the bots move m_FlyHeight blocks above the spawn, not touching the ground
+	double         m_FlyHeight;
+	int            m_ChatInterval;   ///< How often each bot chats, in msec; 0 for never
+	int            m_BuildInterval;  ///< How often each bot places or breaks a block, in msec; 0 for never
+
+	sBotSettings(void);
+} ;
+
+
+
+
+
+/// The measurements collected by all the bots
+struct sBotStats
+{
+	std::vector<int> m_LoginLatencies;  ///< Connecting to receiving Login Success, in msec
+	std::vector<int> m_SpawnLatencies;  ///< Connecting to receiving the first position, in msec
+	std::vector<int> m_ChatRTTs;        ///< Sending a chat message to receiving it back, in msec
+	std::vector<int> m_KeepAliveRTTs;   ///< Keep-alive round trip as measured by the server and reported in the player list, in msec
+
+	Int64 m_NumChunks;           ///< Number of chunks received with any data in them
+	Int64 m_NumBytesReceived;
+	int   m_NumLoginFailures;    ///< Connections refused or dropped before the login succeeded
+	int   m_NumDisconnects;      ///< Connections dropped after the login
+	int   m_NumChatsSent;
+	int   m_NumBlocksPlaced;
+	int   m_NumBlocksBroken;
+
+	// The world age, as reported by the Time Update packets, to calculate the server's tick rate:
+	Int64     m_FirstWorldAge;
+	long long m_FirstWorldAgeTime;
+	Int64     m_LastWorldAge;
+	long long m_LastWorldAgeTime;
+
+	sBotStats(void);
+} ;
+
+
+
+
+
+class cBot
+{
+public:
+	cBot(int a_Index, const sBotSettings & a_Settings, sBotStats & a_Stats);
+	~cBot();
+
+	/// Connects to the server and sends the handshake and login. Returns true if successful
+	bool Connect(long long a_Now);
+
+	/// Returns true while the bot is connected
+	bool IsConnected(void) const { return m_Socket.IsValid(); }
+
+	/// Returns the socket, for the select() call; valid only while connected
+	const cSocket & GetSocket(void) const { return m_Socket; }
+
+	/// Reads the data available on the socket and processes all the complete packets in it
+	void ReceiveData(long long a_Now);
+
+	/// Moves the bot along its path and performs the periodic actions
+	void Tick(long long a_Now);
+
+	/// Closes the connection
+	void Disconnect(void);
+
+	const AString & GetName(void) const { return m_Name; }
+
+protected:
+	int                  m_Index;
+	AString              m_Name;
+	const sBotSettings & m_Settings;
+	sBotStats &          m_Stats;
+
+	cSocket m_Socket;
+
+	/// Received data that doesn't form a complete packet yet
+	AString m_IncomingData;
+
+	/// Time of the connection attempt, in msec (cTimer time)
+	long long m_ConnectTime;
+
+	/// True once the Login Success packet has been received
+	bool m_IsLoggedIn;
+
+	/// True once the server has sent the first position; the bot doesn't move until then
+	bool m_HasSpawned;
+
+	// The position the server spawned the bot at, used as the center of the path:
+	double m_SpawnX, m_SpawnY, m_SpawnZ;
+
+	// The current position:
+	double m_PosX, m_PosY, m_PosZ;
+	float  m_Yaw;
+
+	/// The point the bot is currently walking towards (pathRandom)
+	double m_TargetX, m_TargetZ;
+
+	/// Position along the path: angle for pathCircle, distance for pathLine
+	double m_PathParam;
+
+	/// Direction of the movement along pathLine (+1 or -1)
+	double m_LineDirection;
+
+	long long m_LastTickTime;
+	long long m_NextChatTime;
+	long long m_NextBuildTime;
+
+	/// Coords of the block that the bot has placed and is going to break in the next build action
+	bool m_HasPlacedBlock;
+	int  m_PlacedX, m_PlacedY, m_PlacedZ;
+
+	/// Send times of the chat messages waiting to be echoed back, indexed by the sequence number in the message
+	std::map<int, long long> m_PendingChats;
+	int m_ChatSequence;
+
+	/// Simple per-bot random generator state, so that the bots don't all walk the same way
+	unsigned m_RandomSeed;
+
+
+	/// Processes a single complete packet
+	void HandlePacket(cPacketReader & a_Packet, long long a_Now);
+
+	// Packet handlers:
+	void HandleLoginSuccess  (long long a_Now);
+	void HandleKeepAlive     (cPacketReader & a_Packet);
+	void HandleChat          (cPacketReader & a_Packet, long long a_Now);
+	void HandleTimeUpdate    (cPacketReader & a_Packet, long long a_Now);
+	void HandlePosition      (cPacketReader & a_Packet, long long a_Now);
+	void HandleChunkData     (cPacketReader & a_Packet);
+	void HandleMapChunkBulk  (cPacketReader & a_Packet);
+	void HandlePlayerListItem(cPacketReader & a_Packet);
+	void HandleDisconnect    (cPacketReader & a_Packet);
+
+	/// Moves the bot along its path by the distance it travels in a_Dt msec
+	void Move(float a_Dt);
+
+	/// Sends a numbered chat message, to be timed when it comes back
+	void Chat(long long a_Now);
+
+	/// Places a block next to the bot, or breaks the block placed previously
+	void Build(void);
+
+	/// Returns a random number in the range [0, 1)
+	double Random(void);
+
+	/// Sends the packet of the specified type; a_Body is the packet data after the packet type, it is consumed
+	void SendPacket(UInt32 a_PacketType, cByteBuffer & a_Body);
+} ;
+
+
+
+
@@ -0,0 +1,11 @@
+
+// Globals.h
+
+// This file gets included from every module in the project, so that global symbols may be introduced easily
+// LoadGen links in the server's own networking and protocol sources, so it uses the server's globals as well
+
+#include "../../source/Globals.h"
+
+
+
+
@@ -0,0 +1,517 @@
+
+// LoadGen.cpp
+
+// Implements the main app entrypoint: connects the bots to the server, runs them and reports the measurements
+
+#include "Globals.h"
+#include "Bot.h"
+#include "MCLogger.h"
+#include "OSSupport/Sleep.h"
+#include "OSSupport/Timer.h"
+
+
+
+
+
+/// How often the bots are ticked, in msec; the same as the client's tick
+static const int TICK_INTERVAL = 50;
+
+/// How often the progress is printed, in msec
+static const int PROGRESS_INTERVAL = 5000;
+
+
+
+
+
+/// The settings of the whole run, as given on the command line
+struct sRunSettings
+{
+	int     m_NumBots;
+	int     m_Duration;      ///< Length of the measurement after all bots have been started, in seconds
+	int     m_RampUp;        ///< Delay between connecting two consecutive bots, in msec
+	AString m_MetricsAddress;
+	unsigned short m_MetricsPort;  ///< Port of the webadmin, to scrape the server's tick times from; 0 for none
+	AString m_MetricsAuth;   ///< "user:password" for the webadmin
+
+	sRunSettings(void) :
+		m_NumBots(10),
+		m_Duration(60),
+		m_RampUp(200),
+		m_MetricsAddress("localhost"),
+		m_MetricsPort(0)
+	{
+	}
+} ;
+
+
+
+
+
+/// The tick durations of a single world, as scraped from the server's metrics page
+struct sTickSnapshot
+{
+	Int64 m_Sum;          ///< Sum of all the tick durations, in msec
+	Int64 m_Count;        ///< Number of ticks
+	Int64 m_CountUpTo50;  ///< Number of ticks that took at most 50 msec
+
+	sTickSnapshot(void) : m_Sum(0), m_Count(0), m_CountUpTo50(0) {}
+} ;
+
+typedef std::map<AString, sTickSnapshot> cTickSnapshots;
+
+
+
+
+
+static void PrintUsage(void)
+{
+	printf("Usage: LoadGen [options]\n");
+	printf("  -h <host>          server address (localhost)\n");
+	printf("  -p <port>          server port (25565)\n");
+	printf("  -n <num>           number of bots (10)\n");
+	printf("  -t <seconds>       length of the measurement once all bots are started (60)\n");
+	printf("  -r <msec>          delay between connecting two bots (200)\n");
+	printf("  -path <path>       stand, circle, line or random (circle)\n");
+	printf("  -radius <blocks>   size of the path around the spawn (16)\n");
+	printf("  -speed <blocks/s>  movement speed (4.3)\n");
+	printf("  -fly <blocks>      fly this high above the spawn instead of walking\n");
+	printf("  -chat <msec>       interval between chat messages of a bot, 0 to disable (10000)\n");
+	printf("  -build <msec>      interval between placing / breaking a block, 0 to disable (2000)\n");
+	printf("  -vd <chunks>       view distance requested by the bots (10)\n");
+	printf("  -metrics <host:port>  webadmin to scrape the server's tick times from\n");
+	printf("  -auth <user:pass>  webadmin login for the -metrics scrape\n");
+}
+
+
+
+
+
+/// Parses the commandline into the settings; returns false if the commandline is invalid
+static bool ParseArgs(int argc, char ** argv, sRunSettings & a_Run, sBotSettings & a_Bot)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		AString Arg(argv[i]);
+		if (i + 1 >= argc)
+		{
+			printf("Missing value for parameter \"%s\"\n", Arg.c_str());
+			return false;
+		}
+		AString Value(argv[++i]);
+		if      (Arg == "-h")      { a_Bot.m_ServerAddress = Value; }
+		else if (Arg == "-p")      { a_Bot.m_ServerPort = (unsigned short)atoi(Value.c_str()); }
+		else if (Arg == "-n")      { a_Run.m_NumBots = atoi(Value.c_str()); }
+		else if (Arg == "-t")      { a_Run.m_Duration = atoi(Value.c_str()); }
+		else if (Arg == "-r")      { a_Run.m_RampUp = atoi(Value.c_str()); }
+		else if (Arg == "-radius") { a_Bot.m_PathRadius = atof(Value.c_str()); }
+		else if (Arg == "-speed")  { a_Bot.m_Speed = atof(Value.c_str()); }
+		else if (Arg == "-chat")   { a_Bot.m_ChatInterval = atoi(Value.c_str()); }
+		else if (Arg == "-build")  { a_Bot.m_BuildInterval = atoi(Value.c_str()); }
+		else if (Arg == "-vd")     { a_Bot.m_ViewDistance = atoi(Value.c_str()); }
+		else if (Arg == "-auth")   { a_Run.m_MetricsAuth = Value; }
+		else if (Arg == "-fly")
+		{
+			a_Bot.m_ShouldFly = true;
+			a_Bot.m_FlyHeight = atof(Value.c_str());
+		}
+		else if (Arg == "-path")
+		{
+			if      (Value == "stand")  { a_Bot.m_Path = sBotSettings::pathStand; }
+			else if (Value == "circle") { a_Bot.m_Path = sBotSettings::pathCircle; }
+			else if (Value == "line")   { a_Bot.m_Path = sBotSettings::pathLine; }
+			else if (Value == "random") { a_Bot.m_Path = sBotSettings::pathRandom; }
+			else
+			{
+				printf("Unknown path \"%s\"\n", Value.c_str());
+				return false;
+			}
+		}
+		else if (Arg == "-metrics")
+		{
+			size_t idx = Value.rfind(':');
+			if (idx == AString::npos)
+			{
+				printf("The metrics address needs to be in the host:port format\n");
+				return false;
+			}
+			a_Run.m_MetricsAddress = Value.substr(0, idx);
+			a_Run.m_MetricsPort = (unsigned short)atoi(Value.c_str() + idx + 1);
+		}
+		else
+		{
+			printf("Unknown parameter \"%s\"\n", Arg.c_str());
+			return false;
+		}
+	}
+
+	if ((a_Run.m_NumBots < 1) || (a_Run.m_Duration < 1) || (a_Run.m_RampUp < 0))
+	{
+		printf("Invalid number of bots, duration or ramp-up\n");
+		return false;
+	}
+
+	// select() can only wait for a limited number of sockets:
+	if (a_Run.m_NumBots > FD_SETSIZE - 1)
+	{
+		printf("Limiting the number of bots to %d\n", FD_SETSIZE - 1);
+		a_Run.m_NumBots = FD_SETSIZE - 1;
+	}
+	return true;
+}
+
+
+
+
+
+/// Encodes the data for the HTTP Basic authentication
+static AString Base64Encode(const AString & a_Data)
+{
+	static const char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	AString res;
+	size_t Len = a_Data.size();
+	for (size_t i = 0; i < Len; i += 3)
+	{
+		unsigned Val = (unsigned char)a_Data[i] << 16;
+		if (i + 1 < Len)
+		{
+			Val |= (unsigned char)a_Data[i + 1] << 8;
+		}
+		if (i + 2 < Len)
+		{
+			Val |= (unsigned char)a_Data[i + 2];
+		}
+		res.push_back(Alphabet[(Val >> 18) & 0x3f]);
+		res.push_back(Alphabet[(Val >> 12) & 0x3f]);
+		res.push_back((i + 1 < Len) ? Alphabet[(Val >> 6) & 0x3f] : '=');
+		res.push_back((i + 2 < Len) ? Alphabet[Val & 0x3f] : '=');
+	}
+	return res;
+}
+
+
+
+
+
+/// Returns the value of the world label in the metric line, or an empty string if there's none
+static AString GetWorldLabel(const AString & a_Line)
+{
+	size_t Start = a_Line.find("world=\"");
+	if (Start == AString::npos)
+	{
+		return "";
+	}
+	Start += 7;
+	size_t End = a_Line.find('"', Start);
+	return (End == AString::npos) ? "" : a_Line.substr(Start, End - Start);
+}
+
+
+
+
+
+/// Downloads the server's metrics page and extracts the tick duration histograms from it; returns true if successful
+static bool ScrapeTickTimes(const sRunSettings & a_Run, cTickSnapshots & a_Snapshots)
+{
+	cSocket Socket = cSocket::CreateSocket(cSocket::IPv4);
+	if (!Socket.IsValid() || !Socket.ConnectIPv4(a_Run.m_MetricsAddress, a_Run.m_MetricsPort))
+	{
+		printf("Cannot connect to the webadmin at %s:%d\n", a_Run.m_MetricsAddress.c_str(), a_Run.m_MetricsPort);
+		Socket.CloseSocket();
+		return false;
+	}
+	Socket.SetTimeout(5000);
+
+	AString Request = Printf("GET /metrics HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n", a_Run.m_MetricsAddress.c_str());
+	if (!a_Run.m_MetricsAuth.empty())
+	{
+		AppendPrintf(Request, "Authorization: Basic %s\r\n", Base64Encode(a_Run.m_MetricsAuth).c_str());
+	}
+	Request.append("\r\n");
+	Socket.Send(Request.data(), Request.size());
+
+	// Receive the response; the webadmin may keep the connection alive, so read only as much as the Content-Length says:
+	AString Response;
+	size_t BodyStart = AString::npos;
+	size_t ContentLength = AString::npos;
+	for (;;)
+	{
+		char Buffer[16 KiB];
+		int Received = Socket.Receive(Buffer, sizeof(Buffer), 0);
+		if (Received <= 0)
+		{
+			break;
+		}
+		Response.append(Buffer, Received);
+		if (BodyStart == AString::npos)
+		{
+			BodyStart = Response.find("\r\n\r\n");
+			if (BodyStart == AString::npos)
+			{
+				continue;
+			}
+			BodyStart += 4;
+			AString Headers = Response.substr(0, BodyStart);
+			StrToLower(Headers);
+			size_t idx = Headers.find("content-length:");
+			if (idx != AString::npos)
+			{
+				ContentLength = (size_t)atoi(Headers.c_str() + idx + 15);
+			}
+		}
+		if ((ContentLength != AString::npos) && (Response.size() >= BodyStart + ContentLength))
+		{
+			break;
+		}
+	}
+	Socket.CloseSocket();
+
+	if ((BodyStart == AString::npos) || (Response.compare(0, 12, "HTTP/1.1 200") != 0))
+	{
+		printf("The webadmin didn't return the metrics: %s\n", Response.substr(0, Response.find('\r')).c_str());
+		return false;
+	}
+
+	AStringVector Lines = StringSplit(Response.substr(BodyStart), "\n");
+	for (AStringVector::const_iterator itr = Lines.begin(), end = Lines.end(); itr != end; ++itr)
+	{
+		const AString & Line = *itr;
+		if (Line.compare(0, 41, "mcserver_world_tick_duration_milliseconds") != 0)
+		{
+			continue;
+		}
+		size_t ValueStart = Line.rfind(' ');
+		if (ValueStart == AString::npos)
+		{
+			continue;
+		}
+		Int64 Value = (Int64)atof(Line.c_str() + ValueStart + 1);
+		sTickSnapshot & Snapshot = a_Snapshots[GetWorldLabel(Line)];
+		if (Line.compare(41, 5, "_sum{") == 0)
+		{
+			Snapshot.m_Sum = Value;
+		}
+		else if (Line.compare(41, 7, "_count{") == 0)
+		{
+			Snapshot.m_Count = Value;
+		}
+		else if (Line.find("le=\"50\"") != AString::npos)
+		{
+			Snapshot.m_CountUpTo50 = Value;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+/// Prints the min / avg / 95th percentile / max of the values
+static void PrintDistribution(const char * a_Name, std::vector<int> & a_Values)
+{
+	if (a_Values.empty())
+	{
+		printf("  %-16s no samples\n", a_Name);
+		return;
+	}
+	std::sort(a_Values.begin(), a_Values.end());
+	Int64 Sum = 0;
+	for (std::vector<int>::const_iterator itr = a_Values.begin(), end = a_Values.end(); itr != end; ++itr)
+	{
+		Sum += *itr;
+	}
+	printf("  %-16s min %5d ms, avg %7.1f ms, p95 %5d ms, max %5d ms  (%u samples)\n",
+		a_Name, a_Values.front(), (double)Sum / a_Values.size(),
+		a_Values[(a_Values.size() * 95) / 100], a_Values.back(), (unsigned)a_Values.size()
+	);
+}
+
+
+
+
+
+/// Prints the tick durations between the two scrapes of the metrics
+static void PrintTickTimes(const cTickSnapshots & a_Before, const cTickSnapshots & a_After)
+{
+	for (cTickSnapshots::const_iterator itr = a_After.begin(), end = a_After.end(); itr != end; ++itr)
+	{
+		sTickSnapshot Before;
+		cTickSnapshots::const_iterator itrB = a_Before.find(itr->first);
+		if (itrB != a_Before.end())
+		{
+			Before = itrB->second;
+		}
+		Int64 NumTicks = itr->second.m_Count - Before.m_Count;
+		if (NumTicks <= 0)
+		{
+			continue;
+		}
+		Int64 NumSlowTicks = NumTicks - (itr->second.m_CountUpTo50 - Before.m_CountUpTo50);
+		printf("  world %-10s avg tick %6.1f ms, %5.1f %% of %lld ticks over 50 ms\n",
+			itr->first.c_str(),
+			(double)(itr->second.m_Sum - Before.m_Sum) / NumTicks,
+			100.0 * NumSlowTicks / NumTicks,
+			(long long)NumTicks
+		);
+	}
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	sRunSettings Run;
+	sBotSettings BotSettings;
+	if (!ParseArgs(argc, argv, Run, BotSettings))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	#ifdef _WIN32
+		cSocket::WSAStartup();
+	#endif
+
+	// The server sources linked in report their errors through the logger:
+	cMCLogger Logger("LoadGen.log");
+
+	cTickSnapshots TicksBefore;
+	bool HasMetrics = (Run.m_MetricsPort != 0) && ScrapeTickTimes(Run, TicksBefore);
+
+	printf("Connecting %d bots to %s:%d, %d msec apart, then measuring for %d seconds\n",
+		Run.m_NumBots, BotSettings.m_ServerAddress.c_str(), BotSettings.m_ServerPort, Run.m_RampUp, Run.m_Duration
+	);
+
+	sBotStats Stats;
+	std::vector<cBot *> Bots;
+	cTimer Timer;
+	long long StartTime = Timer.GetNowTime();
+	long long Now = StartTime;
+	long long NextConnect = StartTime;
+	long long NextTick = StartTime;
+	long long NextProgress = StartTime + PROGRESS_INTERVAL;
+	long long EndTime = StartTime + (long long)Run.m_RampUp * Run.m_NumBots + (long long)Run.m_Duration * 1000;
+	while (Now < EndTime)
+	{
+		// Connect the next bot, if it's time:
+		if (((int)Bots.size() < Run.m_NumBots) && (Now >= NextConnect))
+		{
+			cBot * Bot = new cBot((int)Bots.size(), BotSettings, Stats);
+			Bots.push_back(Bot);
+			if (!Bot->Connect(Now))
+			{
+				printf("%s: cannot connect to the server\n", Bot->GetName().c_str());
+			}
+			NextConnect += Run.m_RampUp;
+		}
+
+		// Wait for incoming data until the next tick:
+		fd_set ReadSet;
+		FD_ZERO(&ReadSet);
+		cSocket::xSocket MaxSocket = 0;
+		int NumConnected = 0;
+		for (std::vector<cBot *>::const_iterator itr = Bots.begin(), end = Bots.end(); itr != end; ++itr)
+		{
+			if ((*itr)->IsConnected())
+			{
+				cSocket::xSocket Socket = (*itr)->GetSocket().GetSocket();
+				FD_SET(Socket, &ReadSet);
+				MaxSocket = std::max(MaxSocket, Socket);
+				NumConnected++;
+			}
+		}
+		long long Wait = std::max(0LL, std::min(NextTick, NextConnect) - Now);
+		if (NumConnected > 0)
+		{
+			timeval Timeout;
+			Timeout.tv_sec = 0;
+			Timeout.tv_usec = (long)(std::min(Wait, (long long)TICK_INTERVAL) * 1000);
+			if (select((int)MaxSocket + 1, &ReadSet, NULL, NULL, &Timeout) > 0)
+			{
+				Now = Timer.GetNowTime();
+				for (std::vector<cBot *>::const_iterator itr = Bots.begin(), end = Bots.end(); itr != end; ++itr)
+				{
+					if ((*itr)->IsConnected() && FD_ISSET((*itr)->GetSocket().GetSocket(), &ReadSet))
+					{
+						(*itr)->ReceiveData(Now);
+					}
+				}
+			}
+		}
+		else
+		{
+			cSleep::MilliSleep((unsigned)std::min(Wait, (long long)TICK_INTERVAL));
+		}
+		Now = Timer.GetNowTime();
+
+		if (Now >= NextTick)
+		{
+			for (std::vector<cBot *>::const_iterator itr = Bots.begin(), end = Bots.end(); itr != end; ++itr)
+			{
+				if ((*itr)->IsConnected())
+				{
+					(*itr)->Tick(Now);
+				}
+			}
+			NextTick += TICK_INTERVAL;
+			if (NextTick < Now)
+			{
+				// We're falling behind, don't try to catch up by ticking several times in a row:
+				NextTick = Now + TICK_INTERVAL;
+			}
+		}
+
+		if (Now >= NextProgress)
+		{
+			printf("%5.0f s: %d / %u bots connected, %lld chunks, %.1f MiB received\n",
+				(double)(Now - StartTime) / 1000, NumConnected, (unsigned)Bots.size(),
+				(long long)Stats.m_NumChunks, (double)Stats.m_NumBytesReceived / (1024 * 1024)
+			);
+			NextProgress += PROGRESS_INTERVAL;
+		}
+	}
+
+	int NumConnected = 0;
+	for (std::vector<cBot *>::iterator itr = Bots.begin(), end = Bots.end(); itr != end; ++itr)
+	{
+		NumConnected += (*itr)->IsConnected() ? 1 : 0;
+		delete *itr;
+	}
+	Bots.clear();
+
+	// Report:
+	double Seconds = (double)(Now - StartTime) / 1000;
+	printf("\nResults after %.1f seconds, %d bots, %d still connected:\n", Seconds, Run.m_NumBots, NumConnected);
+	PrintDistribution("login latency",   Stats.m_LoginLatencies);
+	PrintDistribution("spawn latency",   Stats.m_SpawnLatencies);
+	PrintDistribution("keep-alive RTT",  Stats.m_KeepAliveRTTs);
+	PrintDistribution("chat RTT",        Stats.m_ChatRTTs);
+	printf("  chunks           %lld total, %.1f per second, %.1f MiB/s received\n",
+		(long long)Stats.m_NumChunks, (double)Stats.m_NumChunks / Seconds,
+		(double)Stats.m_NumBytesReceived / (1024 * 1024) / Seconds
+	);
+	printf("  actions          %d chats sent, %d blocks placed, %d blocks broken\n",
+		Stats.m_NumChatsSent, Stats.m_NumBlocksPlaced, Stats.m_NumBlocksBroken
+	);
+	printf("  failures         %d logins failed, %d disconnected\n", Stats.m_NumLoginFailures, Stats.m_NumDisconnects);
+	if (Stats.m_LastWorldAgeTime > Stats.m_FirstWorldAgeTime)
+	{
+		printf("  server TPS       %.2f (from the world age)\n",
+			(double)(Stats.m_LastWorldAge - Stats.m_FirstWorldAge) * 1000 / (double)(Stats.m_LastWorldAgeTime - Stats.m_FirstWorldAgeTime)
+		);
+	}
+
+	cTickSnapshots TicksAfter;
+	if (HasMetrics && ScrapeTickTimes(Run, TicksAfter))
+	{
+		PrintTickTimes(TicksBefore, TicksAfter);
+	}
+
+	return ((Stats.m_NumLoginFailures > 0) || (Stats.m_NumDisconnects > 0)) ? 2 : 0;
+}
+
+
+
+
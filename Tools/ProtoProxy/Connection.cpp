@@ -161,6 +161,7 @@ AString PrintableAbsIntTriplet(int a_X, int a_Y, int a_Z, double a_Divisor = 32)
 cConnection::cConnection(SOCKET a_ClientSocket, cServer & a_Server) :
 	m_ItemIdx(0),
 	m_LogFile(NULL),
+	m_ClientCaptureFile(NULL),
 	m_Server(a_Server),
 	m_ClientSocket(a_ClientSocket),
 	m_ServerSocket(-1),
@@ -188,6 +189,11 @@ cConnection::cConnection(SOCKET a_ClientSocket, cServer & a_Server) :
 	m_LogFile = fopen(fnam.c_str(), "w");
 	Log("Log file created");
 	printf("Connection is logged to file \"%s\"\n", fnam.c_str());
+	
+	// The capture file consists of records, one per each received chunk of data: <BE UInt32 size><data>
+	fnam.assign(m_LogNameBase);
+	fnam.append(".client.cap");
+	m_ClientCaptureFile = fopen(fnam.c_str(), "wb");
 }
 
 
@@ -197,6 +203,10 @@ cConnection::cConnection(SOCKET a_ClientSocket, cServer & a_Server) :
 cConnection::~cConnection()
 {
 	fclose(m_LogFile);
+	if (m_ClientCaptureFile != NULL)
+	{
+		fclose(m_ClientCaptureFile);
+	}
 }
 
 
@@ -481,6 +491,13 @@ bool cConnection::SendEncryptedData(SOCKET a_Socket, Encryptor & a_Encryptor, cB
 
 bool cConnection::DecodeClientsPackets(const char * a_Data, int a_Size)
 {
+	if (m_ClientCaptureFile != NULL)
+	{
+		UInt32 Size = htonl((UInt32)a_Size);
+		fwrite(&Size, 4, 1, m_ClientCaptureFile);
+		fwrite(a_Data, 1, a_Size, m_ClientCaptureFile);
+	}
+	
 	if (!m_ClientBuffer.Write(a_Data, a_Size))
 	{
 		Log("Too much queued data for the server, aborting connection");
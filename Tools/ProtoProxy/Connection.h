@@ -31,6 +31,9 @@ class cConnection
 	cCriticalSection m_CSLog;
 	FILE * m_LogFile;
 	
+	/// Raw capture of the client's (unencrypted) data, for replaying through the server's parser using ProtoReplay
+	FILE * m_ClientCaptureFile;
+	
 	cServer & m_Server;
 	SOCKET m_ClientSocket;
 	SOCKET m_ServerSocket;
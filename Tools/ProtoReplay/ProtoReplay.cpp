@@ -0,0 +1,479 @@
+
+// ProtoReplay.cpp
+
+// Implements the main app entrypoint and the replay benchmark
+// Feeds a client-to-server capture recorded by ProtoProxy through two implementations of the 1.7 packet parser:
+//  - "ring": the ringbuffer-based parser (cByteBuffer), decrypting through a fixed 512-byte stack buffer
+//  - "linear": the contiguous parser (cPacketReader), decrypting in place in a growable buffer, as used by cProtocol172
+
+#include "Globals.h"
+#include "ByteBuffer.h"
+#include "Protocol/PacketReader.h"
+#include "OSSupport/Timer.h"
+
+
+
+
+
+/// Data chunks as they were received from the socket, in the order of arrival
+typedef std::vector<AString> AStringVector;
+
+
+
+
+
+/// Statistics gathered while parsing, used to verify that both parsers read the same values
+struct sParseStats
+{
+	int m_NumPackets;
+	int m_NumErrors;
+	double m_Checksum;
+
+	sParseStats(void) :
+		m_NumPackets(0),
+		m_NumErrors(0),
+		m_Checksum(0)
+	{
+	}
+} ;
+
+
+
+
+
+/** Reads the packet body the same way cProtocol172's handlers do. Works with both cByteBuffer and cPacketReader.
+a_State is the protocol state (0 = handshake, 1 = status, 2 = login, 3 = game), updated by handshake and login packets.
+*/
+template <typename Reader>
+void DecodePacket(Reader & a_Data, UInt32 a_PacketType, UInt32 a_RemainingBytes, int & a_State, sParseStats & a_Stats)
+{
+	a_Stats.m_NumPackets += 1;
+	switch (a_State)
+	{
+		case 0:
+		{
+			// Handshake: ProtocolVersion, ServerAddress, ServerPort, NextState
+			UInt32 ProtocolVersion, NextState;
+			AString ServerAddress;
+			short ServerPort;
+			a_Data.ReadVarInt(ProtocolVersion);
+			a_Data.ReadVarUTF8String(ServerAddress);
+			a_Data.ReadBEShort(ServerPort);
+			a_Data.ReadVarInt(NextState);
+			a_State = (int)NextState;
+			return;
+		}
+		case 2:
+		{
+			if (a_PacketType == 0x00)
+			{
+				AString Username;
+				a_Data.ReadVarUTF8String(Username);
+				a_Stats.m_Checksum += Username.size();
+				a_State = 3;
+				return;
+			}
+			break;
+		}
+		case 3:
+		{
+			switch (a_PacketType)
+			{
+				case 0x00:
+				{
+					int KeepAliveID;
+					a_Data.ReadBEInt(KeepAliveID);
+					a_Stats.m_Checksum += KeepAliveID;
+					return;
+				}
+				case 0x01:
+				{
+					AString Message;
+					a_Data.ReadVarUTF8String(Message);
+					a_Stats.m_Checksum += Message.size();
+					return;
+				}
+				case 0x03:
+				{
+					bool IsOnGround;
+					a_Data.ReadBool(IsOnGround);
+					a_Stats.m_Checksum += IsOnGround ? 1 : 0;
+					return;
+				}
+				case 0x04:
+				{
+					double PosX, PosY, Stance, PosZ;
+					bool IsOnGround;
+					a_Data.ReadBEDouble(PosX);
+					a_Data.ReadBEDouble(PosY);
+					a_Data.ReadBEDouble(Stance);
+					a_Data.ReadBEDouble(PosZ);
+					a_Data.ReadBool(IsOnGround);
+					a_Stats.m_Checksum += PosX + PosY + Stance + PosZ;
+					return;
+				}
+				case 0x05:
+				{
+					float Yaw, Pitch;
+					bool IsOnGround;
+					a_Data.ReadBEFloat(Yaw);
+					a_Data.ReadBEFloat(Pitch);
+					a_Data.ReadBool(IsOnGround);
+					a_Stats.m_Checksum += Yaw + Pitch;
+					return;
+				}
+				case 0x06:
+				{
+					double PosX, PosY, Stance, PosZ;
+					float Yaw, Pitch;
+					bool IsOnGround;
+					a_Data.ReadBEDouble(PosX);
+					a_Data.ReadBEDouble(PosY);
+					a_Data.ReadBEDouble(Stance);
+					a_Data.ReadBEDouble(PosZ);
+					a_Data.ReadBEFloat(Yaw);
+					a_Data.ReadBEFloat(Pitch);
+					a_Data.ReadBool(IsOnGround);
+					a_Stats.m_Checksum += PosX + PosY + Stance + PosZ + Yaw + Pitch;
+					return;
+				}
+				case 0x07:
+				{
+					unsigned char Status, BlockY, Face;
+					int BlockX, BlockZ;
+					a_Data.ReadByte(Status);
+					a_Data.ReadBEInt(BlockX);
+					a_Data.ReadByte(BlockY);
+					a_Data.ReadBEInt(BlockZ);
+					a_Data.ReadByte(Face);
+					a_Stats.m_Checksum += Status + BlockX + BlockY + BlockZ + Face;
+					return;
+				}
+				case 0x0a:
+				{
+					int EntityID;
+					unsigned char Animation;
+					a_Data.ReadBEInt(EntityID);
+					a_Data.ReadByte(Animation);
+					a_Stats.m_Checksum += Animation;
+					return;
+				}
+			}
+			break;
+		}
+	}
+
+	// Packet not decoded by the benchmark, skip it:
+	a_Data.SkipRead(a_RemainingBytes);
+}
+
+
+
+
+
+/// The ringbuffer-based parser, as previously used by cProtocol172 (plus rewinding on incomplete packets)
+class cRingParser
+{
+public:
+	cRingParser(void) :
+		m_ReceivedData(32 KiB),
+		m_State(0)
+	{
+	}
+
+	void DataReceived(CFB_Mode<AES>::Decryption * a_Decryptor, const char * a_Data, int a_Size)
+	{
+		if (a_Decryptor != NULL)
+		{
+			byte Decrypted[512];
+			while (a_Size > 0)
+			{
+				int NumBytes = (a_Size > (int)sizeof(Decrypted)) ? (int)sizeof(Decrypted) : a_Size;
+				a_Decryptor->ProcessData(Decrypted, (byte *)a_Data, NumBytes);
+				AddReceivedData((const char *)Decrypted, NumBytes);
+				a_Size -= NumBytes;
+				a_Data += NumBytes;
+			}
+		}
+		else
+		{
+			AddReceivedData(a_Data, a_Size);
+		}
+	}
+
+	sParseStats m_Stats;
+
+protected:
+	cByteBuffer m_ReceivedData;
+	int m_State;
+
+	void AddReceivedData(const char * a_Data, int a_Size)
+	{
+		if (!m_ReceivedData.Write(a_Data, a_Size))
+		{
+			m_Stats.m_NumErrors += 1;
+			return;
+		}
+		while (true)
+		{
+			UInt32 PacketLen;
+			if (!m_ReceivedData.ReadVarInt(PacketLen) || !m_ReceivedData.CanReadBytes(PacketLen))
+			{
+				// Incomplete packet, re-read it once more data arrives
+				m_ReceivedData.ResetRead();
+				return;
+			}
+			UInt32 PacketType;
+			UInt32 Mark1 = m_ReceivedData.GetReadableSpace();
+			if (!m_ReceivedData.ReadVarInt(PacketType))
+			{
+				m_ReceivedData.ResetRead();
+				return;
+			}
+			UInt32 NumBytesRead = Mark1 - m_ReceivedData.GetReadableSpace();
+			DecodePacket(m_ReceivedData, PacketType, PacketLen - NumBytesRead, m_State, m_Stats);
+			if (Mark1 - m_ReceivedData.GetReadableSpace() > PacketLen)
+			{
+				m_Stats.m_NumErrors += 1;
+			}
+			m_ReceivedData.ResetRead();
+			m_ReceivedData.ReadVarInt(PacketType);
+			m_ReceivedData.SkipRead(PacketLen);
+			m_ReceivedData.CommitRead();
+		}
+	}
+} ;
+
+
+
+
+
+/// The contiguous parser, as used by cProtocol172
+class cLinearParser
+{
+public:
+	cLinearParser(void) :
+		m_State(0)
+	{
+	}
+
+	void DataReceived(CFB_Mode<AES>::Decryption * a_Decryptor, const char * a_Data, int a_Size)
+	{
+		if (a_Size <= 0)
+		{
+			return;
+		}
+		if (a_Decryptor != NULL)
+		{
+			size_t Start = m_ReceivedData.size();
+			m_ReceivedData.append(a_Data, a_Size);
+			byte * Data = (byte *)&m_ReceivedData[Start];
+			a_Decryptor->ProcessData(Data, Data, a_Size);
+		}
+		else if (m_ReceivedData.empty())
+		{
+			int NumParsed = ParsePackets(a_Data, a_Size);
+			m_ReceivedData.assign(a_Data + NumParsed, a_Size - NumParsed);
+			return;
+		}
+		else
+		{
+			m_ReceivedData.append(a_Data, a_Size);
+		}
+		int NumParsed = ParsePackets(m_ReceivedData.data(), (int)m_ReceivedData.size());
+		m_ReceivedData.erase(0, NumParsed);
+	}
+
+	sParseStats m_Stats;
+
+protected:
+	AString m_ReceivedData;
+	int m_State;
+
+	int ParsePackets(const char * a_Data, int a_Size)
+	{
+		cPacketReader Data(a_Data, a_Size);
+		cPacketReader Packet;
+		while (Data.ReadPacket(Packet))
+		{
+			UInt32 PacketType;
+			if (!Packet.ReadVarInt(PacketType))
+			{
+				m_Stats.m_NumErrors += 1;
+				continue;
+			}
+			DecodePacket(Packet, PacketType, Packet.GetReadableSpace(), m_State, m_Stats);
+			if (Packet.HasOverrun())
+			{
+				m_Stats.m_NumErrors += 1;
+			}
+		}
+		return Data.GetReadPos();
+	}
+} ;
+
+
+
+
+
+/// Loads the capture file produced by ProtoProxy; returns false on failure
+bool LoadCapture(const char * a_FileName, AStringVector & a_Chunks)
+{
+	FILE * f = fopen(a_FileName, "rb");
+	if (f == NULL)
+	{
+		printf("Cannot open capture file \"%s\"\n", a_FileName);
+		return false;
+	}
+	UInt32 Size;
+	while (fread(&Size, 4, 1, f) == 1)
+	{
+		Size = ntohl(Size);
+		AString Chunk;
+		Chunk.resize(Size);
+		if ((Size > 0) && (fread(&Chunk[0], 1, Size, f) != Size))
+		{
+			printf("Capture file \"%s\" is truncated\n", a_FileName);
+			break;
+		}
+		a_Chunks.push_back(Chunk);
+	}
+	fclose(f);
+	return true;
+}
+
+
+
+
+
+/// Encrypts the chunks the same way a client would, using the specified key as both the key and the IV
+void EncryptCapture(const AStringVector & a_Chunks, const byte * a_Key, AStringVector & a_Encrypted)
+{
+	CFB_Mode<AES>::Encryption Encryptor;
+	Encryptor.SetKey(a_Key, 16, MakeParameters(Name::IV(), ConstByteArrayParameter(a_Key, 16))(Name::FeedbackSize(), 1));
+	a_Encrypted.clear();
+	a_Encrypted.reserve(a_Chunks.size());
+	for (AStringVector::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+	{
+		AString Chunk(*itr);
+		if (!Chunk.empty())
+		{
+			Encryptor.ProcessData((byte *)&Chunk[0], (const byte *)Chunk.data(), Chunk.size());
+		}
+		a_Encrypted.push_back(Chunk);
+	}
+}
+
+
+
+
+
+/// Replays the whole capture a_NumRounds times through a new Parser each round, prints the results
+template <typename Parser>
+sParseStats RunBenchmark(const char * a_Name, const AStringVector & a_Chunks, size_t a_NumBytes, const byte * a_Key, int a_NumRounds)
+{
+	sParseStats Total;
+	cTimer Timer;
+	long long Elapsed = 0;
+	for (int i = 0; i < a_NumRounds; i++)
+	{
+		// Each round needs a fresh decryptor, since the cipher state carries over from the previous data:
+		CFB_Mode<AES>::Decryption Decryptor;
+		if (a_Key != NULL)
+		{
+			Decryptor.SetKey(a_Key, 16, MakeParameters(Name::IV(), ConstByteArrayParameter(a_Key, 16))(Name::FeedbackSize(), 1));
+		}
+		Parser p;
+		long long Start = Timer.GetNowTimeUSec();
+		for (AStringVector::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+		{
+			p.DataReceived((a_Key != NULL) ? &Decryptor : NULL, itr->data(), (int)itr->size());
+		}
+		Elapsed += Timer.GetNowTimeUSec() - Start;
+		Total.m_NumPackets += p.m_Stats.m_NumPackets;
+		Total.m_NumErrors  += p.m_Stats.m_NumErrors;
+		Total.m_Checksum   += p.m_Stats.m_Checksum;
+	}
+
+	double Seconds = (double)Elapsed / 1000000;
+	if (Seconds <= 0)
+	{
+		Seconds = 0.000001;
+	}
+	printf("%-8s %-10s %10.3f s %12.0f packets/s %10.2f MiB/s  (%d errors)\n",
+		a_Name, (a_Key != NULL) ? "encrypted" : "plain", Seconds,
+		(double)Total.m_NumPackets / Seconds,
+		(double)a_NumBytes * a_NumRounds / Seconds / (1024 * 1024),
+		Total.m_NumErrors
+	);
+	return Total;
+}
+
+
+
+
+
+/// Prints a warning if the two parsers didn't read the same data
+void CompareStats(const sParseStats & a_Ring, const sParseStats & a_Linear)
+{
+	if ((a_Ring.m_NumPackets != a_Linear.m_NumPackets) || (a_Ring.m_Checksum != a_Linear.m_Checksum))
+	{
+		printf("WARNING: the parsers disagree: ring parsed %d packets (checksum %f), linear parsed %d packets (checksum %f)\n",
+			a_Ring.m_NumPackets, a_Ring.m_Checksum, a_Linear.m_NumPackets, a_Linear.m_Checksum
+		);
+	}
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: ProtoReplay <capturefile> [NumRounds]\n");
+		printf("The capture file is produced by ProtoProxy, as Logs/Log_<...>.client.cap\n");
+		return 1;
+	}
+	int NumRounds = (argc > 2) ? atoi(argv[2]) : 100;
+	if (NumRounds < 1)
+	{
+		NumRounds = 1;
+	}
+
+	AStringVector Chunks;
+	if (!LoadCapture(argv[1], Chunks))
+	{
+		return 2;
+	}
+	size_t NumBytes = 0;
+	for (AStringVector::const_iterator itr = Chunks.begin(), end = Chunks.end(); itr != end; ++itr)
+	{
+		NumBytes += itr->size();
+	}
+	printf("Loaded %u chunks, %u bytes; replaying %d times\n", (unsigned)Chunks.size(), (unsigned)NumBytes, NumRounds);
+
+	// Plain data:
+	sParseStats Ring   = RunBenchmark<cRingParser>  ("ring",   Chunks, NumBytes, NULL, NumRounds);
+	sParseStats Linear = RunBenchmark<cLinearParser>("linear", Chunks, NumBytes, NULL, NumRounds);
+	CompareStats(Ring, Linear);
+
+	// Encrypted data:
+	byte Key[16];
+	for (size_t i = 0; i < sizeof(Key); i++)
+	{
+		Key[i] = (byte)(i * 17 + 3);
+	}
+	AStringVector Encrypted;
+	EncryptCapture(Chunks, Key, Encrypted);
+	Ring   = RunBenchmark<cRingParser>  ("ring",   Encrypted, NumBytes, Key, NumRounds);
+	Linear = RunBenchmark<cLinearParser>("linear", Encrypted, NumBytes, Key, NumRounds);
+	CompareStats(Ring, Linear);
+
+	return 0;
+}
+
+
+
+
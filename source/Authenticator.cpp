@@ -16,6 +16,9 @@
 
 #define DEFAULT_AUTH_SERVER "session.minecraft.net"
 #define DEFAULT_AUTH_ADDRESS "/game/checkserver.jsp?user=%USERNAME%&serverId=%SERVERID%"
+#define DEFAULT_NUM_WORKERS 4
+#define DEFAULT_TIMEOUT_SEC 10
+#define DEFAULT_CACHE_TTL_SEC 30
 #define MAX_REDIRECTS 10
 
 
@@ -23,10 +26,12 @@
 
 
 cAuthenticator::cAuthenticator(void) :
-	super("cAuthenticator"),
 	m_Server(DEFAULT_AUTH_SERVER),
 	m_Address(DEFAULT_AUTH_ADDRESS),
-	m_ShouldAuthenticate(true)
+	m_ShouldAuthenticate(true),
+	m_NumWorkers(DEFAULT_NUM_WORKERS),
+	m_TimeoutMSec(DEFAULT_TIMEOUT_SEC * 1000),
+	m_CacheTTLMSec(DEFAULT_CACHE_TTL_SEC * 1000)
 {
 }
 
@@ -49,6 +54,9 @@ void cAuthenticator::ReadINI(cIniFile & IniFile)
 	m_Server  = IniFile.GetValueSet("Authentication", "Server", DEFAULT_AUTH_SERVER);
 	m_Address = IniFile.GetValueSet("Authentication", "Address", DEFAULT_AUTH_ADDRESS);
 	m_ShouldAuthenticate = IniFile.GetValueSetB("Authentication", "Authenticate", true);
+	m_NumWorkers   = std::max(1, IniFile.GetValueSetI("Authentication", "NumWorkers", DEFAULT_NUM_WORKERS));
+	m_TimeoutMSec  = std::max(0, IniFile.GetValueSetI("Authentication", "Timeout",    DEFAULT_TIMEOUT_SEC)) * 1000;
+	m_CacheTTLMSec = std::max(0, IniFile.GetValueSetI("Authentication", "CacheTTL",   DEFAULT_CACHE_TTL_SEC)) * 1000;
 }
 
 
@@ -64,8 +72,32 @@ void cAuthenticator::Authenticate(int a_ClientID, const AString & a_UserName, co
 		return;
 	}
 
+	AString Key(a_UserName);
+	Key.push_back('\n');
+	Key.append(a_ServerHash);
+
 	cCSLock Lock(m_CS);
-	m_Queue.push_back(cUser(a_ClientID, a_UserName, a_ServerHash));
+	if (IsCached(Key))
+	{
+		// The auth server has confirmed this very user / server ID pair a short while ago, no need to ask again:
+		Lock.Unlock();
+		cRoot::Get()->AuthenticateUser(a_ClientID);
+		return;
+	}
+	
+	cRequestMap::iterator itr = m_Requests.find(Key);
+	if (itr != m_Requests.end())
+	{
+		// The same pair is already queued or being authenticated, the client will get the result of that request:
+		itr->second.m_ClientIDs.push_back(a_ClientID);
+		return;
+	}
+	
+	cRequest & Request = m_Requests[Key];
+	Request.m_Name = a_UserName;
+	Request.m_ServerID = a_ServerHash;
+	Request.m_ClientIDs.push_back(a_ClientID);
+	m_Queue.push_back(Key);
 	m_QueueNonempty.Set();
 }
 
@@ -75,9 +107,14 @@ void cAuthenticator::Authenticate(int a_ClientID, const AString & a_UserName, co
 
 void cAuthenticator::Start(cIniFile & IniFile)
 {
+	ASSERT(m_Workers.empty());  // Not stopped since the last start?
 	ReadINI(IniFile);
-	m_ShouldTerminate = false;
-	super::Start();
+	for (int i = 0; i < m_NumWorkers; i++)
+	{
+		cWorker * Worker = new cWorker(*this);
+		Worker->Start();
+		m_Workers.push_back(Worker);
+	}
 }
 
 
@@ -86,46 +123,84 @@ void cAuthenticator::Start(cIniFile & IniFile)
 
 void cAuthenticator::Stop(void)
 {
-	m_ShouldTerminate = true;
+	for (cWorkers::iterator itr = m_Workers.begin(); itr != m_Workers.end(); ++itr)
+	{
+		(*itr)->SignalStop();
+	}
+	
+	// Wake up one worker; each terminating worker wakes up the next one:
 	m_QueueNonempty.Set();
-	Wait();
+	
+	for (cWorkers::iterator itr = m_Workers.begin(); itr != m_Workers.end(); ++itr)
+	{
+		(*itr)->Wait();
+		delete *itr;
+	}
+	m_Workers.clear();
 }
 
 
 
 
 
-void cAuthenticator::Execute(void)
+void cAuthenticator::ProcessQueue(cWorker & a_Worker)
 {
 	for (;;)
 	{
 		cCSLock Lock(m_CS);
-		while (!m_ShouldTerminate && (m_Queue.size() == 0))
+		while (!a_Worker.ShouldTerminate() && m_Queue.empty())
 		{
 			cCSUnlock Unlock(Lock);
 			m_QueueNonempty.Wait();
 		}
-		if (m_ShouldTerminate)
+		if (a_Worker.ShouldTerminate())
 		{
+			m_QueueNonempty.Set();
 			return;
 		}
-		ASSERT(!m_Queue.empty());
 		
-		int ClientID = m_Queue.front().m_ClientID;
-		AString UserName = m_Queue.front().m_Name;
+		AString Key = m_Queue.front();
+		m_Queue.pop_front();
+		if (!m_Queue.empty())
+		{
+			// Let another worker process the next request in parallel:
+			m_QueueNonempty.Set();
+		}
+		
+		cRequestMap::iterator itr = m_Requests.find(Key);
+		ASSERT(itr != m_Requests.end());
+		AString UserName = itr->second.m_Name;
+		AString Server = m_Server;
 		AString ActualAddress = m_Address;
 		ReplaceString(ActualAddress, "%USERNAME%", UserName);
-		ReplaceString(ActualAddress, "%SERVERID%", m_Queue.front().m_ServerID);
-		m_Queue.pop_front();
+		ReplaceString(ActualAddress, "%SERVERID%", itr->second.m_ServerID);
 		Lock.Unlock();
 
-		if (!AuthFromAddress(m_Server, ActualAddress, UserName))
+		bool IsAuthenticated = AuthFromAddress(Server, ActualAddress, UserName);
+		
+		// Collect the clients waiting for this result, including those that have asked in the meantime:
+		std::vector<int> ClientIDs;
+		Lock.Lock();
+		itr = m_Requests.find(Key);
+		ASSERT(itr != m_Requests.end());
+		std::swap(ClientIDs, itr->second.m_ClientIDs);
+		m_Requests.erase(itr);
+		if (IsAuthenticated)
 		{
-			cRoot::Get()->KickUser(ClientID, "Failed to authenticate account!");
+			AddToCache(Key);
 		}
-		else
+		Lock.Unlock();
+		
+		for (std::vector<int>::const_iterator itrC = ClientIDs.begin(); itrC != ClientIDs.end(); ++itrC)
 		{
-			cRoot::Get()->AuthenticateUser(ClientID);
+			if (IsAuthenticated)
+			{
+				cRoot::Get()->AuthenticateUser(*itrC);
+			}
+			else
+			{
+				cRoot::Get()->KickUser(*itrC, "Failed to authenticate account!");
+			}
 		}
 	}  // for (-ever)
 }
@@ -134,14 +209,72 @@ void cAuthenticator::Execute(void)
 
 
 
+bool cAuthenticator::IsCached(const AString & a_Key)
+{
+	cCacheMap::iterator itr = m_Cache.find(a_Key);
+	if (itr == m_Cache.end())
+	{
+		return false;
+	}
+	if (itr->second < m_Timer.GetNowTime())
+	{
+		m_Cache.erase(itr);
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+void cAuthenticator::AddToCache(const AString & a_Key)
+{
+	if (m_CacheTTLMSec <= 0)
+	{
+		return;
+	}
+	
+	// Remove the expired entries, so that the cache doesn't grow indefinitely:
+	long long Now = m_Timer.GetNowTime();
+	for (cCacheMap::iterator itr = m_Cache.begin(); itr != m_Cache.end();)
+	{
+		if (itr->second < Now)
+		{
+			m_Cache.erase(itr++);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+	
+	m_Cache[a_Key] = Now + m_CacheTTLMSec;
+}
+
+
+
+
+
 bool cAuthenticator::AuthFromAddress(const AString & a_Server, const AString & a_Address, const AString & a_UserName, int a_Level /* = 1 */)
 {
 	// Returns true if the user authenticated okay, false on error; iLevel is the recursion deptht (bails out if too deep)
 
+	// The server may include a port, such as "localhost:8080" for testing against a local stand-in server:
+	AString ServerName(a_Server);
+	int Port = 80;
+	size_t idxColon = a_Server.find(':');
+	if (idxColon != AString::npos)
+	{
+		ServerName = a_Server.substr(0, idxColon);
+		Port = atoi(a_Server.c_str() + idxColon + 1);
+	}
+
 	cBlockingTCPLink Link;
-	if (!Link.Connect(a_Server.c_str(), 80))
+	Link.SetTimeout(m_TimeoutMSec);
+	if (!Link.Connect(ServerName.c_str(), Port))
 	{
-		LOGERROR("cAuthenticator: cannot connect to auth server \"%s\", kicking user \"%s\"", a_Server.c_str(), a_Server.c_str());
+		LOGERROR("cAuthenticator: cannot connect to auth server \"%s\", kicking user \"%s\"", a_Server.c_str(), a_UserName.c_str());
 		return false;
 	}
 	
@@ -265,3 +398,35 @@ bool cAuthenticator::AuthFromAddress(const AString & a_Server, const AString & a
 
 
 
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cAuthenticator::cWorker:
+
+cAuthenticator::cWorker::cWorker(cAuthenticator & a_Authenticator) :
+	super("cAuthenticator"),
+	m_Authenticator(a_Authenticator)
+{
+}
+
+
+
+
+
+void cAuthenticator::cWorker::Start(void)
+{
+	m_ShouldTerminate = false;
+	super::Start();
+}
+
+
+
+
+
+void cAuthenticator::cWorker::Execute(void)
+{
+	m_Authenticator.ProcessQueue(*this);
+}
+
+
+
+
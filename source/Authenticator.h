@@ -4,7 +4,8 @@
 // Interfaces to the cAuthenticator class representing the thread that authenticates users against the official MC server
 // Authentication prevents "hackers" from joining with an arbitrary username (possibly impersonating the server admins)
 // For more info, see http://wiki.vg/Session#Server_operation
-// In MCS, authentication is implemented as a single thread that receives queued auth requests and dispatches them one by one.
+// In MCS, authentication is implemented as a pool of worker threads that receive queued auth requests and process them in parallel.
+// Duplicate requests for the same user are coalesced into a single query, and successful results are cached for a short while.
 
 
 
@@ -15,6 +16,7 @@
 #define CAUTHENTICATOR_H_INCLUDED
 
 #include "OSSupport/IsThread.h"
+#include "OSSupport/Timer.h"
 
 
 
@@ -27,11 +29,8 @@ class cRoot;
 
 
 
-class cAuthenticator :
-	public cIsThread
+class cAuthenticator
 {
-	typedef cIsThread super;
-	
 public:
 	cAuthenticator(void);
 	~cAuthenticator();
@@ -42,41 +41,87 @@ public:
 	/// Queues a request for authenticating a user. If the auth fails, the user is kicked
 	void Authenticate(int a_ClientID, const AString & a_UserName, const AString & a_ServerHash);
 
-	/// Starts the authenticator thread. The thread may be started and stopped repeatedly
+	/// Starts the authenticator threads. The threads may be started and stopped repeatedly
 	void Start(cIniFile & IniFile);
 	
-	/// Stops the authenticator thread. The thread may be started and stopped repeatedly
+	/// Stops the authenticator threads. The threads may be started and stopped repeatedly
 	void Stop(void);
 	
 private:
 
-	class cUser
+	/// A single worker thread, processing requests from the shared queue
+	class cWorker :
+		public cIsThread
 	{
+		typedef cIsThread super;
+		
 	public:
-		int     m_ClientID;
-		AString m_Name;
-		AString m_ServerID;
+		cWorker(cAuthenticator & a_Authenticator);
+		virtual ~cWorker() {}
+		
+		/// Starts the thread
+		void Start(void);
+		
+		/// Sets the termination flag; the thread notices it the next time it wakes up
+		void SignalStop(void) { m_ShouldTerminate = true; }
+		
+		bool ShouldTerminate(void) const { return m_ShouldTerminate; }
 		
-		cUser(int a_ClientID, const AString & a_Name, const AString & a_ServerID) :
-			m_ClientID(a_ClientID),
-			m_Name(a_Name),
-			m_ServerID(a_ServerID)
-		{
-		}
+	protected:
+		cAuthenticator & m_Authenticator;
+		
+		// cIsThread override:
+		virtual void Execute(void) override;
 	} ;
 	
-	typedef std::deque<cUser> cUserList;
+	typedef std::vector<cWorker *> cWorkers;
+	
+	/** A request for authenticating a single user with a single server ID.
+	All clients that ask for the same user and server ID while the request is queued or in progress are answered together.
+	*/
+	class cRequest
+	{
+	public:
+		AString          m_Name;
+		AString          m_ServerID;
+		std::vector<int> m_ClientIDs;  ///< All clients waiting for the result of this request
+	} ;
+	
+	/// Map of UserName + ServerID -> request; contains all requests that are queued or in progress
+	typedef std::map<AString, cRequest> cRequestMap;
+	
+	/// Map of UserName + ServerID -> time (msec, cTimer) when the cached successful result expires
+	typedef std::map<AString, long long> cCacheMap;
 	
 	cCriticalSection m_CS;
-	cUserList        m_Queue;
+	cRequestMap      m_Requests;
+	AStringList      m_Queue;  ///< Keys into m_Requests that are waiting to be processed, in arrival order
 	cEvent           m_QueueNonempty;
+	cCacheMap        m_Cache;
+	cTimer           m_Timer;
+	cWorkers         m_Workers;
 	
 	AString m_Server;
 	AString m_Address;
 	bool    m_ShouldAuthenticate;
 	
-	// cIsThread override:
-	virtual void Execute(void) override;
+	/// Number of worker threads that query the auth server in parallel
+	int m_NumWorkers;
+	
+	/// Timeout for each network operation (connect, send, receive) with the auth server, in msec
+	int m_TimeoutMSec;
+	
+	/// How long a successful authentication is remembered, in msec. 0 disables the cache
+	int m_CacheTTLMSec;
+	
+	/// Processes queued requests until a_Worker is signalled to terminate. Called from the worker threads.
+	void ProcessQueue(cWorker & a_Worker);
+	
+	/// Returns true if the user / server ID pair has authenticated successfully recently. Expects m_CS to be locked.
+	bool IsCached(const AString & a_Key);
+	
+	/// Remembers a successful authentication, removes expired cache entries. Expects m_CS to be locked.
+	void AddToCache(const AString & a_Key);
 	
 	// Returns true if the user authenticated okay, false on error; iLevel is the recursion deptht (bails out if too deep)
 	bool AuthFromAddress(const AString & a_Server, const AString & a_Address, const AString & a_UserName, int a_Level = 1);
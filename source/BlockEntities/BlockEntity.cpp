@@ -13,6 +13,7 @@
 #include "JukeboxEntity.h"
 #include "NoteEntity.h"
 #include "SignEntity.h"
+#include "../Chunk.h"
 
 
 
@@ -42,3 +43,32 @@ cBlockEntity * cBlockEntity::CreateByBlockType(BLOCKTYPE a_BlockType, NIBBLETYPE
 
 
 
+
+void cBlockEntity::WakeUp(void)
+{
+	// Always queue, even if the entity seems active: it may be in the middle of its Tick() on the tick thread, about to call Sleep()
+	// The chunk activates the queued entity again in its next tick, so the wakeup isn't lost
+	m_IsActive = true;
+	if (m_Chunk != NULL)
+	{
+		m_Chunk->QueueBlockEntityWakeUp(this);
+	}
+}
+
+
+
+
+
+void cBlockEntity::SetChunk(cChunk * a_Chunk)
+{
+	m_Chunk = a_Chunk;
+	if ((a_Chunk != NULL) && m_IsActive)
+	{
+		// The entity was woken up before being added to the chunk
+		a_Chunk->QueueBlockEntityWakeUp(this);
+	}
+}
+
+
+
+
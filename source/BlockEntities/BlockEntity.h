@@ -31,7 +31,10 @@ protected:
 		m_RelX(a_BlockX - cChunkDef::Width * FAST_FLOOR_DIV(a_BlockX, cChunkDef::Width)),
 		m_RelZ(a_BlockZ - cChunkDef::Width * FAST_FLOOR_DIV(a_BlockZ, cChunkDef::Width)),
 		m_BlockType(a_BlockType),
-		m_World(a_World)
+		m_World(a_World),
+		m_Chunk(NULL),
+		m_IsActive(false),
+		m_IsInActiveList(false)
 	{
 	}
 
@@ -81,10 +84,25 @@ public:
 	*/
 	virtual void SendTo(cClientHandle & a_Client) = 0;
 	
-	/// Ticks the entity; returns true if the chunk should be marked as dirty as a result of this ticking. By default does nothing.
+	/** Ticks the entity; returns true if the chunk should be marked as dirty as a result of this ticking. By default does nothing.
+	Only the active entities are ticked. An entity calls Sleep() when it has nothing more to do, and WakeUp() when it gets something to do.
+	*/
 	virtual bool Tick(float a_Dt, cChunk & a_Chunk) { return false; }
+	
+	/// Returns true if the entity is being ticked
+	bool IsActive(void) const { return m_IsActive; }
+	
+	/** Makes the chunk tick the entity, starting with its next tick. May be called from any thread.
+	The wakeup is always queued in the chunk, so it isn't lost even if the entity calls Sleep() in a Tick() running concurrently.
+	*/
+	void WakeUp(void);
+	
+	/// Sets the chunk that holds and ticks the entity; called by the chunk
+	void SetChunk(cChunk * a_Chunk);
 
 protected:
+	friend class cChunk;
+	
 	/// Position in absolute block coordinates
 	int m_PosX, m_PosY, m_PosZ;
 	
@@ -94,6 +112,18 @@ protected:
 	BLOCKTYPE m_BlockType;
 	
 	cWorld * m_World;
+	
+	/// The chunk that ticks the entity; NULL until the entity is added to a chunk
+	cChunk * m_Chunk;
+	
+	/// True if the entity wants to be ticked
+	bool m_IsActive;
+	
+	/// True if the entity is in its chunk's list of active entities; used only by the chunk, in its tick thread
+	bool m_IsInActiveList;
+	
+	/// Makes the chunk stop ticking the entity, after the current tick
+	void Sleep(void) { m_IsActive = false; }
 } ;  // tolua_export
 
 
@@ -114,6 +114,7 @@ void cDropSpenserEntity::DropSpense(cChunk & a_Chunk)
 void cDropSpenserEntity::Activate(void)
 {
 	m_ShouldDropSpense = true;
+	WakeUp();
 }
 
 
@@ -135,6 +136,8 @@ void cDropSpenserEntity::SetRedstonePower(bool a_IsPowered)
 
 bool cDropSpenserEntity::Tick(float a_Dt, cChunk & a_Chunk)
 {
+	// There's nothing to do until the next activation:
+	Sleep();
 	if (!m_ShouldDropSpense)
 	{
 		return false;
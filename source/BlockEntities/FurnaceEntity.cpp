@@ -38,6 +38,9 @@ cFurnaceEntity::cFurnaceEntity(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTY
 {
 	cBlockEntityWindowOwner::SetBlockEntity(this);
 	m_Contents.AddListener(*this);
+	
+	// Tick at least once, a furnace loaded from storage may be burning:
+	WakeUp();
 }
 
 
@@ -96,11 +99,12 @@ bool cFurnaceEntity::Tick(float a_Dt, cChunk & a_Chunk)
 {
 	if (m_FuelBurnTime <= 0)
 	{
-		// No fuel is burning, reset progressbars and bail out
+		// No fuel is burning, reset progressbars and sleep until the contents change
 		if ((m_LastProgressCook > 0) || (m_LastProgressFuel > 0))
 		{
 			UpdateProgressBars();
 		}
+		Sleep();
 		return false;
 	}
 
@@ -252,6 +256,7 @@ void cFurnaceEntity::BurnNewFuel(void)
 	m_FuelBurnTime = NewTime;
 	m_TimeBurned = 0;
 	SetIsCooking(true);
+	WakeUp();
 	if (m_Contents.GetSlot(fsFuel).m_ItemType == E_ITEM_LAVA_BUCKET)
 	{
 		m_Contents.SetSlot(fsFuel, cItem(E_ITEM_BUCKET));
@@ -270,6 +275,9 @@ void cFurnaceEntity::OnSlotChanged(cItemGrid * a_ItemGrid, int a_SlotNum)
 {
 	super::OnSlotChanged(a_ItemGrid, a_SlotNum);
 	
+	// The furnace may be able to start burning now; if not, it goes back to sleep in its next tick
+	WakeUp();
+	
 	if (m_World == NULL)
 	{
 		// The furnace isn't initialized yet, do no processing
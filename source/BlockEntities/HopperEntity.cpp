@@ -19,8 +19,25 @@
 cHopperEntity::cHopperEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cWorld * a_World) :
 	super(E_BLOCK_HOPPER, a_BlockX, a_BlockY, a_BlockZ, ContentsWidth, ContentsHeight, a_World),
 	m_LastMoveItemsInTick(0),
-	m_LastMoveItemsOutTick(0)
+	m_LastMoveItemsOutTick(0),
+	m_AreLinksValid(false),
+	m_AreLinksIncomplete(false),
+	m_WasMoveRefused(false)
 {
+	WakeUp();
+	m_Source[0] = NULL;
+	m_Source[1] = NULL;
+	m_Dest[0] = NULL;
+	m_Dest[1] = NULL;
+}
+
+
+
+
+
+cHopperEntity::~cHopperEntity()
+{
+	RemoveLinks();
 }
 
 
@@ -54,14 +71,41 @@ bool cHopperEntity::GetOutputBlockPos(NIBBLETYPE a_BlockMeta, int & a_OutputX, i
 
 
 
+void cHopperEntity::InvalidateLinks(void)
+{
+	m_AreLinksValid = false;
+	WakeUp();
+}
+
+
+
+
+
 bool cHopperEntity::Tick(float a_Dt, cChunk & a_Chunk)
 {
+	// The links are looked up again until all the containers' chunks are loaded:
+	if (!m_AreLinksValid || m_AreLinksIncomplete)
+	{
+		UpdateLinks(a_Chunk);
+	}
+	
 	Int64 CurrentTick = a_Chunk.GetWorld()->GetWorldAge();
+	m_WasMoveRefused = false;
 	
 	bool res = false;
 	res = MoveItemsIn  (a_Chunk, CurrentTick) || res;
 	res = MovePickupsIn(a_Chunk, CurrentTick) || res;
 	res = MoveItemsOut (a_Chunk, CurrentTick) || res;
+	
+	// If nothing could be moved and nothing is waiting for the next transfer, sleep until something changes:
+	if (
+		!res && !m_WasMoveRefused && !m_AreLinksIncomplete &&
+		(CurrentTick - m_LastMoveItemsInTick >= TICKS_PER_TRANSFER) &&
+		(CurrentTick - m_LastMoveItemsOutTick >= TICKS_PER_TRANSFER)
+	)
+	{
+		Sleep();
+	}
 	return res;
 }
 
@@ -123,6 +167,44 @@ void cHopperEntity::UsedBy(cPlayer * a_Player)
 
 
 
+void cHopperEntity::OnSlotChanged(cItemGrid * a_Grid, int a_SlotNum)
+{
+	// Either our contents or one of the linked containers' contents have changed, there may be something to move now:
+	WakeUp();
+	
+	if (a_Grid == &m_Contents)
+	{
+		super::OnSlotChanged(a_Grid, a_SlotNum);
+	}
+}
+
+
+
+
+
+void cHopperEntity::OnGridDestroyed(cItemGrid * a_Grid)
+{
+	// One of the linked containers is going away, drop the pointers and look up the links again in the next tick
+	// The grid has already removed us from its listeners, so only unlink the rest:
+	for (int i = 0; i < 2; i++)
+	{
+		if ((m_Source[i] != NULL) && (&m_Source[i]->GetContents() == a_Grid))
+		{
+			m_Source[i] = NULL;
+		}
+		if ((m_Dest[i] != NULL) && (&m_Dest[i]->GetContents() == a_Grid))
+		{
+			m_Dest[i] = NULL;
+		}
+	}
+	RemoveLinks();
+	InvalidateLinks();
+}
+
+
+
+
+
 /// Opens a new window UI for this hopper
 void cHopperEntity::OpenNewWindow(void)
 {
@@ -133,46 +215,159 @@ void cHopperEntity::OpenNewWindow(void)
 
 
 
-/// Moves items from the container above it into this hopper. Returns true if the contents have changed.
-bool cHopperEntity::MoveItemsIn(cChunk & a_Chunk, Int64 a_CurrentTick)
+void cHopperEntity::UpdateLinks(cChunk & a_Chunk)
 {
-	if (m_PosY >= cChunkDef::Height)
+	RemoveLinks();
+	m_AreLinksValid = true;
+	m_AreLinksIncomplete = false;
+	
+	// Source: the container above the hopper
+	if (m_PosY + 1 < cChunkDef::Height)
 	{
-		// This hopper is at the top of the world, no more blocks above
-		return false;
+		m_AreLinksIncomplete = !LinkContainerAt(a_Chunk, m_PosX, m_PosY + 1, m_PosZ, m_Source) || m_AreLinksIncomplete;
+	}
+	
+	// Destination: the container the hopper is facing
+	int bx, by, bz;
+	if (GetOutputBlockPos(a_Chunk.GetMeta(m_RelX, m_PosY, m_RelZ), bx, by, bz) && (by >= 0))
+	{
+		m_AreLinksIncomplete = !LinkContainerAt(a_Chunk, bx, by, bz, m_Dest) || m_AreLinksIncomplete;
+	}
+	
+	// Listen to the containers' changes, so that we can wake up when there's something to move:
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_Source[i] != NULL)
+		{
+			m_Source[i]->GetContents().AddListener(*this);
+		}
+		if (m_Dest[i] != NULL)
+		{
+			m_Dest[i]->GetContents().AddListener(*this);
+		}
 	}
+}
 
-	if (a_CurrentTick - m_LastMoveItemsInTick < TICKS_PER_TRANSFER)
+
+
+
+
+void cHopperEntity::RemoveLinks(void)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_Source[i] != NULL)
+		{
+			m_Source[i]->GetContents().RemoveListener(*this);
+			m_Source[i] = NULL;
+		}
+		if (m_Dest[i] != NULL)
+		{
+			m_Dest[i]->GetContents().RemoveListener(*this);
+			m_Dest[i] = NULL;
+		}
+	}
+}
+
+
+
+
+
+bool cHopperEntity::LinkContainerAt(cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ, cBlockEntityWithItems ** a_Links)
+{
+	int rx = a_BlockX - a_Chunk.GetPosX() * cChunkDef::Width;
+	int rz = a_BlockZ - a_Chunk.GetPosZ() * cChunkDef::Width;
+	cChunk * Chunk = a_Chunk.GetRelNeighborChunkAdjustCoords(rx, rz);
+	if ((Chunk == NULL) || !Chunk->IsValid())
 	{
-		// Too early after the previous transfer
 		return false;
 	}
 	
-	// Try moving an item in:
-	bool res = false;
-	switch (a_Chunk.GetBlock(m_RelX, m_PosY + 1, m_RelZ))
+	switch (Chunk->GetBlock(rx, a_BlockY, rz))
 	{
 		case E_BLOCK_CHEST:
 		{
-			// Chests have special handling because of double-chests
-			res = MoveItemsFromChest(a_Chunk);
+			a_Links[0] = (cBlockEntityWithItems *)Chunk->GetBlockEntity(a_BlockX, a_BlockY, a_BlockZ);
 			break;
 		}
 		case E_BLOCK_LIT_FURNACE:
 		case E_BLOCK_FURNACE:
-		{
-			// Furnaces have special handling because only the output and leftover fuel buckets shall be moved
-			res = MoveItemsFromFurnace(a_Chunk);
-			break;
-		}
 		case E_BLOCK_DISPENSER:
 		case E_BLOCK_DROPPER:
 		case E_BLOCK_HOPPER:
 		{
-			res = MoveItemsFromGrid(*(cBlockEntityWithItems *)a_Chunk.GetBlockEntity(m_PosX, m_PosY + 1, m_PosZ));
+			a_Links[0] = (cBlockEntityWithItems *)Chunk->GetBlockEntity(a_BlockX, a_BlockY, a_BlockZ);
+			return true;
+		}
+		default:
+		{
+			// Not a container
+			return true;
+		}
+	}
+	
+	// Chests have special handling because of double-chests, look for the other half:
+	static const struct
+	{
+		int x, z;
+	}
+	Coords [] =
+	{
+		{1, 0},
+		{-1, 0},
+		{0, 1},
+		{0, -1},
+	} ;
+	for (size_t i = 0; i < ARRAYCOUNT(Coords); i++)
+	{
+		int x = rx + Coords[i].x;
+		int z = rz + Coords[i].z;
+		cChunk * Neighbor = Chunk->GetRelNeighborChunkAdjustCoords(x, z);
+		if ((Neighbor == NULL) || !Neighbor->IsValid())
+		{
+			return false;
+		}
+		if (Neighbor->GetBlock(x, a_BlockY, z) == E_BLOCK_CHEST)
+		{
+			a_Links[1] = (cBlockEntityWithItems *)Neighbor->GetBlockEntity(a_BlockX + Coords[i].x, a_BlockY, a_BlockZ + Coords[i].z);
 			break;
 		}
 	}
+	return true;
+}
+
+
+
+
+
+/// Moves items from the container above it into this hopper. Returns true if the contents have changed.
+bool cHopperEntity::MoveItemsIn(cChunk & a_Chunk, Int64 a_CurrentTick)
+{
+	if (a_CurrentTick - m_LastMoveItemsInTick < TICKS_PER_TRANSFER)
+	{
+		// Too early after the previous transfer
+		return false;
+	}
+	
+	if (m_Source[0] == NULL)
+	{
+		// No container above the hopper
+		return false;
+	}
+	
+	// Try moving an item in:
+	bool res = false;
+	BLOCKTYPE SourceType = m_Source[0]->GetBlockType();
+	if ((SourceType == E_BLOCK_FURNACE) || (SourceType == E_BLOCK_LIT_FURNACE))
+	{
+		// Furnaces have special handling because only the output and leftover fuel buckets shall be moved
+		res = MoveItemsFromFurnace(*(cFurnaceEntity *)m_Source[0]);
+	}
+	else
+	{
+		// Chests (try the other half of a double chest, too), dispensers, droppers and hoppers:
+		res = MoveItemsFromGrid(*m_Source[0]) || ((m_Source[1] != NULL) && MoveItemsFromGrid(*m_Source[1]));
+	}
 	
 	// If the item has been moved, reset the last tick:
 	if (res)
@@ -207,53 +402,24 @@ bool cHopperEntity::MoveItemsOut(cChunk & a_Chunk, Int64 a_CurrentTick)
 		return false;
 	}
 	
-	int bx, by, bz;
-	NIBBLETYPE Meta = a_Chunk.GetMeta(m_RelX, m_PosY, m_RelZ);
-	if (!GetOutputBlockPos(Meta, bx, by, bz))
+	if (m_Dest[0] == NULL)
 	{
 		// Not attached to another container
 		return false;
 	}
-	if (by < 0)
-	{
-		// Cannot output below the zero-th block level
-		return false;
-	}
 	
-	// Convert coords to relative:
-	int rx = bx - a_Chunk.GetPosX() * cChunkDef::Width;
-	int rz = bz - a_Chunk.GetPosZ() * cChunkDef::Width;
-	cChunk * DestChunk = a_Chunk.GetRelNeighborChunkAdjustCoords(rx, rz);
-	if (DestChunk == NULL)
+	// Call proper moving function, based on the destination container:
+	bool res = false;
+	BLOCKTYPE DestType = m_Dest[0]->GetBlockType();
+	if ((DestType == E_BLOCK_FURNACE) || (DestType == E_BLOCK_LIT_FURNACE))
 	{
-		// The destination chunk has been unloaded, don't tick
-		return false;
+		// Furnaces have special handling because of the direction-to-slot relation
+		res = MoveItemsToFurnace(*(cFurnaceEntity *)m_Dest[0], a_Chunk.GetMeta(m_RelX, m_PosY, m_RelZ));
 	}
-	
-	// Call proper moving function, based on the blocktype present at the coords:
-	bool res = false;
-	switch (DestChunk->GetBlock(rx, by, rz))
+	else
 	{
-		case E_BLOCK_CHEST:
-		{
-			// Chests have special handling because of double-chests
-			res = MoveItemsToChest(*DestChunk, bx, by, bz);
-			break;
-		}
-		case E_BLOCK_LIT_FURNACE:
-		case E_BLOCK_FURNACE:
-		{
-			// Furnaces have special handling because of the direction-to-slot relation
-			res = MoveItemsToFurnace(*DestChunk, bx, by, bz, Meta);
-			break;
-		}
-		case E_BLOCK_DISPENSER:
-		case E_BLOCK_DROPPER:
-		case E_BLOCK_HOPPER:
-		{
-			res = MoveItemsToGrid(*(cBlockEntityWithItems *)DestChunk->GetBlockEntity(bx, by, bz));
-			break;
-		}
+		// Chests (try the other half of a double chest, too), dispensers, droppers and hoppers:
+		res = MoveItemsToGrid(*m_Dest[0]) || ((m_Dest[1] != NULL) && MoveItemsToGrid(*m_Dest[1]));
 	}
 	
 	// If the item has been moved, reset the last tick:
@@ -269,74 +435,23 @@ bool cHopperEntity::MoveItemsOut(cChunk & a_Chunk, Int64 a_CurrentTick)
 
 
 
-/// Moves items from a chest (dblchest) above the hopper into this hopper. Returns true if contents have changed.
-bool cHopperEntity::MoveItemsFromChest(cChunk & a_Chunk)
+/// Moves items from the furnace above the hopper into this hopper. Returns true if contents have changed.
+bool cHopperEntity::MoveItemsFromFurnace(cFurnaceEntity & a_Furnace)
 {
-	if (MoveItemsFromGrid(*(cChestEntity *)a_Chunk.GetBlockEntity(m_PosX, m_PosY + 1, m_PosZ)))
-	{
-		// Moved the item from the chest directly above the hopper
-		return true;
-	}
-	
-	// Check if the chest is a double-chest, if so, try to move from there:
-	static const struct
-	{
-		int x, z;
-	}
-	Coords [] =
-	{
-		{1, 0},
-		{-1, 0},
-		{0, 1},
-		{0, -1},
-	} ;
-	for (int i = 0; i < ARRAYCOUNT(Coords); i++)
-	{
-		int x = m_RelX + Coords[i].x;
-		int z = m_RelZ + Coords[i].z;
-		cChunk * Neighbor = a_Chunk.GetRelNeighborChunkAdjustCoords(x, z);
-		if (
-			(Neighbor == NULL) ||
-			(Neighbor->GetBlock(x, m_PosY + 1, z) != E_BLOCK_CHEST)
-		)
-		{
-			continue;
-		}
-		if (MoveItemsFromGrid(*(cChestEntity *)Neighbor->GetBlockEntity(x, m_PosY, z)))
-		{
-			return true;
-		}
-		return false;
-	}
-	
-	// The chest was single and nothing could be moved
-	return false;
-}
-
-
-
-
-
-/// Moves items from a furnace above the hopper into this hopper. Returns true if contents have changed.
-bool cHopperEntity::MoveItemsFromFurnace(cChunk & a_Chunk)
-{
-	cFurnaceEntity * Furnace = (cFurnaceEntity *)a_Chunk.GetBlockEntity(m_PosX, m_PosY + 1, m_PosZ);
-	ASSERT(Furnace != NULL);
-	
 	// Try move from the output slot:
-	if (MoveItemsFromSlot(*Furnace, cFurnaceEntity::fsOutput, true))
+	if (MoveItemsFromSlot(a_Furnace, cFurnaceEntity::fsOutput, true))
 	{
-		cItem NewOutput(Furnace->GetOutputSlot());
-		Furnace->SetOutputSlot(NewOutput.AddCount(-1));
+		cItem NewOutput(a_Furnace.GetOutputSlot());
+		a_Furnace.SetOutputSlot(NewOutput.AddCount(-1));
 		return true;
 	}
 	
 	// No output moved, check if we can move an empty bucket out of the fuel slot:
-	if (Furnace->GetFuelSlot().m_ItemType == E_ITEM_BUCKET)
+	if (a_Furnace.GetFuelSlot().m_ItemType == E_ITEM_BUCKET)
 	{
-		if (MoveItemsFromSlot(*Furnace, cFurnaceEntity::fsFuel, true))
+		if (MoveItemsFromSlot(a_Furnace, cFurnaceEntity::fsFuel, true))
 		{
-			Furnace->SetFuelSlot(cItem());
+			a_Furnace.SetFuelSlot(cItem());
 			return true;
 		}
 	}
@@ -401,6 +516,7 @@ bool cHopperEntity::MoveItemsFromSlot(cBlockEntityWithItems & a_Entity, int a_Sl
 				if (cPluginManager::Get()->CallHookHopperPullingItem(*m_World, *this, i, a_Entity, a_SlotNum))
 				{
 					// Plugin disagrees with the move
+					m_WasMoveRefused = true;
 					continue;
 				}
 			}
@@ -412,6 +528,7 @@ bool cHopperEntity::MoveItemsFromSlot(cBlockEntityWithItems & a_Entity, int a_Sl
 			if (cPluginManager::Get()->CallHookHopperPullingItem(*m_World, *this, i, a_Entity, a_SlotNum))
 			{
 				// Plugin disagrees with the move
+				m_WasMoveRefused = true;
 				continue;
 			}
 			
@@ -426,67 +543,18 @@ bool cHopperEntity::MoveItemsFromSlot(cBlockEntityWithItems & a_Entity, int a_Sl
 
 
 
-/// Moves items to the chest at the specified coords. Returns true if contents have changed
-bool cHopperEntity::MoveItemsToChest(cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ)
-{
-	// Try the chest directly connected to the hopper:
-	if (MoveItemsToGrid(*(cChestEntity *)a_Chunk.GetBlockEntity(a_BlockX, a_BlockY, a_BlockZ)))
-	{
-		return true;
-	}
-
-	// Check if the chest is a double-chest, if so, try to move into the other half:
-	static const struct
-	{
-		int x, z;
-	}
-	Coords [] =
-	{
-		{1, 0},
-		{-1, 0},
-		{0, 1},
-		{0, -1},
-	} ;
-	for (int i = 0; i < ARRAYCOUNT(Coords); i++)
-	{
-		int x = m_RelX + Coords[i].x;
-		int z = m_RelZ + Coords[i].z;
-		cChunk * Neighbor = a_Chunk.GetRelNeighborChunkAdjustCoords(x, z);
-		if (
-			(Neighbor == NULL) ||
-			(Neighbor->GetBlock(x, m_PosY + 1, z) != E_BLOCK_CHEST)
-		)
-		{
-			continue;
-		}
-		if (MoveItemsToGrid(*(cChestEntity *)Neighbor->GetBlockEntity(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			return true;
-		}
-		return false;
-	}
-	
-	// The chest was single and nothing could be moved
-	return false;
-}
-
-
-
-
-
-/// Moves items to the furnace at the specified coords. Returns true if contents have changed
-bool cHopperEntity::MoveItemsToFurnace(cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYPE a_HopperMeta)
+/// Moves items to the specified furnace. Returns true if contents have changed
+bool cHopperEntity::MoveItemsToFurnace(cFurnaceEntity & a_Furnace, NIBBLETYPE a_HopperMeta)
 {
-	cFurnaceEntity * Furnace = (cFurnaceEntity *)a_Chunk.GetBlockEntity(a_BlockX, a_BlockY, a_BlockZ);
 	if (a_HopperMeta == E_META_HOPPER_FACING_YM)
 	{
 		// Feed the input slot of the furnace
-		return MoveItemsToSlot(*Furnace, cFurnaceEntity::fsInput);
+		return MoveItemsToSlot(a_Furnace, cFurnaceEntity::fsInput);
 	}
 	else
 	{
 		// Feed the fuel slot of the furnace
-		return MoveItemsToSlot(*Furnace, cFurnaceEntity::fsFuel);
+		return MoveItemsToSlot(a_Furnace, cFurnaceEntity::fsFuel);
 	}
 	return false;
 }
@@ -526,6 +594,7 @@ bool cHopperEntity::MoveItemsToSlot(cBlockEntityWithItems & a_Entity, int a_DstS
 				if (cPluginManager::Get()->CallHookHopperPushingItem(*m_World, *this, i, a_Entity, a_DstSlotNum))
 				{
 					// A plugin disagrees with the move
+					m_WasMoveRefused = true;
 					continue;
 				}
 				Grid.SetSlot(a_DstSlotNum, m_Contents.GetSlot(i).CopyOne());
@@ -550,6 +619,7 @@ bool cHopperEntity::MoveItemsToSlot(cBlockEntityWithItems & a_Entity, int a_DstS
 				if (cPluginManager::Get()->CallHookHopperPushingItem(*m_World, *this, i, a_Entity, a_DstSlotNum))
 				{
 					// A plugin disagrees with the move
+					m_WasMoveRefused = true;
 					continue;
 				}
 				Grid.ChangeSlotCount(a_DstSlotNum, 1);
@@ -16,6 +16,12 @@
 
 
 
+class cFurnaceEntity;
+
+
+
+
+
 class cHopperEntity :  // tolua_export
 	public cBlockEntityWindowOwner,
 	// tolua_begin
@@ -35,6 +41,8 @@ public:
 	/// Constructor used for normal operation
 	cHopperEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cWorld * a_World);
 	
+	virtual ~cHopperEntity();
+	
 	/** Returns the block coords of the block receiving the output items, based on the meta
 	Returns false if unattached.
 	Exported in ManualBindings.cpp
@@ -43,10 +51,30 @@ public:
 	
 	static const char * GetClassStatic(void) { return "cHopperEntity"; }
 	
+	/** Makes the hopper look up its source and destination containers again and wakes it up.
+	Called by the chunk when a container is placed near the hopper.
+	*/
+	void InvalidateLinks(void);
+	
 protected:
 
 	Int64 m_LastMoveItemsInTick;
 	Int64 m_LastMoveItemsOutTick;
+	
+	/** The containers that the items are moved from (above the hopper) and to (where the hopper faces).
+	The second one is the other half of a double chest, or NULL. The hopper listens to the containers' contents changes.
+	*/
+	cBlockEntityWithItems * m_Source[2];
+	cBlockEntityWithItems * m_Dest[2];
+	
+	/// Set to false when the links need to be looked up again
+	bool m_AreLinksValid;
+	
+	/// Set to true when a link couldn't be looked up, because the chunk with the container isn't loaded
+	bool m_AreLinksIncomplete;
+	
+	/// Set when a plugin refused a move; the hopper keeps trying, since the plugin may allow it later
+	bool m_WasMoveRefused;
 
 	// cBlockEntity overrides:
 	virtual bool Tick(float a_Dt, cChunk & a_Chunk) override;
@@ -54,8 +82,23 @@ protected:
 	virtual void SendTo(cClientHandle & a_Client) override;
 	virtual void UsedBy(cPlayer * a_Player) override;
 	
+	// cItemGrid::cListener overrides:
+	virtual void OnSlotChanged(cItemGrid * a_Grid, int a_SlotNum) override;
+	virtual void OnGridDestroyed(cItemGrid * a_Grid) override;
+	
 	/// Opens a new chest window for this chest. Scans for neighbors to open a double chest window, if appropriate.
 	void OpenNewWindow(void);
+	
+	/// Looks up the source and destination containers and starts listening to their changes
+	void UpdateLinks(cChunk & a_Chunk);
+	
+	/// Stops listening to the linked containers and forgets them
+	void RemoveLinks(void);
+	
+	/** Looks up the container at the specified coords, and the other half if it is a double chest, into a_Links[].
+	Returns false if the container's chunk isn't loaded.
+	*/
+	bool LinkContainerAt(cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ, cBlockEntityWithItems ** a_Links);
 
 	/// Moves items from the container above it into this hopper. Returns true if the contents have changed.
 	bool MoveItemsIn(cChunk & a_Chunk, Int64 a_CurrentTick);
@@ -66,11 +109,8 @@ protected:
 	/// Moves items out from this hopper into the destination. Returns true if the contents have changed.
 	bool MoveItemsOut(cChunk & a_Chunk, Int64 a_CurrentTick);
 	
-	/// Moves items from a chest (dblchest) above the hopper into this hopper. Returns true if contents have changed.
-	bool MoveItemsFromChest(cChunk & a_Chunk);
-	
-	/// Moves items from a furnace above the hopper into this hopper. Returns true if contents have changed.
-	bool MoveItemsFromFurnace(cChunk & a_Chunk);
+	/// Moves items from the furnace above the hopper into this hopper. Returns true if contents have changed.
+	bool MoveItemsFromFurnace(cFurnaceEntity & a_Furnace);
 	
 	/// Moves items from the specified a_Entity's Contents into this hopper. Returns true if contents have changed.
 	bool MoveItemsFromGrid(cBlockEntityWithItems & a_Entity);
@@ -78,11 +118,8 @@ protected:
 	/// Moves one piece from the specified itemstack into this hopper. Returns true if contents have changed. Doesn't change the itemstack.
 	bool MoveItemsFromSlot(cBlockEntityWithItems & a_Entity, int a_SrcSlotNum, bool a_AllowNewStacks);
 	
-	/// Moves items to the chest at the specified coords. Returns true if contents have changed
-	bool MoveItemsToChest(cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ);
-	
-	/// Moves items to the furnace at the specified coords. Returns true if contents have changed
-	bool MoveItemsToFurnace(cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYPE a_HopperMeta);
+	/// Moves items to the specified furnace. Returns true if contents have changed
+	bool MoveItemsToFurnace(cFurnaceEntity & a_Furnace, NIBBLETYPE a_HopperMeta);
 	
 	/// Moves items to the specified ItemGrid. Returns true if contents have changed
 	bool MoveItemsToGrid(cBlockEntityWithItems & a_Entity);
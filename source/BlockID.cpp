@@ -21,6 +21,7 @@ bool       g_BlockIsSnowable[256];
 bool       g_BlockRequiresSpecialTool[256];
 bool       g_BlockIsSolid[256];
 bool       g_BlockIsTorchPlaceable[256];
+bool       g_BlockIsRandomTicked[256];
 
 
 
@@ -592,6 +593,7 @@ public:
 		memset(g_BlockOneHitDig,           0x00, sizeof(g_BlockOneHitDig));
 		memset(g_BlockPistonBreakable,     0x00, sizeof(g_BlockPistonBreakable));
 		memset(g_BlockIsTorchPlaceable,    0x00, sizeof(g_BlockIsTorchPlaceable));
+		memset(g_BlockIsRandomTicked,      0x00, sizeof(g_BlockIsRandomTicked));
 		
 		// Setting bools to true must be done manually, see http://forum.mc-server.org/showthread.php?tid=629&pid=5415#pid5415
 		for (int i = 0; i < ARRAYCOUNT(g_BlockIsSnowable); i++)
@@ -949,6 +951,20 @@ public:
 		g_BlockIsTorchPlaceable[E_BLOCK_WOOL]                  = true;
 		g_BlockIsTorchPlaceable[E_BLOCK_STONE]                 = true;
 		g_BlockIsTorchPlaceable[E_BLOCK_STONE_BRICKS]          = true;
+
+		// Randomly ticked blocks, the ones whose handlers do something in OnUpdate():
+		g_BlockIsRandomTicked[E_BLOCK_CACTUS]       = true;
+		g_BlockIsRandomTicked[E_BLOCK_CARROTS]      = true;
+		g_BlockIsRandomTicked[E_BLOCK_CROPS]        = true;
+		g_BlockIsRandomTicked[E_BLOCK_FARMLAND]     = true;
+		g_BlockIsRandomTicked[E_BLOCK_GRASS]        = true;
+		g_BlockIsRandomTicked[E_BLOCK_LEAVES]       = true;
+		g_BlockIsRandomTicked[E_BLOCK_MELON_STEM]   = true;
+		g_BlockIsRandomTicked[E_BLOCK_POTATOES]     = true;
+		g_BlockIsRandomTicked[E_BLOCK_PUMPKIN_STEM] = true;
+		g_BlockIsRandomTicked[E_BLOCK_SAPLING]      = true;
+		g_BlockIsRandomTicked[E_BLOCK_SUGARCANE]    = true;
+		g_BlockIsRandomTicked[E_BLOCK_VINES]        = true;
 	}
 } BlockPropertiesInitializer;
 
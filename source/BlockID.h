@@ -901,6 +901,7 @@ extern bool       g_BlockIsSnowable[256];
 extern bool       g_BlockRequiresSpecialTool[256];
 extern bool       g_BlockIsSolid[256];
 extern bool       g_BlockIsTorchPlaceable[256];
+extern bool       g_BlockIsRandomTicked[256];
 
 
 
@@ -22,7 +22,7 @@ class cBlockHandler
 public:
 	cBlockHandler(BLOCKTYPE a_BlockType);
 
-	/// Called when the block gets ticked either by a random tick or by a queued tick
+	/// Called when the block gets ticked either by a random tick or by a queued tick. Blocks that need the random ticks must be marked in g_BlockIsRandomTicked[]
 	virtual void OnUpdate(cWorld *a_World, int a_BlockX, int a_BlockY, int a_BlockZ);
 
 	/** Called before a block is placed	into a world. 
@@ -63,28 +63,38 @@ sSetBlock::sSetBlock( int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_Bloc
 cChunk::cChunk(
 	int a_ChunkX, int a_ChunkY, int a_ChunkZ, 
 	cChunkMap * a_ChunkMap, cWorld * a_World,
-	cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP
+	cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP,
+	cFluidSimulatorData * a_WaterSimulatorData, cFluidSimulatorData * a_LavaSimulatorData,
+	cChunkBuffer * a_Data
 )
-	: m_PosX( a_ChunkX )
+	: m_IsValid(false)
+	, m_IsDirty(false)
+	, m_IsSaving(false)
+	, m_DirtySince(-1)
+	, m_CSWokenBlockEntities("Chunk block entity wakeups")
+	, m_StayCount(0)
+	, m_PosX( a_ChunkX )
 	, m_PosY( a_ChunkY )
 	, m_PosZ( a_ChunkZ )
-	, m_BlockTickX( 0 )
-	, m_BlockTickY( 0 )
-	, m_BlockTickZ( 0 )
 	, m_World( a_World )
 	, m_ChunkMap(a_ChunkMap)
-	, m_IsValid(false)
-	, m_IsLightValid(false)
-	, m_IsDirty(false)
-	, m_IsSaving(false)
-	, m_StayCount(0)
+	, m_CSData("Chunk data")
+	, m_Data(a_Data)
+	, m_BlockTickX( 0 )
+	, m_BlockTickY( -1 )
+	, m_BlockTickZ( 0 )
+	, m_NumRandomTicked(0)
+	, m_SolidBlocksGeneration(0)
 	, m_NeighborXM(a_NeighborXM)
 	, m_NeighborXP(a_NeighborXP)
 	, m_NeighborZM(a_NeighborZM)
 	, m_NeighborZP(a_NeighborZP)
-	, m_WaterSimulatorData(a_World->GetWaterSimulator()->CreateChunkData())
-	, m_LavaSimulatorData (a_World->GetLavaSimulator ()->CreateChunkData())
+	, m_WaterSimulatorData(a_WaterSimulatorData)
+	, m_LavaSimulatorData (a_LavaSimulatorData)
 {
+	m_Data->m_IsLightValid = false;
+	memset(m_NumRandomTickedInSection, 0, sizeof(m_NumRandomTickedInSection));
+	
 	if (a_NeighborXM != NULL)
 	{
 		a_NeighborXM->m_NeighborXP = this;
@@ -118,6 +128,7 @@ cChunk::~cChunk()
 		delete *itr;
 	}
 	m_BlockEntities.clear();
+	ClearActiveBlockEntities();
 
 	// Remove and destroy all entities that are not players:
 	cEntityList Entities;
@@ -147,8 +158,11 @@ cChunk::~cChunk()
 	{
 		m_NeighborZP->m_NeighborZM = NULL;
 	}
-	delete m_WaterSimulatorData;
-	delete m_LavaSimulatorData;
+	
+	// The simulator data is owned by the chunk pool, which recycles it for another chunk
+	
+	// The block data may still be used by snapshots; the pool takes its own reference if it wants to recycle it
+	m_Data->Release();
 }
 
 
@@ -157,7 +171,10 @@ cChunk::~cChunk()
 
 void cChunk::SetValid(void)
 {
-	m_IsValid = true;
+	{
+		cCSLock Lock(m_CSData);
+		m_IsValid = true;
+	}
 	
 	m_World->GetChunkMap()->ChunkValidated();
 }
@@ -188,6 +205,45 @@ bool cChunk::CanUnload(void)
 
 
 
+Int64 cChunk::UpdateDirtySince(Int64 a_WorldAge)
+{
+	if (!m_IsDirty)
+	{
+		m_DirtySince = -1;
+	}
+	else if (m_DirtySince < 0)
+	{
+		m_DirtySince = a_WorldAge;
+	}
+	return m_DirtySince;
+}
+
+
+
+
+
+void cChunk::GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers) const
+{
+	for (cBlockEntityList::const_iterator itr = m_BlockEntities.begin(), end = m_BlockEntities.end(); itr != end; ++itr)
+	{
+		bool IsHopper = ((*itr)->GetBlockType() == E_BLOCK_HOPPER);
+		if ((*itr)->IsActive())
+		{
+			a_NumActive += 1;
+			a_NumActiveHoppers += IsHopper ? 1 : 0;
+		}
+		else
+		{
+			a_NumSleeping += 1;
+			a_NumSleepingHoppers += IsHopper ? 1 : 0;
+		}
+	}
+}
+
+
+
+
+
 void cChunk::MarkSaving(void)
 {
 	m_IsSaving = true;
@@ -204,6 +260,9 @@ void cChunk::MarkSaved(void)
 		return;
 	}
 	m_IsDirty = false;
+	
+	// Any change from now on starts a new dirty period:
+	m_DirtySince = -1;
 }
 
 
@@ -213,6 +272,7 @@ void cChunk::MarkSaved(void)
 void cChunk::MarkLoaded(void)
 {
 	m_IsDirty = false;
+	m_DirtySince = -1;
 	SetValid();
 }
 
@@ -236,13 +296,19 @@ void cChunk::MarkLoadFailed(void)
 
 void cChunk::GetAllData(cChunkDataCallback & a_Callback)
 {
-	a_Callback.HeightMap    (&m_HeightMap);
-	a_Callback.BiomeData    (&m_BiomeMap);
-	a_Callback.BlockTypes   (m_BlockTypes);
-	a_Callback.BlockMeta    (m_BlockMeta);
-	a_Callback.LightIsValid (m_IsLightValid);
-	a_Callback.BlockLight   (m_BlockLight);
-	a_Callback.BlockSkyLight(m_BlockSkyLight);
+	// Callbacks that process the block data later, without the world locked, can take a snapshot instead of copying the data:
+	cChunkSnapshot Snapshot;
+	GetSnapshot(Snapshot);
+	if (!a_Callback.BlockDataSnapshot(Snapshot))
+	{
+		a_Callback.HeightMap    (&m_Data->m_HeightMap);
+		a_Callback.BiomeData    (&m_Data->m_BiomeMap);
+		a_Callback.BlockTypes   (m_Data->m_BlockTypes);
+		a_Callback.BlockMeta    (m_Data->m_BlockMeta);
+		a_Callback.LightIsValid (m_Data->m_IsLightValid);
+		a_Callback.BlockLight   (m_Data->m_BlockLight);
+		a_Callback.BlockSkyLight(m_Data->m_BlockSkyLight);
+	}
 	
 	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
 	{
@@ -259,6 +325,21 @@ void cChunk::GetAllData(cChunkDataCallback & a_Callback)
 
 
 
+bool cChunk::GetSnapshot(cChunkSnapshot & a_Snapshot)
+{
+	cCSLock Lock(m_CSData);
+	if (!m_IsValid)
+	{
+		return false;
+	}
+	a_Snapshot.Set(m_Data);
+	return true;
+}
+
+
+
+
+
 void cChunk::SetAllData(
 	const BLOCKTYPE *  a_BlockTypes, 
 	const NIBBLETYPE * a_BlockMeta,
@@ -269,42 +350,50 @@ void cChunk::SetAllData(
 	cBlockEntityList & a_BlockEntities
 )
 {
-	memcpy(m_BiomeMap, a_BiomeMap, sizeof(m_BiomeMap));
-	
-	if (a_HeightMap != NULL)
-	{
-		memcpy(m_HeightMap, a_HeightMap, sizeof(m_HeightMap));
-	}
-	
-	memcpy(m_BlockTypes, a_BlockTypes, sizeof(m_BlockTypes));
-	memcpy(m_BlockMeta,  a_BlockMeta,  sizeof(m_BlockMeta));
-	if (a_BlockLight != NULL)
-	{
-		memcpy(m_BlockLight, a_BlockLight, sizeof(m_BlockLight));
-	}
-	if (a_BlockSkyLight != NULL)
-	{
-		memcpy(m_BlockSkyLight, a_BlockSkyLight, sizeof(m_BlockSkyLight));
-	}
-	
-	m_IsLightValid = (a_BlockLight != NULL) && (a_BlockSkyLight != NULL);
-	
-	if (a_HeightMap == NULL)
 	{
-		CalculateHeightmap();
+		cCSLock Lock(m_CSData);
+		PrepareDataChange(false);
+		memcpy(m_Data->m_BiomeMap, a_BiomeMap, sizeof(m_Data->m_BiomeMap));
+		
+		if (a_HeightMap != NULL)
+		{
+			memcpy(m_Data->m_HeightMap, a_HeightMap, sizeof(m_Data->m_HeightMap));
+		}
+		
+		memcpy(m_Data->m_BlockTypes, a_BlockTypes, sizeof(m_Data->m_BlockTypes));
+		memcpy(m_Data->m_BlockMeta,  a_BlockMeta,  sizeof(m_Data->m_BlockMeta));
+		if (a_BlockLight != NULL)
+		{
+			memcpy(m_Data->m_BlockLight, a_BlockLight, sizeof(m_Data->m_BlockLight));
+		}
+		if (a_BlockSkyLight != NULL)
+		{
+			memcpy(m_Data->m_BlockSkyLight, a_BlockSkyLight, sizeof(m_Data->m_BlockSkyLight));
+		}
+		
+		m_Data->m_IsLightValid = (a_BlockLight != NULL) && (a_BlockSkyLight != NULL);
+		
+		if (a_HeightMap == NULL)
+		{
+			CalculateHeightmap();
+		}
 	}
+	CountRandomTickedBlocks();
+	m_SolidBlocksGeneration += 1;
 
 	// Clear the block entities present - either the loader / saver has better, or we'll create empty ones:
 	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
 	{
 		delete *itr;
 	}
+	ClearActiveBlockEntities();
 	std::swap(a_BlockEntities, m_BlockEntities);
 	
-	// Set all block entities' World variable:
+	// Set all block entities' World and Chunk variables:
 	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
 	{
 		(*itr)->SetWorld(m_World);
+		(*itr)->SetChunk(this);
 	}
 	
 	// Create block entities that the loader didn't load; fill them with defaults
@@ -330,9 +419,29 @@ void cChunk::SetLight(
 {
 	// TODO: We might get cases of wrong lighting when a chunk changes in the middle of a lighting calculation.
 	// Postponing until we see how bad it is :)
-	memcpy(m_BlockLight,    a_BlockLight, sizeof(m_BlockLight));
-	memcpy(m_BlockSkyLight, a_SkyLight,   sizeof(m_BlockSkyLight));
-	m_IsLightValid = true;
+	cCSLock Lock(m_CSData);
+	PrepareDataChange();
+	memcpy(m_Data->m_BlockLight,    a_BlockLight, sizeof(m_Data->m_BlockLight));
+	memcpy(m_Data->m_BlockSkyLight, a_SkyLight,   sizeof(m_Data->m_BlockSkyLight));
+	m_Data->m_IsLightValid = true;
+}
+
+
+
+
+
+void cChunk::PrepareDataChange(bool a_ShouldKeepData)
+{
+	if (!m_Data->IsShared())
+	{
+		// Only the chunk references the data, nobody can start sharing it while we hold m_CSData
+		return;
+	}
+	
+	// Snapshots are using the data, they keep the current buffer and the chunk continues in a new one:
+	cChunkBuffer * NewData = a_ShouldKeepData ? m_Data->Clone() : new cChunkBuffer;
+	m_Data->Release();
+	m_Data = NewData;
 }
 
 
@@ -341,7 +450,7 @@ void cChunk::SetLight(
 
 void cChunk::GetBlockTypes(BLOCKTYPE * a_BlockTypes)
 {
-	memcpy(a_BlockTypes, m_BlockTypes, NumBlocks);
+	memcpy(a_BlockTypes, m_Data->m_BlockTypes, NumBlocks);
 }
 
 
@@ -435,26 +544,36 @@ void cChunk::Stay(bool a_Stay)
 void cChunk::CollectMobCensus(cMobCensus& toFill)
 {
 	toFill.CollectSpawnableChunk(*this);
-	std::list<const Vector3d*> playerPositions;
-	cPlayer* currentPlayer;
-	for (cClientHandleList::iterator itr = m_LoadedByClient.begin(), end = m_LoadedByClient.end(); itr != end; ++itr)
-	{
-		currentPlayer = (*itr)->GetPlayer();
-		playerPositions.push_back(&(currentPlayer->GetPosition()));
-	} 
 
 	Vector3d currentPosition;
 	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
 	{
 		//LOGD("Counting entity #%i (%s)", (*itr)->GetUniqueID(), (*itr)->GetClass());
-		if ((*itr)->IsMob())
+		if (!(*itr)->IsMob())
 		{
-			cMonster& Monster = (cMonster&)(**itr);
-			currentPosition = Monster.GetPosition();
-			for (std::list<const Vector3d*>::const_iterator itr2 = playerPositions.begin(); itr2 != playerPositions.end(); itr2 ++)
+			continue;
+		}
+
+		// Collect each mob only once, with the distance to the closest player that has loaded this chunk:
+		cMonster& Monster = (cMonster&)(**itr);
+		currentPosition = Monster.GetPosition();
+		double ClosestDistance = -1;
+		for (cClientHandleList::const_iterator itr2 = m_LoadedByClient.begin(), end = m_LoadedByClient.end(); itr2 != end; ++itr2)
+		{
+			cPlayer * currentPlayer = (*itr2)->GetPlayer();
+			if (currentPlayer == NULL)
 			{
-				toFill.CollectMob(Monster,*this,(currentPosition-**itr2).SqrLength());
+				continue;
 			}
+			double Distance = (currentPosition - currentPlayer->GetPosition()).SqrLength();
+			if ((ClosestDistance < 0) || (Distance < ClosestDistance))
+			{
+				ClosestDistance = Distance;
+			}
+		}
+		if (ClosestDistance >= 0)
+		{
+			toFill.CollectMob(Monster, *this, ClosestDistance);
 		}
 	}  // for itr - m_Entitites[]
 }
@@ -577,11 +696,10 @@ void cChunk::Tick(float a_Dt)
 	
 	TickBlocks();
 
-	// Tick all block entities in this chunk:
-	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
-	{
-		m_IsDirty = (*itr)->Tick(a_Dt, *this) | m_IsDirty;
-	}
+	TickBlockEntities(a_Dt);
+	
+	// Move all the simple entities at once; the rest are moved by their Tick():
+	m_ChunkMap->GetPhysicsBatch().Tick(a_Dt, *this, m_Entities);
 	
 	// Tick all entities in this chunk (except mobs):
 	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
@@ -744,41 +862,66 @@ void cChunk::CheckBlocks(void)
 
 void cChunk::TickBlocks(void)
 {
-	// Tick dem blocks
-	// _X: We must limit the random number or else we get a nasty int overflow bug ( http://forum.mc-server.org/showthread.php?tid=457 )
-	int RandomX = m_World->GetTickRandomNumber(0x00ffffff);
-	int RandomY = m_World->GetTickRandomNumber(0x00ffffff);
-	int RandomZ = m_World->GetTickRandomNumber(0x00ffffff);
-	int TickX = m_BlockTickX;
-	int TickY = m_BlockTickY;
-	int TickZ = m_BlockTickZ;
-
-	// This for loop looks disgusting, but it actually does a simple thing - first processes m_BlockTick, then adds random to it
-	// This is so that SetNextBlockTick() works
-	for (int i = 0; i < 50; i++,
-	
-		// This weird construct (*2, then /2) is needed,
-		// otherwise the blocktick distribution is too biased towards even coords!
-		
-		TickX = (TickX + RandomX) % (Width * 2),
-		TickY = (TickY + RandomY) % (Height * 2),
-		TickZ = (TickZ + RandomZ) % (Width * 2),
-		m_BlockTickX = TickX / 2,
-		m_BlockTickY = TickY / 2,
-		m_BlockTickZ = TickZ / 2
-	)
+	int BaseX = m_PosX * Width;
+	int BaseZ = m_PosZ * Width;
+	
+	// Tick the block requested by SetNextBlockTick(), whatever it is:
+	if (m_BlockTickY >= 0)
 	{
-
-		if (m_BlockTickY > cChunkDef::GetHeight(m_HeightMap, m_BlockTickX, m_BlockTickZ))
+		int BlockY = m_BlockTickY;
+		m_BlockTickY = -1;
+		cBlockHandler * Handler = BlockHandler(m_Data->m_BlockTypes[MakeIndexNoCheck(m_BlockTickX, BlockY, m_BlockTickZ)]);
+		ASSERT(Handler != NULL);  // Happenned on server restart, FS #243
+		Handler->OnUpdate(m_World, m_BlockTickX + BaseX, BlockY, m_BlockTickZ + BaseZ);
+	}
+	
+	if (m_NumRandomTicked == 0)
+	{
+		// Nothing in the chunk reacts to random ticks
+		return;
+	}
+	
+	// The blocks are XZY-ordered, so each section is a continuous part of the array and a random index in a section is a random block:
+	for (int Section = 0; Section < NumSections; Section++)
+	{
+		if (m_NumRandomTickedInSection[Section] == 0)
 		{
-			continue; // It's all air up here
+			continue;
 		}
+		for (int i = 0; i < RandomTicksPerSection; i++)
+		{
+			int SectionIdx = m_World->GetTickRandomNumber(SectionVolume - 1);
+			BLOCKTYPE BlockType = m_Data->m_BlockTypes[Section * SectionVolume + SectionIdx];
+			if (!g_BlockIsRandomTicked[BlockType])
+			{
+				continue;
+			}
+			int RelX = SectionIdx % Width;
+			int RelZ = (SectionIdx / Width) % Width;
+			int RelY = Section * SectionHeight + SectionIdx / (Width * Width);
+			BlockHandler(BlockType)->OnUpdate(m_World, RelX + BaseX, RelY, RelZ + BaseZ);
+		}  // for i - random ticks
+	}  // for Section
+}
 
-		unsigned int Index = MakeIndexNoCheck(m_BlockTickX, m_BlockTickY, m_BlockTickZ);
-		cBlockHandler * Handler = BlockHandler(m_BlockTypes[Index]);
-		ASSERT(Handler != NULL);  // Happenned on server restart, FS #243
-		Handler->OnUpdate(m_World, m_BlockTickX + m_PosX * Width, m_BlockTickY, m_BlockTickZ + m_PosZ * Width);
-	}  // for i - tickblocks
+
+
+
+
+void cChunk::CountRandomTickedBlocks(void)
+{
+	m_NumRandomTicked = 0;
+	for (int Section = 0; Section < NumSections; Section++)
+	{
+		const BLOCKTYPE * BlockTypes = m_Data->m_BlockTypes + Section * SectionVolume;
+		int Count = 0;
+		for (int i = 0; i < SectionVolume; i++)
+		{
+			Count += g_BlockIsRandomTicked[BlockTypes[i]] ? 1 : 0;
+		}
+		m_NumRandomTickedInSection[Section] = Count;
+		m_NumRandomTicked += Count;
+	}
 }
 
 
@@ -1240,7 +1383,7 @@ int cChunk::GetHeight(int a_X, int a_Z)
 	
 	if ((a_X >= 0) && (a_X < Width) && (a_Z >= 0) && (a_Z < Width))
 	{
-		return m_HeightMap[a_X + a_Z * Width];
+		return m_Data->m_HeightMap[a_X + a_Z * Width];
 	}
 	return 0;
 }
@@ -1257,7 +1400,7 @@ void cChunk::CreateBlockEntities(void)
 		{
 			for (int y = 0; y < Height; y++)
 			{
-				BLOCKTYPE BlockType = cChunkDef::GetBlock(m_BlockTypes, x, y, z);
+				BLOCKTYPE BlockType = cChunkDef::GetBlock(m_Data->m_BlockTypes, x, y, z);
 				switch (BlockType)
 				{
 					case E_BLOCK_CHEST:
@@ -1273,10 +1416,12 @@ void cChunk::CreateBlockEntities(void)
 					{
 						if (!HasBlockEntityAt(x + m_PosX * Width, y + m_PosY * Height, z + m_PosZ * Width))
 						{
-							m_BlockEntities.push_back(cBlockEntity::CreateByBlockType(
+							cBlockEntity * BlockEntity = cBlockEntity::CreateByBlockType(
 								BlockType, GetMeta(x, y, z),
 								x + m_PosX * Width, y + m_PosY * Height, z + m_PosZ * Width, m_World
-							));
+							);
+							m_BlockEntities.push_back(BlockEntity);
+							BlockEntity->SetChunk(this);
 						}
 						break;
 					}
@@ -1304,7 +1449,7 @@ void cChunk::WakeUpSimulators(void)
 			int BlockZ = z + BaseZ;
 			for (int y = GetHeight(x, z); y >= 0; y--)
 			{
-				switch (cChunkDef::GetBlock(m_BlockTypes, x, y, z))
+				switch (cChunkDef::GetBlock(m_Data->m_BlockTypes, x, y, z))
 				{
 					case E_BLOCK_WATER:
 					{
@@ -1328,6 +1473,8 @@ void cChunk::WakeUpSimulators(void)
 
 void cChunk::CalculateHeightmap()
 {
+	cCSLock Lock(m_CSData);
+	PrepareDataChange();
 	for (int x = 0; x < Width; x++)
 	{
 		for (int z = 0; z < Width; z++)
@@ -1335,9 +1482,9 @@ void cChunk::CalculateHeightmap()
 			for (int y = Height - 1; y > -1; y--)
 			{
 				int index = MakeIndex( x, y, z );
-				if (m_BlockTypes[index] != E_BLOCK_AIR)
+				if (m_Data->m_BlockTypes[index] != E_BLOCK_AIR)
 				{
-					m_HeightMap[x + z * Width] = (unsigned char)y;
+					m_Data->m_HeightMap[x + z * Width] = (unsigned char)y;
 					break;
 				}
 			}  // for y
@@ -1378,6 +1525,13 @@ void cChunk::SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType,
 		case E_BLOCK_LIT_FURNACE:
 		case E_BLOCK_FURNACE:
 		case E_BLOCK_HOPPER:
+		{
+			AddBlockEntity(cBlockEntity::CreateByBlockType(a_BlockType, a_BlockMeta, WorldPos.x, WorldPos.y, WorldPos.z, m_World));
+			
+			// The hoppers around may have a new container to move items from or to:
+			WakeUpHoppersAround(a_RelX, a_RelY, a_RelZ);
+			break;
+		}
 		case E_BLOCK_SIGN_POST:
 		case E_BLOCK_WALLSIGN:
 		case E_BLOCK_NOTE_BLOCK:
@@ -1393,6 +1547,41 @@ void cChunk::SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType,
 
 
 
+void cChunk::WakeUpHoppersAround(int a_RelX, int a_RelY, int a_RelZ)
+{
+	// A container is the source of the hopper below it and the destination of the hoppers next to it and above it.
+	// A chest can also be the other half of a double chest, so check the hoppers around its neighbors, too:
+	for (int y = a_RelY - 1; y <= a_RelY + 1; y++)
+	{
+		if ((y < 0) || (y >= Height))
+		{
+			continue;
+		}
+		for (int z = a_RelZ - 2; z <= a_RelZ + 2; z++)
+		{
+			for (int x = a_RelX - 2; x <= a_RelX + 2; x++)
+			{
+				int RelX = x;
+				int RelZ = z;
+				cChunk * Chunk = GetRelNeighborChunkAdjustCoords(RelX, RelZ);
+				if ((Chunk == NULL) || !Chunk->IsValid() || (Chunk->GetBlock(RelX, y, RelZ) != E_BLOCK_HOPPER))
+				{
+					continue;
+				}
+				cHopperEntity * Hopper = (cHopperEntity *)Chunk->GetBlockEntity(x + m_PosX * Width, y, z + m_PosZ * Width);
+				if (Hopper != NULL)
+				{
+					Hopper->InvalidateLinks();
+				}
+			}  // for x
+		}  // for z
+	}  // for y
+}
+
+
+
+
+
 void cChunk::QueueSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, Int64 a_Tick)
 {
 	m_SetBlockQueue.push_back(sSetBlockQueueItem(a_RelX, a_RelY, a_RelZ, a_BlockType, a_BlockMeta, a_Tick));
@@ -1454,16 +1643,14 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 	ASSERT(IsValid());
 	
 	const int index = MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	const BLOCKTYPE OldBlockType = cChunkDef::GetBlock(m_BlockTypes, index);
-	const BLOCKTYPE OldBlockMeta = GetNibble(m_BlockMeta, index);
+	const BLOCKTYPE OldBlockType = cChunkDef::GetBlock(m_Data->m_BlockTypes, index);
+	const BLOCKTYPE OldBlockMeta = GetNibble(m_Data->m_BlockMeta, index);
 	if ((OldBlockType == a_BlockType) && (OldBlockMeta == a_BlockMeta))
 	{
 		return;
 	}
 
 	MarkDirty();
-	
-	m_BlockTypes[index] = a_BlockType;
 
 	// The client doesn't need to distinguish between stationary and nonstationary fluids:
 	if (
@@ -1479,7 +1666,22 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 		m_PendingSendBlocks.push_back(sSetBlock(m_PosX, m_PosZ, a_RelX, a_RelY, a_RelZ, a_BlockType, a_BlockMeta));
 	}
 	
-	SetNibble(m_BlockMeta, index, a_BlockMeta);
+	if (g_BlockIsRandomTicked[OldBlockType] != g_BlockIsRandomTicked[a_BlockType])
+	{
+		int Delta = g_BlockIsRandomTicked[a_BlockType] ? 1 : -1;
+		m_NumRandomTickedInSection[a_RelY / SectionHeight] += Delta;
+		m_NumRandomTicked += Delta;
+	}
+	if (g_BlockIsSolid[OldBlockType] != g_BlockIsSolid[a_BlockType])
+	{
+		m_SolidBlocksGeneration += 1;
+	}
+	
+	// The rest only changes the block data, keep the background readers out for that:
+	cCSLock Lock(m_CSData);
+	PrepareDataChange();
+	m_Data->m_BlockTypes[index] = a_BlockType;
+	SetNibble(m_Data->m_BlockMeta, index, a_BlockMeta);
 
 	// ONLY recalculate lighting if it's necessary!
 	if(
@@ -1488,23 +1690,23 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 		(g_BlockTransparent[OldBlockType]        != g_BlockTransparent[a_BlockType])
 	)
 	{
-		m_IsLightValid = false;
+		m_Data->m_IsLightValid = false;
 	}
 
 	// Update heightmap, if needed:
-	if (a_RelY >= m_HeightMap[a_RelX + a_RelZ * Width])
+	if (a_RelY >= m_Data->m_HeightMap[a_RelX + a_RelZ * Width])
 	{
 		if (a_BlockType != E_BLOCK_AIR)
 		{
-			m_HeightMap[a_RelX + a_RelZ * Width] = (unsigned char)a_RelY;
+			m_Data->m_HeightMap[a_RelX + a_RelZ * Width] = (unsigned char)a_RelY;
 		}
 		else
 		{
 			for (int y = a_RelY - 1; y > 0; --y)
 			{
-				if (m_BlockTypes[MakeIndexNoCheck(a_RelX, y, a_RelZ)] != E_BLOCK_AIR)
+				if (m_Data->m_BlockTypes[MakeIndexNoCheck(a_RelX, y, a_RelZ)] != E_BLOCK_AIR)
 				{
-					m_HeightMap[a_RelX + a_RelZ * Width] = (unsigned char)y;
+					m_Data->m_HeightMap[a_RelX + a_RelZ * Width] = (unsigned char)y;
 					break;
 				}
 			}  // for y - column in m_BlockData
@@ -1550,6 +1752,7 @@ void cChunk::AddBlockEntity(cBlockEntity * a_BlockEntity)
 {
 	MarkDirty();
 	m_BlockEntities.push_back(a_BlockEntity);
+	a_BlockEntity->SetChunk(this);
 }
 
 
@@ -1670,6 +1873,79 @@ void cChunk::RemoveBlockEntity( cBlockEntity* a_BlockEntity )
 {
 	MarkDirty();
 	m_BlockEntities.remove(a_BlockEntity);
+	
+	// The entity is going to be deleted, make sure it isn't ticked anymore:
+	a_BlockEntity->SetChunk(NULL);
+	if (a_BlockEntity->m_IsInActiveList)
+	{
+		m_ActiveBlockEntities.remove(a_BlockEntity);
+		a_BlockEntity->m_IsInActiveList = false;
+	}
+	cCSLock Lock(m_CSWokenBlockEntities);
+	m_WokenBlockEntities.remove(a_BlockEntity);
+}
+
+
+
+
+
+void cChunk::QueueBlockEntityWakeUp(cBlockEntity * a_BlockEntity)
+{
+	cCSLock Lock(m_CSWokenBlockEntities);
+	m_WokenBlockEntities.push_back(a_BlockEntity);
+}
+
+
+
+
+
+void cChunk::TickBlockEntities(float a_Dt)
+{
+	// Start ticking the block entities that have been woken up since the last tick:
+	cBlockEntityList Woken;
+	{
+		cCSLock Lock(m_CSWokenBlockEntities);
+		std::swap(Woken, m_WokenBlockEntities);
+	}
+	for (cBlockEntityList::iterator itr = Woken.begin(), end = Woken.end(); itr != end; ++itr)
+	{
+		// The entity may have gone to sleep in the last tick after being woken up, so make it active again:
+		(*itr)->m_IsActive = true;
+		
+		// An entity may be woken up several times, but mustn't be added twice:
+		if (!(*itr)->m_IsInActiveList)
+		{
+			(*itr)->m_IsInActiveList = true;
+			m_ActiveBlockEntities.push_back(*itr);
+		}
+	}
+	
+	// Tick the active block entities, drop the ones that went to sleep:
+	for (cBlockEntityList::iterator itr = m_ActiveBlockEntities.begin(); itr != m_ActiveBlockEntities.end();)
+	{
+		cBlockEntity * BlockEntity = *itr;
+		m_IsDirty = BlockEntity->Tick(a_Dt, *this) | m_IsDirty;
+		if (BlockEntity->IsActive())
+		{
+			++itr;
+		}
+		else
+		{
+			BlockEntity->m_IsInActiveList = false;
+			itr = m_ActiveBlockEntities.erase(itr);
+		}
+	}
+}
+
+
+
+
+
+void cChunk::ClearActiveBlockEntities(void)
+{
+	m_ActiveBlockEntities.clear();
+	cCSLock Lock(m_CSWokenBlockEntities);
+	m_WokenBlockEntities.clear();
 }
 
 
@@ -1762,6 +2038,7 @@ void cChunk::AddEntity(cEntity * a_Entity)
 	ASSERT(std::find(m_Entities.begin(), m_Entities.end(), a_Entity) == m_Entities.end());  // Not there already
 	
 	m_Entities.push_back(a_Entity);
+	a_Entity->InvalidatePhysicsBatchCache();
 }
 
 
@@ -2172,7 +2449,7 @@ BLOCKTYPE cChunk::GetBlock(int a_RelX, int a_RelY, int a_RelZ) const
 		return 0; // Clip
 	}
 
-	return m_BlockTypes[MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ)];
+	return m_Data->m_BlockTypes[MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ)];
 }
 
 
@@ -2187,7 +2464,7 @@ BLOCKTYPE cChunk::GetBlock(int a_BlockIdx) const
 		return 0;
 	}
 	
-	return m_BlockTypes[ a_BlockIdx ];
+	return m_Data->m_BlockTypes[ a_BlockIdx ];
 }
 
 
@@ -2197,8 +2474,8 @@ BLOCKTYPE cChunk::GetBlock(int a_BlockIdx) const
 void cChunk::GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
 {
 	int Idx = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	a_BlockType = cChunkDef::GetBlock (m_BlockTypes, a_RelX, a_RelY, a_RelZ);
-	a_BlockMeta = cChunkDef::GetNibble(m_BlockMeta, a_RelX, a_RelY, a_RelZ);
+	a_BlockType = cChunkDef::GetBlock (m_Data->m_BlockTypes, a_RelX, a_RelY, a_RelZ);
+	a_BlockMeta = cChunkDef::GetNibble(m_Data->m_BlockMeta, a_RelX, a_RelY, a_RelZ);
 }
 
 
@@ -2208,10 +2485,10 @@ void cChunk::GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_
 void cChunk::GetBlockInfo(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta, NIBBLETYPE & a_SkyLight, NIBBLETYPE & a_BlockLight)
 {
 	int Idx = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	a_BlockType  = cChunkDef::GetBlock (m_BlockTypes,    Idx);
-	a_Meta       = cChunkDef::GetNibble(m_BlockMeta,     Idx);
-	a_SkyLight   = cChunkDef::GetNibble(m_BlockSkyLight, Idx);
-	a_BlockLight = cChunkDef::GetNibble(m_BlockLight,    Idx);
+	a_BlockType  = cChunkDef::GetBlock (m_Data->m_BlockTypes,    Idx);
+	a_Meta       = cChunkDef::GetNibble(m_Data->m_BlockMeta,     Idx);
+	a_SkyLight   = cChunkDef::GetNibble(m_Data->m_BlockSkyLight, Idx);
+	a_BlockLight = cChunkDef::GetNibble(m_Data->m_BlockLight,    Idx);
 }
 
 
@@ -2692,6 +2969,26 @@ void cChunk::SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClientHa
 
 
 
+void cChunk::SendBlockEntities(cClientHandle * a_Client)
+{
+	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
+	{
+		if (a_Client != NULL)
+		{
+			(*itr)->SendTo(*a_Client);
+			continue;
+		}
+		for (cClientHandleList::iterator itrC = m_LoadedByClient.begin(); itrC != m_LoadedByClient.end(); ++itrC)
+		{
+			(*itr)->SendTo(*(*itrC));
+		}  // for itrC - m_LoadedByClient[]
+	}  // for itr - m_BlockEntities[]
+}
+
+
+
+
+
 void cChunk::PositionToWorldPosition(int a_RelX, int a_RelY, int a_RelZ, int & a_BlockX, int & a_BlockY, int & a_BlockZ)
 {
 	a_BlockY = a_RelY;
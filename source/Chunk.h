@@ -3,6 +3,7 @@
 
 #include "Entities/Entity.h"
 #include "ChunkDef.h"
+#include "ChunkSnapshot.h"
 
 #include "Simulator/FireSimulator.h"
 #include "Simulator/SandSimulator.h"
@@ -71,7 +72,9 @@ public:
 	cChunk(
 		int a_ChunkX, int a_ChunkY, int a_ChunkZ,   // Chunk coords
 		cChunkMap * a_ChunkMap, cWorld * a_World,   // Parent objects
-		cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP  // Neighbor chunks
+		cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP,  // Neighbor chunks
+		cFluidSimulatorData * a_WaterSimulatorData, cFluidSimulatorData * a_LavaSimulatorData,  // Simulator data, owned by the cChunkPool that created the chunk
+		cChunkBuffer * a_Data  // Block data storage, the chunk takes over the reference
 	);
 	~cChunk();
 
@@ -79,10 +82,19 @@ public:
 	void SetValid(void);                           // Also wakes up any calls to cChunkMap::GetHeight()
 	void MarkRegenerating(void);                   // Marks all clients attached to this chunk as wanting this chunk
 	bool IsDirty(void) const {return m_IsDirty; }  // Returns true if the chunk has changed since it was last saved
+	
+	/** Returns the world age (in ticks) since which the chunk has been dirty, or -1 if it is not dirty.
+	The dirty time is only noticed by this function; a_WorldAge is the current world age, recorded if the chunk became dirty since the last call.
+	*/
+	Int64 UpdateDirtySince(Int64 a_WorldAge);
+	
+	/// Adds the number of active and sleeping block entities, and of those the hoppers, in the chunk to the counters
+	void GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers) const;
+	
 	bool HasLoadFailed(void) const {return m_HasLoadFailed; }  // Returns true if the chunk failed to load and hasn't been generated since then
 	bool CanUnload(void);
 	
-	bool IsLightValid(void) const {return m_IsLightValid; }
+	bool IsLightValid(void) const {return m_Data->m_IsLightValid; }
 	
 	/*
 	To save a chunk, the WSSchema must:
@@ -99,6 +111,11 @@ public:
 	/// Gets all chunk data, calls the a_Callback's methods for each data type
 	void GetAllData(cChunkDataCallback & a_Callback);
 	
+	/** Takes a read-only snapshot of the chunk's block data (heightmap, biomes, block types and metas, light); returns false if the chunk is not valid.
+	Safe to call from any thread that has the chunk located under cChunkMap's m_CSChunks; locks m_CSData only to reference the data.
+	*/
+	bool GetSnapshot(cChunkSnapshot & a_Snapshot);
+	
 	/// Sets all chunk data
 	void SetAllData(
 		const BLOCKTYPE *  a_BlockTypes, 
@@ -179,7 +196,7 @@ public:
 	*/
 	cChunk * GetRelNeighborChunkAdjustCoords(int & a_RelX, int & a_RelZ) const;
 	
-	EMCSBiome GetBiomeAt(int a_RelX, int a_RelZ) const {return cChunkDef::GetBiome(m_BiomeMap, a_RelX, a_RelZ); }
+	EMCSBiome GetBiomeAt(int a_RelX, int a_RelZ) const {return cChunkDef::GetBiome(m_Data->m_BiomeMap, a_RelX, a_RelZ); }
 	
 	void CollectPickupsByPlayer(cPlayer * a_Player);
 	
@@ -241,6 +258,9 @@ public:
 	bool GetSignLines (int a_BlockX, int a_BlockY, int a_BlockZ, AString & a_Line1, AString & a_Line2, AString & a_Line3, AString & a_Line4);  // Lua-accessible
 
 	void UseBlockEntity(cPlayer * a_Player, int a_X, int a_Y, int a_Z);  // [x, y, z] in world block coords
+	
+	/// Queues the block entity to be added to the ticked ones in the next tick. Called by cBlockEntity::WakeUp() from any thread.
+	void QueueBlockEntityWakeUp(cBlockEntity * a_BlockEntity);
 
 	void CalculateLighting(); // Recalculate right now
 	void CalculateHeightmap();
@@ -270,6 +290,9 @@ public:
 	void BroadcastUseBed             (const cEntity & a_Entity, int a_BlockX, int a_BlockY, int a_BlockZ );
 	
 	void SendBlockEntity             (int a_BlockX, int a_BlockY, int a_BlockZ, cClientHandle & a_Client);
+	
+	/// Sends all the block entities in the chunk to a_Client, or to all the chunk's clients if a_Client is NULL
+	void SendBlockEntities           (cClientHandle * a_Client);
 
 	Vector3i PositionToWorldPosition(const Vector3i & a_RelPos)
 	{
@@ -285,6 +308,9 @@ public:
 		m_IsSaving = false;
 	}
 	
+	/// Returns a number that changes whenever any block in the chunk changes between solid and non-solid
+	UInt32 GetSolidBlocksGeneration(void) const { return m_SolidBlocksGeneration; }
+	
 	/// Sets the blockticking to start at the specified block. Only one blocktick may be set, second call overwrites the first call
 	inline void SetNextBlockTick(int a_RelX, int a_RelY, int a_RelZ)
 	{
@@ -293,15 +319,15 @@ public:
 		m_BlockTickZ = a_RelZ;
 	}
 	
-	inline NIBBLETYPE GetMeta(int a_RelX, int a_RelY, int a_RelZ) const              {return cChunkDef::GetNibble(m_BlockMeta, a_RelX, a_RelY, a_RelZ); }
-	inline NIBBLETYPE GetMeta(int a_BlockIdx) const                                  {return cChunkDef::GetNibble(m_BlockMeta, a_BlockIdx); }
-	inline void       SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta) {       cChunkDef::SetNibble(m_BlockMeta, a_RelX, a_RelY, a_RelZ, a_Meta); }
-	inline void       SetMeta(int a_BlockIdx, NIBBLETYPE a_Meta)                     {       cChunkDef::SetNibble(m_BlockMeta, a_BlockIdx, a_Meta); }
+	inline NIBBLETYPE GetMeta(int a_RelX, int a_RelY, int a_RelZ) const              {return cChunkDef::GetNibble(m_Data->m_BlockMeta, a_RelX, a_RelY, a_RelZ); }
+	inline NIBBLETYPE GetMeta(int a_BlockIdx) const                                  {return cChunkDef::GetNibble(m_Data->m_BlockMeta, a_BlockIdx); }
+	inline void       SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta) {cCSLock Lock(m_CSData); PrepareDataChange(); cChunkDef::SetNibble(m_Data->m_BlockMeta, a_RelX, a_RelY, a_RelZ, a_Meta); }
+	inline void       SetMeta(int a_BlockIdx, NIBBLETYPE a_Meta)                     {cCSLock Lock(m_CSData); PrepareDataChange(); cChunkDef::SetNibble(m_Data->m_BlockMeta, a_BlockIdx, a_Meta); }
 
-	inline NIBBLETYPE GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const {return cChunkDef::GetNibble(m_BlockLight, a_RelX, a_RelY, a_RelZ); }
-	inline NIBBLETYPE GetSkyLight  (int a_RelX, int a_RelY, int a_RelZ) const {return cChunkDef::GetNibble(m_BlockSkyLight, a_RelX, a_RelY, a_RelZ); }
-	inline NIBBLETYPE GetBlockLight(int a_Idx) const {return cChunkDef::GetNibble(m_BlockLight, a_Idx); }
-	inline NIBBLETYPE GetSkyLight  (int a_Idx) const {return cChunkDef::GetNibble(m_BlockSkyLight, a_Idx); }
+	inline NIBBLETYPE GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const {return cChunkDef::GetNibble(m_Data->m_BlockLight, a_RelX, a_RelY, a_RelZ); }
+	inline NIBBLETYPE GetSkyLight  (int a_RelX, int a_RelY, int a_RelZ) const {return cChunkDef::GetNibble(m_Data->m_BlockSkyLight, a_RelX, a_RelY, a_RelZ); }
+	inline NIBBLETYPE GetBlockLight(int a_Idx) const {return cChunkDef::GetNibble(m_Data->m_BlockLight, a_Idx); }
+	inline NIBBLETYPE GetSkyLight  (int a_Idx) const {return cChunkDef::GetNibble(m_Data->m_BlockSkyLight, a_Idx); }
 	
 	/// Same as GetBlock(), but relative coords needn't be in this chunk (uses m_Neighbor-s or m_ChunkMap in such a case); returns true on success
 	bool UnboundedRelGetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const;
@@ -338,6 +364,7 @@ public:
 	cFireSimulatorChunkData & GetFireSimulatorData (void) { return m_FireSimulatorData; }
 	cFluidSimulatorData *     GetWaterSimulatorData(void) { return m_WaterSimulatorData; }
 	cFluidSimulatorData *     GetLavaSimulatorData (void) { return m_LavaSimulatorData; }
+	cChunkBuffer *            GetData              (void) { return m_Data; }
 	cSandSimulatorChunkData & GetSandSimulatorData (void) { return m_SandSimulatorData; }
 	cRedstoneSimulatorChunkData & GetRedstoneSimulatorData(void) { return m_RedstoneSimulatorData; }
 
@@ -348,6 +375,12 @@ private:
 
 	friend class cChunkMap;
 	
+	// The random block ticks are done per 16-block high section, with 3 random picks per section in each tick, like vanilla does:
+	static const int SectionHeight = 16;
+	static const int NumSections   = cChunkDef::Height / SectionHeight;
+	static const int SectionVolume = cChunkDef::Width * cChunkDef::Width * SectionHeight;
+	static const int RandomTicksPerSection = 3;
+	
 	struct sSetBlockQueueItem
 	{
 		int m_RelX, m_RelY, m_RelZ;
@@ -365,10 +398,10 @@ private:
 	
 
 	bool m_IsValid;        // True if the chunk is loaded / generated
-	bool m_IsLightValid;   // True if the blocklight and skylight are calculated
 	bool m_IsDirty;        // True if the chunk has changed since it was last saved
 	bool m_IsSaving;       // True if the chunk is being saved
 	bool m_HasLoadFailed;  // True if chunk failed to load and hasn't been generated yet since then
+	Int64 m_DirtySince;    // World age (in ticks) when the chunk was first noticed to be dirty by UpdateDirtySince(), -1 if not dirty since the last save / load
 	
 	std::vector<unsigned int> m_ToTickBlocks;
 	sSetBlockVector           m_PendingSendBlocks;  ///< Blocks that have changed and need to be sent to all clients
@@ -381,6 +414,15 @@ private:
 	cEntityList        m_Entities;
 	cBlockEntityList   m_BlockEntities;
 	
+	/// The block entities that are ticked, a subset of m_BlockEntities; the rest sleep until they are woken up
+	cBlockEntityList   m_ActiveBlockEntities;
+	
+	/// The block entities woken up since the last tick, to be added to m_ActiveBlockEntities. Protected by m_CSWokenBlockEntities.
+	cBlockEntityList   m_WokenBlockEntities;
+	
+	/// Guards m_WokenBlockEntities, the block entities may be woken up from other threads. Nothing else is locked while holding it.
+	cCriticalSection   m_CSWokenBlockEntities;
+	
 	/// Number of times the chunk has been requested to stay (by various cChunkStay objects); if zero, the chunk can be unloaded
 	int m_StayCount;
 
@@ -388,17 +430,27 @@ private:
 	cWorld *    m_World;
 	cChunkMap * m_ChunkMap;
 
-	// TODO: Make these pointers and don't allocate what isn't needed
-	BLOCKTYPE  m_BlockTypes   [cChunkDef::NumBlocks];
-	NIBBLETYPE m_BlockMeta    [cChunkDef::NumBlocks / 2];
-	NIBBLETYPE m_BlockLight   [cChunkDef::NumBlocks / 2];
-	NIBBLETYPE m_BlockSkyLight[cChunkDef::NumBlocks / 2];
+	/** Guards m_Data (the pointer and, together with m_IsValid, the changes to the data) against the background readers taking snapshots.
+	All writers already hold the chunkmap's m_CSLayers, so they lock this only around the actual changes and can read without locking.
+	Never held while calling out of the chunk; it is the innermost lock, see the lock order in ChunkMap.h.
+	*/
+	cCriticalSection m_CSData;
 
-	cChunkDef::HeightMap m_HeightMap;
-	cChunkDef::BiomeMap  m_BiomeMap;
+	/** The block data (block types, metas, light, heightmap, biomes), shared with the snapshots.
+	Any change to it must be done with m_CSData locked and after calling PrepareDataChange().
+	*/
+	cChunkBuffer * m_Data;
 
+	/// The block to tick first in the next TickBlocks(), set by SetNextBlockTick(); m_BlockTickY is -1 if none
 	int m_BlockTickX, m_BlockTickY, m_BlockTickZ;
 	
+	/// Number of randomly ticked blocks (g_BlockIsRandomTicked[]) in each section and in the whole chunk; only these sections get random ticks
+	int m_NumRandomTickedInSection[NumSections];
+	int m_NumRandomTicked;
+	
+	/// Incremented whenever a block changes between solid and non-solid (g_BlockIsSolid[]), see GetSolidBlocksGeneration()
+	UInt32 m_SolidBlocksGeneration;
+	
 	cChunk * m_NeighborXM;  // Neighbor at [X - 1, Z]
 	cChunk * m_NeighborXP;  // Neighbor at [X + 1, Z]
 	cChunk * m_NeighborZM;  // Neighbor at [X,     Z - 1]
@@ -417,13 +469,30 @@ private:
 	void getThreeRandomNumber(int& a_X, int& a_Y, int& a_Z,int a_MaxX, int a_MaxY, int a_MaxZ);
 
 	void RemoveBlockEntity(cBlockEntity * a_BlockEntity);
+	
+	/// Adds the woken up block entities to the ticked ones, then ticks them; the ones that went to sleep are removed from the ticked ones
+	void TickBlockEntities(float a_Dt);
+	
+	/// Forgets the ticked and the woken up block entities; called after the block entities are deleted, since deleting them may wake up others
+	void ClearActiveBlockEntities(void);
+	
 	void AddBlockEntity   (cBlockEntity * a_BlockEntity);
 
 	void SpreadLightOfBlock(NIBBLETYPE * a_LightBuffer, int a_X, int a_Y, int a_Z, char a_Falloff);
 
+	/** Makes m_Data safe to change: if any snapshot references it, the chunk switches to a copy of it
+	(or to an uninitialized buffer, if a_ShouldKeepData is false and the caller overwrites all the data). Assumes m_CSData is locked.
+	*/
+	void PrepareDataChange(bool a_ShouldKeepData = true);
+
 	/// Creates a block entity for each block that needs a block entity and doesn't have one in the list
 	void CreateBlockEntities(void);
 	
+	/** Makes the hoppers that may move items from or to a container at the specified coords look up their containers again.
+	Called when a container block entity is created; the removed ones notify their hoppers through their item grids.
+	*/
+	void WakeUpHoppersAround(int a_RelX, int a_RelY, int a_RelZ);
+	
 	/// Wakes up each simulator for its specific blocks; through all the blocks in the chunk
 	void WakeUpSimulators(void);
 	
@@ -436,9 +505,14 @@ private:
 	/// Checks the block scheduled for checking in m_ToTickBlocks[]
 	void CheckBlocks(void);
 	
-	/// Ticks several random blocks in the chunk
+	/** Ticks the block set by SetNextBlockTick(), then RandomTicksPerSection random blocks in each section that has any randomly ticked blocks.
+	The chance of a block being ticked is the same as in vanilla, and chunks of stone and air cost nothing.
+	*/
 	void TickBlocks(void);
 	
+	/// Counts the randomly ticked blocks into m_NumRandomTickedInSection[] and m_NumRandomTicked
+	void CountRandomTickedBlocks(void);
+	
 	/// Adds snow to the top of snowy biomes and hydrates farmland / fills cauldrons in rainy biomes
 	void ApplyWeatherToTop(void);
 	
@@ -34,6 +34,7 @@ class cBlockEntity;
 class cEntity;
 class cClientHandle;
 class cBlockEntity;
+class cChunkSnapshot;
 
 typedef std::list<cEntity *>        cEntityList;
 typedef std::list<cBlockEntity *>   cBlockEntityList;
@@ -401,6 +402,12 @@ public:
 	*/
 	virtual bool Coords(int a_ChunkX, int a_ChunkZ) { UNUSED(a_ChunkX); UNUSED(a_ChunkZ); return true; };
 	
+	/** Called once with a read-only snapshot of the chunk's block data (only by cChunk::GetAllData()); the snapshot may be kept.
+	If true is returned, the callback reads the block data from the snapshot, and HeightMap(), BiomeData(), BlockTypes(),
+	BlockMeta(), LightIsValid(), BlockLight() and BlockSkyLight() are not called.
+	*/
+	virtual bool BlockDataSnapshot(const cChunkSnapshot & a_Snapshot) {UNUSED(a_Snapshot); return false; };
+	
 	/// Called once to provide heightmap data
 	virtual void HeightMap(const cChunkDef::HeightMap * a_HeightMap) {UNUSED(a_HeightMap); };
 	
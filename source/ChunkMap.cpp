@@ -31,7 +31,9 @@
 // cChunkMap:
 
 cChunkMap::cChunkMap(cWorld * a_World )
-	: m_World( a_World )
+	: m_CSLayers("ChunkMap")
+	, m_CSChunks("ChunkMap lookup")
+	, m_World( a_World )
 {
 }
 
@@ -42,6 +44,7 @@ cChunkMap::cChunkMap(cWorld * a_World )
 cChunkMap::~cChunkMap()
 {
 	cCSLock Lock(m_CSLayers);
+	cCSLock LockChunks(m_CSChunks);
 	while (!m_Layers.empty())
 	{
 		delete m_Layers.back();
@@ -56,6 +59,7 @@ cChunkMap::~cChunkMap()
 void cChunkMap::RemoveLayer( cChunkLayer* a_Layer )
 {
 	cCSLock Lock(m_CSLayers);
+	cCSLock LockChunks(m_CSChunks);
 	m_Layers.remove(a_Layer);
 }
 
@@ -81,6 +85,7 @@ cChunkMap::cChunkLayer * cChunkMap::GetLayer(int a_LayerX, int a_LayerZ)
 		LOGERROR("cChunkMap: Cannot create new layer, server out of memory?");
 		return NULL;
 	}
+	cCSLock LockChunks(m_CSChunks);
 	m_Layers.push_back(Layer);
 	return Layer;
 }
@@ -102,7 +107,7 @@ cChunkMap::cChunkLayer * cChunkMap::FindLayerForChunk(int a_ChunkX, int a_ChunkZ
 
 cChunkMap::cChunkLayer * cChunkMap::FindLayer(int a_LayerX, int a_LayerZ)
 {
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(m_CSLayers.IsLockedByCurrentThread() || m_CSChunks.IsLockedByCurrentThread());
 
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
@@ -310,7 +315,7 @@ bool cChunkMap::LockedFastSetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLO
 
 cChunk * cChunkMap::FindChunk(int a_ChunkX, int a_ChunkZ)
 {
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(m_CSLayers.IsLockedByCurrentThread() || m_CSChunks.IsLockedByCurrentThread());
 	
 	cChunkLayer * Layer = FindLayerForChunk(a_ChunkX, a_ChunkZ);
 	if (Layer == NULL)
@@ -697,6 +702,21 @@ void cChunkMap::SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClien
 
 
 
+void cChunkMap::SendChunkBlockEntities(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
+{
+	cCSLock Lock(m_CSLayers);
+	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, 0, a_ChunkZ);
+	if ((Chunk == NULL) || !Chunk->IsValid())
+	{
+		return;
+	}
+	Chunk->SendBlockEntities(a_Client);
+}
+
+
+
+
+
 void cChunkMap::UseBlockEntity(cPlayer * a_Player, int a_BlockX, int a_BlockY, int a_BlockZ)
 {
 	// a_Player rclked block entity at the coords specified, handle it
@@ -899,6 +919,18 @@ bool cChunkMap::GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_
 
 
 
+bool cChunkMap::GetChunkSnapshot(int a_ChunkX, int a_ChunkZ, cChunkSnapshot & a_Snapshot)
+{
+	// Only the lookup lock, the chunk can't be unloaded while we hold it:
+	cCSLock Lock(m_CSChunks);
+	cChunk * Chunk = FindChunk(a_ChunkX, a_ChunkZ);
+	return (Chunk != NULL) && Chunk->GetSnapshot(a_Snapshot);
+}
+
+
+
+
+
 bool cChunkMap::GetChunkBlockTypes(int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_BlockTypes)
 {
 	cCSLock Lock(m_CSLayers);
@@ -1036,6 +1068,88 @@ void cChunkMap::FastSetBlocks(sSetBlockList & a_BlockList)
 
 
 
+/// Orders sSetBlock items by their chunk coords; used for sorting in cChunkMap::SetBlocks()
+static bool IsSetBlockInLowerChunk(const sSetBlock & a_First, const sSetBlock & a_Second)
+{
+	if (a_First.ChunkX != a_Second.ChunkX)
+	{
+		return (a_First.ChunkX < a_Second.ChunkX);
+	}
+	return (a_First.ChunkZ < a_Second.ChunkZ);
+}
+
+
+
+
+
+int cChunkMap::SetBlocks(sSetBlockVector & a_Blocks, bool a_ShouldFastSet)
+{
+	// Group the changes by chunk; the sort must be stable so that multiple changes to a single block keep their order:
+	std::stable_sort(a_Blocks.begin(), a_Blocks.end(), IsSetBlockInLowerChunk);
+	
+	int NumFailed = 0;
+	cChunkCoordsList ToRelight;
+	sSetBlockVector::const_iterator itr = a_Blocks.begin(), end = a_Blocks.end();
+	while (itr != end)
+	{
+		// Find the range of changes belonging to this chunk:
+		int ChunkX = itr->ChunkX;
+		int ChunkZ = itr->ChunkZ;
+		sSetBlockVector::const_iterator ChunkEnd = itr;
+		while ((ChunkEnd != end) && (ChunkEnd->ChunkX == ChunkX) && (ChunkEnd->ChunkZ == ChunkZ))
+		{
+			++ChunkEnd;
+		}
+		
+		cCSLock Lock(m_CSLayers);
+		cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
+		if ((Chunk == NULL) || !Chunk->IsValid())
+		{
+			NumFailed += (int)(ChunkEnd - itr);
+			itr = ChunkEnd;
+			continue;
+		}
+		
+		bool WasLightValid = Chunk->IsLightValid();
+		for (; itr != ChunkEnd; ++itr)
+		{
+			if ((itr->y < 0) || (itr->y >= cChunkDef::Height))
+			{
+				// The chunk doesn't check the coords in release builds
+				NumFailed += 1;
+				continue;
+			}
+			if (a_ShouldFastSet)
+			{
+				Chunk->FastSetBlock(itr->x, itr->y, itr->z, itr->BlockType, itr->BlockMeta);
+			}
+			else
+			{
+				Chunk->SetBlock(itr->x, itr->y, itr->z, itr->BlockType, itr->BlockMeta);
+				m_World->GetSimulatorManager()->WakeUp(ChunkX * cChunkDef::Width + itr->x, itr->y, ChunkZ * cChunkDef::Width + itr->z, Chunk);
+			}
+		}  // for itr - a_Blocks[] in this chunk
+		
+		// The chunk collects its block changes into m_PendingSendBlocks, those get broadcast as a single multi-block-change in its next tick
+		
+		if (WasLightValid && !Chunk->IsLightValid())
+		{
+			ToRelight.push_back(cChunkCoords(ChunkX, ZERO_CHUNK_Y, ChunkZ));
+		}
+	}  // while (itr)
+	
+	// Queue relighting outside of the lock, the lighting thread's ChunkStay locks the chunkmap on its own:
+	for (cChunkCoordsList::const_iterator itrC = ToRelight.begin(), endC = ToRelight.end(); itrC != endC; ++itrC)
+	{
+		m_World->QueueLightChunk(itrC->m_ChunkX, itrC->m_ChunkZ);
+	}
+	return NumFailed;
+}
+
+
+
+
+
 void cChunkMap::CollectPickupsByPlayer(cPlayer * a_Player)
 {
 	int BlockX = (int)(a_Player->GetPosX());  // Truncating doesn't matter much; we're scanning entire chunks anyway
@@ -1565,16 +1679,125 @@ bool cChunkMap::ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback
 
 
 
-void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlocksAffected)
+/// Returns the box of blocks that an explosion can reach; the Y range is clamped to the world, so MinY > MaxY if the explosion is outside it
+static void GetExplosionBounds(const sExplosion & a_Explosion, int & a_MinX, int & a_MaxX, int & a_MinY, int & a_MaxY, int & a_MinZ, int & a_MaxZ)
+{
+	int ExplosionSizeInt = (int)ceil(a_Explosion.m_Size);
+	a_MinX = (int)floor(a_Explosion.m_X) - ExplosionSizeInt;
+	a_MaxX = (int)ceil(a_Explosion.m_X + ExplosionSizeInt);
+	a_MinY = std::max((int)floor(a_Explosion.m_Y - ExplosionSizeInt), 0);
+	a_MaxY = std::min((int)ceil(a_Explosion.m_Y + ExplosionSizeInt), cChunkDef::Height - 1);
+	a_MinZ = (int)floor(a_Explosion.m_Z) - ExplosionSizeInt;
+	a_MaxZ = (int)ceil(a_Explosion.m_Z + ExplosionSizeInt);
+}
+
+
+
+
+
+void cChunkMap::DoExplosions(sExplosionVector & a_Explosions)
+{
+	// Explosions whose blocks fit into a box of this size (in the XZ plane) are processed together:
+	static const int MAX_GROUP_SIZE = 64;
+	
+	size_t Idx = 0;
+	while (Idx < a_Explosions.size())
+	{
+		// Make a group of consecutive explosions that are close to each other:
+		int MinX = 0, MaxX = 0, MinY = 0, MaxY = 0, MinZ = 0, MaxZ = 0;
+		size_t GroupStart = Idx;
+		for (; Idx < a_Explosions.size(); Idx++)
+		{
+			int ExpMinX, ExpMaxX, ExpMinY, ExpMaxY, ExpMinZ, ExpMaxZ;
+			GetExplosionBounds(a_Explosions[Idx], ExpMinX, ExpMaxX, ExpMinY, ExpMaxY, ExpMinZ, ExpMaxZ);
+			if (Idx == GroupStart)
+			{
+				MinX = ExpMinX; MaxX = ExpMaxX;
+				MinY = ExpMinY; MaxY = ExpMaxY;
+				MinZ = ExpMinZ; MaxZ = ExpMaxZ;
+				continue;
+			}
+			if (
+				(std::max(MaxX, ExpMaxX) - std::min(MinX, ExpMinX) > MAX_GROUP_SIZE) ||
+				(std::max(MaxZ, ExpMaxZ) - std::min(MinZ, ExpMinZ) > MAX_GROUP_SIZE)
+			)
+			{
+				// Too far from the rest of the group, start a new group with this explosion
+				break;
+			}
+			MinX = std::min(MinX, ExpMinX); MaxX = std::max(MaxX, ExpMaxX);
+			MinY = std::min(MinY, ExpMinY); MaxY = std::max(MaxY, ExpMaxY);
+			MinZ = std::min(MinZ, ExpMinZ); MaxZ = std::max(MaxZ, ExpMaxZ);
+		}
+		
+		if (MinY > MaxY)
+		{
+			// All the explosions in the group are outside the world's Y range
+			continue;
+		}
+		
+		if (DoExplosionGroup(a_Explosions, GroupStart, Idx, MinX, MaxX, MinY, MaxY, MinZ, MaxZ) || (Idx - GroupStart == 1))
+		{
+			continue;
+		}
+		
+		// Some chunks in the group's box are not loaded. Each explosion needs only its own box to be loaded, so process them one by one:
+		for (size_t i = GroupStart; i < Idx; i++)
+		{
+			int ExpMinX, ExpMaxX, ExpMinY, ExpMaxY, ExpMinZ, ExpMaxZ;
+			GetExplosionBounds(a_Explosions[i], ExpMinX, ExpMaxX, ExpMinY, ExpMaxY, ExpMinZ, ExpMaxZ);
+			if (ExpMinY <= ExpMaxY)
+			{
+				DoExplosionGroup(a_Explosions, i, i + 1, ExpMinX, ExpMaxX, ExpMinY, ExpMaxY, ExpMinZ, ExpMaxZ);
+			}
+		}
+	}  // while (Idx)
+}
+
+
+
+
+
+bool cChunkMap::DoExplosionGroup(
+	sExplosionVector & a_Explosions, size_t a_Begin, size_t a_End,
+	int a_MinX, int a_MaxX, int a_MinY, int a_MaxY, int a_MinZ, int a_MaxZ
+)
+{
+	// Apply all the explosions in the group to a single area:
+	cBlockArea Area;
+	if (!Area.Read(m_World, a_MinX, a_MaxX, a_MinY, a_MaxY, a_MinZ, a_MaxZ))
+	{
+		return false;
+	}
+	for (size_t i = a_Begin; i < a_End; i++)
+	{
+		DoExplosionInArea(a_Explosions[i], Area);
+	}
+	Area.Write(m_World, a_MinX, a_MinY, a_MinZ);
+	
+	// Wake up all simulators for the area, so that water and lava flows and sand falls into the blasted holes (FS #391):
+	WakeUpSimulatorsInArea(a_MinX, a_MaxX + 1, a_MinY, a_MaxY, a_MinZ, a_MaxZ + 1);
+	return true;
+}
+
+
+
+
+
+void cChunkMap::DoExplosionInArea(sExplosion & a_Explosion, cBlockArea & a_Area)
 {
 	// Don't explode if outside of Y range (prevents the following test running into unallocated memory):
-	if ((a_BlockY < 0) || (a_BlockY > cChunkDef::Height - 1))
+	if ((a_Explosion.m_Y < 0) || (a_Explosion.m_Y > cChunkDef::Height - 1))
 	{
 		return;
 	}
 	
+	int bx = (int)floor(a_Explosion.m_X);
+	int by = (int)floor(a_Explosion.m_Y);
+	int bz = (int)floor(a_Explosion.m_Z);
+	
 	// Don't explode if the explosion center is inside a liquid block:
-	switch (m_World->GetBlock((int)floor(a_BlockX), (int)floor(a_BlockY), (int)floor(a_BlockZ)))
+	switch (a_Area.GetBlockType(bx, by, bz))
 	{
 		case E_BLOCK_WATER:
 		case E_BLOCK_STATIONARY_WATER:
@@ -1585,16 +1808,9 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 		}
 	}
 	
-	cBlockArea area;
-	int bx = (int)floor(a_BlockX);
-	int by = (int)floor(a_BlockY);
-	int bz = (int)floor(a_BlockZ);
-	int ExplosionSizeInt = (int) ceil(a_ExplosionSize);
+	int ExplosionSizeInt = (int) ceil(a_Explosion.m_Size);
 	int ExplosionSizeSq =  ExplosionSizeInt * ExplosionSizeInt;
-	a_BlocksAffected.reserve(8 * ExplosionSizeInt * ExplosionSizeInt * ExplosionSizeInt);
-	int MinY = std::max((int)floor(a_BlockY - ExplosionSizeInt), 0);
-	int MaxY = std::min((int)ceil(a_BlockY + ExplosionSizeInt), cChunkDef::Height - 1);
-	area.Read(m_World, bx - ExplosionSizeInt, (int)ceil(a_BlockX + ExplosionSizeInt), MinY, MaxY, bz - ExplosionSizeInt, (int)ceil(a_BlockZ + ExplosionSizeInt));
+	a_Explosion.m_BlocksAffected.reserve(8 * ExplosionSizeInt * ExplosionSizeInt * ExplosionSizeInt);
 	for (int x = -ExplosionSizeInt; x < ExplosionSizeInt; x++)
 	{
 		for (int y = -ExplosionSizeInt; y < ExplosionSizeInt; y++)
@@ -1612,16 +1828,16 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 					continue;
 				}
 
-				BLOCKTYPE Block = area.GetBlockType(bx + x, by + y, bz + z);
+				BLOCKTYPE Block = a_Area.GetBlockType(bx + x, by + y, bz + z);
 				switch (Block)
 				{
 					case E_BLOCK_TNT:
 					{
 						// Activate the TNT, with a random fuse between 10 to 30 game ticks
 						double FuseTime = (double)(10 + m_World->GetTickRandomNumber(20)) / 20;
-						m_World->SpawnPrimedTNT(a_BlockX + x + 0.5, a_BlockY + y + 0.5, a_BlockZ + z + 0.5, FuseTime);
-						area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_AIR);
-						a_BlocksAffected.push_back(Vector3i(bx + x, by + y, bz + z));
+						m_World->SpawnPrimedTNT(a_Explosion.m_X + x + 0.5, a_Explosion.m_Y + y + 0.5, a_Explosion.m_Z + z + 0.5, FuseTime);
+						a_Area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_AIR);
+						a_Explosion.m_BlocksAffected.push_back(Vector3i(bx + x, by + y, bz + z));
 						break;
 					}
 					case E_BLOCK_OBSIDIAN:
@@ -1636,14 +1852,14 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 					case E_BLOCK_STATIONARY_WATER:
 					{
 						// Turn into simulated water:
-						area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_WATER);
+						a_Area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_WATER);
 						break;
 					}
 					
 					case E_BLOCK_STATIONARY_LAVA:
 					{
 						// Turn into simulated lava:
-						area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_LAVA);
+						a_Area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_LAVA);
 						break;
 					}
 					
@@ -1660,24 +1876,16 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 							cItems Drops;
 							cBlockHandler * Handler = BlockHandler(Block);
 
-							Handler->ConvertToPickups(Drops, area.GetBlockMeta(bx + x, by + y, bz + z));
+							Handler->ConvertToPickups(Drops, a_Area.GetBlockMeta(bx + x, by + y, bz + z));
 							m_World->SpawnItemPickups(Drops, bx + x, by + y, bz + z);
 						}
-						area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_AIR);
-						a_BlocksAffected.push_back(Vector3i(bx + x, by + y, bz + z));
+						a_Area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_AIR);
+						a_Explosion.m_BlocksAffected.push_back(Vector3i(bx + x, by + y, bz + z));
 					}
 				}  // switch (BlockType)
 			}  // for z
 		}  // for y
 	}  // for x
-	area.Write(m_World, bx - ExplosionSizeInt, MinY, bz - ExplosionSizeInt);
-
-	// Wake up all simulators for the area, so that water and lava flows and sand falls into the blasted holes (FS #391):
-	WakeUpSimulatorsInArea(
-		bx - ExplosionSizeInt, bx + ExplosionSizeInt + 1,
-		MinY, MaxY,
-		bz - ExplosionSizeInt, bz + ExplosionSizeInt + 1
-	);
 }
 
 
@@ -2104,6 +2312,47 @@ void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty)
 
 
 
+void cChunkMap::GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers)
+{
+	a_NumActive = 0;
+	a_NumSleeping = 0;
+	a_NumActiveHoppers = 0;
+	a_NumSleepingHoppers = 0;
+	cCSLock Lock(m_CSLayers);
+	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
+	{
+		(*itr)->GetBlockEntityStats(a_NumActive, a_NumSleeping, a_NumActiveHoppers, a_NumSleepingHoppers);
+	}  // for itr - m_Layers[]
+}
+
+
+
+
+
+void cChunkMap::SetChunkPoolSize(int a_MaxSize)
+{
+	cCSLock Lock(m_CSLayers);
+	m_ChunkPool.SetMaxSize(a_MaxSize);
+}
+
+
+
+
+
+void cChunkMap::GetChunkPoolStats(int & a_NumPooled, int & a_MaxSize, int & a_NumAllocations, int & a_NumReuses, int & a_NumReleases)
+{
+	cCSLock Lock(m_CSLayers);
+	a_NumPooled      = m_ChunkPool.GetNumPooled();
+	a_MaxSize        = m_ChunkPool.GetMaxSize();
+	a_NumAllocations = m_ChunkPool.GetNumAllocations();
+	a_NumReuses      = m_ChunkPool.GetNumReuses();
+	a_NumReleases    = m_ChunkPool.GetNumReleases();
+}
+
+
+
+
+
 void cChunkMap::GrowMelonPumpkin(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, MTRand & a_Rand)
 {
 	int ChunkX, ChunkZ;
@@ -2237,6 +2486,37 @@ void cChunkMap::SaveAllChunks(void)
 
 
 
+int cChunkMap::SaveOldestDirtyChunks(Int64 a_WorldAge, Int64 a_MinDirtyAge, int a_MaxChunks)
+{
+	if (a_MaxChunks <= 0)
+	{
+		return 0;
+	}
+	
+	cDirtyChunks Chunks;
+	{
+		cCSLock Lock(m_CSLayers);
+		for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
+		{
+			(*itr)->CollectDirtyChunks(a_WorldAge, a_WorldAge - a_MinDirtyAge, Chunks);
+		}  // for itr - m_Layers[]
+	}
+	
+	// Queue the chunks that have been dirty the longest:
+	int NumToSave = std::min((int)Chunks.size(), a_MaxChunks);
+	std::partial_sort(Chunks.begin(), Chunks.begin() + NumToSave, Chunks.end());
+	cWorldStorage & Storage = m_World->GetStorage();
+	for (int i = 0; i < NumToSave; i++)
+	{
+		Storage.QueueSaveChunk(Chunks[i].m_ChunkX, ZERO_CHUNK_Y, Chunks[i].m_ChunkZ);
+	}
+	return NumToSave;
+}
+
+
+
+
+
 int cChunkMap::GetNumChunks(void)
 {
 	cCSLock Lock(m_CSLayers);
@@ -2299,7 +2579,7 @@ cChunkMap::cChunkLayer::~cChunkLayer()
 {
 	for (int i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
 	{
-		delete m_Chunks[i];
+		m_Parent->m_ChunkPool.Free(m_Chunks[i]);
 		m_Chunks[i] = NULL;  // // Must zero out, because further chunk deletions query the chunkmap for entities and that would touch deleted data
 	}  // for i - m_Chunks[]
 }
@@ -2328,7 +2608,8 @@ cChunkPtr cChunkMap::cChunkLayer::GetChunk( int a_ChunkX, int a_ChunkY, int a_Ch
 		cChunk * neixp = (LocalX < LAYER_SIZE - 1) ? m_Chunks[Index + 1]          : m_Parent->FindChunk(a_ChunkX + 1, a_ChunkZ);
 		cChunk * neizm = (LocalZ > 0)              ? m_Chunks[Index - LAYER_SIZE] : m_Parent->FindChunk(a_ChunkX    , a_ChunkZ - 1);
 		cChunk * neizp = (LocalZ < LAYER_SIZE - 1) ? m_Chunks[Index + LAYER_SIZE] : m_Parent->FindChunk(a_ChunkX    , a_ChunkZ + 1);
-		m_Chunks[Index] = new cChunk(a_ChunkX, 0, a_ChunkZ, m_Parent, m_Parent->GetWorld(), neixm, neixp, neizm, neizp);
+		cCSLock Lock(m_Parent->m_CSChunks);
+		m_Chunks[Index] = m_Parent->m_ChunkPool.Allocate(a_ChunkX, 0, a_ChunkZ, m_Parent, m_Parent->GetWorld(), neixm, neixp, neizm, neizp);
 	}
 	return m_Chunks[Index];
 }
@@ -2519,6 +2800,21 @@ void cChunkMap::cChunkLayer::GetChunkStats(int & a_NumChunksValid, int & a_NumCh
 
 
 
+void cChunkMap::cChunkLayer::GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers) const
+{
+	for (int i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
+	{
+		if (m_Chunks[i] != NULL)
+		{
+			m_Chunks[i]->GetBlockEntityStats(a_NumActive, a_NumSleeping, a_NumActiveHoppers, a_NumSleepingHoppers);
+		}
+	}  // for i - m_Chunks[]
+}
+
+
+
+
+
 void cChunkMap::cChunkLayer::Save(void)
 {
 	cWorld * World = m_Parent->GetWorld();
@@ -2535,6 +2831,26 @@ void cChunkMap::cChunkLayer::Save(void)
 
 
 
+void cChunkMap::cChunkLayer::CollectDirtyChunks(Int64 a_WorldAge, Int64 a_DirtyBefore, cDirtyChunks & a_Chunks)
+{
+	for (int i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
+	{
+		if ((m_Chunks[i] == NULL) || !m_Chunks[i]->IsValid())
+		{
+			continue;
+		}
+		Int64 DirtySince = m_Chunks[i]->UpdateDirtySince(a_WorldAge);
+		if ((DirtySince >= 0) && (DirtySince <= a_DirtyBefore))
+		{
+			a_Chunks.push_back(sDirtyChunk(DirtySince, m_Chunks[i]->GetPosX(), m_Chunks[i]->GetPosZ()));
+		}
+	}  // for i - m_Chunks[]
+}
+
+
+
+
+
 void cChunkMap::cChunkLayer::UnloadUnusedChunks(void)
 {
 	for (int i = 0; i < ARRAYCOUNT(m_Chunks); i++)
@@ -2545,10 +2861,15 @@ void cChunkMap::cChunkLayer::UnloadUnusedChunks(void)
 			!cPluginManager::Get()->CallHookChunkUnloading(m_Parent->GetWorld(), m_Chunks[i]->GetPosX(), m_Chunks[i]->GetPosZ())  // Plugins agree
 		)
 		{
+			// Keep the chunk's stored data in the warm cache for as long as possible, the chunk may be needed again soon:
+			m_Parent->GetWorld()->GetStorage().GetWarmCache().Touch(m_Chunks[i]->GetPosX(), m_Chunks[i]->GetPosZ());
+			
 			// The cChunk destructor calls our GetChunk() while removing its entities
 			// so we still need to be able to return the chunk. Therefore we first delete, then NULLify
 			// Doing otherwise results in bug http://forum.mc-server.org/showthread.php?tid=355
-			delete m_Chunks[i];
+			// The background readers mustn't find the chunk while it's being destroyed:
+			cCSLock Lock(m_Parent->m_CSChunks);
+			m_Parent->m_ChunkPool.Free(m_Chunks[i]);
 			m_Chunks[i] = NULL;
 		}
 	}  // for i - m_Chunks[]
@@ -6,6 +6,8 @@
 #pragma once
 
 #include "ChunkDef.h"
+#include "ChunkPool.h"
+#include "Entities/PhysicsBatch.h"
 
 
 
@@ -43,6 +45,26 @@ typedef cItemCallback<cChunk>             cChunkCallback;
 
 
 
+/// A single explosion to be processed by cChunkMap::DoExplosions()
+struct sExplosion
+{
+	double m_Size;
+	double m_X;
+	double m_Y;
+	double m_Z;
+	
+	/// The blocks destroyed by the explosion, filled in by cChunkMap::DoExplosions()
+	cVector3iArray m_BlocksAffected;
+	
+	sExplosion(double a_Size, double a_X, double a_Y, double a_Z) : m_Size(a_Size), m_X(a_X), m_Y(a_Y), m_Z(a_Z) {}
+} ;
+
+typedef std::vector<sExplosion> sExplosionVector;
+
+
+
+
+
 class cChunkMap
 {
 public:
@@ -79,6 +101,9 @@ public:
 	/// Sends the block entity, if it is at the coords specified, to a_Client
 	void SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClientHandle & a_Client);
 	
+	/// Sends all the block entities in the chunk to a_Client, or to all the chunk's clients if a_Client is NULL
+	void SendChunkBlockEntities(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+	
 	/// a_Player rclked block entity at the coords specified, handle it
 	void UseBlockEntity(cPlayer * a_Player, int a_X, int a_Y, int a_Z);
 	
@@ -121,6 +146,12 @@ public:
 	
 	bool GetChunkData       (int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback);
 	
+	/** Takes a read-only snapshot of the chunk's block data (no entities or block entities); returns false if the chunk is not valid.
+	Doesn't lock m_CSLayers, so it doesn't wait for the world tick; meant for the background threads (lighting, chunk sending).
+	Doesn't queue the chunk for loading.
+	*/
+	bool GetChunkSnapshot   (int a_ChunkX, int a_ChunkZ, cChunkSnapshot & a_Snapshot);
+	
 	/// Copies the chunk's blocktypes into a_Blocks; returns true if successful
 	bool GetChunkBlockTypes (int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_Blocks);
 	
@@ -129,6 +160,14 @@ public:
 	int       GetHeight          (int a_BlockX, int a_BlockZ);  // Waits for the chunk to get loaded / generated
 	bool      TryGetHeight       (int a_BlockX, int a_BlockZ, int & a_Height);  // Returns false if chunk not loaded / generated
 	void      FastSetBlocks      (sSetBlockList & a_BlockList);
+	
+	/** Sets many blocks at once. a_Blocks gets sorted by chunk, so that each chunk is looked up only once and all its changes are applied under a single lock.
+	If a_ShouldFastSet is true, FastSetBlock() is used for each block (no neighbor updates), otherwise full SetBlock() processing is done.
+	The changes get sent to clients as one multi-block-change per chunk, and each chunk whose lighting is invalidated is queued for relighting once.
+	Returns the number of blocks that weren't set because their chunk is not loaded or their Y coord is out of range.
+	*/
+	int       SetBlocks          (sSetBlockVector & a_Blocks, bool a_ShouldFastSet);
+	
 	void      CollectPickupsByPlayer(cPlayer * a_Player);
 	
 	BLOCKTYPE  GetBlock          (int a_BlockX, int a_BlockY, int a_BlockZ);
@@ -185,8 +224,14 @@ public:
 	/// Calls the callback for each entity in the specified chunk; returns true if all entities processed, false if the callback aborted by returning true
 	bool ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback & a_Callback);  // Lua-accessible
 
-	/// Destroys and returns a list of blocks destroyed in the explosion at the specified coordinates
-	void DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlockAffected);
+	/** Processes all the explosions, filling in the list of blocks destroyed by each of them.
+	Explosions close to each other are processed together: the blocks around them are read into a single cBlockArea,
+	all the explosions are applied to it in order and it is written back once, so that each chunk is modified
+	(and its lighting invalidated) only once, no matter how many explosions hit it.
+	If some chunks in a group's box are not loaded, the group's explosions are processed one by one instead;
+	an explosion that reaches into a chunk that is not loaded does nothing.
+	*/
+	void DoExplosions(sExplosionVector & a_Explosions);
 	
 	/// Calls the callback if the entity with the specified ID is found, with the entity object as the callback param. Returns true if entity found and callback returned false.
 	bool DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback);  // Lua-accessible
@@ -256,6 +301,18 @@ public:
 	/// Returns the number of valid chunks and the number of dirty chunks
 	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty);
 	
+	/// Returns the number of block entities (and of hoppers among them) that are ticking and that are sleeping until woken up
+	void GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers);
+	
+	/// Sets the maximum number of unloaded chunks whose storage is kept for reuse
+	void SetChunkPoolSize(int a_MaxSize);
+	
+	/// Returns the statistics of the chunk storage pool
+	void GetChunkPoolStats(int & a_NumPooled, int & a_MaxSize, int & a_NumAllocations, int & a_NumReuses, int & a_NumReleases);
+	
+	/// Returns the physics batch used by the chunks while ticking their entities. Only to be used from within the world tick.
+	cEntityPhysicsBatch & GetPhysicsBatch(void) { return m_PhysicsBatch; }
+	
 	/// Grows a melon or a pumpkin next to the block specified (assumed to be the stem)
 	void GrowMelonPumpkin(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, MTRand & a_Rand);
 	
@@ -278,6 +335,11 @@ public:
 
 	void UnloadUnusedChunks(void);
 	void SaveAllChunks(void);
+	
+	/** Queues for saving up to a_MaxChunks chunks that have been dirty for at least a_MinDirtyAge ticks, the longest-dirty ones first.
+	a_WorldAge is the current world age. Returns the number of chunks queued.
+	*/
+	int SaveOldestDirtyChunks(Int64 a_WorldAge, Int64 a_MinDirtyAge, int a_MaxChunks);
 
 	cWorld * GetWorld(void) { return m_World; }
 
@@ -295,6 +357,19 @@ private:
 
 	friend class cChunk;  // The chunks can manipulate neighbors while in their Tick() method, using LockedGetBlock() and LockedSetBlock()
 
+	/// A chunk waiting for an autosave: the world age since which it's dirty, and its coords
+	struct sDirtyChunk
+	{
+		Int64 m_DirtySince;
+		int   m_ChunkX;
+		int   m_ChunkZ;
+		
+		sDirtyChunk(Int64 a_DirtySince, int a_ChunkX, int a_ChunkZ) : m_DirtySince(a_DirtySince), m_ChunkX(a_ChunkX), m_ChunkZ(a_ChunkZ) {}
+		
+		bool operator < (const sDirtyChunk & a_Other) const { return (m_DirtySince < a_Other.m_DirtySince); }
+	} ;
+	typedef std::vector<sDirtyChunk> cDirtyChunks;
+
 	class cChunkLayer
 	{
 	public:
@@ -314,9 +389,15 @@ private:
 		
 		void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const;
 		
+		/// Adds the number of active and sleeping block entities and hoppers in the layer to the counters
+		void GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers) const;
+		
 		void Save(void);
 		void UnloadUnusedChunks(void);
 		
+		/// Adds the chunks that have been dirty since a_DirtyBefore or earlier into a_Chunks, together with the world age since which they're dirty
+		void CollectDirtyChunks(Int64 a_WorldAge, Int64 a_DirtyBefore, cDirtyChunks & a_Chunks);
+		
 		/// Collect a mob census, of all mobs, their megatype, their chunk and their distance o closest player
 		void CollectMobCensus(cMobCensus& a_ToFill);		
 		/// Try to Spawn Monsters inside all Chunks
@@ -346,10 +427,10 @@ private:
 	
 	typedef std::list<cChunkLayer *> cChunkLayerList;
 
-	/// Finds the cChunkLayer object responsible for the specified chunk; returns NULL if not found. Assumes m_CSLayers is locked.
+	/// Finds the cChunkLayer object responsible for the specified chunk; returns NULL if not found. Assumes m_CSLayers or m_CSChunks is locked.
 	cChunkLayer * FindLayerForChunk(int a_ChunkX, int a_ChunkZ);
 	
-	/// Returns the specified cChunkLayer object; returns NULL if not found. Assumes m_CSLayers is locked.
+	/// Returns the specified cChunkLayer object; returns NULL if not found. Assumes m_CSLayers or m_CSChunks is locked.
 	cChunkLayer * FindLayer(int a_LayerX, int a_LayerZ);
 	
 	/// Returns the cChunkLayer object responsible for the specified chunk; creates it if not found.
@@ -360,9 +441,27 @@ private:
 	
 	void RemoveLayer(cChunkLayer * a_Layer);
 
+	/*
+	Locking:
+	m_CSLayers is the world lock; the tick thread holds it for the whole tick and all the chunk operations lock it.
+	m_CSChunks protects only the chunk lookup structures (m_Layers and the layers' m_Chunks[]). They are changed
+	only by threads holding m_CSLayers, which lock m_CSChunks just around the change. The background readers
+	(GetChunkSnapshot()) lock only m_CSChunks to find a chunk, and then the chunk's m_CSData to reference its data.
+	The lock order is m_CSLayers -> m_CSChunks -> cChunk::m_CSData, and at most one chunk's m_CSData may be held
+	at a time, so neighbor chunks can never deadlock. m_CSData mustn't be held while calling out of the chunk.
+	m_CSChunks is held while a chunk is destroyed, which calls plugin hooks; that is safe only because the background
+	readers don't hold any other lock when locking m_CSChunks, and they read the snapshots only after unlocking it.
+	*/
 	cCriticalSection m_CSLayers;
+	cCriticalSection m_CSChunks;
 	cChunkLayerList  m_Layers;
 	cEvent           m_evtChunkValid;  // Set whenever any chunk becomes valid, via ChunkValidated()
+	
+	/// Storage of unloaded chunks, reused for newly created chunks. Protected by m_CSLayers.
+	cChunkPool m_ChunkPool;
+	
+	/// Shared by all the chunks for their entity physics; used only in the tick thread, so that the arrays' capacity is reused
+	cEntityPhysicsBatch m_PhysicsBatch;
 
 	cWorld * m_World;
 
@@ -385,8 +484,19 @@ private:
 	/// Fast-sets a block in any chunk while in the cChunk's Tick() method; returns true if successful, false if chunk not loaded (doesn't queue load)
 	bool LockedFastSetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
 	
-	/// Locates a chunk ptr in the chunkmap; doesn't create it when not found; assumes m_CSLayers is locked. To be called only from cChunkMap.
+	/// Locates a chunk ptr in the chunkmap; doesn't create it when not found; assumes m_CSLayers or m_CSChunks is locked. To be called only from cChunkMap.
 	cChunk * FindChunk(int a_ChunkX, int a_ChunkZ);
+	
+	/** Applies the explosions a_Explosions[a_Begin .. a_End - 1] to the blocks in the specified box, which must contain all the blocks they can reach.
+	Returns false and does nothing if any of the chunks in the box is not loaded.
+	*/
+	bool DoExplosionGroup(
+		sExplosionVector & a_Explosions, size_t a_Begin, size_t a_End,
+		int a_MinX, int a_MaxX, int a_MinY, int a_MaxY, int a_MinZ, int a_MaxZ
+	);
+	
+	/// Applies a single explosion to the blocks in a_Area, which must contain all the blocks that the explosion can reach
+	void DoExplosionInArea(sExplosion & a_Explosion, cBlockArea & a_Area);
 };
 
 
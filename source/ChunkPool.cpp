@@ -0,0 +1,167 @@
+
+// ChunkPool.cpp
+
+// Implements the cChunkPool class representing a per-world pool of chunk storage that is recycled across chunk unloads and loads
+
+#include "Globals.h"
+
+#include "ChunkPool.h"
+#include "Chunk.h"
+#include "World.h"
+#include "Simulator/FluidSimulator.h"
+
+
+
+
+
+cChunkPool::cChunkPool(void) :
+	m_MaxSize(0),
+	m_NumAllocations(0),
+	m_NumReuses(0),
+	m_NumReleases(0)
+{
+}
+
+
+
+
+
+cChunkPool::~cChunkPool()
+{
+	Clear();
+}
+
+
+
+
+
+void cChunkPool::SetMaxSize(int a_MaxSize)
+{
+	m_MaxSize = std::max(a_MaxSize, 0);
+	while ((int)m_Pool.size() > m_MaxSize)
+	{
+		Release(m_Pool.back());
+		m_Pool.pop_back();
+		m_NumReleases++;
+	}
+}
+
+
+
+
+
+cChunk * cChunkPool::Allocate(
+	int a_ChunkX, int a_ChunkY, int a_ChunkZ,
+	cChunkMap * a_ChunkMap, cWorld * a_World,
+	cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP
+)
+{
+	sStorage Storage;
+	if (m_Pool.empty())
+	{
+		Storage.m_Memory = ::operator new(sizeof(cChunk));
+		Storage.m_WaterSimulatorData = a_World->GetWaterSimulator()->CreateChunkData();
+		Storage.m_LavaSimulatorData  = a_World->GetLavaSimulator ()->CreateChunkData();
+		Storage.m_Data = NULL;
+		m_NumAllocations++;
+	}
+	else
+	{
+		Storage = m_Pool.back();
+		m_Pool.pop_back();
+		m_NumReuses++;
+	}
+	if (Storage.m_Data == NULL)
+	{
+		Storage.m_Data = new cChunkBuffer;
+	}
+
+	return new(Storage.m_Memory) cChunk(
+		a_ChunkX, a_ChunkY, a_ChunkZ,
+		a_ChunkMap, a_World,
+		a_NeighborXM, a_NeighborXP, a_NeighborZM, a_NeighborZP,
+		Storage.m_WaterSimulatorData, Storage.m_LavaSimulatorData,
+		Storage.m_Data
+	);
+}
+
+
+
+
+
+void cChunkPool::Free(cChunk * a_Chunk)
+{
+	if (a_Chunk == NULL)
+	{
+		return;
+	}
+
+	sStorage Storage;
+	Storage.m_Memory = a_Chunk;
+	Storage.m_WaterSimulatorData = a_Chunk->GetWaterSimulatorData();
+	Storage.m_LavaSimulatorData  = a_Chunk->GetLavaSimulatorData();
+	Storage.m_Data = a_Chunk->GetData();
+	Storage.m_Data->AddRef();
+	a_Chunk->~cChunk();
+	
+	// If a snapshot still uses the block data, leave the buffer to it:
+	if (Storage.m_Data->IsShared())
+	{
+		Storage.m_Data->Release();
+		Storage.m_Data = NULL;
+	}
+
+	if ((int)m_Pool.size() >= m_MaxSize)
+	{
+		Release(Storage);
+		m_NumReleases++;
+		return;
+	}
+
+	// Pending fluid blocks belong to the old chunk, they mustn't be simulated in the next one:
+	if (Storage.m_WaterSimulatorData != NULL)
+	{
+		Storage.m_WaterSimulatorData->Clear();
+	}
+	if (Storage.m_LavaSimulatorData != NULL)
+	{
+		Storage.m_LavaSimulatorData->Clear();
+	}
+	m_Pool.push_back(Storage);
+}
+
+
+
+
+
+void cChunkPool::Clear(void)
+{
+	for (cStorages::iterator itr = m_Pool.begin(), end = m_Pool.end(); itr != end; ++itr)
+	{
+		Release(*itr);
+	}
+	m_Pool.clear();
+}
+
+
+
+
+
+void cChunkPool::Release(sStorage & a_Storage)
+{
+	delete a_Storage.m_WaterSimulatorData;
+	delete a_Storage.m_LavaSimulatorData;
+	if (a_Storage.m_Data != NULL)
+	{
+		a_Storage.m_Data->Release();
+	}
+	::operator delete(a_Storage.m_Memory);
+	a_Storage.m_WaterSimulatorData = NULL;
+	a_Storage.m_LavaSimulatorData = NULL;
+	a_Storage.m_Data = NULL;
+	a_Storage.m_Memory = NULL;
+}
+
+
+
+
@@ -0,0 +1,90 @@
+
+// ChunkPool.h
+
+// Interfaces to the cChunkPool class representing a per-world pool of chunk storage that is recycled across chunk unloads and loads
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cChunk;
+class cChunkMap;
+class cWorld;
+class cFluidSimulatorData;
+class cChunkBuffer;
+
+
+
+
+
+/** Recycles the memory of unloaded cChunk objects, together with their fluid simulator data and block data buffers.
+Each chunk's block data buffer is over 160 KiB; players walking around the map
+cause a constant stream of chunks being unloaded and new ones being created. Instead of freeing the memory
+and allocating it again a moment later, up to a configured number of chunk-sized memory blocks are kept
+and new chunks are constructed in them.
+The fluid simulator data objects are kept with the memory block; they are cleared and handed to the next chunk.
+So is the block data buffer, unless a snapshot still references it when the chunk is unloaded; then the snapshot
+keeps the buffer and the next chunk gets a new one.
+The pool is not thread-safe by itself, the owning cChunkMap calls it only with its m_CSLayers locked.
+*/
+class cChunkPool
+{
+public:
+	cChunkPool(void);
+	~cChunkPool();
+
+	/// Sets the maximum number of unused chunks kept in the pool. Excess pooled chunks are released.
+	void SetMaxSize(int a_MaxSize);
+
+	/// Constructs a new cChunk object, reusing pooled storage if available
+	cChunk * Allocate(
+		int a_ChunkX, int a_ChunkY, int a_ChunkZ,
+		cChunkMap * a_ChunkMap, cWorld * a_World,
+		cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP
+	);
+
+	/// Destroys the cChunk object and keeps its storage in the pool, unless the pool is full
+	void Free(cChunk * a_Chunk);
+
+	/// Releases all the pooled storage
+	void Clear(void);
+
+	// Statistics:
+	int GetMaxSize       (void) const { return m_MaxSize; }
+	int GetNumPooled     (void) const { return (int)m_Pool.size(); }
+	int GetNumAllocations(void) const { return m_NumAllocations; }  ///< Number of chunks constructed in newly allocated memory
+	int GetNumReuses     (void) const { return m_NumReuses; }       ///< Number of chunks constructed in pooled memory
+	int GetNumReleases   (void) const { return m_NumReleases; }     ///< Number of chunks whose memory was freed because the pool was full
+
+protected:
+	/// The storage of a single chunk, kept in the pool between uses
+	struct sStorage
+	{
+		void *                m_Memory;
+		cFluidSimulatorData * m_WaterSimulatorData;
+		cFluidSimulatorData * m_LavaSimulatorData;
+		cChunkBuffer *        m_Data;  ///< NULL if the chunk's buffer couldn't be kept
+	} ;
+
+	typedef std::vector<sStorage> cStorages;
+
+	cStorages m_Pool;
+	int       m_MaxSize;
+	int       m_NumAllocations;
+	int       m_NumReuses;
+	int       m_NumReleases;
+
+	/// Frees the memory, simulator data and block data of the storage
+	static void Release(sStorage & a_Storage);
+} ;
+
+
+
+
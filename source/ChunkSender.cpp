@@ -10,7 +10,8 @@
 #include "Globals.h"
 #include "ChunkSender.h"
 #include "World.h"
-#include "BlockEntities/BlockEntity.h"
+#include "ClientHandle.h"
+#include "ChunkSnapshot.h"
 #include "Protocol/ChunkDataSerializer.h"
 
 
@@ -35,6 +36,7 @@ void cNotifyChunkSender::Call(int a_ChunkX, int a_ChunkZ)
 cChunkSender::cChunkSender(void) :
 	super("ChunkSender"),
 	m_World(NULL),
+	m_CS("ChunkSender queue"),
 	m_Notify(NULL),
 	m_RemoveCount(0)
 {
@@ -205,29 +207,28 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, cClientHa
 		return;
 	}
 	
-	// If the chunk is not valid, do nothing - whoever needs it has queued it for loading / generating
-	if (!m_World->IsChunkValid(a_ChunkX, a_ChunkZ))
+	// Query the chunk data. If the chunk is not valid, do nothing - whoever needs it has queued it for loading / generating
+	cChunkSnapshot Snapshot;
+	if (!m_World->GetChunkSnapshot(a_ChunkX, a_ChunkZ, Snapshot))
 	{
 		return;
 	}
 	
 	// If the chunk is not lighted, queue it for relighting and get notified when it's ready:
-	if (!m_World->IsChunkLighted(a_ChunkX, a_ChunkZ))
+	if (!Snapshot.IsLightValid())
 	{
 		m_World->QueueLightChunk(a_ChunkX, a_ChunkZ, &m_Notify);
 		return;
 	}
 	
-	// Query and prepare chunk data:
-	if (!m_World->GetChunkData(a_ChunkX, a_ChunkZ, *this))
-	{
-		return;
-	}
-	cChunkDataSerializer Data(m_BlockTypes, m_BlockMetas, m_BlockLight, m_BlockSkyLight, m_BiomeMap);
+	ConvertBiomes(Snapshot.GetBiomeMap());
+	cChunkDataSerializer Data(Snapshot.GetBlockTypes(), Snapshot.GetBlockMetas(), Snapshot.GetBlockLight(), Snapshot.GetSkyLight(), m_BiomeMap);
 	
 	// Send:
 	if (a_Client == NULL)
 	{
+		// Compress now for the protocol that most clients use, so that it isn't done inside the broadcast with the ChunkMap's CS locked:
+		Data.Serialize(cChunkDataSerializer::RELEASE_1_3_2);
 		m_World->BroadcastChunkData(a_ChunkX, a_ChunkZ, Data);
 	}
 	else
@@ -236,18 +237,7 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, cClientHa
 	}
 	
 	// Send block-entity packets:
-	for (sBlockCoords::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
-	{
-		if (a_Client == NULL)
-		{
-			m_World->BroadcastBlockEntity(itr->m_BlockX, itr->m_BlockY, itr->m_BlockZ);
-		}
-		else
-		{
-			m_World->SendBlockEntity(itr->m_BlockX, itr->m_BlockY, itr->m_BlockZ, *a_Client);
-		}
-	}  // for itr - m_Packets[]
-	m_BlockEntities.clear();
+	m_World->SendChunkBlockEntities(a_ChunkX, a_ChunkZ, a_Client);
 	
 	// TODO: Send entity spawn packets
 }
@@ -256,31 +246,14 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, cClientHa
 
 
 
-void cChunkSender::BlockEntity(cBlockEntity * a_Entity)
-{
-	m_BlockEntities.push_back(sBlockCoord(a_Entity->GetPosX(), a_Entity->GetPosY(), a_Entity->GetPosZ()));
-}
-
-
-
-
-void cChunkSender::Entity(cEntity * a_Entity)
-{
-	// Nothing needed yet, perhaps in the future when we save entities into chunks we'd like to send them upon load, too ;)
-}
-
-
-
-
-
-void cChunkSender::BiomeData(const cChunkDef::BiomeMap * a_BiomeMap)
+void cChunkSender::ConvertBiomes(const cChunkDef::BiomeMap & a_BiomeMap)
 {
 	for (int i = 0; i < ARRAYCOUNT(m_BiomeMap); i++)
 	{
-		if ((*a_BiomeMap)[i] < 255)
+		if (a_BiomeMap[i] < 255)
 		{
 			// Normal MC biome, copy as-is:
-			m_BiomeMap[i] = (unsigned char)((*a_BiomeMap)[i]);
+			m_BiomeMap[i] = (unsigned char)(a_BiomeMap[i]);
 		}
 		else
 		{
@@ -11,10 +11,10 @@ to come to a queue.
 And once they do, it requests the chunk data and sends it all away, either
 	broadcasting (ChunkReady), or
 	sends to a specific client (QueueSendChunkTo)
-Chunk data is queried using the cChunkDataCallback interface.
-It is cached inside the ChunkSender object during the query and then processed after the query ends.
-Note that the data needs to be compressed only *after* the query finishes, 
-because the query callbacks run with ChunkMap's CS locked.
+Chunk data is taken as a read-only snapshot, through cWorld::GetChunkSnapshot(), which doesn't wait for the world tick
+and doesn't copy the data. The snapshot is serialized without holding any locks. When broadcasting, the data is compressed
+before it is handed to the world, because the broadcast runs with ChunkMap's CS locked.
+The block entities are sent afterwards, by the world, since they can only be accessed with ChunkMap's CS locked.
 
 A client may remove itself from all direct requests(QueueSendChunkTo()) by calling RemoveClient(); 
 this ensures that the client's Send() won't be called anymore by ChunkSender.
@@ -67,8 +67,7 @@ public:
 
 
 class cChunkSender:
-	public cIsThread,
-	public cChunkDataSeparateCollector
+	public cIsThread
 {
 	typedef cIsThread super;
 public:
@@ -117,22 +116,6 @@ protected:
 		}
 	} ;
 	typedef std::list<sSendChunk> sSendChunkList;
-
-	struct sBlockCoord
-	{
-		int m_BlockX;
-		int m_BlockY;
-		int m_BlockZ;
-		
-		sBlockCoord(int a_BlockX, int a_BlockY, int a_BlockZ) :
-			m_BlockX(a_BlockX),
-			m_BlockY(a_BlockY),
-			m_BlockZ(a_BlockZ)
-		{
-		}
-	} ;
-
-	typedef std::vector<sBlockCoord> sBlockCoords;
 	
 	cWorld * m_World;
 	
@@ -145,20 +128,15 @@ protected:
 	
 	cNotifyChunkSender m_Notify;  // Used for chunks that don't have a valid lighting - they will be re-queued after lightcalc
 	
-	// Data about the chunk that is being sent:
-	// NOTE that m_BlockData[] is inherited from the cChunkDataCollector
+	// Data about the chunk that is being sent; the rest is read directly from the chunk's snapshot:
 	unsigned char m_BiomeMap[cChunkDef::Width * cChunkDef::Width];
-	sBlockCoords  m_BlockEntities;  // Coords of the block entities to send
 	// TODO: sEntityIDs    m_Entities;       // Entity-IDs of the entities to send
 	
 	// cIsThread override:
 	virtual void Execute(void) override;
 	
-	// cChunkDataCollector overrides:
-	// (Note that they are called while the ChunkMap's CS is locked - don't do heavy calculations here!)
-	virtual void BiomeData    (const cChunkDef::BiomeMap * a_BiomeMap) override;
-	virtual void Entity       (cEntity *      a_Entity) override;
-	virtual void BlockEntity  (cBlockEntity * a_Entity) override;
+	/// Converts the chunk's biomes into m_BiomeMap[], in the format the protocol uses
+	void ConvertBiomes(const cChunkDef::BiomeMap & a_BiomeMap);
 
 	/// Sends the specified chunk to a_Client, or to all chunk clients if a_Client == NULL
 	void SendChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, cClientHandle * a_Client);
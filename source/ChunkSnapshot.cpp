@@ -0,0 +1,169 @@
+
+// ChunkSnapshot.cpp
+
+// Implements the cChunkBuffer class holding a chunk's block data, and the cChunkSnapshot class providing read-only access to it
+
+#include "Globals.h"
+#include "ChunkSnapshot.h"
+
+
+
+
+
+/// Adds a_Delta to a_Value atomically, returns the new value
+static int AtomicAdd(volatile int & a_Value, int a_Delta)
+{
+	#ifdef _WIN32
+		return InterlockedExchangeAdd((volatile LONG *)&a_Value, a_Delta) + a_Delta;
+	#else
+		return __sync_add_and_fetch(&a_Value, a_Delta);
+	#endif
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cChunkBuffer:
+
+cChunkBuffer::cChunkBuffer(void) :
+	m_IsLightValid(false),
+	m_RefCount(1)
+{
+}
+
+
+
+
+
+cChunkBuffer * cChunkBuffer::Clone(void) const
+{
+	cChunkBuffer * res = new cChunkBuffer;
+	memcpy(res->m_BlockTypes,    m_BlockTypes,    sizeof(m_BlockTypes));
+	memcpy(res->m_BlockMeta,     m_BlockMeta,     sizeof(m_BlockMeta));
+	memcpy(res->m_BlockLight,    m_BlockLight,    sizeof(m_BlockLight));
+	memcpy(res->m_BlockSkyLight, m_BlockSkyLight, sizeof(m_BlockSkyLight));
+	memcpy(res->m_HeightMap,     m_HeightMap,     sizeof(m_HeightMap));
+	memcpy(res->m_BiomeMap,      m_BiomeMap,      sizeof(m_BiomeMap));
+	res->m_IsLightValid = m_IsLightValid;
+	return res;
+}
+
+
+
+
+
+void cChunkBuffer::AddRef(void)
+{
+	AtomicAdd(m_RefCount, 1);
+}
+
+
+
+
+
+void cChunkBuffer::Release(void)
+{
+	int RefCount = AtomicAdd(m_RefCount, -1);
+	ASSERT(RefCount >= 0);
+	if (RefCount == 0)
+	{
+		delete this;
+	}
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cChunkSnapshot:
+
+cChunkSnapshot::cChunkSnapshot(void) :
+	m_Buffer(NULL)
+{
+}
+
+
+
+
+
+cChunkSnapshot::cChunkSnapshot(const cChunkSnapshot & a_Other) :
+	m_Buffer(a_Other.m_Buffer)
+{
+	if (m_Buffer != NULL)
+	{
+		m_Buffer->AddRef();
+	}
+}
+
+
+
+
+
+cChunkSnapshot::~cChunkSnapshot()
+{
+	Clear();
+}
+
+
+
+
+
+cChunkSnapshot & cChunkSnapshot::operator =(const cChunkSnapshot & a_Other)
+{
+	Set(a_Other.m_Buffer);
+	return *this;
+}
+
+
+
+
+
+void cChunkSnapshot::Clear(void)
+{
+	if (m_Buffer != NULL)
+	{
+		m_Buffer->Release();
+		m_Buffer = NULL;
+	}
+}
+
+
+
+
+
+void cChunkSnapshot::GetBlockData(cChunkDataCallback & a_Callback) const
+{
+	ASSERT(IsValid());
+
+	a_Callback.HeightMap (&m_Buffer->m_HeightMap);
+	a_Callback.BiomeData (&m_Buffer->m_BiomeMap);
+	a_Callback.BlockTypes(m_Buffer->m_BlockTypes);
+	a_Callback.BlockMeta (m_Buffer->m_BlockMeta);
+	if (a_Callback.LightIsValid(m_Buffer->m_IsLightValid))
+	{
+		a_Callback.BlockLight   (m_Buffer->m_BlockLight);
+		a_Callback.BlockSkyLight(m_Buffer->m_BlockSkyLight);
+	}
+}
+
+
+
+
+
+void cChunkSnapshot::Set(cChunkBuffer * a_Buffer)
+{
+	// AddRef first, in case a_Buffer is the one we already reference:
+	if (a_Buffer != NULL)
+	{
+		a_Buffer->AddRef();
+	}
+	Clear();
+	m_Buffer = a_Buffer;
+}
+
+
+
+
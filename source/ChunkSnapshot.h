@@ -0,0 +1,116 @@
+
+// ChunkSnapshot.h
+
+// Interfaces to the cChunkBuffer class holding a chunk's block data, and the cChunkSnapshot class providing read-only access to it
+
+/*
+The chunk keeps its block data (block types, metas, light, heightmap, biomes) in a reference-counted cChunkBuffer.
+A background thread (lighting, chunk sender, storage) asks the chunk for a cChunkSnapshot, which only adds a reference
+to the chunk's current buffer; nothing is copied, and the chunk's m_CSData is locked just for taking the reference.
+The snapshot can then be read for as long as needed, without any locks.
+
+A buffer that is referenced by any snapshot is never changed. When the chunk is about to change its block data and
+the buffer is shared, it first replaces the buffer with a private copy and changes the copy (copy-on-write); the
+snapshots keep their version of the data. Only the first change after a snapshot is taken pays for the copy,
+and if the snapshots have already been released by then, the buffer is changed in place without copying.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+
+
+
+
+
+/** The block data of a single chunk, shared by the chunk and the snapshots of it.
+Only the owning chunk changes the data, and only while it holds the only reference.
+*/
+class cChunkBuffer
+{
+public:
+	cChunkDef::BlockTypes   m_BlockTypes;
+	cChunkDef::BlockNibbles m_BlockMeta;
+	cChunkDef::BlockNibbles m_BlockLight;
+	cChunkDef::BlockNibbles m_BlockSkyLight;
+	cChunkDef::HeightMap    m_HeightMap;
+	cChunkDef::BiomeMap     m_BiomeMap;
+	bool m_IsLightValid;  ///< True if the blocklight and skylight are calculated
+
+	/// Creates a new buffer with a single reference; the data is uninitialized
+	cChunkBuffer(void);
+
+	/// Creates a copy of this buffer, with a single reference
+	cChunkBuffer * Clone(void) const;
+
+	void AddRef(void);
+
+	/// Drops a reference; deletes the buffer when the last one is dropped
+	void Release(void);
+
+	/// Returns true if there's more than one reference to the buffer
+	bool IsShared(void) const { return (m_RefCount > 1); }
+
+protected:
+	volatile int m_RefCount;
+
+	/// Only Release() may delete the buffer
+	~cChunkBuffer() {}
+
+	// Not copyable, use Clone() instead:
+	cChunkBuffer(const cChunkBuffer &);
+	cChunkBuffer & operator =(const cChunkBuffer &);
+} ;
+
+
+
+
+
+/** Read-only access to a chunk's block data as it was when the snapshot was taken.
+Taken by cChunk::GetSnapshot(); can be copied and kept around, each copy holds a reference to the data.
+*/
+class cChunkSnapshot
+{
+public:
+	cChunkSnapshot(void);
+	cChunkSnapshot(const cChunkSnapshot & a_Other);
+	~cChunkSnapshot();
+
+	cChunkSnapshot & operator =(const cChunkSnapshot & a_Other);
+
+	/// Returns true if the snapshot holds any data
+	bool IsValid(void) const { return (m_Buffer != NULL); }
+
+	/// Drops the reference to the data
+	void Clear(void);
+
+	// The data access; may be called only on a valid snapshot:
+	bool IsLightValid(void) const                            { return m_Buffer->m_IsLightValid; }
+	const cChunkDef::BlockTypes   & GetBlockTypes(void) const { return m_Buffer->m_BlockTypes; }
+	const cChunkDef::BlockNibbles & GetBlockMetas(void) const { return m_Buffer->m_BlockMeta; }
+	const cChunkDef::BlockNibbles & GetBlockLight(void) const { return m_Buffer->m_BlockLight; }
+	const cChunkDef::BlockNibbles & GetSkyLight  (void) const { return m_Buffer->m_BlockSkyLight; }
+	const cChunkDef::HeightMap    & GetHeightMap (void) const { return m_Buffer->m_HeightMap; }
+	const cChunkDef::BiomeMap     & GetBiomeMap  (void) const { return m_Buffer->m_BiomeMap; }
+
+	/** Calls the callback's block data methods (heightmap, biomes, block types and metas, light) with the snapshot's data.
+	The light is given only if the callback's LightIsValid() returns true.
+	*/
+	void GetBlockData(cChunkDataCallback & a_Callback) const;
+
+protected:
+	friend class cChunk;
+
+	cChunkBuffer * m_Buffer;
+
+	/// Makes the snapshot reference the specified buffer. Called by cChunk with its m_CSData locked.
+	void Set(cChunkBuffer * a_Buffer);
+} ;
+
+
+
+
@@ -80,6 +80,8 @@ int cClientHandle::s_ClientCount = 0;
 cClientHandle::cClientHandle(const cSocket * a_Socket, int a_ViewDistance)
 	: m_ViewDistance(a_ViewDistance)
 	, m_IPString(a_Socket->GetIPString())
+	, m_CSChunkLists("Client chunk lists")
+	, m_CSOutgoingData("Client outgoing data")
 	, m_OutgoingData(64 KiB)
 	, m_Player(NULL)
 	, m_HasSentDC(false)
@@ -91,6 +93,11 @@ cClientHandle::cClientHandle(const cSocket * a_Socket, int a_ViewDistance)
 	, m_State(csConnected)
 	, m_LastStreamedChunkX(0x7fffffff)  // bogus chunk coords to force streaming upon login
 	, m_LastStreamedChunkZ(0x7fffffff)
+	, m_RequestedViewDistance(a_ViewDistance)
+	, m_DrainRate(256 KiB)
+	, m_NumBytesDrained(0)
+	, m_HasOutgoingBacklog(false)
+	, m_TimeSinceDrainRateUpdate(0)
 	, m_ShouldCheckDownloaded(false)
 	, m_UniqueID(0)
 	, m_BlockDigAnimStage(-1)
@@ -127,6 +134,7 @@ cClientHandle::~cClientHandle()
 		cCSLock Lock(m_CSChunkLists);
 		m_LoadedChunks.clear();
 		m_ChunksToSend.clear();
+		m_ChunksToStream.clear();
 	}
 
 	if (m_Player != NULL)
@@ -343,21 +351,27 @@ void cClientHandle::StreamChunks(void)
 	}  // for itr - RemoveChunks[]
 	
 	// Add all chunks that are in range and not yet in m_LoadedChunks:
-	// Queue these smartly - from the center out to the edge
+	// Queue these smartly - from the center out to the edge; StreamNextChunks() sends them as fast as the connection allows
+	cChunkCoordsList ChunksToStream;
 	for (int d = 0; d <= m_ViewDistance; ++d)  // cycle through (square) distance, from nearest to furthest
 	{
 		// For each distance add chunks in a hollow square centered around current position:
 		for (int i = -d; i <= d; ++i)
 		{
-			StreamChunk(ChunkPosX + d, ChunkPosZ + i);
-			StreamChunk(ChunkPosX - d, ChunkPosZ + i);
+			ChunksToStream.push_back(cChunkCoords(ChunkPosX + d, ZERO_CHUNK_Y, ChunkPosZ + i));
+			ChunksToStream.push_back(cChunkCoords(ChunkPosX - d, ZERO_CHUNK_Y, ChunkPosZ + i));
 		}  // for i
 		for (int i = -d + 1; i < d; ++i)
 		{
-			StreamChunk(ChunkPosX + i, ChunkPosZ + d);
-			StreamChunk(ChunkPosX + i, ChunkPosZ - d);
+			ChunksToStream.push_back(cChunkCoords(ChunkPosX + i, ZERO_CHUNK_Y, ChunkPosZ + d));
+			ChunksToStream.push_back(cChunkCoords(ChunkPosX + i, ZERO_CHUNK_Y, ChunkPosZ - d));
 		}  // for i
 	}  // for d
+	{
+		cCSLock Lock(m_CSChunkLists);
+		std::swap(m_ChunksToStream, ChunksToStream);
+	}
+	StreamNextChunks();
 	
 	// Touch chunks GENERATEDISTANCE ahead to let them generate:
 	for (int d = m_ViewDistance + 1; d <= m_ViewDistance + GENERATEDISTANCE; ++d)  // cycle through (square) distance, from nearest to furthest
@@ -379,12 +393,12 @@ void cClientHandle::StreamChunks(void)
 
 
 
-void cClientHandle::StreamChunk(int a_ChunkX, int a_ChunkZ)
+bool cClientHandle::StreamChunk(int a_ChunkX, int a_ChunkZ)
 {
 	if (m_State >= csDestroying)
 	{
 		// Don't stream chunks to clients that are being destroyed
-		return;
+		return false;
 	}
 	
 	cWorld * World = m_Player->GetWorld();
@@ -398,7 +412,108 @@ void cClientHandle::StreamChunk(int a_ChunkX, int a_ChunkZ)
 			m_ChunksToSend.push_back(cChunkCoords(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ));
 		}
 		World->SendChunkTo(a_ChunkX, a_ChunkZ, this);
+		return true;
+	}
+	return false;
+}
+
+
+
+
+
+void cClientHandle::StreamNextChunks(void)
+{
+	if ((m_Player == NULL) || (m_State >= csDestroying))
+	{
+		return;
+	}
+	
+	// Send about a second worth of data at a time; the chunks that are being prepared by the chunk sender count, too:
+	int Budget = std::max((int)MIN_CHUNK_STREAM_BUDGET, m_DrainRate);
+	int Backlog = GetOutgoingBacklog();
+	for (;;)
+	{
+		int ChunkX, ChunkZ;
+		{
+			cCSLock Lock(m_CSChunkLists);
+			if (m_ChunksToStream.empty() || (Backlog + (int)m_ChunksToSend.size() * ESTIMATED_CHUNK_SIZE >= Budget))
+			{
+				return;
+			}
+			ChunkX = m_ChunksToStream.front().m_ChunkX;
+			ChunkZ = m_ChunksToStream.front().m_ChunkZ;
+			m_ChunksToStream.pop_front();
+		}
+		StreamChunk(ChunkX, ChunkZ);  // Chunks that the client already has are skipped
+	}
+}
+
+
+
+
+
+void cClientHandle::UpdateDrainRate(float a_Dt)
+{
+	int Backlog = GetOutgoingBacklog();
+	if (Backlog > 0)
+	{
+		m_HasOutgoingBacklog = true;
+	}
+	m_TimeSinceDrainRateUpdate += a_Dt;
+	if (m_TimeSinceDrainRateUpdate < 1000)
+	{
+		return;
+	}
+	
+	int NumBytesDrained;
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		NumBytesDrained = m_NumBytesDrained;
+		m_NumBytesDrained = 0;
+	}
+	int Rate = (int)((double)NumBytesDrained * 1000 / m_TimeSinceDrainRateUpdate);
+	if (m_HasOutgoingBacklog)
+	{
+		// The connection couldn't take all the data, so the measured rate is what it can do:
+		m_DrainRate = (m_DrainRate + Rate) / 2;
+	}
+	else
+	{
+		// The connection took everything, it may be able to take more:
+		m_DrainRate = std::max(m_DrainRate, Rate) + m_DrainRate / 4;
+	}
+	m_DrainRate = std::max((int)MIN_DRAIN_RATE, std::min((int)MAX_DRAIN_RATE, m_DrainRate));
+	m_HasOutgoingBacklog = false;
+	m_TimeSinceDrainRateUpdate = 0;
+}
+
+
+
+
+
+void cClientHandle::UpdateViewDistance(void)
+{
+	int ViewDistance = std::min(m_RequestedViewDistance, cRoot::Get()->GetServer()->GetLoadGovernor().GetViewDistanceCap());
+	if (ViewDistance == m_ViewDistance)
+	{
+		return;
 	}
+	m_ViewDistance = ViewDistance;
+	
+	// Need to re-stream chunks for the change to become apparent; reset the last streamed coords so that StreamChunks() doesn't skip it:
+	m_LastStreamedChunkX = 0x7fffffff;
+	m_LastStreamedChunkZ = 0x7fffffff;
+	StreamChunks();
+}
+
+
+
+
+
+int cClientHandle::GetOutgoingBacklog(void)
+{
+	cCSLock Lock(m_CSOutgoingData);
+	return m_OutgoingData.GetReadableSpace() + (int)m_OutgoingDataOverflow.size();
 }
 
 
@@ -418,6 +533,7 @@ void cClientHandle::RemoveFromAllChunks()
 		cCSLock Lock(m_CSChunkLists);
 		m_LoadedChunks.clear();
 		m_ChunksToSend.clear();
+		m_ChunksToStream.clear();
 		
 		// Also reset the LastStreamedChunk coords to bogus coords,
 		// so that all chunks are streamed in subsequent StreamChunks() call (FS #407)
@@ -1380,6 +1496,7 @@ void cClientHandle::MoveToWorld(cWorld & a_World, bool a_SendRespawnPacket)
 		cCSLock Lock(m_CSChunkLists);
 		std::swap(Chunks, m_LoadedChunks);
 		m_ChunksToSend.clear();
+		m_ChunksToStream.clear();
 	}
 	for (cChunkCoordsList::iterator itr = Chunks.begin(), end = Chunks.end(); itr != end; ++itr)
 	{
@@ -1472,6 +1589,11 @@ void cClientHandle::Tick(float a_Dt)
 		return;
 	}
 	
+	// Stream the chunks at the pace of the connection:
+	UpdateViewDistance();
+	UpdateDrainRate(a_Dt);
+	StreamNextChunks();
+	
 	// If the chunk the player's in was just sent, spawn the player:
 	if (m_HasSentPlayerChunk && (m_State != csPlaying) && !IsDestroying())
 	{
@@ -2080,10 +2202,10 @@ void cClientHandle::SetViewDistance(int a_ViewDistance)
 	{
 		a_ViewDistance = MAX_VIEW_DISTANCE;
 	}
-	m_ViewDistance = a_ViewDistance;
+	m_RequestedViewDistance = a_ViewDistance;
 	
-	// Need to re-stream chunks for the change to become apparent:
-	StreamChunks();
+	// Apply the load governor's cap and re-stream the chunks, if needed:
+	UpdateViewDistance();
 }
 
 
@@ -2165,6 +2287,7 @@ void cClientHandle::DataReceived(const char * a_Data, int a_Size)
 {
 	// Data is received from the client, store it in the buffer to be processed by the Tick thread:
 	m_TimeSinceLastPacket = 0;
+	cRoot::Get()->GetServer()->GetMetrics().AddBytesReceived(a_Size);
 	cCSLock Lock(m_CSIncomingData);
 	m_IncomingData.append(a_Data, a_Size);
 }
@@ -2182,7 +2305,9 @@ void cClientHandle::GetOutgoingData(AString & a_Data)
 		m_OutgoingData.CommitRead();
 		a_Data.append(m_OutgoingDataOverflow);
 		m_OutgoingDataOverflow.clear();
+		m_NumBytesDrained += (int)a_Data.size();
 	}
+	cRoot::Get()->GetServer()->GetMetrics().AddBytesSent((int)a_Data.size());
 
 	// Disconnect player after all packets have been sent
 	if (m_HasSentDC && a_Data.empty())
@@ -147,6 +147,9 @@ public:
 	
 	void SetViewDistance(int a_ViewDistance);		// tolua_export
 	int  GetViewDistance(void) const { return m_ViewDistance; }  // tolua_export
+	
+	/// Returns the number of bytes waiting in the outgoing buffers
+	int GetOutgoingBacklog(void);
 
 	int GetUniqueID() const { return m_UniqueID; }	// tolua_export
 	
@@ -208,6 +211,19 @@ private:
 	
 	static const int GENERATEDISTANCE = 2; // Server generates this many chunks AHEAD of player sight. 2 is the minimum, since foliage is generated 1 step behind chunk terrain generation
 	
+	/** Chunks are handed over for sending only while the outgoing data, including the chunks being prepared, is below a second worth
+	of the connection's drain rate, but at least this many bytes, so that a slow link isn't flooded with chunk data
+	queued in front of the other packets.
+	*/
+	static const int MIN_CHUNK_STREAM_BUDGET = 64 KiB;
+	
+	/// Rough size of a compressed chunk, in bytes; used for estimating the size of the chunks being prepared for sending
+	static const int ESTIMATED_CHUNK_SIZE = 8 KiB;
+	
+	/// Limits for the estimated drain rate, in bytes per second
+	static const int MIN_DRAIN_RATE = 16 KiB;
+	static const int MAX_DRAIN_RATE = 16 MiB;
+	
 	AString m_IPString;
 
 	int     m_ProtocolVersion;
@@ -236,6 +252,26 @@ private:
 	// Chunk position when the last StreamChunks() was called; used to avoid re-streaming while in the same chunk
 	int m_LastStreamedChunkX;
 	int m_LastStreamedChunkZ;
+	
+	/** Chunks in the view distance that haven't been handed over to the world for sending yet, nearest first.
+	StreamNextChunks() hands them over as fast as the client's connection takes the data. Protected by m_CSChunkLists.
+	*/
+	cChunkCoordsList m_ChunksToStream;
+	
+	/// The view distance set for the player; m_ViewDistance is lower while the server's load governor limits it
+	int m_RequestedViewDistance;
+	
+	/// Estimated rate at which the client's connection takes the outgoing data, in bytes per second
+	int m_DrainRate;
+	
+	/// Number of bytes taken by the socket thread since the last drain rate update. Protected by m_CSOutgoingData.
+	int m_NumBytesDrained;
+	
+	/// True if there was data waiting in the outgoing buffers in any tick since the last drain rate update
+	bool m_HasOutgoingBacklog;
+	
+	/// Time since the last drain rate update, in msec
+	float m_TimeSinceDrainRateUpdate;
 
 	/// Seconds since the last packet data was received (updated in Tick(), reset in DataReceived())
 	float m_TimeSinceLastPacket;
@@ -307,8 +343,17 @@ private:
 	/// Returns true if the rate block interactions is within a reasonable limit (bot protection)
 	bool CheckBlockInteractionsRate(void);
 	
-	/// Adds a single chunk to be streamed to the client; used by StreamChunks()
-	void StreamChunk(int a_ChunkX, int a_ChunkZ);
+	/// Adds a single chunk to be streamed to the client; used by StreamNextChunks(). Returns true if the chunk was queued for sending.
+	bool StreamChunk(int a_ChunkX, int a_ChunkZ);
+	
+	/// Hands the chunks from m_ChunksToStream over to the world for sending, as long as the client's connection keeps up
+	void StreamNextChunks(void);
+	
+	/// Updates m_DrainRate once a second, based on how much data the socket thread has taken
+	void UpdateDrainRate(float a_Dt);
+	
+	/// Applies the load governor's view distance cap to the requested view distance; re-streams the chunks if the view distance changes
+	void UpdateViewDistance(void);
 	
 	/// Handles the DIG_STARTED dig packet:
 	void HandleBlockDigStarted (int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, BLOCKTYPE a_OldBlock, NIBBLETYPE a_OldMeta);
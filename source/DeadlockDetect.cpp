@@ -117,7 +117,7 @@ void cDeadlockDetect::CheckWorldAge(const AString & a_WorldName, Int64 a_Age)
 		itr->second.m_NumCyclesSame += 1;
 		if (itr->second.m_NumCyclesSame > NUM_CYCLES_LIMIT)
 		{
-			DeadlockDetected();
+			DeadlockDetected(a_WorldName);
 			return;
 		}
 	}
@@ -132,8 +132,16 @@ void cDeadlockDetect::CheckWorldAge(const AString & a_WorldName, Int64 a_Age)
 
 
 
-void cDeadlockDetect::DeadlockDetected(void)
+void cDeadlockDetect::DeadlockDetected(const AString & a_WorldName)
 {
+	LOGERROR("Deadlock detected: world %s hasn't ticked for %d seconds. Locks:", a_WorldName.c_str(), NUM_CYCLES_LIMIT * CYCLE_MILLISECONDS / 1000);
+	AStringVector Report = cCriticalSection::GetProfilingReport();
+	for (AStringVector::const_iterator itr = Report.begin(), end = Report.end(); itr != end; ++itr)
+	{
+		LOGERROR("%s", itr->c_str());
+	}
+	cMCLogger::GetInstance()->Flush();
+	
 	ASSERT(!"Deadlock detected");
 	
 	// TODO: Make a crashdump / coredump
@@ -7,6 +7,7 @@
 This class simply monitors each world's m_WorldAge, which is expected to grow on each tick.
 If the world age doesn't grow for several seconds, it's either because the server is super-overloaded,
 or because the world tick thread hangs in a deadlock. We presume the latter and therefore kill the server.
+Before that, the lock profiling report is logged, which (in a LOCK_PROFILING build) tells which threads hold which locks.
 Once we learn to write crashdumps programmatically, we should do so just before killing, to enable debugging.
 */
 
@@ -56,8 +57,8 @@ protected:
 	/// Checks if the world's age has changed, updates the world's stats; calls DeadlockDetected() if deadlock detected
 	void CheckWorldAge(const AString & a_WorldName, Int64 a_Age);
 	
-	/// Called when a deadlock is detected. Aborts the server.
-	void DeadlockDetected(void);
+	/// Called when a deadlock is detected in the specified world. Logs the lock report and aborts the server.
+	void DeadlockDetected(const AString & a_WorldName);
 } ;
 
 
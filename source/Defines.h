@@ -44,6 +44,9 @@ extern bool g_BlockIsSolid[256];
 /// Can torches be placed on this block?
 extern bool g_BlockIsTorchPlaceable[256];
 
+/// Does the block do anything when ticked randomly? Chunks don't pick the other blocks for random ticks at all
+extern bool g_BlockIsRandomTicked[256];
+
 /// Experience Orb setup
 enum
 {
@@ -43,6 +43,10 @@ cEntity::cEntity(eEntityType a_EntityType, double a_X, double a_Y, double a_Z, d
 	, m_bDirtySpeed(true)
 	, m_bOnGround( false )
 	, m_Gravity( -9.81f )
+	, m_IsPhysicsBatched(false)
+	, m_PhysicsBatchSolidNeighbors(0)
+	, m_PhysicsBatchBlockIdx(-1)
+	, m_PhysicsBatchSolidGeneration(0)
 	, m_IsInitialized(false)
 	, m_LastPosX( 0.0 )
 	, m_LastPosY( 0.0 )
@@ -495,6 +499,11 @@ void cEntity::Tick(float a_Dt, cChunk & a_Chunk)
 			SetPosition(m_AttachedTo->GetPosition());
 		}
 	}
+	else if (m_IsPhysicsBatched)
+	{
+		// The chunk's physics batch has already moved this entity in this tick
+		m_IsPhysicsBatched = false;
+	}
 	else
 	{
 		if (a_Chunk.IsValid())
@@ -347,6 +347,9 @@ public:
 	
 	/// Called when the specified player right-clicks this entity
 	virtual void OnRightClicked(cPlayer & a_Player) {};
+	
+	/// Makes cEntityPhysicsBatch recompute the entity's solid-block neighborhood; called when the entity is added to a chunk
+	void InvalidatePhysicsBatchCache(void) { m_PhysicsBatchBlockIdx = -1; }
 
 	/// Returns the list of drops for this pawn when it is killed. May check a_Killer for special handling (sword of looting etc.). Called from KilledBy().
 	virtual void GetDrops(cItems & a_Drops, cEntity * a_Killer = NULL) {}
@@ -378,6 +381,16 @@ protected:
 	bool     m_bOnGround;
 	float    m_Gravity;
 	
+	/// Set by cEntityPhysicsBatch when it has already handled the physics of this entity in the current tick
+	bool     m_IsPhysicsBatched;
+	
+	/** The solid-block neighborhood that cEntityPhysicsBatch computed for the entity in an earlier tick, kept so that it needn't be read again.
+	Valid while the entity stays in the block m_PhysicsBatchBlockIdx (-1 if none) of its chunk and the chunk's solid blocks generation stays the same.
+	*/
+	UInt32   m_PhysicsBatchSolidNeighbors;
+	int      m_PhysicsBatchBlockIdx;
+	UInt32   m_PhysicsBatchSolidGeneration;
+	
 	// Last Position.
 	double m_LastPosX, m_LastPosY, m_LastPosZ;
 
@@ -410,6 +423,7 @@ protected:
 	void SetWorld(cWorld * a_World) { m_World = a_World; }
 	
 	friend class cReferenceManager;
+	friend class cEntityPhysicsBatch;
 	void AddReference( cEntity*& a_EntityPtr );
 	void ReferencedBy( cEntity*& a_EntityPtr );
 	void Dereference( cEntity*& a_EntityPtr );
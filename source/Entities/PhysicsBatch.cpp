@@ -0,0 +1,275 @@
+
+// PhysicsBatch.cpp
+
+// Implements the cEntityPhysicsBatch class that handles the physics of simple entities in a chunk all at once
+
+#include "Globals.h"
+
+#include "PhysicsBatch.h"
+#include "../Chunk.h"
+
+
+
+
+
+/// Returns the bit in cEntityPhysicsBatch::m_SolidNeighbors for the specified offset from the entity's block
+#define NEIGHBOR_BIT(x, y, z) (1u << (((y) + 1) * 9 + ((z) + 1) * 3 + ((x) + 1)))
+
+
+
+
+
+cEntityPhysicsBatch::cEntityPhysicsBatch(void)
+{
+}
+
+
+
+
+
+void cEntityPhysicsBatch::Tick(float a_Dt, cChunk & a_Chunk, cEntityList & a_Entities)
+{
+	if (!a_Chunk.IsValid())
+	{
+		return;
+	}
+
+	Clear();
+	for (cEntityList::iterator itr = a_Entities.begin(), end = a_Entities.end(); itr != end; ++itr)
+	{
+		if ((*itr)->IsPickup())
+		{
+			Gather(**itr, a_Chunk);
+		}
+	}
+	if (m_Entities.empty())
+	{
+		return;
+	}
+
+	Integrate(a_Dt / 1000);
+	Scatter();
+}
+
+
+
+
+
+void cEntityPhysicsBatch::Clear(void)
+{
+	m_Entities.clear();
+	m_PosX.clear();
+	m_PosY.clear();
+	m_PosZ.clear();
+	m_SpeedX.clear();
+	m_SpeedY.clear();
+	m_SpeedZ.clear();
+	m_WaterSpeedX.clear();
+	m_WaterSpeedY.clear();
+	m_WaterSpeedZ.clear();
+	m_Gravity.clear();
+	m_IsOnGround.clear();
+	m_SolidNeighbors.clear();
+	m_ShouldFallBack.clear();
+}
+
+
+
+
+
+void cEntityPhysicsBatch::Gather(cEntity & a_Entity, cChunk & a_Chunk)
+{
+	if (a_Entity.IsDestroyed() || (a_Entity.m_AttachedTo != NULL))
+	{
+		return;
+	}
+
+	// The whole neighborhood must be within this chunk:
+	int BlockY = (int)floor(a_Entity.GetPosY());
+	int RelX = (int)floor(a_Entity.GetPosX()) - a_Chunk.GetPosX() * cChunkDef::Width;
+	int RelZ = (int)floor(a_Entity.GetPosZ()) - a_Chunk.GetPosZ() * cChunkDef::Width;
+	if (
+		(BlockY < 1) || (BlockY > cChunkDef::Height - 2) ||
+		(RelX < 1) || (RelX > cChunkDef::Width - 2) ||
+		(RelZ < 1) || (RelZ > cChunkDef::Width - 2)
+	)
+	{
+		return;
+	}
+
+	// Water and cobwebs need the full handling, and so does an entity stuck in a solid block:
+	BLOCKTYPE BlockIn = a_Chunk.GetBlock(RelX, BlockY, RelZ);
+	if (g_BlockIsSolid[BlockIn] || IsBlockWater(BlockIn) || (BlockIn == E_BLOCK_COBWEB))
+	{
+		return;
+	}
+
+	// Reuse the neighborhood from the previous ticks if the entity hasn't left its block and the chunk's solid blocks haven't changed.
+	// Most pickups rest on the ground for minutes, this saves them 27 block lookups per tick:
+	int BlockIdx = (int)cChunkDef::MakeIndexNoCheck(RelX, BlockY, RelZ);
+	UInt32 Generation = a_Chunk.GetSolidBlocksGeneration();
+	if ((a_Entity.m_PhysicsBatchBlockIdx != BlockIdx) || (a_Entity.m_PhysicsBatchSolidGeneration != Generation))
+	{
+		UInt32 SolidNeighbors = 0;
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int z = -1; z <= 1; z++)
+			{
+				for (int x = -1; x <= 1; x++)
+				{
+					if (g_BlockIsSolid[a_Chunk.GetBlock(RelX + x, BlockY + y, RelZ + z)])
+					{
+						SolidNeighbors |= NEIGHBOR_BIT(x, y, z);
+					}
+				}  // for x
+			}  // for z
+		}  // for y
+		a_Entity.m_PhysicsBatchSolidNeighbors = SolidNeighbors;
+		a_Entity.m_PhysicsBatchBlockIdx = BlockIdx;
+		a_Entity.m_PhysicsBatchSolidGeneration = Generation;
+	}
+
+	m_Entities.push_back(&a_Entity);
+	m_PosX.push_back(a_Entity.GetPosX());
+	m_PosY.push_back(a_Entity.GetPosY());
+	m_PosZ.push_back(a_Entity.GetPosZ());
+	m_SpeedX.push_back(a_Entity.GetSpeedX());
+	m_SpeedY.push_back(a_Entity.GetSpeedY());
+	m_SpeedZ.push_back(a_Entity.GetSpeedZ());
+	m_WaterSpeedX.push_back(a_Entity.m_WaterSpeed.x);
+	m_WaterSpeedY.push_back(a_Entity.m_WaterSpeed.y);
+	m_WaterSpeedZ.push_back(a_Entity.m_WaterSpeed.z);
+	m_Gravity.push_back(a_Entity.GetGravity());
+	m_IsOnGround.push_back(a_Entity.m_bOnGround ? 1 : 0);
+	m_SolidNeighbors.push_back(a_Entity.m_PhysicsBatchSolidNeighbors);
+	m_ShouldFallBack.push_back(0);
+}
+
+
+
+
+
+void cEntityPhysicsBatch::Integrate(double a_Dt)
+{
+	// This follows cEntity::HandlePhysics() for an entity in a non-solid, non-water block,
+	// with the cTracer trace replaced by a per-axis collision test against the neighborhood.
+	double Friction = 0.7 / (1 + a_Dt);
+	size_t NumEntities = m_Entities.size();
+	for (size_t i = 0; i < NumEntities; i++)
+	{
+		UInt32 Solid = m_SolidNeighbors[i];
+		bool IsOnGround = (m_IsOnGround[i] != 0);
+		double SpeedX = m_SpeedX[i];
+		double SpeedY = m_SpeedY[i];
+		double SpeedZ = m_SpeedZ[i];
+
+		if (IsOnGround && ((Solid & NEIGHBOR_BIT(0, -1, 0)) == 0))
+		{
+			IsOnGround = false;
+		}
+		if (!IsOnGround)
+		{
+			SpeedY += m_Gravity[i] * a_Dt;
+		}
+		else if (SpeedX * SpeedX + SpeedY * SpeedY + SpeedZ * SpeedZ > 0.0004)
+		{
+			SpeedX *= Friction;
+			SpeedX = (fabs(SpeedX) < 0.05) ? 0 : SpeedX;
+			SpeedZ *= Friction;
+			SpeedZ = (fabs(SpeedZ) < 0.05) ? 0 : SpeedZ;
+		}
+
+		// The water speed only decays here, the entity is not in water:
+		double WaterSpeedX = m_WaterSpeedX[i] * 0.9;
+		double WaterSpeedY = m_WaterSpeedY[i] * 0.9;
+		double WaterSpeedZ = m_WaterSpeedZ[i] * 0.9;
+		WaterSpeedX = (fabs(WaterSpeedX) < 0.05) ? 0 : WaterSpeedX;
+		WaterSpeedZ = (fabs(WaterSpeedZ) < 0.05) ? 0 : WaterSpeedZ;
+		SpeedX += WaterSpeedX;
+		SpeedY += WaterSpeedY;
+		SpeedZ += WaterSpeedZ;
+
+		// Move, one axis at a time, Y first so that falling entities land before sliding:
+		double PosX = m_PosX[i];
+		double PosY = m_PosY[i];
+		double PosZ = m_PosZ[i];
+		double BaseX = floor(PosX);
+		double BaseY = floor(PosY);
+		double BaseZ = floor(PosZ);
+		double NextY = PosY + SpeedY * a_Dt;
+		double NextX = PosX + SpeedX * a_Dt;
+		double NextZ = PosZ + SpeedZ * a_Dt;
+		if ((fabs(NextX - PosX) >= 1) || (fabs(NextY - PosY) >= 1) || (fabs(NextZ - PosZ) >= 1))
+		{
+			// Too fast for the neighborhood
+			m_ShouldFallBack[i] = 1;
+			continue;
+		}
+
+		int OfsY = (int)(floor(NextY) - BaseY);
+		if ((OfsY != 0) && ((Solid & NEIGHBOR_BIT(0, OfsY, 0)) != 0))
+		{
+			// Same offsets from the hit face as the tracer-based physics uses:
+			NextY = (OfsY < 0) ? (BaseY + 0.05) : (BaseY + 0.95);
+			IsOnGround = IsOnGround || (OfsY < 0);
+			SpeedY = 0;
+			OfsY = 0;
+		}
+		int OfsX = (int)(floor(NextX) - BaseX);
+		if ((OfsX != 0) && ((Solid & NEIGHBOR_BIT(OfsX, OfsY, 0)) != 0))
+		{
+			NextX = (OfsX < 0) ? (BaseX + 0.3) : (BaseX + 0.7);
+			SpeedX = 0;
+			OfsX = 0;
+		}
+		int OfsZ = (int)(floor(NextZ) - BaseZ);
+		if ((OfsZ != 0) && ((Solid & NEIGHBOR_BIT(OfsX, OfsY, OfsZ)) != 0))
+		{
+			NextZ = (OfsZ < 0) ? (BaseZ + 0.3) : (BaseZ + 0.7);
+			SpeedZ = 0;
+		}
+
+		m_PosX[i] = NextX;
+		m_PosY[i] = NextY;
+		m_PosZ[i] = NextZ;
+		m_SpeedX[i] = SpeedX;
+		m_SpeedY[i] = SpeedY;
+		m_SpeedZ[i] = SpeedZ;
+		m_WaterSpeedX[i] = WaterSpeedX;
+		m_WaterSpeedY[i] = WaterSpeedY;
+		m_WaterSpeedZ[i] = WaterSpeedZ;
+		m_IsOnGround[i] = IsOnGround ? 1 : 0;
+	}  // for i - m_Entities[]
+}
+
+
+
+
+
+void cEntityPhysicsBatch::Scatter(void)
+{
+	size_t NumEntities = m_Entities.size();
+	for (size_t i = 0; i < NumEntities; i++)
+	{
+		if (m_ShouldFallBack[i] != 0)
+		{
+			continue;
+		}
+
+		// Set only the changed values, the setters mark the entity for a client update:
+		cEntity & Entity = *m_Entities[i];
+		if (m_PosX[i] != Entity.GetPosX())     Entity.SetPosX(m_PosX[i]);
+		if (m_PosY[i] != Entity.GetPosY())     Entity.SetPosY(m_PosY[i]);
+		if (m_PosZ[i] != Entity.GetPosZ())     Entity.SetPosZ(m_PosZ[i]);
+		if (m_SpeedX[i] != Entity.GetSpeedX()) Entity.SetSpeedX(m_SpeedX[i]);
+		if (m_SpeedY[i] != Entity.GetSpeedY()) Entity.SetSpeedY(m_SpeedY[i]);
+		if (m_SpeedZ[i] != Entity.GetSpeedZ()) Entity.SetSpeedZ(m_SpeedZ[i]);
+		Entity.m_WaterSpeed.Set(m_WaterSpeedX[i], m_WaterSpeedY[i], m_WaterSpeedZ[i]);
+		Entity.m_bOnGround = (m_IsOnGround[i] != 0);
+		Entity.m_IsPhysicsBatched = true;
+	}
+}
+
+
+
+
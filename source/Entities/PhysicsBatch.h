@@ -0,0 +1,91 @@
+
+// PhysicsBatch.h
+
+// Interfaces to the cEntityPhysicsBatch class that handles the physics of simple entities in a chunk all at once
+
+/*
+Most of the entities on a busy server are pickups (item farms easily create thousands of them) and most of them
+are either resting on the ground or falling freely. cEntity::HandlePhysics() handles each of them separately,
+with a virtual call, several neighbor chunk lookups, a water flow query that locks the chunkmap and a cTracer trace.
+
+The batch does the same for all the pickups in a chunk in three passes:
+	- Gather: copies the kinematic state of each eligible entity into parallel arrays, together with a bitmask
+	of the solid blocks in the 3x3x3 neighborhood of the entity. The bitmask is kept in the entity and read from the chunk
+	again only when the entity moves to another block or a block in the chunk changes its solidity
+	(cChunk::GetSolidBlocksGeneration()), so a resting pickup costs a single block lookup per tick.
+	- Integrate: applies gravity, ground friction and water drift and moves the entities, resolving the collisions
+	with the neighborhood blocks one axis at a time. This loop touches only the arrays, no chunk data and no entity objects.
+	- Scatter: writes the new state back into the entities and marks them so that cEntity::Tick() skips HandlePhysics().
+
+Entities that the batch cannot handle exactly enough (in water or cobweb, stuck inside a solid block,
+next to the chunk border or moving more than one block per tick) are left untouched and cEntity::Tick()
+handles them the usual way.
+
+Only pickups are batched. Arrows need the per-entity trace to hit other entities, and falling blocks don't use
+HandlePhysics() at all, they fall straight down a column on their own.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Entity.h"
+
+
+
+
+
+// fwd:
+class cChunk;
+
+
+
+
+
+class cEntityPhysicsBatch
+{
+public:
+	cEntityPhysicsBatch(void);
+
+	/// Handles the physics of all the eligible entities in a_Entities, which are the entities of a_Chunk. a_Dt is in msec.
+	void Tick(float a_Dt, cChunk & a_Chunk, cEntityList & a_Entities);
+
+protected:
+	// The entity state, each array has one item per gathered entity:
+	std::vector<cEntity *> m_Entities;
+	std::vector<double>    m_PosX;
+	std::vector<double>    m_PosY;
+	std::vector<double>    m_PosZ;
+	std::vector<double>    m_SpeedX;
+	std::vector<double>    m_SpeedY;
+	std::vector<double>    m_SpeedZ;
+	std::vector<double>    m_WaterSpeedX;
+	std::vector<double>    m_WaterSpeedY;
+	std::vector<double>    m_WaterSpeedZ;
+	std::vector<double>    m_Gravity;
+	std::vector<char>      m_IsOnGround;
+
+	/// Solid blocks around the entity, bit ((y + 1) * 9 + (z + 1) * 3 + (x + 1)) is set if the block at offset {x, y, z} is solid
+	std::vector<UInt32>    m_SolidNeighbors;
+
+	/// Set by Integrate() for entities that moved too fast for the neighborhood; these are not scattered
+	std::vector<char>      m_ShouldFallBack;
+
+	/// Clears the per-tick arrays, keeping their capacity
+	void Clear(void);
+
+	/// Adds the entity to the arrays, if it is eligible for the batch
+	void Gather(cEntity & a_Entity, cChunk & a_Chunk);
+
+	/// Updates the state in the arrays; a_Dt is in seconds
+	void Integrate(double a_Dt);
+
+	/// Writes the state from the arrays back into the entities
+	void Scatter(void);
+} ;
+
+
+
+
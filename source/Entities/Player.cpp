@@ -1414,8 +1414,10 @@ bool cPlayer::LoadFromDisk()
 		if( itr->second ) LOGINFO("%s", itr->first.c_str() );
 	}
 
-	AString SourceFile;
-	Printf(SourceFile, "players/%s.json", m_PlayerName.c_str() );
+	// If the player's data from a previous session is still waiting to be written, let it finish first:
+	cRoot::Get()->GetPlayerSaver().WaitForPlayer(m_PlayerName);
+
+	AString SourceFile = cPlayerSaver::GetPlayerFileName(m_PlayerName);
 
 	cFile f;
 	if (!f.Open(SourceFile, cFile::fmRead))
@@ -1489,62 +1491,26 @@ bool cPlayer::LoadFromDisk()
 
 bool cPlayer::SaveToDisk()
 {
-	cFile::CreateFolder(FILE_IO_PREFIX + AString("players"));
-
-	// create the JSON data
-	Json::Value JSON_PlayerPosition;
-	JSON_PlayerPosition.append(Json::Value(GetPosX()));
-	JSON_PlayerPosition.append(Json::Value(GetPosY()));
-	JSON_PlayerPosition.append(Json::Value(GetPosZ()));
-
-	Json::Value JSON_PlayerRotation;
-	JSON_PlayerRotation.append(Json::Value(GetRotation()));
-	JSON_PlayerRotation.append(Json::Value(GetPitch()));
-	JSON_PlayerRotation.append(Json::Value(GetRoll()));
-
-	Json::Value JSON_Inventory;
-	m_Inventory.SaveToJson(JSON_Inventory);
-
-	Json::Value root;
-	root["position"]       = JSON_PlayerPosition;
-	root["rotation"]       = JSON_PlayerRotation;
-	root["inventory"]      = JSON_Inventory;
-	root["health"]         = m_Health;
-	root["xpTotal"]        = m_LifetimeTotalXp;
-	root["xpCurrent"]      = m_CurrentXp;
-	root["air"]            = m_AirLevel;
-	root["food"]           = m_FoodLevel;
-	root["foodSaturation"] = m_FoodSaturationLevel;
-	root["foodTickTimer"]  = m_FoodTickTimer;
-	root["foodExhaustion"] = m_FoodExhaustionLevel;
-	root["world"] = GetWorld()->GetName();
-
-	if (m_GameMode == GetWorld()->GetGameMode())
-	{
-		root["gamemode"] = (int) eGameMode_NotSet;
-	}
-	else
-	{
-		root["gamemode"] = (int) m_GameMode;
-	}
-
-	Json::StyledWriter writer;
-	std::string JsonData = writer.write(root);
-
-	AString SourceFile;
-	Printf(SourceFile, "players/%s.json", m_PlayerName.c_str() );
-
-	cFile f;
-	if (!f.Open(SourceFile, cFile::fmWrite))
-	{
-		LOGERROR("ERROR WRITING PLAYER \"%s\" TO FILE \"%s\" - cannot open file", m_PlayerName.c_str(), SourceFile.c_str());
-		return false;
-	}
-	if (f.Write(JsonData.c_str(), JsonData.size()) != (int)JsonData.size())
-	{
-		LOGERROR("ERROR WRITING PLAYER JSON TO FILE \"%s\"", SourceFile.c_str()); 
-		return false;
-	}
+	// Only take a snapshot of the data here, the serializing and writing is done in the player saver thread:
+	cPlayerSaver::sPlayerData Data;
+	Data.m_PlayerName          = m_PlayerName;
+	Data.m_Position            = GetPosition();
+	Data.m_Yaw                 = GetRotation();
+	Data.m_Pitch               = GetPitch();
+	Data.m_Roll                = GetRoll();
+	m_Inventory.CopyAllSlots(Data.m_Inventory);
+	Data.m_Health              = m_Health;
+	Data.m_LifetimeTotalXp     = m_LifetimeTotalXp;
+	Data.m_CurrentXp           = m_CurrentXp;
+	Data.m_AirLevel            = m_AirLevel;
+	Data.m_FoodLevel           = m_FoodLevel;
+	Data.m_FoodSaturationLevel = m_FoodSaturationLevel;
+	Data.m_FoodTickTimer       = m_FoodTickTimer;
+	Data.m_FoodExhaustionLevel = m_FoodExhaustionLevel;
+	Data.m_WorldName           = GetWorld()->GetName();
+	Data.m_GameMode            = (m_GameMode == GetWorld()->GetGameMode()) ? (int)eGameMode_NotSet : (int)m_GameMode;
+
+	cRoot::Get()->GetPlayerSaver().QueueSave(Data);
 	return true;
 }
 
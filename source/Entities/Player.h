@@ -265,6 +265,7 @@ public:
 
 	bool MoveToWorld(const char * a_WorldName);  // tolua_export
 
+	/// Takes a snapshot of the player's data and queues it for writing in the player saver thread
 	bool SaveToDisk(void);
 	bool LoadFromDisk(void);
 	void LoadPermissionsFromDisk(void);											// tolua_export
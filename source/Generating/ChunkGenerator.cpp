@@ -30,6 +30,7 @@ const unsigned int QUEUE_SKIP_LIMIT = 500;
 cChunkGenerator::cChunkGenerator(void) :
 	super("cChunkGenerator"),
 	m_World(NULL),
+	m_CS("Generator queue"),
 	m_Generator(NULL)
 {
 }
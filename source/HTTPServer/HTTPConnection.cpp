@@ -35,7 +35,7 @@ cHTTPConnection::~cHTTPConnection()
 
 void cHTTPConnection::SendStatusAndReason(int a_StatusCode, const AString & a_Response)
 {
-	AppendPrintf(m_OutgoingData, "%d %s\r\nContent-Length: 0\r\n\r\n", a_StatusCode, a_Response.c_str());
+	AppendPrintf(m_OutgoingData, "HTTP/1.1 %d %s\r\nContent-Length: 0\r\n\r\n", a_StatusCode, a_Response.c_str());
 	m_HTTPServer.NotifyConnectionWrite(*this);
 	m_State = wcsRecvHeaders;
 }
@@ -80,6 +80,20 @@ void cHTTPConnection::Send(const void * a_Data, int a_Size)
 
 
 
+void cHTTPConnection::SendWholeResponse(cHTTPResponse & a_Response, const AString & a_Body)
+{
+	ASSERT(m_State == wcsRecvIdle);
+	a_Response.SetContentLength((int)a_Body.size());
+	a_Response.AppendToData(m_OutgoingData);
+	m_OutgoingData.append(a_Body);
+	m_State = wcsRecvHeaders;
+	m_HTTPServer.NotifyConnectionWrite(*this);
+}
+
+
+
+
+
 void cHTTPConnection::FinishResponse(void)
 {
 	ASSERT(m_State == wcsSendingResp);
@@ -195,9 +209,10 @@ void cHTTPConnection::DataReceived(const char * a_Data, int a_Size)
 		case wcsRecvBody:
 		{
 			ASSERT(m_CurrentRequest != NULL);
+			int BytesToConsume = 0;
 			if (m_CurrentRequestBodyRemaining > 0)
 			{
-				int BytesToConsume = std::min(m_CurrentRequestBodyRemaining, a_Size);
+				BytesToConsume = std::min(m_CurrentRequestBodyRemaining, a_Size);
 				m_HTTPServer.RequestBody(*this, *m_CurrentRequest, a_Data, BytesToConsume);
 				m_CurrentRequestBodyRemaining -= BytesToConsume;
 			}
@@ -207,6 +222,12 @@ void cHTTPConnection::DataReceived(const char * a_Data, int a_Size)
 				m_HTTPServer.RequestFinished(*this, *m_CurrentRequest);
 				delete m_CurrentRequest;
 				m_CurrentRequest = NULL;
+				
+				// The client may have pipelined the next request on this persistent connection, process it:
+				if ((a_Size > BytesToConsume) && (m_State == wcsRecvHeaders))
+				{
+					DataReceived(a_Data + BytesToConsume, a_Size - BytesToConsume);
+				}
 			}
 			break;
 		}
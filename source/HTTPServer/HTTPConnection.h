@@ -56,6 +56,11 @@ public:
 	/// Sends the data as the response (may be called multiple times)
 	void Send(const AString & a_Data) { Send(a_Data.data(), a_Data.size()); }
 	
+	/** Sends the entire response - the headers from a_Response and a_Body - using Content-Length instead of the chunked encoding.
+	Sets a_Response's content length to the body size. The connection is ready for the next request afterwards.
+	*/
+	void SendWholeResponse(cHTTPResponse & a_Response, const AString & a_Body);
+	
 	/// Indicates that the current response is finished, gets ready for receiving another request (HTTP 1.1 keepalive)
 	void FinishResponse(void);
 	
@@ -64,6 +64,22 @@ void cHTTPMessage::AddHeader(const AString & a_Key, const AString & a_Value)
 
 
 
+AString cHTTPMessage::GetHeader(const AString & a_Key) const
+{
+	AString Key = a_Key;
+	StrToLower(Key);
+	cNameValueMap::const_iterator itr = m_Headers.find(Key);
+	if (itr == m_Headers.end())
+	{
+		return AString();
+	}
+	return itr->second;
+}
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cHTTPRequest:
 
@@ -200,14 +216,16 @@ int cHTTPRequest::ParseRequestLine(const char * a_Data, int a_Size)
 					return -1;
 				}
 				// Check that there's HTTP/version at the end
-				if (strncmp(a_Data + URLEnd + 1, "HTTP/1.", 7) != 0)
+				if (strncmp(m_IncomingHeaderData.c_str() + URLEnd + 1, "HTTP/1.", 7) != 0)
 				{
 					m_IsValid = false;
 					return -1;
 				}
 				m_Method = m_IncomingHeaderData.substr(LineStart, MethodEnd - LineStart);
 				m_URL = m_IncomingHeaderData.substr(MethodEnd + 1, URLEnd - MethodEnd - 1);
-				return i + 1;
+				
+				// Return the number of bytes consumed from a_Data, the line may have started in a previous call:
+				return (int)(i + 1 + a_Size - IdxEnd);
 			}
 		}  // switch (m_IncomingHeaderData[i])
 	}  // for i - m_IncomingHeaderData[]
@@ -247,8 +265,20 @@ void cHTTPRequest::OnHeaderLine(const AString & a_Key, const AString & a_Value)
 // cHTTPResponse:
 
 cHTTPResponse::cHTTPResponse(void) :
-	super(mkResponse)
+	super(mkResponse),
+	m_StatusCode(HTTP_OK),
+	m_StatusReason("OK")
+{
+}
+
+
+
+
+
+void cHTTPResponse::SetStatus(int a_StatusCode, const AString & a_Reason)
 {
+	m_StatusCode = a_StatusCode;
+	m_StatusReason = a_Reason;
 }
 
 
@@ -257,12 +287,29 @@ cHTTPResponse::cHTTPResponse(void) :
 
 void cHTTPResponse::AppendToData(AString & a_DataStream) const
 {
-	a_DataStream.append("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nContent-Type: ");
-	a_DataStream.append(m_ContentType);
-	a_DataStream.append("\r\n");
+	AppendPrintf(a_DataStream, "HTTP/1.1 %d %s\r\n", m_StatusCode, m_StatusReason.c_str());
+	if (m_StatusCode == HTTP_NOT_MODIFIED)
+	{
+		// No body follows, and Content-Length would have to be the length of the unmodified content; send neither
+	}
+	else if (m_ContentLength >= 0)
+	{
+		AppendPrintf(a_DataStream, "Content-Length: %d\r\n", m_ContentLength);
+	}
+	else
+	{
+		a_DataStream.append("Transfer-Encoding: chunked\r\n");
+	}
+	if (!m_ContentType.empty())
+	{
+		a_DataStream.append("Content-Type: ");
+		a_DataStream.append(m_ContentType);
+		a_DataStream.append("\r\n");
+	}
 	for (cNameValueMap::const_iterator itr = m_Headers.begin(), end = m_Headers.end(); itr != end; ++itr)
 	{
-		if ((itr->first == "Content-Type") || (itr->first == "Content-Length"))
+		// The keys are stored lowercase by AddHeader():
+		if ((itr->first == "content-type") || (itr->first == "content-length"))
 		{
 			continue;
 		}
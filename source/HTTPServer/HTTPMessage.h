@@ -21,7 +21,9 @@ public:
 	enum
 	{
 		HTTP_OK = 200,
+		HTTP_NOT_MODIFIED = 304,
 		HTTP_BAD_REQUEST = 400,
+		HTTP_NOT_FOUND = 404,
 	} ;
 
 	enum eKind
@@ -40,6 +42,9 @@ public:
 	
 	const AString & GetContentType  (void) const { return m_ContentType; }
 	int             GetContentLength(void) const { return m_ContentLength; }
+	
+	/// Returns the value of the specified header (case-insensitive name), or an empty string if the header is not present
+	AString GetHeader(const AString & a_Key) const;
 
 protected:
 	typedef std::map<AString, AString> cNameValueMap;
@@ -153,10 +158,18 @@ class cHTTPResponse :
 public:
 	cHTTPResponse(void);
 	
+	/// Sets the status code and reason that are sent in the response line; 200 OK by default
+	void SetStatus(int a_StatusCode, const AString & a_Reason);
+	
 	/** Appends the response to the specified datastream - response line and headers.
-	The body will be sent later directly through cConnection::Send()
+	If the content length is set, the body is expected to be sent as-is (cHTTPConnection::SendWholeResponse()),
+	otherwise the chunked transfer encoding is announced and the body is sent in chunks through cHTTPConnection::Send()
 	*/
 	void AppendToData(AString & a_DataStream) const;
+	
+protected:
+	int     m_StatusCode;
+	AString m_StatusReason;
 } ;
 
 
@@ -516,6 +516,39 @@ bool cInventory::AddToBar( cItem & a_Item, const int a_Offset, const int a_Size,
 
 
 void cInventory::SaveToJson(Json::Value & a_Value)
+{
+	cItems Slots;
+	CopyAllSlots(Slots);
+	SaveSlotsToJson(Slots, a_Value);
+}
+
+
+
+
+
+void cInventory::CopyAllSlots(cItems & a_Slots) const
+{
+	a_Slots.clear();
+	a_Slots.reserve(invNumSlots);
+	for (int i = 0; i < invArmorCount; i++)
+	{
+		a_Slots.push_back(m_ArmorSlots.GetSlot(i));
+	}
+	for (int i = 0; i < invInventoryCount; i++)
+	{
+		a_Slots.push_back(m_InventorySlots.GetSlot(i));
+	}
+	for (int i = 0; i < invHotbarCount; i++)
+	{
+		a_Slots.push_back(m_HotbarSlots.GetSlot(i));
+	}
+}
+
+
+
+
+
+void cInventory::SaveSlotsToJson(const cItems & a_Slots, Json::Value & a_Value)
 {
 	// The JSON originally included the 4 crafting slots and the result, so we have to put empty items there, too:
 	cItem EmptyItem;
@@ -526,27 +559,11 @@ void cInventory::SaveToJson(Json::Value & a_Value)
 		a_Value.append(EmptyItemJson);
 	}
 	
-	// The 4 armor slots follow:
-	for (int i = 0; i < invArmorCount; i++)
-	{
-		Json::Value JSON_Item;
-		m_ArmorSlots.GetSlot(i).GetJson(JSON_Item);
-		a_Value.append(JSON_Item);
-	}
-
-	// Next comes the main inventory:
-	for (int i = 0; i < invInventoryCount; i++)
-	{
-		Json::Value JSON_Item;
-		m_InventorySlots.GetSlot(i).GetJson(JSON_Item);
-		a_Value.append(JSON_Item);
-	}
-
-	// The hotbar is the last:
-	for (int i = 0; i < invHotbarCount; i++)
+	// The armor slots, the main inventory and the hotbar follow, in this order:
+	for (cItems::const_iterator itr = a_Slots.begin(); itr != a_Slots.end(); ++itr)
 	{
 		Json::Value JSON_Item;
-		m_HotbarSlots.GetSlot(i).GetJson(JSON_Item);
+		itr->GetJson(JSON_Item);
 		a_Value.append(JSON_Item);
 	}
 }
@@ -155,6 +155,12 @@ public:
 
 	void SaveToJson(Json::Value & a_Value);
 	bool LoadFromJson(Json::Value & a_Value);
+	
+	/// Copies all the slots, in the GetSlot() order, into a_Slots; used for taking a snapshot for saving
+	void CopyAllSlots(cItems & a_Slots) const;
+	
+	/// Writes the slots, as copied by CopyAllSlots(), into a_Value, in the format read by LoadFromJson()
+	static void SaveSlotsToJson(const cItems & a_Slots, Json::Value & a_Value);
 
 protected:
 	bool AddToBar( cItem & a_Item, const int a_Offset, const int a_Size, bool* a_bChangedSlots, int a_Mode = 0 );
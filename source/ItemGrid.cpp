@@ -27,6 +27,17 @@ cItemGrid::cItemGrid(int a_Width, int a_Height) :
 
 cItemGrid::~cItemGrid()
 {
+	// Let the listeners that are still registered drop their pointers to this grid:
+	cListeners Listeners;
+	{
+		cCSLock Lock(m_CSListeners);
+		std::swap(Listeners, m_Listeners);
+	}
+	for (cListeners::iterator itr = Listeners.begin(), end = Listeners.end(); itr != end; ++itr)
+	{
+		(*itr)->OnGridDestroyed(this);
+	}
+	
 	delete[] m_Slots;
 }
 
@@ -26,6 +26,9 @@ public:
 	public:
 		/// Called whenever a slot changes
 		virtual void OnSlotChanged(cItemGrid * a_ItemGrid, int a_SlotNum) = 0;
+		
+		/// Called when the grid is being destroyed, for listeners that keep a pointer to it. The listener is removed by the grid itself.
+		virtual void OnGridDestroyed(cItemGrid * a_ItemGrid) { UNUSED(a_ItemGrid); }
 	} ;
 	typedef std::vector<cListener *> cListeners;
 	
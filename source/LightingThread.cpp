@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "LightingThread.h"
 #include "ChunkMap.h"
+#include "ChunkSnapshot.h"
 #include "World.h"
 
 
@@ -76,7 +77,8 @@ public:
 
 cLightingThread::cLightingThread(void) :
 	super("cLightingThread"),
-	m_World(NULL)
+	m_World(NULL),
+	m_CS("Lighting queue")
 {
 }
 
@@ -354,22 +356,32 @@ void cLightingThread::LightChunk(cLightingThread::sItem & a_Item)
 
 bool cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
 {
+	// Take the snapshots of all the chunks first, so that we don't copy anything if any of them is missing:
+	cChunkSnapshot Snapshots[3][3];
+	for (int z = 0; z < 3; z++)
+	{
+		for (int x = 0; x < 3; x++)
+		{
+			if (!m_World->GetChunkSnapshot(a_ChunkX + x - 1, a_ChunkZ + z - 1, Snapshots[x][z]))
+			{
+				return false;
+			}
+		}  // for x
+	}  // for z
+	
+	// Scatter the data into the 3x3 arrays, no locks are needed for that:
 	cReader Reader;
 	Reader.m_BlockTypes = m_BlockTypes;
 	Reader.m_HeightMap  = m_HeightMap;
-	
 	for (int z = 0; z < 3; z++)
 	{
 		Reader.m_ReadingChunkZ = z;
 		for (int x = 0; x < 3; x++)
 		{
 			Reader.m_ReadingChunkX = x;
-			if (!m_World->GetChunkData(a_ChunkX + x - 1, a_ChunkZ + z - 1, Reader))
-			{
-				return false;
-			}
-		}  // for z
-	}  // for x
+			Snapshots[x][z].GetBlockData(Reader);
+		}  // for x
+	}  // for z
 	
 	memset(m_BlockLight, 0, sizeof(m_BlockLight));
 	memset(m_SkyLight,   0, sizeof(m_SkyLight));
@@ -0,0 +1,121 @@
+
+// LoadGovernor.cpp
+
+// Implements the cLoadGovernor class that reduces the clients' view distance while the server is overloaded
+
+#include "Globals.h"
+
+#include "LoadGovernor.h"
+#include "ClientHandle.h"
+#include "Root.h"
+#include "../iniFile/iniFile.h"
+
+
+
+
+
+cLoadGovernor::cLoadGovernor(void) :
+	m_IsEnabled(false),
+	m_MaxTickTime(45),
+	m_MaxMemory(0),
+	m_MinViewDistance(cClientHandle::MIN_VIEW_DISTANCE),
+	m_EvaluationInterval(5000),
+	m_ViewDistanceCap(cClientHandle::MAX_VIEW_DISTANCE),
+	m_TimeSinceEvaluation(0),
+	m_SumTickTimes(0),
+	m_NumTicks(0)
+{
+}
+
+
+
+
+
+void cLoadGovernor::Init(cIniFile & a_SettingsIni)
+{
+	m_IsEnabled          = a_SettingsIni.GetValueSetB("LoadGovernor", "Enabled",             false);
+	m_MaxTickTime        = a_SettingsIni.GetValueSetI("LoadGovernor", "MaxTickTime",         45);
+	m_MaxMemory          = a_SettingsIni.GetValueSetI("LoadGovernor", "MaxMemoryMiB",        0) * 1024;
+	m_MinViewDistance    = a_SettingsIni.GetValueSetI("LoadGovernor", "MinViewDistance",     cClientHandle::MIN_VIEW_DISTANCE);
+	m_EvaluationInterval = (float)a_SettingsIni.GetValueSetI("LoadGovernor", "EvaluationSeconds", 5) * 1000;
+
+	m_MinViewDistance = std::max((int)cClientHandle::MIN_VIEW_DISTANCE, std::min((int)cClientHandle::MAX_VIEW_DISTANCE, m_MinViewDistance));
+	m_ViewDistanceCap = cClientHandle::MAX_VIEW_DISTANCE;
+}
+
+
+
+
+
+void cLoadGovernor::ReportTickTime(int a_TickTime)
+{
+	if (!m_IsEnabled)
+	{
+		return;
+	}
+	cCSLock Lock(m_CS);
+	m_SumTickTimes += a_TickTime;
+	m_NumTicks++;
+}
+
+
+
+
+
+void cLoadGovernor::Tick(float a_Dt)
+{
+	if (!m_IsEnabled)
+	{
+		return;
+	}
+	m_TimeSinceEvaluation += a_Dt;
+	if (m_TimeSinceEvaluation < m_EvaluationInterval)
+	{
+		return;
+	}
+	m_TimeSinceEvaluation = 0;
+	Evaluate();
+}
+
+
+
+
+
+void cLoadGovernor::Evaluate(void)
+{
+	int AvgTickTime = 0;
+	{
+		cCSLock Lock(m_CS);
+		if (m_NumTicks > 0)
+		{
+			AvgTickTime = (int)(m_SumTickTimes / m_NumTicks);
+		}
+		m_SumTickTimes = 0;
+		m_NumTicks = 0;
+	}
+	int Memory = (m_MaxMemory > 0) ? cRoot::GetPhysicalRAMUsage() : 0;
+
+	bool IsOverloaded = (AvgTickTime > m_MaxTickTime) || ((m_MaxMemory > 0) && (Memory > m_MaxMemory));
+
+	// Raise the cap only when there's enough headroom, so that the cap doesn't oscillate around the threshold:
+	bool HasHeadroom = (AvgTickTime * 4 < m_MaxTickTime * 3) && ((m_MaxMemory <= 0) || (Memory * 10 < m_MaxMemory * 9));
+
+	if (IsOverloaded && (m_ViewDistanceCap > m_MinViewDistance))
+	{
+		m_ViewDistanceCap--;
+		LOGWARNING("Server overloaded (avg tick %d ms, memory %d MiB), limiting the view distance to %d",
+			AvgTickTime, Memory / 1024, m_ViewDistanceCap
+		);
+	}
+	else if (HasHeadroom && (m_ViewDistanceCap < cClientHandle::MAX_VIEW_DISTANCE))
+	{
+		m_ViewDistanceCap++;
+		LOGINFO("Server load decreased (avg tick %d ms, memory %d MiB), limiting the view distance to %d",
+			AvgTickTime, Memory / 1024, m_ViewDistanceCap
+		);
+	}
+}
+
+
+
+
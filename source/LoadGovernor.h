@@ -0,0 +1,72 @@
+
+// LoadGovernor.h
+
+// Interfaces to the cLoadGovernor class that reduces the clients' view distance while the server is overloaded
+
+/*
+The worlds report the duration of each of their ticks; the server tick thread periodically evaluates the average
+tick duration and the memory usage of the process. When either of them is over its configured threshold,
+the view distance cap is lowered by one; once both are comfortably below the thresholds again, the cap
+is raised by one. The clients apply the cap in their Tick(), as if the player had changed their view distance.
+The governor is disabled by default, in which case the cap stays at the maximum view distance.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+// fwd:
+class cIniFile;
+
+
+
+
+
+class cLoadGovernor
+{
+public:
+	cLoadGovernor(void);
+
+	/// Reads the settings from the [LoadGovernor] section of settings.ini
+	void Init(cIniFile & a_SettingsIni);
+
+	/// Called by the world tick threads after each tick, with the duration of the tick in msec
+	void ReportTickTime(int a_TickTime);
+
+	/// Called from the server tick thread; re-evaluates the server load and adjusts the cap once in a while
+	void Tick(float a_Dt);
+
+	/// Returns the maximum view distance that the clients may currently use
+	int GetViewDistanceCap(void) const { return m_ViewDistanceCap; }
+
+	bool IsEnabled(void) const { return m_IsEnabled; }
+
+protected:
+	bool  m_IsEnabled;
+	int   m_MaxTickTime;          ///< Average tick duration, in msec, above which the server is considered overloaded
+	int   m_MaxMemory;            ///< Physical memory usage, in KiB, above which the server is considered overloaded; 0 for no limit
+	int   m_MinViewDistance;      ///< The cap is never lowered below this
+	float m_EvaluationInterval;   ///< How often the load is evaluated and the cap adjusted, in msec
+
+	/// The current cap; written only by the server tick thread, read by the world tick threads
+	int m_ViewDistanceCap;
+
+	/// Time since the last evaluation, in msec
+	float m_TimeSinceEvaluation;
+
+	cCriticalSection m_CS;  ///< Protects the tick time statistics below
+	Int64 m_SumTickTimes;   ///< Sum of the tick durations reported since the last evaluation
+	int   m_NumTicks;       ///< Number of the ticks reported since the last evaluation
+
+	/// Evaluates the statistics collected since the last evaluation and adjusts the cap
+	void Evaluate(void);
+} ;
+
+
+
+
@@ -104,42 +104,65 @@ void cLog::Log(const char * a_Format, va_list argList)
 	AString Message;
 	AppendVPrintf(Message, a_Format, argList);
 
-	time_t rawtime;
-	time ( &rawtime );
-	
+	AString Line = FormatLine(time(NULL), cIsThread::GetCurrentID(), Message);
+	WriteLine(Line);
+	Flush();
+	PrintToConsole(Line);
+}
+
+
+
+
+
+AString cLog::FormatLine(time_t a_Time, unsigned long a_ThreadID, const AString & a_Message)
+{
 	struct tm* timeinfo;
 #ifdef _MSC_VER
 	struct tm timeinforeal;
 	timeinfo = &timeinforeal;
-	localtime_s(timeinfo, &rawtime );
+	localtime_s(timeinfo, &a_Time );
 #else
-	timeinfo = localtime( &rawtime );
+	timeinfo = localtime( &a_Time );
 #endif
 
 	AString Line;
 	#ifdef _DEBUG
-	Printf(Line, "[%04x|%02d:%02d:%02d] %s", cIsThread::GetCurrentID(), timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, Message.c_str());
+	Printf(Line, "[%04lx|%02d:%02d:%02d] %s", a_ThreadID, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, a_Message.c_str());
 	#else
-	Printf(Line, "[%02d:%02d:%02d] %s", timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, Message.c_str());
+	UNUSED(a_ThreadID);
+	Printf(Line, "[%02d:%02d:%02d] %s", timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, a_Message.c_str());
 	#endif
+	return Line;
+}
+
+
+
+
+
+void cLog::WriteLine(const AString & a_Line)
+{
 	if (m_File)
 	{
-		fprintf(m_File, "%s\n", Line.c_str());
-		fflush(m_File);
+		fwrite(a_Line.data(), 1, a_Line.size(), m_File);
+		fputc('\n', m_File);
 	}
+}
 
-	// Print to console:
+
+
+
+
+void cLog::PrintToConsole(const AString & a_Line)
+{
 #if defined(ANDROID_NDK)
-	//__android_log_vprint(ANDROID_LOG_ERROR,"MCServer", a_Format, argList);
-	__android_log_print(ANDROID_LOG_ERROR, "MCServer", "%s", Line.c_str() );
-	//CallJavaFunction_Void_String(g_JavaThread, "AddToLog", Line );
+	__android_log_print(ANDROID_LOG_ERROR, "MCServer", "%s", a_Line.c_str() );
 #else
-	printf("%s", Line.c_str());
+	printf("%s", a_Line.c_str());
 #endif
 
 	#if defined (_WIN32) && defined(_DEBUG)
 	// In a Windows Debug build, output the log to debug console as well:
-	OutputDebugStringA((Line + "\n").c_str());
+	OutputDebugStringA((a_Line + "\n").c_str());
 	#endif  // _WIN32
 }
 
@@ -147,6 +170,18 @@ void cLog::Log(const char * a_Format, va_list argList)
 
 
 
+void cLog::Flush(void)
+{
+	if (m_File)
+	{
+		fflush(m_File);
+	}
+}
+
+
+
+
+
 void cLog::Log(const char* a_Format, ...)
 {
 	va_list argList;
@@ -16,6 +16,19 @@ public:
 	~cLog();
 	void Log(const char* a_Format, va_list argList );
 	void Log(const char* a_Format, ...);
+
+	/// Returns the message prefixed with the time (and the thread ID in Debug builds), as it is written into the log
+	static AString FormatLine(time_t a_Time, unsigned long a_ThreadID, const AString & a_Message);
+
+	/// Writes the already formatted line into the logfile, without flushing it
+	void WriteLine(const AString & a_Line);
+
+	/// Prints the already formatted line to the console, without the trailing newline
+	static void PrintToConsole(const AString & a_Line);
+
+	/// Flushes the data written so far into the logfile
+	void Flush(void);
+
 	// tolua_begin
 	void SimpleLog(const char* a_String);
 	void OpenLog( const char* a_FileName );
@@ -3,11 +3,550 @@
 
 #include <time.h>
 #include "Log.h"
+#include "OSSupport/IsThread.h"
+#include "OSSupport/Timer.h"
 
 
 
 
 
+/// Maximum number of messages waiting to be written; further messages, except errors, are dropped
+static const int MAX_QUEUE_LENGTH = 10000;
+
+/// How often the logfile is flushed, in msec; errors are flushed immediately
+static const int FLUSH_INTERVAL = 1000;
+
+/// Each call site may log at most this many warnings and errors within a RATE_LIMIT_WINDOW, the rest is suppressed
+static const int RATE_LIMIT_COUNT = 20;
+
+/// Length of the rate-limiting window, in msec
+static const int RATE_LIMIT_WINDOW = 10000;
+
+/// How long LOGERROR() and Flush() wait for the message to be written, in msec
+static const int MAX_FLUSH_WAIT = 1000;
+
+
+
+
+
+// Atomic operations used by the lock-free queue:
+
+/// Adds a_Delta to a_Value atomically, returns the new value
+static int AtomicAdd(volatile int & a_Value, int a_Delta)
+{
+	#ifdef _WIN32
+		return InterlockedExchangeAdd((volatile LONG *)&a_Value, a_Delta) + a_Delta;
+	#else
+		return __sync_add_and_fetch(&a_Value, a_Delta);
+	#endif
+}
+
+
+
+
+
+/// Stores a_NewValue into a_Ptr atomically, returns the previous value; a full memory barrier
+template <typename T> static T * AtomicExchange(T * volatile & a_Ptr, T * a_NewValue)
+{
+	#ifdef _WIN32
+		return (T *)InterlockedExchangePointer((PVOID volatile *)&a_Ptr, a_NewValue);
+	#else
+		// __sync_lock_test_and_set() is only an acquire barrier, make it a full one:
+		__sync_synchronize();
+		return __sync_lock_test_and_set(&a_Ptr, a_NewValue);
+	#endif
+}
+
+
+
+
+
+/// A full memory barrier; also makes sure the data of a message is read only after its m_Next pointer has been observed
+static void ReadBarrier(void)
+{
+	#ifdef _WIN32
+		MemoryBarrier();
+	#else
+		__sync_synchronize();
+	#endif
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cMCLogger::cWriter:
+
+class cMCLogger::cWriter :
+	public cIsThread
+{
+	typedef cIsThread super;
+
+public:
+	cWriter(cMCLogger & a_Logger);
+
+	/// Stops the thread and writes the messages still in the queue
+	virtual ~cWriter();
+
+	/** Formats the message and queues it for writing, unless it's rate-limited or the queue is full.
+	If a_ShouldWait is true, waits (for at most MAX_FLUSH_WAIT msec) until the message is written and the logfile flushed.
+	*/
+	void Push(eColorScheme a_Scheme, const char * a_Format, va_list a_ArgList, bool a_ShouldWait);
+
+	/// Waits until the messages queued so far are written and the logfile flushed, for at most MAX_FLUSH_WAIT msec
+	void Flush(void);
+
+	/// Starts the writer thread; until then, and if it fails to start, the messages are written synchronously
+	void StartThread(void);
+
+protected:
+	/// Lets a producer wait until its message is written. Shared by the producer and the writer, the last one to release it deletes it
+	struct sWaiter
+	{
+		cEvent       m_evtWritten;
+		volatile int m_RefCount;
+
+		sWaiter(void) : m_RefCount(2) {}
+
+		void Release(void)
+		{
+			if (AtomicAdd(m_RefCount, -1) == 0)
+			{
+				delete this;
+			}
+		}
+	} ;
+
+	/// A single message in the queue; the queue is a singly-linked list, the oldest message is first
+	struct sMessage
+	{
+		sMessage * volatile m_Next;
+		eColorScheme        m_Scheme;
+		time_t              m_Time;
+		unsigned long       m_ThreadID;
+		AString             m_Text;
+		sWaiter *           m_Waiter;         ///< Signalled when the message is written; NULL if nobody waits for it
+		bool                m_IsFlushMarker;  ///< If true, the message isn't written, it only makes the writer flush the logfile
+
+		sMessage(void) : m_Next(NULL), m_Scheme(csRegular), m_Time(0), m_ThreadID(0), m_Waiter(NULL), m_IsFlushMarker(false) {}
+	} ;
+
+	/// Rate-limiting state of a single call site
+	struct sCallSite
+	{
+		long long m_WindowStart;    ///< cTimer time when the current window started
+		int       m_Count;          ///< Number of messages within the current window
+		int       m_NumSuppressed;  ///< Number of messages not written within the current window
+
+		sCallSite(void) : m_WindowStart(0), m_Count(0), m_NumSuppressed(0) {}
+	} ;
+
+	typedef std::map<AString, sCallSite> cCallSites;
+
+	cMCLogger & m_Logger;
+
+	/// The most recently pushed message; producers swap themselves in here
+	sMessage * volatile m_Head;
+
+	/// The last message already written; its m_Next is the oldest message to write. Owned by the writer thread
+	sMessage * m_Tail;
+
+	/// Number of messages pushed but not yet written
+	volatile int m_NumQueued;
+
+	/// Number of messages dropped because the queue was full
+	volatile int m_NumDropped;
+
+	/// The value of m_NumDropped at the time it was last reported into the log
+	int m_NumDroppedReported;
+
+	/// Set by the producers when the queue becomes non-empty
+	cEvent m_evtQueued;
+
+	/// Set by the writer when it has found a counted message that its producer hasn't linked yet; the producer then sets m_evtQueued
+	volatile bool m_IsWaitingForLink;
+
+	/// True while the thread is running; if it isn't, messages are written synchronously
+	volatile bool m_IsRunning;
+
+	/// ID of the writer thread, so that its own messages don't wait for itself
+	volatile unsigned long m_WriterThreadID;
+
+	cTimer m_Timer;
+
+	/// Guards m_CallSites; the producers check the rate limits, the writer reports the suppressed messages
+	cCriticalSection m_CSCallSites;
+
+	/// The rate-limiting state of all call sites that have logged a warning or an error recently
+	cCallSites m_CallSites;
+
+
+	// cIsThread override:
+	virtual void Execute(void) override;
+
+	/** Counts the call site's message against its rate limit; returns false if the message should be suppressed.
+	Queues the summary of the messages suppressed in the call site's previous window, if any.
+	*/
+	bool CheckRateLimit(const AString & a_CallSite);
+
+	/// Links the message at the end of the queue; a_NumQueued is the queue length including the message. Optionally waits until it's written
+	void Enqueue(sMessage * a_Msg, int a_NumQueued, bool a_ShouldWait);
+
+	/** Writes all the queued messages that are linked into the queue.
+	Returns false if it stopped at a message that has been counted but not linked yet; its producer sets m_evtQueued when it links it.
+	*/
+	bool WriteQueued(void);
+
+	/// Writes the single message (or flushes the logfile for a flush marker)
+	void Write(sMessage & a_Message);
+
+	/// Writes the number of suppressed messages for the call sites whose window has ended (all call sites if a_All is true)
+	void ReportSuppressed(long long a_Now, bool a_All);
+
+	/// Writes the number of messages dropped since the last report, if any
+	void ReportDropped(void);
+} ;
+
+
+
+
+
+cMCLogger::cWriter::cWriter(cMCLogger & a_Logger) :
+	super("cMCLogger::cWriter"),
+	m_Logger(a_Logger),
+	m_NumQueued(0),
+	m_NumDropped(0),
+	m_NumDroppedReported(0),
+	m_IsWaitingForLink(false),
+	m_IsRunning(false),
+	m_WriterThreadID(0)
+{
+	// The queue always contains at least one, already written, message:
+	m_Head = new sMessage;
+	m_Tail = m_Head;
+}
+
+
+
+
+
+cMCLogger::cWriter::~cWriter()
+{
+	m_ShouldTerminate = true;
+	m_evtQueued.Set();
+	Wait();
+	m_IsRunning = false;
+
+	// Any producer still linking its message writes it by itself, now that the thread isn't running:
+	WriteQueued();
+	ReportSuppressed(m_Timer.GetNowTime(), true);
+	ReportDropped();
+	m_Logger.m_Log->Flush();
+	delete m_Tail;
+}
+
+
+
+
+
+void cMCLogger::cWriter::Push(eColorScheme a_Scheme, const char * a_Format, va_list a_ArgList, bool a_ShouldWait)
+{
+	// Apply the rate limit before spending anything on the message, so that a storm from one call site doesn't fill the queue.
+	// Plugins log everything through "%s", their call sites are told apart by the text instead:
+	AString Text;
+	if ((a_Scheme == csWarning) || (a_Scheme == csError))
+	{
+		if (strcmp(a_Format, "%s") == 0)
+		{
+			AppendVPrintf(Text, a_Format, a_ArgList);
+			if (!CheckRateLimit(Text))
+			{
+				return;
+			}
+		}
+		else if (!CheckRateLimit(a_Format))
+		{
+			return;
+		}
+	}
+
+	int NumQueued = AtomicAdd(m_NumQueued, 1);
+	if ((NumQueued > MAX_QUEUE_LENGTH) && (a_Scheme != csError))
+	{
+		AtomicAdd(m_NumQueued, -1);
+		AtomicAdd(m_NumDropped, 1);
+		return;
+	}
+
+	sMessage * Msg = new sMessage;
+	Msg->m_Scheme = a_Scheme;
+	Msg->m_Time = time(NULL);
+	Msg->m_ThreadID = cIsThread::GetCurrentID();
+	if (Text.empty())
+	{
+		AppendVPrintf(Msg->m_Text, a_Format, a_ArgList);
+	}
+	else
+	{
+		std::swap(Msg->m_Text, Text);
+	}
+	Enqueue(Msg, NumQueued, a_ShouldWait);
+}
+
+
+
+
+
+bool cMCLogger::cWriter::CheckRateLimit(const AString & a_CallSite)
+{
+	long long Now = m_Timer.GetNowTime();
+	int NumSuppressed = 0;
+	{
+		cCSLock Lock(m_CSCallSites);
+		sCallSite & Site = m_CallSites[a_CallSite];
+		if (Now - Site.m_WindowStart >= RATE_LIMIT_WINDOW)
+		{
+			NumSuppressed = Site.m_NumSuppressed;
+			Site.m_WindowStart = Now;
+			Site.m_Count = 0;
+			Site.m_NumSuppressed = 0;
+		}
+		Site.m_Count += 1;
+		if (Site.m_Count > RATE_LIMIT_COUNT)
+		{
+			Site.m_NumSuppressed += 1;
+			return false;
+		}
+	}
+
+	if (NumSuppressed > 0)
+	{
+		sMessage * Msg = new sMessage;
+		Msg->m_Scheme = csWarning;
+		Msg->m_Time = time(NULL);
+		Msg->m_ThreadID = cIsThread::GetCurrentID();
+		Printf(Msg->m_Text, "(%d more messages like \"%s\" were suppressed)", NumSuppressed, a_CallSite.c_str());
+		Enqueue(Msg, AtomicAdd(m_NumQueued, 1), false);
+	}
+	return true;
+}
+
+
+
+
+
+void cMCLogger::cWriter::Enqueue(sMessage * a_Msg, int a_NumQueued, bool a_ShouldWait)
+{
+	// The writer thread mustn't wait for itself:
+	sWaiter * Waiter = NULL;
+	if (a_ShouldWait && m_IsRunning && (cIsThread::GetCurrentID() != m_WriterThreadID))
+	{
+		Waiter = new sWaiter;
+		a_Msg->m_Waiter = Waiter;
+	}
+
+	// Link the message at the end of the queue:
+	sMessage * Prev = AtomicExchange(m_Head, a_Msg);
+	Prev->m_Next = a_Msg;
+
+	if (!m_IsRunning)
+	{
+		// No writer thread (not started yet, failed to start or already stopped), write the message right away:
+		WriteQueued();
+	}
+	else
+	{
+		// Pairs with the barrier in WriteQueued(), so that either the writer sees the link, or we see its flag:
+		ReadBarrier();
+		if ((a_NumQueued == 1) || (Waiter != NULL) || m_IsWaitingForLink)
+		{
+			m_evtQueued.Set();
+		}
+	}
+
+	if (Waiter != NULL)
+	{
+		Waiter->m_evtWritten.Wait(MAX_FLUSH_WAIT);
+		Waiter->Release();
+	}
+}
+
+
+
+
+
+void cMCLogger::cWriter::StartThread(void)
+{
+	m_IsRunning = Start();
+}
+
+
+
+
+
+void cMCLogger::cWriter::Flush(void)
+{
+	// Queue a marker and wait for it; the messages queued by other threads after it don't delay us:
+	sMessage * Marker = new sMessage;
+	Marker->m_IsFlushMarker = true;
+	Enqueue(Marker, AtomicAdd(m_NumQueued, 1), true);
+}
+
+
+
+
+
+void cMCLogger::cWriter::Execute(void)
+{
+	m_WriterThreadID = cIsThread::GetCurrentID();
+	long long LastFlush = m_Timer.GetNowTime();
+	while (!m_ShouldTerminate)
+	{
+		m_evtQueued.Wait(FLUSH_INTERVAL);
+		WriteQueued();
+
+		long long Now = m_Timer.GetNowTime();
+		if (Now - LastFlush >= FLUSH_INTERVAL)
+		{
+			ReportSuppressed(Now, false);
+			ReportDropped();
+			m_Logger.m_Log->Flush();
+			LastFlush = Now;
+		}
+	}
+}
+
+
+
+
+
+bool cMCLogger::cWriter::WriteQueued(void)
+{
+	cCSLock Lock(m_Logger.m_CriticalSection);
+	m_IsWaitingForLink = false;
+	bool res = true;
+	for (;;)
+	{
+		sMessage * Next = m_Tail->m_Next;
+		if (Next == NULL)
+		{
+			if (m_NumQueued == 0)
+			{
+				break;
+			}
+
+			// A producer has counted its message but not linked it yet. Ask it to wake us up instead of waiting here,
+			// unless it has linked the message in the meantime (pairs with the barrier in Enqueue()):
+			m_IsWaitingForLink = true;
+			ReadBarrier();
+			if (m_Tail->m_Next == NULL)
+			{
+				res = false;
+				break;
+			}
+			m_IsWaitingForLink = false;
+			continue;
+		}
+		ReadBarrier();
+
+		// The written message becomes the new tail:
+		delete m_Tail;
+		m_Tail = Next;
+		Write(*Next);
+		Next->m_Text.clear();
+		if (Next->m_Waiter != NULL)
+		{
+			Next->m_Waiter->m_evtWritten.Set();
+			Next->m_Waiter->Release();
+			Next->m_Waiter = NULL;
+		}
+		AtomicAdd(m_NumQueued, -1);
+	}
+	fflush(stdout);
+	return res;
+}
+
+
+
+
+
+void cMCLogger::cWriter::Write(sMessage & a_Message)
+{
+	if (!a_Message.m_IsFlushMarker)
+	{
+		m_Logger.WriteLine(a_Message.m_Scheme, cLog::FormatLine(a_Message.m_Time, a_Message.m_ThreadID, a_Message.m_Text));
+	}
+	if ((a_Message.m_Scheme == csError) || a_Message.m_IsFlushMarker)
+	{
+		m_Logger.m_Log->Flush();
+	}
+}
+
+
+
+
+
+void cMCLogger::cWriter::ReportSuppressed(long long a_Now, bool a_All)
+{
+	// Collect the summaries first, the producers mustn't wait for the console:
+	AStringVector Summaries;
+	{
+		cCSLock Lock(m_CSCallSites);
+		for (cCallSites::iterator itr = m_CallSites.begin(); itr != m_CallSites.end();)
+		{
+			if (!a_All && (a_Now - itr->second.m_WindowStart < RATE_LIMIT_WINDOW))
+			{
+				++itr;
+				continue;
+			}
+			if (itr->second.m_NumSuppressed > 0)
+			{
+				Summaries.push_back(Printf("(%d more messages like \"%s\" were suppressed)", itr->second.m_NumSuppressed, itr->first.c_str()));
+			}
+			cCallSites::iterator itrErase = itr;
+			++itr;
+			m_CallSites.erase(itrErase);
+		}
+	}
+	if (Summaries.empty())
+	{
+		return;
+	}
+
+	cCSLock Lock(m_Logger.m_CriticalSection);
+	for (AStringVector::const_iterator itr = Summaries.begin(), end = Summaries.end(); itr != end; ++itr)
+	{
+		m_Logger.WriteLine(csWarning, cLog::FormatLine(time(NULL), m_WriterThreadID, *itr));
+	}
+}
+
+
+
+
+
+
+void cMCLogger::cWriter::ReportDropped(void)
+{
+	int NumDropped = m_NumDropped;
+	if (NumDropped == m_NumDroppedReported)
+	{
+		return;
+	}
+	cCSLock Lock(m_Logger.m_CriticalSection);
+	m_Logger.WriteLine(csWarning, cLog::FormatLine(time(NULL), m_WriterThreadID,
+		Printf("The logger couldn't keep up, %d messages were dropped", NumDropped - m_NumDroppedReported)
+	));
+	m_NumDroppedReported = NumDropped;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cMCLogger:
+
 cMCLogger * cMCLogger::s_MCLogger = NULL;
 bool g_ShouldColorOutput = false;
 
@@ -55,6 +594,8 @@ cMCLogger::cMCLogger(const AString & a_FileName)
 
 cMCLogger::~cMCLogger()
 {
+	delete m_Writer;
+	m_Writer = NULL;
 	m_Log->Log("--- Stopped Log ---\n");
 	delete m_Log;
 	if (this == s_MCLogger)
@@ -71,6 +612,7 @@ void cMCLogger::InitLog(const AString & a_FileName)
 {
 	m_Log = new cLog(a_FileName);
 	m_Log->Log("--- Started Log ---\n");
+	m_Writer = new cWriter(*this);
 
 	s_MCLogger = this;
 
@@ -87,6 +629,8 @@ void cMCLogger::InitLog(const AString & a_FileName)
 		g_ShouldColorOutput = isatty(fileno(stdout));
 		// TODO: Check if the terminal supports colors, somehow?
 	#endif
+
+	m_Writer->StartThread();
 }
 
 
@@ -121,11 +665,7 @@ void cMCLogger::LogSimple(const char* a_Text, int a_LogType /* = 0 */ )
 
 void cMCLogger::Log(const char * a_Format, va_list a_ArgList)
 {
-	cCSLock Lock(m_CriticalSection);
-	SetColor(csRegular);
-	m_Log->Log(a_Format, a_ArgList);
-	ResetColor();
-	puts("");
+	m_Writer->Push(csRegular, a_Format, a_ArgList, false);
 }
 
 
@@ -134,11 +674,7 @@ void cMCLogger::Log(const char * a_Format, va_list a_ArgList)
 
 void cMCLogger::Info(const char * a_Format, va_list a_ArgList)
 {
-	cCSLock Lock(m_CriticalSection);
-	SetColor(csInfo);
-	m_Log->Log(a_Format, a_ArgList);
-	ResetColor();
-	puts("");
+	m_Writer->Push(csInfo, a_Format, a_ArgList, false);
 }
 
 
@@ -147,11 +683,7 @@ void cMCLogger::Info(const char * a_Format, va_list a_ArgList)
 
 void cMCLogger::Warn(const char * a_Format, va_list a_ArgList)
 {
-	cCSLock Lock(m_CriticalSection);
-	SetColor(csWarning);
-	m_Log->Log(a_Format, a_ArgList);
-	ResetColor();
-	puts("");
+	m_Writer->Push(csWarning, a_Format, a_ArgList, false);
 }
 
 
@@ -160,11 +692,30 @@ void cMCLogger::Warn(const char * a_Format, va_list a_ArgList)
 
 void cMCLogger::Error(const char * a_Format, va_list a_ArgList)
 {
-	cCSLock Lock(m_CriticalSection);
-	SetColor(csError);
-	m_Log->Log(a_Format, a_ArgList);
+	// The error may be followed by the server terminating, wait until the message is written, so that it isn't lost:
+	m_Writer->Push(csError, a_Format, a_ArgList, true);
+}
+
+
+
+
+
+void cMCLogger::Flush(void)
+{
+	m_Writer->Flush();
+}
+
+
+
+
+
+void cMCLogger::WriteLine(eColorScheme a_Scheme, const AString & a_Line)
+{
+	SetColor(a_Scheme);
+	cLog::PrintToConsole(a_Line);
 	ResetColor();
 	puts("");
+	m_Log->WriteLine(a_Line);
 }
 
 
@@ -1,6 +1,16 @@
 
 #pragma once
 
+/*
+The logging functions only format the message and queue it; a background thread writes the messages into the
+logfile and to the console, so that the threads calling LOG() never wait for the disk or the terminal.
+The queue is lock-free (multiple producers, single consumer) and bounded: when full, further messages are dropped
+and their count is reported later. Errors are never dropped and LOGERROR() waits (for a limited time) until that
+error is written and flushed, so that the message is not lost when the server terminates right afterwards.
+Warnings and errors repeated from a single call site (format string) are rate-limited before they are queued,
+so a storm from one call site cannot fill the queue; the suppressed messages are summarized once per window.
+*/
+
 
 
 
@@ -28,6 +38,9 @@ public:																// tolua_export
 
 	void LogSimple(const char* a_Text, int a_LogType = 0 );			// tolua_export
 
+	/// Waits (for a limited time) until all the messages queued so far have been written and flushed into the logfile
+	void Flush(void);
+
 	static cMCLogger* GetInstance();
 private:
 	enum eColorScheme
@@ -38,8 +51,14 @@ private:
 		csError,
 	} ;
 	
+	/// The background thread with the queue of messages waiting to be written; defined in MCLogger.cpp
+	class cWriter;
+	friend class cWriter;
+
+	/// Serializes the writing into the logfile and the console
 	cCriticalSection m_CriticalSection;
 	cLog * m_Log;
+	cWriter * m_Writer;
 	static cMCLogger * s_MCLogger;
 
 
@@ -51,6 +70,9 @@ private:
 	
 	/// Common initialization for all constructors, creates a logfile with the specified name and assigns s_MCLogger to this
 	void InitLog(const AString & a_FileName);
+
+	/// Writes the formatted line in the specified color scheme to the console and into the logfile
+	void WriteLine(eColorScheme a_Scheme, const AString & a_Line);
 };																	// tolua_export
 
 
@@ -896,6 +896,85 @@ tolua_lerror:
 
 
 
+static int tolua_cWorld_SetBlocks(lua_State * tolua_S)
+{
+	// Exported manually, because tolua cannot convert a Lua table into a sSetBlockVector
+	// Function signature: SetBlocks(BlockTable, [ShouldFastSet]) -> NumFailed
+	// Each BlockTable item is an array-table {BlockX, BlockY, BlockZ, BlockType, [BlockMeta]}
+	#ifndef TOLUA_RELEASE
+	tolua_Error tolua_err;
+	if (
+		!tolua_isusertype (tolua_S, 1, "cWorld", 0, &tolua_err) ||
+		!tolua_istable    (tolua_S, 2, 0, &tolua_err) ||
+		!tolua_isboolean  (tolua_S, 3, 1, &tolua_err) ||
+		!tolua_isnoobj    (tolua_S, 4, &tolua_err)
+		)
+		goto tolua_lerror;
+	else
+	#endif
+	{
+		cWorld * self      = (cWorld *) tolua_tousertype(tolua_S, 1, 0);
+		bool ShouldFastSet = (tolua_toboolean(tolua_S, 3, 0) != 0);
+		#ifndef TOLUA_RELEASE
+		if (self == NULL)
+		{
+			tolua_error(tolua_S, "invalid 'self' in function 'SetBlocks'", NULL);
+		}
+		#endif
+		
+		// Convert the table into a sSetBlockVector; the items with non-numeric values or out-of-range Y are counted as failed:
+		int NumItems = (int)lua_objlen(tolua_S, 2);
+		int NumInvalid = 0;
+		sSetBlockVector Blocks;
+		Blocks.reserve(NumItems);
+		for (int i = 1; i <= NumItems; i++)
+		{
+			lua_rawgeti(tolua_S, 2, i);
+			if (!lua_istable(tolua_S, -1))
+			{
+				lua_pop(tolua_S, 1);
+				return lua_do_error(tolua_S, "Error in function call '#funcname#': Item #%d in the block table is not a table", i);
+			}
+			int Values[5] = {0, 0, 0, 0, 0};
+			bool IsValid = true;
+			for (size_t v = 0; v < ARRAYCOUNT(Values); v++)
+			{
+				lua_rawgeti(tolua_S, -1, v + 1);
+				if (lua_isnumber(tolua_S, -1))
+				{
+					Values[v] = (int)lua_tonumber(tolua_S, -1);
+				}
+				else if ((v < 4) || !lua_isnil(tolua_S, -1))
+				{
+					// The coords and the block type are mandatory, the meta is optional
+					IsValid = false;
+				}
+				lua_pop(tolua_S, 1);
+			}
+			lua_pop(tolua_S, 1);
+			if (!IsValid || (Values[1] < 0) || (Values[1] >= cChunkDef::Height))
+			{
+				NumInvalid += 1;
+				continue;
+			}
+			Blocks.push_back(sSetBlock(Values[0], Values[1], Values[2], (BLOCKTYPE)Values[3], (NIBBLETYPE)Values[4]));
+		}  // for i - BlockTable[]
+		
+		tolua_pushnumber(tolua_S, NumInvalid + self->SetBlocks(Blocks, ShouldFastSet));
+	}
+	return 1;
+	
+	#ifndef TOLUA_RELEASE
+tolua_lerror:
+	tolua_error(tolua_S, "#ferror in function 'SetBlocks'.", &tolua_err);
+	return 0;
+	#endif
+}
+
+
+
+
+
 class cLuaWorldTask :
 	public cWorld::cTask
 {
@@ -2145,6 +2224,7 @@ void ManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "GetBlockTypeMeta",      tolua_cWorld_GetBlockTypeMeta);
 			tolua_function(tolua_S, "GetSignLines",          tolua_cWorld_GetSignLines);
 			tolua_function(tolua_S, "QueueTask",             tolua_cWorld_QueueTask);
+			tolua_function(tolua_S, "SetBlocks",             tolua_cWorld_SetBlocks);
 			tolua_function(tolua_S, "SetSignLines",          tolua_cWorld_SetSignLines);
 			tolua_function(tolua_S, "TryGetHeight",          tolua_cWorld_TryGetHeight);
 			tolua_function(tolua_S, "UpdateSign",            tolua_cWorld_SetSignLines);
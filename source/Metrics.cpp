@@ -0,0 +1,230 @@
+
+// Metrics.cpp
+
+// Implements the cMetrics class that collects the server internals and formats them for a metrics scraper
+
+#include "Globals.h"
+
+#include "Metrics.h"
+#include "Root.h"
+
+
+
+
+
+const int cMetrics::TICK_HISTOGRAM_BOUNDS[] = {5, 10, 20, 35, 50, 75, 100, 250, 1000};
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cMetrics::sWorldStats:
+
+cMetrics::sWorldStats::sWorldStats(void) :
+	m_NumChunksValid(0),
+	m_NumChunksDirty(0),
+	m_NumChunksInLighting(0),
+	m_GeneratorQueueLength(0),
+	m_LightingQueueLength(0),
+	m_StorageLoadQueueLength(0),
+	m_StorageSaveQueueLength(0)
+{
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cMetrics::sTickHistogram:
+
+cMetrics::sTickHistogram::sTickHistogram(void) :
+	m_Sum(0),
+	m_Count(0)
+{
+	for (int i = 0; i <= NUM_TICK_HISTOGRAM_BOUNDS; i++)
+	{
+		m_Buckets[i] = 0;
+	}
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cMetrics:
+
+cMetrics::cMetrics(void) :
+	m_BytesReceived(0),
+	m_BytesSent(0)
+{
+}
+
+
+
+
+
+void cMetrics::ReportTickTime(const AString & a_WorldName, int a_TickTime)
+{
+	int Bucket = 0;
+	while ((Bucket < NUM_TICK_HISTOGRAM_BOUNDS) && (a_TickTime > TICK_HISTOGRAM_BOUNDS[Bucket]))
+	{
+		Bucket++;
+	}
+
+	cCSLock Lock(m_CS);
+	sTickHistogram & Histogram = m_TickHistograms[a_WorldName];
+	Histogram.m_Buckets[Bucket] += 1;
+	Histogram.m_Sum += a_TickTime;
+	Histogram.m_Count += 1;
+}
+
+
+
+
+
+void cMetrics::SetWorldStats(const AString & a_WorldName, const sWorldStats & a_Stats)
+{
+	cCSLock Lock(m_CS);
+	m_WorldStats[a_WorldName] = a_Stats;
+}
+
+
+
+
+
+void cMetrics::AddBytesReceived(int a_NumBytes)
+{
+	cCSLock Lock(m_CS);
+	m_BytesReceived += a_NumBytes;
+}
+
+
+
+
+
+void cMetrics::AddBytesSent(int a_NumBytes)
+{
+	cCSLock Lock(m_CS);
+	m_BytesSent += a_NumBytes;
+}
+
+
+
+
+
+AString cMetrics::GetPrometheusText(void)
+{
+	AString res;
+
+	// The process-wide values don't need the lock:
+	res.append("# HELP process_resident_memory_bytes Resident memory size in bytes.\n# TYPE process_resident_memory_bytes gauge\n");
+	AppendPrintf(res, "process_resident_memory_bytes %lld\n", (long long)cRoot::GetPhysicalRAMUsage() * 1024);
+	res.append("# HELP process_virtual_memory_bytes Virtual memory size in bytes.\n# TYPE process_virtual_memory_bytes gauge\n");
+	AppendPrintf(res, "process_virtual_memory_bytes %lld\n", (long long)cRoot::GetVirtualRAMUsage() * 1024);
+
+	cCSLock Lock(m_CS);
+
+	res.append("# HELP mcserver_network_received_bytes_total Bytes received from the game clients.\n# TYPE mcserver_network_received_bytes_total counter\n");
+	AppendPrintf(res, "mcserver_network_received_bytes_total %lld\n", (long long)m_BytesReceived);
+	res.append("# HELP mcserver_network_sent_bytes_total Bytes sent to the game clients.\n# TYPE mcserver_network_sent_bytes_total counter\n");
+	AppendPrintf(res, "mcserver_network_sent_bytes_total %lld\n", (long long)m_BytesSent);
+
+	// Tick duration histograms:
+	res.append("# HELP mcserver_world_tick_duration_milliseconds Duration of the world ticks.\n# TYPE mcserver_world_tick_duration_milliseconds histogram\n");
+	for (cTickHistograms::const_iterator itr = m_TickHistograms.begin(), end = m_TickHistograms.end(); itr != end; ++itr)
+	{
+		AString World = EscapeLabelValue(itr->first);
+		Int64 Cumulative = 0;
+		for (int i = 0; i < NUM_TICK_HISTOGRAM_BOUNDS; i++)
+		{
+			Cumulative += itr->second.m_Buckets[i];
+			AppendPrintf(res, "mcserver_world_tick_duration_milliseconds_bucket{world=\"%s\",le=\"%d\"} %lld\n",
+				World.c_str(), TICK_HISTOGRAM_BOUNDS[i], (long long)Cumulative
+			);
+		}
+		AppendPrintf(res, "mcserver_world_tick_duration_milliseconds_bucket{world=\"%s\",le=\"+Inf\"} %lld\n", World.c_str(), (long long)itr->second.m_Count);
+		AppendPrintf(res, "mcserver_world_tick_duration_milliseconds_sum{world=\"%s\"} %lld\n", World.c_str(), (long long)itr->second.m_Sum);
+		AppendPrintf(res, "mcserver_world_tick_duration_milliseconds_count{world=\"%s\"} %lld\n", World.c_str(), (long long)itr->second.m_Count);
+	}
+
+	// Per-world gauges, each metric's samples need to be grouped together:
+	static const struct
+	{
+		const char * m_Name;
+		const char * m_Help;
+		int sWorldStats::* m_Value;
+	} WorldGauges[] =
+	{
+		{"mcserver_world_generator_queue_length",    "Chunks waiting for the generator.",        &sWorldStats::m_GeneratorQueueLength},
+		{"mcserver_world_lighting_queue_length",     "Chunks waiting for the lighting thread.",  &sWorldStats::m_LightingQueueLength},
+		{"mcserver_world_storage_load_queue_length", "Chunks waiting to be loaded from storage.", &sWorldStats::m_StorageLoadQueueLength},
+		{"mcserver_world_storage_save_queue_length", "Chunks waiting to be saved to storage.",   &sWorldStats::m_StorageSaveQueueLength},
+	} ;
+	for (size_t i = 0; i < ARRAYCOUNT(WorldGauges); i++)
+	{
+		AppendPrintf(res, "# HELP %s %s\n# TYPE %s gauge\n", WorldGauges[i].m_Name, WorldGauges[i].m_Help, WorldGauges[i].m_Name);
+		for (cWorldStatsMap::const_iterator itr = m_WorldStats.begin(), end = m_WorldStats.end(); itr != end; ++itr)
+		{
+			AppendPrintf(res, "%s{world=\"%s\"} %d\n", WorldGauges[i].m_Name, EscapeLabelValue(itr->first).c_str(), itr->second.*(WorldGauges[i].m_Value));
+		}
+	}
+
+	res.append("# HELP mcserver_world_chunks Chunks loaded in the world, by state.\n# TYPE mcserver_world_chunks gauge\n");
+	for (cWorldStatsMap::const_iterator itr = m_WorldStats.begin(), end = m_WorldStats.end(); itr != end; ++itr)
+	{
+		AString World = EscapeLabelValue(itr->first);
+		AppendPrintf(res, "mcserver_world_chunks{world=\"%s\",state=\"valid\"} %d\n",    World.c_str(), itr->second.m_NumChunksValid);
+		AppendPrintf(res, "mcserver_world_chunks{world=\"%s\",state=\"dirty\"} %d\n",    World.c_str(), itr->second.m_NumChunksDirty);
+		AppendPrintf(res, "mcserver_world_chunks{world=\"%s\",state=\"lighting\"} %d\n", World.c_str(), itr->second.m_NumChunksInLighting);
+	}
+
+	res.append("# HELP mcserver_world_entities Entities in the world, by class.\n# TYPE mcserver_world_entities gauge\n");
+	for (cWorldStatsMap::const_iterator itr = m_WorldStats.begin(), end = m_WorldStats.end(); itr != end; ++itr)
+	{
+		AString World = EscapeLabelValue(itr->first);
+		for (cEntityCounts::const_iterator itrE = itr->second.m_NumEntities.begin(), endE = itr->second.m_NumEntities.end(); itrE != endE; ++itrE)
+		{
+			AppendPrintf(res, "mcserver_world_entities{world=\"%s\",class=\"%s\"} %d\n", World.c_str(), EscapeLabelValue(itrE->first).c_str(), itrE->second);
+		}
+	}
+
+	res.append("# HELP mcserver_client_outgoing_buffer_bytes Data buffered for sending to the client.\n# TYPE mcserver_client_outgoing_buffer_bytes gauge\n");
+	for (cWorldStatsMap::const_iterator itr = m_WorldStats.begin(), end = m_WorldStats.end(); itr != end; ++itr)
+	{
+		AString World = EscapeLabelValue(itr->first);
+		for (sClientStatsVector::const_iterator itrC = itr->second.m_Clients.begin(), endC = itr->second.m_Clients.end(); itrC != endC; ++itrC)
+		{
+			AppendPrintf(res, "mcserver_client_outgoing_buffer_bytes{world=\"%s\",client=\"%s\"} %d\n", World.c_str(), EscapeLabelValue(itrC->m_Name).c_str(), itrC->m_OutgoingBacklog);
+		}
+	}
+
+	return res;
+}
+
+
+
+
+
+AString cMetrics::EscapeLabelValue(const AString & a_Value)
+{
+	AString res;
+	res.reserve(a_Value.size());
+	for (AString::const_iterator itr = a_Value.begin(), end = a_Value.end(); itr != end; ++itr)
+	{
+		switch (*itr)
+		{
+			case '\\': res.append("\\\\"); break;
+			case '"':  res.append("\\\""); break;
+			case '\n': res.append("\\n");  break;
+			default:   res.push_back(*itr); break;
+		}
+	}
+	return res;
+}
+
+
+
+
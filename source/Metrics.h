@@ -0,0 +1,101 @@
+
+// Metrics.h
+
+// Interfaces to the cMetrics class that collects the server internals and formats them for a metrics scraper
+
+/*
+The producers publish their values into this object: the world tick threads report each tick's duration and,
+once per second, a snapshot of their chunk, queue, entity and client statistics; the clients add the bytes
+they receive and send. The scrape (cWebAdmin's "/metrics" page) only formats the values stored here, under
+this object's own lock, so it never has to lock any world, chunkmap or client.
+The output uses the Prometheus text exposition format.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+class cMetrics
+{
+public:
+	/// Statistics of a single client, as published by its world
+	struct sClientStats
+	{
+		AString m_Name;
+		int     m_OutgoingBacklog;  ///< Bytes buffered for sending to the client
+	} ;
+
+	typedef std::vector<sClientStats> sClientStatsVector;
+
+	/// Number of entities per entity class name
+	typedef std::map<AString, int> cEntityCounts;
+
+	/// Statistics of a single world, published once per second by the world's tick thread
+	struct sWorldStats
+	{
+		int m_NumChunksValid;
+		int m_NumChunksDirty;
+		int m_NumChunksInLighting;
+		int m_GeneratorQueueLength;
+		int m_LightingQueueLength;
+		int m_StorageLoadQueueLength;
+		int m_StorageSaveQueueLength;
+		cEntityCounts      m_NumEntities;
+		sClientStatsVector m_Clients;
+
+		sWorldStats(void);
+	} ;
+
+	cMetrics(void);
+
+	/// Called by the world tick threads after each tick, with the duration of the tick in msec
+	void ReportTickTime(const AString & a_WorldName, int a_TickTime);
+
+	/// Replaces the statistics of the specified world with the new snapshot
+	void SetWorldStats(const AString & a_WorldName, const sWorldStats & a_Stats);
+
+	/// Adds to the total number of bytes received from all the clients
+	void AddBytesReceived(int a_NumBytes);
+
+	/// Adds to the total number of bytes sent to all the clients
+	void AddBytesSent(int a_NumBytes);
+
+	/// Returns all the metrics in the Prometheus text format
+	AString GetPrometheusText(void);
+
+protected:
+	/// Upper bounds of the tick duration histogram buckets, in msec; the last, implicit, bucket is +Inf
+	static const int TICK_HISTOGRAM_BOUNDS[];
+	static const int NUM_TICK_HISTOGRAM_BOUNDS = 9;
+
+	/// Cumulative tick duration histogram of a single world
+	struct sTickHistogram
+	{
+		Int64 m_Buckets[NUM_TICK_HISTOGRAM_BOUNDS + 1];  ///< Number of ticks that took at most the respective bound (non-cumulative)
+		Int64 m_Sum;    ///< Sum of all the tick durations, in msec
+		Int64 m_Count;  ///< Number of all the ticks
+
+		sTickHistogram(void);
+	} ;
+
+	typedef std::map<AString, sTickHistogram> cTickHistograms;
+	typedef std::map<AString, sWorldStats>    cWorldStatsMap;
+
+	cCriticalSection m_CS;
+	cTickHistograms  m_TickHistograms;
+	cWorldStatsMap   m_WorldStats;
+	Int64            m_BytesReceived;
+	Int64            m_BytesSent;
+
+	/// Returns the string escaped for use as a label value
+	static AString EscapeLabelValue(const AString & a_Value);
+} ;
+
+
+
+
@@ -7,6 +7,26 @@
 
 
 
+cMobCensus::cMobCensus(void) :
+	m_NumEligibleForSpawnChunks(0)
+{
+}
+
+
+
+
+
+void cMobCensus::Clear(void)
+{
+	m_ProximityCounter.Clear();
+	m_MobFamilyCollecter.Clear();
+	m_NumEligibleForSpawnChunks = 0;
+}
+
+
+
+
+
 void cMobCensus::CollectMob(cMonster & a_Monster, cChunk & a_Chunk, double a_Distance)
 {
 	m_ProximityCounter.CollectMob(a_Monster, a_Chunk, a_Distance);
@@ -53,7 +73,7 @@ int cMobCensus::GetCapMultiplier(cMonster::eFamily a_MobFamily)
 
 void cMobCensus::CollectSpawnableChunk(cChunk & a_Chunk)
 {
-	m_EligibleForSpawnChunks.insert(&a_Chunk);
+	m_NumEligibleForSpawnChunks++;
 }
 
 
@@ -62,7 +82,7 @@ void cMobCensus::CollectSpawnableChunk(cChunk & a_Chunk)
 
 int cMobCensus::GetNumChunks(void)
 {
-	return m_EligibleForSpawnChunks.size();
+	return m_NumEligibleForSpawnChunks;
 }
 
 
@@ -25,6 +25,11 @@ as side effect 2 : it also know the caps for mobs number and can compare census
 class cMobCensus
 {
 public:
+	cMobCensus(void);
+
+	/// Forgets all the collected data, so that the census can be reused for the next tick without reallocating
+	void Clear(void);
+
 	/// Returns the nested proximity counter
 	cMobProximityCounter & GetProximityCounter(void);
 
@@ -45,7 +50,8 @@ protected :
 	cMobProximityCounter m_ProximityCounter;
 	cMobFamilyCollecter m_MobFamilyCollecter;
 
-	std::set<cChunk *> m_EligibleForSpawnChunks;
+	/// Number of the chunks that are elligible for spawning; each chunk is collected only once
+	int m_NumEligibleForSpawnChunks;
 
 	/// Returns the number of chunks that are elligible for spawning (for now, the loaded, valid chunks)
 	int GetNumChunks();
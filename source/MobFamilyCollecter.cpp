@@ -6,10 +6,34 @@
 
 
 
+cMobFamilyCollecter::cMobFamilyCollecter(void)
+{
+	Clear();
+}
+
+
+
+
+
+void cMobFamilyCollecter::Clear(void)
+{
+	for (int i = 0; i < cMonster::mfMaxplusone; i++)
+	{
+		m_NumMobs[i] = 0;
+	}
+}
+
+
+
+
+
 void cMobFamilyCollecter::CollectMob(cMonster & a_Monster)
 {
 	cMonster::eFamily MobFamily = a_Monster.GetMobFamily();
-	m_Mobs[MobFamily].insert(&a_Monster);
+	if ((MobFamily >= 0) && (MobFamily < cMonster::mfMaxplusone))
+	{
+		m_NumMobs[MobFamily]++;
+	}
 }
 
 
@@ -18,7 +42,11 @@ void cMobFamilyCollecter::CollectMob(cMonster & a_Monster)
 
 int cMobFamilyCollecter::GetNumberOfCollectedMobs(cMonster::eFamily a_Family)
 {
-	return m_Mobs[a_Family].size();
+	if ((a_Family < 0) || (a_Family >= cMonster::mfMaxplusone))
+	{
+		return 0;
+	}
+	return m_NumMobs[a_Family];
 }
 
 
@@ -16,13 +16,19 @@ class cChunk;
 
 
 
-/** This class is used to collect the list of mobs for each family
+/** This class is used to count the mobs for each family
+Each mob is expected to be collected only once.
 */
 class cMobFamilyCollecter
 {
 public :
 	typedef const std::set<cMonster::eFamily> tMobFamilyList;
 
+	cMobFamilyCollecter(void);
+
+	// forget all the collected mobs
+	void Clear(void);
+
 	// collect a mob
 	void CollectMob(cMonster & a_Monster);
 
@@ -30,7 +36,7 @@ public :
 	int GetNumberOfCollectedMobs(cMonster::eFamily a_Family);
 
 protected : 
-	std::map<cMonster::eFamily, std::set<cMonster *> > m_Mobs;
+	int m_NumMobs[cMonster::mfMaxplusone];
 
 } ;
 
@@ -3,81 +3,60 @@
 
 #include "MobProximityCounter.h"
 
-#include "Entities/Entity.h"
+#include "Mobs/Monster.h"
 #include "Chunk.h"
 
-void cMobProximityCounter::CollectMob(cEntity& a_Monster, cChunk& a_Chunk, double a_Distance)
+cMobProximityCounter::cMobProximityCounter(void) :
+	m_IsSorted(false)
+{
+}
+
+void cMobProximityCounter::Clear(void)
+{
+	m_DistanceToMonster.clear();
+	m_IsSorted = false;
+}
+
+void cMobProximityCounter::CollectMob(cMonster & a_Monster, cChunk & a_Chunk, double a_Distance)
 {
 //	LOGD("Collecting monster %s, with distance %f",a_Monster->GetClass(),a_Distance);
-	tMonsterToDistance::iterator it = m_MonsterToDistance.find(&a_Monster);
-	if (it == m_MonsterToDistance.end())
+	if (!m_DistanceToMonster.empty() && (m_DistanceToMonster.back().m_Monster == &a_Monster))
 	{
-		sDistanceAndChunk newDistanceAndChunk(a_Distance,a_Chunk);
-		std::pair<tMonsterToDistance::iterator,bool> result = m_MonsterToDistance.insert(tMonsterToDistance::value_type(&a_Monster,newDistanceAndChunk));
-		if (!result.second)
+		sMobDistance & Last = m_DistanceToMonster.back();
+		if (a_Distance < Last.m_Distance)
 		{
-			ASSERT(!"A collected Monster was not found inside distance map using find(), but insert() said there already is a key for it");
+			Last.m_Distance = a_Distance;
+			Last.m_Chunk = &a_Chunk;
 		}
+		return;
 	}
-	else
-	{
-		if (a_Distance < it->second.m_Distance)
-		{
-			it->second.m_Distance = a_Distance;
-			it->second.m_Chunk = a_Chunk;
-		}
-	}
-
-	m_EligibleForSpawnChunks.insert(&a_Chunk);
 
+	m_DistanceToMonster.push_back(sMobDistance(a_Monster, a_Chunk, a_Distance));
+	m_IsSorted = false;
 }
 
-void cMobProximityCounter::convertMaps()
+cMobProximityCounter::sIterablePair cMobProximityCounter::getMobWithinThosesDistances(double a_DistanceMin, double a_DistanceMax)
 {
-	for(tMonsterToDistance::const_iterator itr = m_MonsterToDistance.begin(); itr != m_MonsterToDistance.end(); itr++)
+	if (!m_IsSorted)
 	{
-		m_DistanceToMonster.insert(tDistanceToMonster::value_type(itr->second.m_Distance,sMonsterAndChunk(*itr->first,itr->second.m_Chunk)));
+		std::sort(m_DistanceToMonster.begin(), m_DistanceToMonster.end());
+		m_IsSorted = true;
 	}
-}
 
-cMobProximityCounter::sIterablePair cMobProximityCounter::getMobWithinThosesDistances(double a_DistanceMin, double a_DistanceMax)
-{
+	// The distances are squared, search for the bounds as such:
 	sIterablePair toReturn;
-	toReturn.m_Count = 0;
-	toReturn.m_Begin = m_DistanceToMonster.end();
+	toReturn.m_Begin = m_DistanceToMonster.begin();
 	toReturn.m_End = m_DistanceToMonster.end();
-
-	a_DistanceMin *= a_DistanceMin;// this is because is use square distance
-	a_DistanceMax *= a_DistanceMax;
-
-	if (m_DistanceToMonster.size() <= 0)
+	if (a_DistanceMin != -1)
 	{
-		convertMaps();
+		// this is the first one with distance > a_DistanceMin
+		toReturn.m_Begin = std::upper_bound(m_DistanceToMonster.begin(), m_DistanceToMonster.end(), a_DistanceMin * a_DistanceMin, IsCloser);
 	}
-
-	for(tDistanceToMonster::const_iterator itr = m_DistanceToMonster.begin(); itr != m_DistanceToMonster.end(); itr++)
+	if (a_DistanceMax != -1)
 	{
-		if (toReturn.m_Begin == m_DistanceToMonster.end())
-		{
-			if (a_DistanceMin == -1 || itr->first > a_DistanceMin)
-			{
-				toReturn.m_Begin = itr; // this is the first one with distance > a_DistanceMin;
-			}
-		}
-
-		if (toReturn.m_Begin != m_DistanceToMonster.end())
-		{
-			if (a_DistanceMax != -1 && itr->first > a_DistanceMax)
-			{
-				toReturn.m_End = itr; // this is just after the last one with distance < a_DistanceMax
-				// Note : if we are not going through this, it's ok, toReturn.m_End will be end();
-				break;
-			}
-			else
-			{
-				toReturn.m_Count ++;
-			}
-		}
+		// this is just after the last one with distance <= a_DistanceMax
+		toReturn.m_End = std::upper_bound(toReturn.m_Begin, toReturn.m_End, a_DistanceMax * a_DistanceMax, IsCloser);
 	}
+	toReturn.m_Count = (int)(toReturn.m_End - toReturn.m_Begin);
 	return toReturn;
 }
@@ -1,60 +1,56 @@
 
 #pragma once
 
-#include <set>
-
 class cChunk;
-class cEntity;
+class cMonster;
 
 
 // This class is used to collect, for each Mob, what is the distance of the closest player
 // it was first being designed in order to make mobs spawn / despawn / act
 // as the behaviour and even life of mobs depends on the distance to closest player
+// The collected data is kept in a flat array that is reused across ticks (see Clear()), so that
+// collecting the mobs doesn't allocate anything once the array has grown to the mob population.
 class cMobProximityCounter
 {
-protected :
-	// structs used for later maps (see m_MonsterToDistance and m_DistanceToMonster)
-	struct sDistanceAndChunk
-	{
-		sDistanceAndChunk(double a_Distance, cChunk& a_Chunk) : m_Distance(a_Distance), m_Chunk(a_Chunk) {}
-		double m_Distance;
-		cChunk& m_Chunk;
-	};
-	struct sMonsterAndChunk
+public :
+	/// A collected mob, with the chunk that "hosts" it (the one that will perform the action)
+	struct sMobDistance
 	{
-		sMonsterAndChunk(cEntity& a_Monster, cChunk& a_Chunk) : m_Monster(a_Monster), m_Chunk(a_Chunk) {}
-		cEntity& m_Monster;
-		cChunk& m_Chunk;
+		sMobDistance(cMonster & a_Monster, cChunk & a_Chunk, double a_Distance) : m_Monster(&a_Monster), m_Chunk(&a_Chunk), m_Distance(a_Distance) {}
+		cMonster * m_Monster;
+		cChunk *   m_Chunk;
+		double     m_Distance;  ///< Squared distance to the closest player
+
+		bool operator <(const sMobDistance & a_Other) const { return (m_Distance < a_Other.m_Distance); }
 	};
 
-public : 
-	typedef std::map<cEntity*,sDistanceAndChunk> tMonsterToDistance;
-	typedef std::multimap<double,sMonsterAndChunk> tDistanceToMonster;
+	// used for searching the sorted mobs by distance
+	static bool IsCloser(double a_Distance, const sMobDistance & a_Mob) { return (a_Distance < a_Mob.m_Distance); }
 
-protected : 
-	// this map is filled during collection phase, it will be later transformed into DistanceToMonster
-	tMonsterToDistance m_MonsterToDistance;
+	typedef std::vector<sMobDistance> tDistanceToMonster;
 
-	// this map is generated after collection phase, in order to access monster by distance to player
+protected :
+	// The collected mobs; sorted by distance on the first query after the collection
 	tDistanceToMonster m_DistanceToMonster;
 
-	// this are the collected chunks. Used to determinate the number of elligible chunk for spawning.
-	std::set<cChunk*> m_EligibleForSpawnChunks;
-
-protected : 
-	// transform monsterToDistance map (that was usefull for collecting) into distanceToMonster
-	// that will be usefull for picking up.
-	void convertMaps();
+	bool m_IsSorted;
 
 public :
+	cMobProximityCounter(void);
+
+	// forget all the collected mobs, but keep the memory for the next collection
+	void Clear(void);
+
 	// count a mob on a specified chunk with specified distance to an unkown player
 	// if the distance is shortest than the one collected, this become the new closest
 	// distance and the chunk become the "hosting" chunk (that is the one that will perform the action)
-	void CollectMob(cEntity& a_Monster, cChunk& a_Chunk, double a_Distance);
+	// All the distances of a single mob need to be collected one right after another
+	void CollectMob(cMonster & a_Monster, cChunk & a_Chunk, double a_Distance);
 
 	// return the mobs that are within the range of distance of the closest player they are
 	// that means that if a mob is 30 m from a player and 150 m from another one. It will be
 	// in the range [0..50] but not in [100..200]
+	// -1 for either bound means unlimited
 	struct sIterablePair{
 		tDistanceToMonster::const_iterator m_Begin;
 		tDistanceToMonster::const_iterator m_End;
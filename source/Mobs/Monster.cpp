@@ -85,6 +85,7 @@ cMonster::cMonster(const AString & a_ConfigName, eType a_MobType, const AString
 	, m_AttackRange(2.0f)
 	, m_AttackInterval(0)
 	, m_BurnsInDaylight(false)
+	, m_SkippedDt(0)
 {
 	if (!a_ConfigName.empty())
 	{
@@ -105,6 +106,22 @@ void cMonster::SpawnOn(cClientHandle & a_Client)
 
 
 
+void cMonster::TickAtInterval(float a_Dt, cChunk & a_Chunk, int a_TickInterval, Int64 a_WorldAge)
+{
+	if ((a_TickInterval > 1) && (((a_WorldAge + GetUniqueID()) % a_TickInterval) != 0))
+	{
+		m_SkippedDt += a_Dt;
+		return;
+	}
+	float Dt = a_Dt + m_SkippedDt;
+	m_SkippedDt = 0;
+	Tick(Dt, a_Chunk);
+}
+
+
+
+
+
 void cMonster::MoveToPosition( const Vector3f & a_Position )
 {
 	m_bMovingToDestination = true;
@@ -88,6 +88,11 @@ public:
 	virtual void SpawnOn(cClientHandle & a_ClientHandle) override;
 
 	virtual void Tick(float a_Dt, cChunk & a_Chunk) override;
+	
+	/** Ticks the monster at a reduced rate, once every a_TickInterval ticks (staggered by the entity ID, so that not all the mobs tick at once).
+	The time of the skipped ticks is accumulated and added to the a_Dt of the tick that is done.
+	*/
+	void TickAtInterval(float a_Dt, cChunk & a_Chunk, int a_TickInterval, Int64 a_WorldAge);
 
 	virtual void DoTakeDamage(TakeDamageInfo & a_TDI) override;
 	
@@ -183,6 +188,9 @@ protected:
 	float m_AttackInterval;
 	
 	bool m_BurnsInDaylight;
+	
+	/// The time of the ticks skipped by TickAtInterval(), in msec; added to the next tick's a_Dt
+	float m_SkippedDt;
 
 	void AddRandomDropItem(cItems & a_Drops, unsigned int a_Min, unsigned int a_Max, short a_Item, short a_ItemHealth = 0);
 	
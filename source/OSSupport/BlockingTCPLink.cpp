@@ -18,7 +18,8 @@
 
 
 
-cBlockingTCPLink::cBlockingTCPLink(void)
+cBlockingTCPLink::cBlockingTCPLink(void) :
+	m_TimeoutMSec(0)
 {
 }
 
@@ -37,7 +38,7 @@ cBlockingTCPLink::~cBlockingTCPLink()
 
 void cBlockingTCPLink::CloseSocket()
 {
-	if (!m_Socket.IsValid())
+	if (m_Socket.IsValid())
 	{
 		m_Socket.CloseSocket();
 	}
@@ -66,6 +67,10 @@ bool cBlockingTCPLink::Connect(const char * iAddress, unsigned int iPort)
 		LOGERROR("cTCPLink: Cannot create a socket");
 		return false;
 	}
+	if ((m_TimeoutMSec > 0) && !m_Socket.SetTimeout(m_TimeoutMSec))
+	{
+		LOGWARN("cTCPLink: Cannot set socket timeout (%s)", cSocket::GetLastErrorString().c_str());
+	}
 
 	addr = inet_addr(iAddress);
 	hp = gethostbyaddr((char *)&addr, sizeof(addr), AF_INET);
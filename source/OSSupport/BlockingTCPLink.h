@@ -18,9 +18,14 @@ public:																			// tolua_export
 	int SendMessage( const char* a_Message, int a_Flags = 0 );					// tolua_export
 	void CloseSocket();															// tolua_export
 	void ReceiveData(AString & oData);													// tolua_export
+	
+	/// Sets the timeout for each of the following socket operations, in msec. 0 means no timeout
+	void SetTimeout(int a_TimeoutMSec) { m_TimeoutMSec = a_TimeoutMSec; }
+	
 protected:
 
 	cSocket m_Socket;
+	int m_TimeoutMSec;
 };	// tolua_export
 
 
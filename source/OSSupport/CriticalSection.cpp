@@ -6,10 +6,172 @@
 
 
 
+#ifdef LOCK_PROFILING
+
+#include "Timer.h"
+
+
+
+
+
+/// Adds a_Delta to a_Value atomically
+static void AtomicAdd(volatile int & a_Value, int a_Delta)
+{
+	#ifdef _WIN32
+		InterlockedExchangeAdd((volatile LONG *)&a_Value, a_Delta);
+	#else
+		__sync_add_and_fetch(&a_Value, a_Delta);
+	#endif
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cLockProfiler:
+
+/// Keeps track of all the named CSs, so that their stats can be reported
+class cLockProfiler
+{
+public:
+	static cLockProfiler & Get(void)
+	{
+		// Created by the first named CS, which is in the main thread before any other threads are started
+		static cLockProfiler Instance;
+		return Instance;
+	}
+	
+	Int64 GetNowUSec(void) { return m_Timer.GetNowTimeUSec(); }
+	
+	int GetGeneration(void) const { return m_Generation; }
+	
+	void Register(cCriticalSection * a_CS)
+	{
+		cCSLock Lock(m_CS);
+		m_CSs.insert(a_CS);
+	}
+	
+	/// Removes the CS from the live ones, keeping its stats in the totals for its name
+	void Unregister(cCriticalSection * a_CS)
+	{
+		cCSLock Lock(m_CS);
+		m_CSs.erase(a_CS);
+		if (a_CS->m_Profile.m_Generation == m_Generation)
+		{
+			AddStats(m_Retired[a_CS->m_Profile.m_Name], a_CS->m_Profile);
+		}
+	}
+	
+	void Reset(void)
+	{
+		cCSLock Lock(m_CS);
+		m_Retired.clear();
+		m_Generation += 1;
+	}
+	
+	AStringVector GetReport(void)
+	{
+		Int64 Now = GetNowUSec();
+		cCSLock Lock(m_CS);
+		
+		// Sum up the stats by name:
+		cTotalsMap Totals(m_Retired);
+		AStringVector Held;
+		for (cCSs::const_iterator itr = m_CSs.begin(), end = m_CSs.end(); itr != end; ++itr)
+		{
+			const cCriticalSection::sProfile & Profile = (*itr)->m_Profile;
+			sTotals & NameTotals = Totals[Profile.m_Name];
+			NameTotals.m_NumCSs += 1;
+			if (Profile.m_Generation == m_Generation)
+			{
+				AddStats(NameTotals, Profile);
+			}
+			if (Profile.m_LockLevel > 0)
+			{
+				Held.push_back(Printf("  %s held by thread %04lx for %lld ms, %d threads waiting",
+					Profile.m_Name, Profile.m_OwnerThreadID, (Now - Profile.m_LockedSince) / 1000, Profile.m_NumWaiting
+				));
+			}
+		}
+		
+		// Report the most waited-for names first:
+		std::vector<std::pair<Int64, AString> > Lines;
+		for (cTotalsMap::const_iterator itr = Totals.begin(), end = Totals.end(); itr != end; ++itr)
+		{
+			const sTotals & t = itr->second;
+			Lines.push_back(std::make_pair(t.m_TotalWait, Printf(
+				"%s (%d): %lld locks, %lld contended; wait %lld ms total, %lld us max; hold %lld ms total, %lld us max",
+				itr->first.c_str(), t.m_NumCSs, t.m_NumLocks, t.m_NumContended,
+				t.m_TotalWait / 1000, t.m_MaxWait, t.m_TotalHold / 1000, t.m_MaxHold
+			)));
+		}
+		std::sort(Lines.begin(), Lines.end());
+		AStringVector res;
+		for (size_t i = Lines.size(); i > 0; i--)
+		{
+			res.push_back(Lines[i - 1].second);
+		}
+		res.insert(res.end(), Held.begin(), Held.end());
+		return res;
+	}
+	
+protected:
+	/// The summed up stats of all the CSs with the same name
+	struct sTotals
+	{
+		int   m_NumCSs;  ///< Number of the live CSs with the name
+		Int64 m_NumLocks;
+		Int64 m_NumContended;
+		Int64 m_TotalWait;
+		Int64 m_MaxWait;
+		Int64 m_TotalHold;
+		Int64 m_MaxHold;
+		
+		sTotals(void) : m_NumCSs(0), m_NumLocks(0), m_NumContended(0), m_TotalWait(0), m_MaxWait(0), m_TotalHold(0), m_MaxHold(0) {}
+	} ;
+	
+	typedef std::set<cCriticalSection *> cCSs;
+	typedef std::map<AString, sTotals> cTotalsMap;
+	
+	/// Guards the containers; it has no name, so it isn't profiled itself
+	cCriticalSection m_CS;
+	
+	/// All the live named CSs
+	cCSs m_CSs;
+	
+	/// Stats of the destroyed CSs, by name
+	cTotalsMap m_Retired;
+	
+	/// Incremented on each reset; a CS whose stats are from an older generation resets them on its next lock
+	volatile int m_Generation;
+	
+	cTimer m_Timer;
+	
+	cLockProfiler(void) : m_Generation(0) {}
+	
+	/// Adds the stats of a single CS into a_Totals
+	static void AddStats(sTotals & a_Totals, const cCriticalSection::sProfile & a_Profile)
+	{
+		a_Totals.m_NumLocks     += a_Profile.m_NumLocks;
+		a_Totals.m_NumContended += a_Profile.m_NumContended;
+		a_Totals.m_TotalWait    += a_Profile.m_TotalWait;
+		a_Totals.m_MaxWait       = std::max(a_Totals.m_MaxWait, a_Profile.m_MaxWait);
+		a_Totals.m_TotalHold    += a_Profile.m_TotalHold;
+		a_Totals.m_MaxHold       = std::max(a_Totals.m_MaxHold, a_Profile.m_MaxHold);
+	}
+} ;
+
+#endif  // LOCK_PROFILING
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cCriticalSection:
 
-cCriticalSection::cCriticalSection()
+cCriticalSection::cCriticalSection(const char * a_Name)
 {
 	#ifdef _WIN32
 		InitializeCriticalSection(&m_CriticalSection);
@@ -26,6 +188,18 @@ cCriticalSection::cCriticalSection()
 	#ifdef _DEBUG
 		m_IsLocked = 0;
 	#endif  // _DEBUG
+	
+	#ifdef LOCK_PROFILING
+		memset(&m_Profile, 0, sizeof(m_Profile));
+		m_Profile.m_Name = a_Name;
+		if (a_Name != NULL)
+		{
+			m_Profile.m_Generation = cLockProfiler::Get().GetGeneration();
+			cLockProfiler::Get().Register(this);
+		}
+	#else
+		UNUSED(a_Name);
+	#endif  // LOCK_PROFILING
 }
 
 
@@ -34,6 +208,13 @@ cCriticalSection::cCriticalSection()
 
 cCriticalSection::~cCriticalSection()
 {
+	#ifdef LOCK_PROFILING
+		if (m_Profile.m_Name != NULL)
+		{
+			cLockProfiler::Get().Unregister(this);
+		}
+	#endif  // LOCK_PROFILING
+	
 	#ifdef _WIN32
 		DeleteCriticalSection(&m_CriticalSection);
 	#else
@@ -51,11 +232,18 @@ cCriticalSection::~cCriticalSection()
 
 void cCriticalSection::Lock()
 {
-	#ifdef _WIN32
-		EnterCriticalSection(&m_CriticalSection);
+	#ifdef LOCK_PROFILING
+		if (m_Profile.m_Name != NULL)
+		{
+			ProfiledLock();
+		}
+		else
+		{
+			LockRaw();
+		}
 	#else
-		pthread_mutex_lock(&m_CriticalSection);
-	#endif
+		LockRaw();
+	#endif  // else LOCK_PROFILING
 	
 	#ifdef _DEBUG
 		m_IsLocked += 1;
@@ -74,6 +262,49 @@ void cCriticalSection::Unlock()
 		m_IsLocked -= 1;
 	#endif  // _DEBUG
 	
+	#ifdef LOCK_PROFILING
+		if (m_Profile.m_Name != NULL)
+		{
+			ProfiledUnlock();
+			return;
+		}
+	#endif  // LOCK_PROFILING
+	
+	UnlockRaw();
+}
+
+
+
+
+
+void cCriticalSection::LockRaw(void)
+{
+	#ifdef _WIN32
+		EnterCriticalSection(&m_CriticalSection);
+	#else
+		pthread_mutex_lock(&m_CriticalSection);
+	#endif
+}
+
+
+
+
+
+bool cCriticalSection::TryLockRaw(void)
+{
+	#ifdef _WIN32
+		return (TryEnterCriticalSection(&m_CriticalSection) != 0);
+	#else
+		return (pthread_mutex_trylock(&m_CriticalSection) == 0);
+	#endif
+}
+
+
+
+
+
+void cCriticalSection::UnlockRaw(void)
+{
 	#ifdef _WIN32
 		LeaveCriticalSection(&m_CriticalSection);
 	#else
@@ -105,6 +336,103 @@ bool cCriticalSection::IsLockedByCurrentThread(void)
 
 
 
+#ifdef LOCK_PROFILING
+void cCriticalSection::ProfiledLock(void)
+{
+	cLockProfiler & Profiler = cLockProfiler::Get();
+	
+	// Measure the time only if some other thread holds the CS, the uncontended locks should stay cheap:
+	bool IsContended = false;
+	Int64 WaitTime = 0;
+	if (!TryLockRaw())
+	{
+		IsContended = true;
+		AtomicAdd(m_Profile.m_NumWaiting, 1);
+		Int64 WaitStart = Profiler.GetNowUSec();
+		LockRaw();
+		WaitTime = Profiler.GetNowUSec() - WaitStart;
+		AtomicAdd(m_Profile.m_NumWaiting, -1);
+	}
+	
+	// The CS is ours now, the stats can be written:
+	sProfile & Profile = m_Profile;
+	Profile.m_LockLevel += 1;
+	if (Profile.m_LockLevel > 1)
+	{
+		// Recursive lock, counts as a part of the outermost one
+		return;
+	}
+	if (Profile.m_Generation != Profiler.GetGeneration())
+	{
+		// The stats have been reset since this CS was last locked
+		Profile.m_Generation   = Profiler.GetGeneration();
+		Profile.m_NumLocks     = 0;
+		Profile.m_NumContended = 0;
+		Profile.m_TotalWait    = 0;
+		Profile.m_MaxWait      = 0;
+		Profile.m_TotalHold    = 0;
+		Profile.m_MaxHold      = 0;
+	}
+	Profile.m_OwnerThreadID = cIsThread::GetCurrentID();
+	Profile.m_LockedSince = Profiler.GetNowUSec();
+	Profile.m_NumLocks += 1;
+	if (IsContended)
+	{
+		Profile.m_NumContended += 1;
+		Profile.m_TotalWait += WaitTime;
+		Profile.m_MaxWait = std::max(Profile.m_MaxWait, WaitTime);
+	}
+}
+
+
+
+
+
+void cCriticalSection::ProfiledUnlock(void)
+{
+	sProfile & Profile = m_Profile;
+	ASSERT(Profile.m_LockLevel > 0);
+	Profile.m_LockLevel -= 1;
+	if (Profile.m_LockLevel == 0)
+	{
+		Int64 HoldTime = cLockProfiler::Get().GetNowUSec() - Profile.m_LockedSince;
+		Profile.m_TotalHold += HoldTime;
+		Profile.m_MaxHold = std::max(Profile.m_MaxHold, HoldTime);
+	}
+	UnlockRaw();
+}
+#endif  // LOCK_PROFILING
+
+
+
+
+
+AStringVector cCriticalSection::GetProfilingReport(void)
+{
+	#ifdef LOCK_PROFILING
+		return cLockProfiler::Get().GetReport();
+	#else
+		AStringVector res;
+		res.push_back("Lock profiling is not compiled in; build with LOCK_PROFILING defined (\"make lockprofile=1\") to enable it.");
+		return res;
+	#endif
+}
+
+
+
+
+
+void cCriticalSection::ResetProfiling(void)
+{
+	#ifdef LOCK_PROFILING
+		cLockProfiler::Get().Reset();
+	#endif
+}
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cCSLock
 
@@ -5,10 +5,20 @@
 
 
 
+/*
+When compiled with LOCK_PROFILING defined ("make lockprofile=1"), each critical section that has been given a name
+records how many times it was locked, how many of those had to wait for another thread, the total and maximum
+wait and hold times, and which thread holds it right now. The stats of all the CSs with the same name are summed
+up in the report, so that e.g. all the chunks' data CSs show as a single line. The report is available through
+the "locks" console command and is logged by cDeadlockDetect when it detects a stalled world.
+Without LOCK_PROFILING, the names are ignored and there's no overhead.
+*/
+
 class cCriticalSection
 {
 public:
-	cCriticalSection(void);
+	/// a_Name is used only for the lock profiling; it must be a string literal (or otherwise live as long as the CS)
+	cCriticalSection(const char * a_Name = NULL);
 	~cCriticalSection();
 
 	void Lock(void);
@@ -19,12 +29,54 @@ public:
 	bool IsLockedByCurrentThread(void);
 	#endif  // _DEBUG
 	
+	/** Returns the lock profiling report, one line per CS name plus a line for each named CS that is currently locked.
+	Returns a note that the profiling is not compiled in when it isn't.
+	The stats are read without locking the CSs, so that the report works even when they are deadlocked; the values may be slightly off.
+	*/
+	static AStringVector GetProfilingReport(void);
+	
+	/// Resets the lock profiling stats; each CS's stats are actually reset by the next thread locking it
+	static void ResetProfiling(void);
+	
 private:
 	#ifdef _DEBUG
 	int           m_IsLocked;  // Number of times this CS is locked
 	unsigned long m_OwningThreadID;
 	#endif  // _DEBUG
 	
+	#ifdef LOCK_PROFILING
+	/// The profiling stats; all of them are written only by the thread holding the CS
+	struct sProfile
+	{
+		const char *  m_Name;
+		int           m_LockLevel;          ///< Number of times the owner has locked the CS (recursion)
+		unsigned long m_OwnerThreadID;      ///< Valid only when m_LockLevel > 0
+		volatile int  m_NumWaiting;         ///< Number of threads waiting for the CS right now; updated atomically
+		Int64         m_LockedSince;        ///< Time of the outermost Lock(), in usec
+		Int64         m_NumLocks;           ///< Number of outermost locks
+		Int64         m_NumContended;       ///< Number of the locks that had to wait for another thread
+		Int64         m_TotalWait;          ///< usec
+		Int64         m_MaxWait;            ///< usec
+		Int64         m_TotalHold;          ///< usec
+		Int64         m_MaxHold;            ///< usec
+		int           m_Generation;         ///< The profiler's reset generation for which the stats were collected
+	} ;
+	sProfile m_Profile;
+	
+	friend class cLockProfiler;
+	
+	/// Locks the CS and updates the profiling stats
+	void ProfiledLock(void);
+	
+	/// Updates the profiling stats and unlocks the CS
+	void ProfiledUnlock(void);
+	#endif  // LOCK_PROFILING
+	
+	/// The OS lock and unlock, without any bookkeeping
+	void LockRaw(void);
+	bool TryLockRaw(void);
+	void UnlockRaw(void);
+	
 	#ifdef _WIN32
 		CRITICAL_SECTION m_CriticalSection;
 	#else  // _WIN32
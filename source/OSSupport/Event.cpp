@@ -97,6 +97,62 @@ void cEvent::Wait(void)
 
 
 
+bool cEvent::Wait(int a_TimeoutMSec)
+{
+	#ifdef _WIN32
+		DWORD res = WaitForSingleObject(m_Event, (DWORD)a_TimeoutMSec);
+		if ((res != WAIT_OBJECT_0) && (res != WAIT_TIMEOUT))
+		{
+			LOGWARN("cEvent: waiting for the event failed: %d, GLE = %d. Continuing, but server may be unstable.", res, GetLastError());
+		}
+		return (res == WAIT_OBJECT_0);
+	#else
+		if (m_bIsNamed)
+		{
+			// MacOS doesn't have sem_timedwait(), poll instead:
+			for (int i = 0; i < a_TimeoutMSec; i++)
+			{
+				if (sem_trywait(m_Event) == 0)
+				{
+					return true;
+				}
+				cSleep::MilliSleep(1);
+			}
+			return (sem_trywait(m_Event) == 0);
+		}
+
+		timespec Deadline;
+		clock_gettime(CLOCK_REALTIME, &Deadline);
+		Deadline.tv_sec += a_TimeoutMSec / 1000;
+		Deadline.tv_nsec += (a_TimeoutMSec % 1000) * 1000000;
+		if (Deadline.tv_nsec >= 1000000000)
+		{
+			Deadline.tv_sec += 1;
+			Deadline.tv_nsec -= 1000000000;
+		}
+		for (;;)
+		{
+			if (sem_timedwait(m_Event, &Deadline) == 0)
+			{
+				return true;
+			}
+			if (errno == ETIMEDOUT)
+			{
+				return false;
+			}
+			if (errno != EINTR)
+			{
+				LOGWARN("cEvent: waiting for the event failed: errno = %i. Continuing, but server may be unstable.", errno);
+				return false;
+			}
+		}
+	#endif
+}
+
+
+
+
+
 void cEvent::Set(void)
 {
 	#ifdef _WIN32
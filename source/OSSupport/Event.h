@@ -24,6 +24,9 @@ public:
 
 	void Wait(void);
 	void Set (void);
+
+	/// Waits for the event for at most the specified time; returns true if the event was set, false on timeout
+	bool Wait(int a_TimeoutMSec);
 	
 private:
 
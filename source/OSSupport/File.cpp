@@ -7,6 +7,11 @@
 
 #include "File.h"
 #include <fstream>
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
 
 
 
@@ -201,6 +206,42 @@ int cFile::Tell (void) const
 
 
 
+bool cFile::Flush(void)
+{
+	ASSERT(IsOpen());
+	
+	if (!IsOpen())
+	{
+		return false;
+	}
+	
+	return (fflush(m_File) == 0);
+}
+
+
+
+
+
+bool cFile::Truncate(int a_Size)
+{
+	ASSERT(IsOpen());
+	
+	if (!IsOpen() || (fflush(m_File) != 0))
+	{
+		return false;
+	}
+	
+	#ifdef _WIN32
+		return (_chsize(_fileno(m_File), a_Size) == 0);
+	#else
+		return (ftruncate(fileno(m_File), a_Size) == 0);
+	#endif
+}
+
+
+
+
+
 int cFile::GetSize(void) const
 {
 	ASSERT(IsOpen());
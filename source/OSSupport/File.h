@@ -95,6 +95,12 @@ public:
 	/// Reads the file from current position till EOF into an AString; returns the number of bytes read or -1 for error
 	int ReadRestOfFile(AString & a_Contents);
 	
+	/// Hands the buffered written data over to the OS, so that it survives the process crashing; returns true on success; asserts if not open
+	bool Flush(void);
+	
+	/// Cuts the file off at the specified size, discarding everything after it; returns true on success; asserts if not open
+	bool Truncate(int a_Size);
+	
 	// tolua_begin
 	
 	/// Returns true if the file specified exists
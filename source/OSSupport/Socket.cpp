@@ -169,6 +169,25 @@ bool cSocket::SetReuseAddress(void)
 
 
 
+bool cSocket::SetTimeout(int a_TimeoutMSec)
+{
+	#ifdef _WIN32
+		DWORD Timeout = a_TimeoutMSec;
+	#else
+		timeval Timeout;
+		Timeout.tv_sec  = a_TimeoutMSec / 1000;
+		Timeout.tv_usec = (a_TimeoutMSec % 1000) * 1000;
+	#endif
+	return (
+		(setsockopt(m_Socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&Timeout, sizeof(Timeout)) == 0) &&
+		(setsockopt(m_Socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&Timeout, sizeof(Timeout)) == 0)
+	);
+}
+
+
+
+
+
 int cSocket::WSAStartup()
 {
 #ifdef _WIN32
@@ -38,6 +38,9 @@ public:
 	/// Sets the address-reuse socket flag; returns true on success
 	bool SetReuseAddress(void);
 	
+	/// Sets the timeout for blocking sends and receives (and connects on *nix), in msec; returns true on success
+	bool SetTimeout(int a_TimeoutMSec);
+	
 	static int WSAStartup(void);
 
 	static AString GetErrorString(int a_ErrNo);
@@ -35,3 +35,20 @@ long long cTimer::GetNowTime(void)
 
 
 
+
+long long cTimer::GetNowTimeUSec(void)
+{
+	#ifdef _WIN32
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		return ((now.QuadPart * 1000000) / m_TicksPerSecond.QuadPart);
+	#else
+		struct timeval  now;
+		gettimeofday(&now, NULL);
+		return (long long)now.tv_sec * 1000000 + now.tv_usec;
+	#endif
+}
+
+
+
+
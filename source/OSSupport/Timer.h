@@ -20,6 +20,9 @@ public:
 
 	// Returns the current time expressed in milliseconds
 	long long GetNowTime(void);
+
+	// Returns the current time expressed in microseconds; used for profiling short operations
+	long long GetNowTimeUSec(void);
 private:
 
 	#ifdef _WIN32
@@ -0,0 +1,226 @@
+
+// PlayerSaver.cpp
+
+// Implements the cPlayerSaver class representing the thread that writes player data to disk
+
+#include "Globals.h"
+
+#include "PlayerSaver.h"
+#include "Inventory.h"
+
+#include <json/json.h>
+
+
+
+
+
+cPlayerSaver::cPlayerSaver(void) :
+	super("cPlayerSaver"),
+	m_IsRunning(false)
+{
+}
+
+
+
+
+
+cPlayerSaver::~cPlayerSaver()
+{
+	Stop();
+}
+
+
+
+
+
+void cPlayerSaver::Start(void)
+{
+	cFile::CreateFolder(FILE_IO_PREFIX + AString("players"));
+	m_ShouldTerminate = false;
+	m_IsRunning = true;
+	super::Start();
+}
+
+
+
+
+
+void cPlayerSaver::Stop(void)
+{
+	if (!m_IsRunning)
+	{
+		return;
+	}
+	m_ShouldTerminate = true;
+	m_evtQueued.Set();
+	Wait();
+	m_IsRunning = false;
+
+	// Write anything that has been queued while the thread was terminating:
+	WriteQueue();
+}
+
+
+
+
+
+void cPlayerSaver::QueueSave(const sPlayerData & a_Data)
+{
+	if (!m_IsRunning)
+	{
+		WritePlayer(a_Data);
+		return;
+	}
+
+	{
+		cCSLock Lock(m_CS);
+		m_Queue[a_Data.m_PlayerName] = a_Data;
+	}
+	m_evtQueued.Set();
+}
+
+
+
+
+
+void cPlayerSaver::WaitForPlayer(const AString & a_PlayerName)
+{
+	cCSLock Lock(m_CS);
+	while ((m_Queue.find(a_PlayerName) != m_Queue.end()) || (m_WritingPlayer == a_PlayerName))
+	{
+		if (!m_IsRunning)
+		{
+			// Nobody else is going to write the data, do it ourselves:
+			Lock.Unlock();
+			WriteQueue();
+			return;
+		}
+		cCSUnlock Unlock(Lock);
+		m_evtQueued.Set();
+		cSleep::MilliSleep(1);
+	}
+}
+
+
+
+
+
+AString cPlayerSaver::GetPlayerFileName(const AString & a_PlayerName)
+{
+	AString FileName;
+	Printf(FileName, "players/%s.json", a_PlayerName.c_str());
+	return FileName;
+}
+
+
+
+
+
+void cPlayerSaver::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		m_evtQueued.Wait();
+		WriteQueue();
+	}
+}
+
+
+
+
+
+void cPlayerSaver::WriteQueue(void)
+{
+	for (;;)
+	{
+		sPlayerData Data;
+		{
+			cCSLock Lock(m_CS);
+			if (m_Queue.empty())
+			{
+				return;
+			}
+			cPlayerDataMap::iterator itr = m_Queue.begin();
+			std::swap(Data, itr->second);
+			m_Queue.erase(itr);
+			m_WritingPlayer = Data.m_PlayerName;
+		}
+
+		WritePlayer(Data);
+
+		cCSLock Lock(m_CS);
+		m_WritingPlayer.clear();
+	}
+}
+
+
+
+
+
+bool cPlayerSaver::WritePlayer(const sPlayerData & a_Data)
+{
+	Json::Value JSON_PlayerPosition;
+	JSON_PlayerPosition.append(Json::Value(a_Data.m_Position.x));
+	JSON_PlayerPosition.append(Json::Value(a_Data.m_Position.y));
+	JSON_PlayerPosition.append(Json::Value(a_Data.m_Position.z));
+
+	Json::Value JSON_PlayerRotation;
+	JSON_PlayerRotation.append(Json::Value(a_Data.m_Yaw));
+	JSON_PlayerRotation.append(Json::Value(a_Data.m_Pitch));
+	JSON_PlayerRotation.append(Json::Value(a_Data.m_Roll));
+
+	Json::Value JSON_Inventory;
+	cInventory::SaveSlotsToJson(a_Data.m_Inventory, JSON_Inventory);
+
+	Json::Value root;
+	root["position"]       = JSON_PlayerPosition;
+	root["rotation"]       = JSON_PlayerRotation;
+	root["inventory"]      = JSON_Inventory;
+	root["health"]         = a_Data.m_Health;
+	root["xpTotal"]        = a_Data.m_LifetimeTotalXp;
+	root["xpCurrent"]      = a_Data.m_CurrentXp;
+	root["air"]            = a_Data.m_AirLevel;
+	root["food"]           = a_Data.m_FoodLevel;
+	root["foodSaturation"] = a_Data.m_FoodSaturationLevel;
+	root["foodTickTimer"]  = a_Data.m_FoodTickTimer;
+	root["foodExhaustion"] = a_Data.m_FoodExhaustionLevel;
+	root["world"]          = a_Data.m_WorldName;
+	root["gamemode"]       = a_Data.m_GameMode;
+
+	Json::FastWriter Writer;
+	std::string JsonData = Writer.write(root);
+
+	// Write into a temporary file first and then replace the real file, so that a crash mid-write doesn't destroy the data:
+	AString FileName = GetPlayerFileName(a_Data.m_PlayerName);
+	AString TempFileName = FileName + ".tmp";
+	{
+		cFile f;
+		if (!f.Open(TempFileName, cFile::fmWrite))
+		{
+			LOGERROR("ERROR WRITING PLAYER \"%s\" TO FILE \"%s\" - cannot open file", a_Data.m_PlayerName.c_str(), TempFileName.c_str());
+			return false;
+		}
+		if (f.Write(JsonData.c_str(), JsonData.size()) != (int)JsonData.size())
+		{
+			LOGERROR("ERROR WRITING PLAYER JSON TO FILE \"%s\"", TempFileName.c_str());
+			return false;
+		}
+	}
+
+	#ifdef _WIN32
+		// rename() doesn't replace an existing file on Windows:
+		bool IsRenamed = (MoveFileEx((FILE_IO_PREFIX + TempFileName).c_str(), (FILE_IO_PREFIX + FileName).c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+	#else
+		bool IsRenamed = cFile::Rename(FILE_IO_PREFIX + TempFileName, FILE_IO_PREFIX + FileName);
+	#endif
+	if (!IsRenamed)
+	{
+		LOGERROR("ERROR WRITING PLAYER \"%s\" - cannot replace file \"%s\"", a_Data.m_PlayerName.c_str(), FileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+
+
@@ -0,0 +1,91 @@
+
+// PlayerSaver.h
+
+// Interfaces to the cPlayerSaver class representing the thread that writes player data to disk
+// The tick thread only takes a cheap snapshot of the player's data and queues it; the thread serializes it into JSON and writes the file.
+// Repeated saves of the same player that arrive before the data is written are coalesced into a single write of the latest data.
+
+
+
+
+
+#pragma once
+
+#include "OSSupport/IsThread.h"
+#include "Item.h"
+#include "Vector3d.h"
+
+
+
+
+
+class cPlayerSaver :
+	public cIsThread
+{
+	typedef cIsThread super;
+
+public:
+	/// A copy of all the player data that gets saved
+	struct sPlayerData
+	{
+		AString  m_PlayerName;
+		Vector3d m_Position;
+		double   m_Yaw;
+		double   m_Pitch;
+		double   m_Roll;
+		cItems   m_Inventory;  ///< All inventory slots, as copied by cInventory::CopyAllSlots()
+		int      m_Health;
+		short    m_LifetimeTotalXp;
+		short    m_CurrentXp;
+		int      m_AirLevel;
+		int      m_FoodLevel;
+		double   m_FoodSaturationLevel;
+		int      m_FoodTickTimer;
+		double   m_FoodExhaustionLevel;
+		AString  m_WorldName;
+		int      m_GameMode;  ///< eGameMode_NotSet if the player uses the world's gamemode
+	} ;
+
+	cPlayerSaver(void);
+	~cPlayerSaver();
+
+	/// Starts the saver thread. The thread may be started and stopped repeatedly
+	void Start(void);
+
+	/// Writes all the queued data and stops the saver thread
+	void Stop(void);
+
+	/** Queues the player data for writing.
+	If data for the same player is already queued, it is replaced, so only the latest data gets written.
+	If the thread is not running, the data is written right away.
+	*/
+	void QueueSave(const sPlayerData & a_Data);
+
+	/// Blocks until any queued data for the specified player has been written. Used before loading the player's file.
+	void WaitForPlayer(const AString & a_PlayerName);
+
+	/// Returns the name of the file in which the specified player's data is stored
+	static AString GetPlayerFileName(const AString & a_PlayerName);
+
+protected:
+	typedef std::map<AString, sPlayerData> cPlayerDataMap;
+
+	cCriticalSection m_CS;
+	cPlayerDataMap   m_Queue;          ///< Player name -> the latest data to be written
+	AString          m_WritingPlayer;  ///< Name of the player whose data is currently being written, empty if none
+	cEvent           m_evtQueued;
+	bool             m_IsRunning;
+
+	// cIsThread override:
+	virtual void Execute(void) override;
+
+	/// Writes all the data that is queued, including data queued while writing
+	void WriteQueue(void);
+
+	/// Serializes the data into JSON and writes it into the player's file, through a temporary file. Returns true on success.
+	bool WritePlayer(const sPlayerData & a_Data);
+} ;
+
+
+
+
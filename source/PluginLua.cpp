@@ -25,8 +25,13 @@ extern "C"
 
 cPluginLua::cPluginLua(const AString & a_PluginDirectory) :
 	cPlugin(a_PluginDirectory),
-	m_LuaState(Printf("plugin %s", a_PluginDirectory.c_str()))
+	m_CriticalSection("Lua plugin"),
+	m_LuaState(Printf("plugin %s", a_PluginDirectory.c_str())),
+	m_HookInstructionLimit(0),
+	m_HookNestingLevel(0),
+	m_IsHookAborted(false)
 {
+	SetLanguage(E_LUA);
 }
 
 
@@ -145,6 +150,7 @@ void cPluginLua::Tick(float a_Dt)
 {
 	cCSLock Lock(m_CriticalSection);
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_TICK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_TICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Dt);
@@ -160,6 +166,7 @@ bool cPluginLua::OnBlockToPickups(cWorld * a_World, cEntity * a_Digger, int a_Bl
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_BLOCK_TO_PICKUPS];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_BLOCK_TO_PICKUPS);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_Digger, a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta, &a_Pickups, cLuaState::Return, res);
@@ -180,6 +187,7 @@ bool cPluginLua::OnChat(cPlayer * a_Player, AString & a_Message)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHAT];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CHAT);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Message, cLuaState::Return, res, a_Message);
@@ -200,6 +208,7 @@ bool cPluginLua::OnChunkAvailable(cWorld * a_World, int a_ChunkX, int a_ChunkZ)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_AVAILABLE];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CHUNK_AVAILABLE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, cLuaState::Return, res);
@@ -220,6 +229,7 @@ bool cPluginLua::OnChunkGenerated(cWorld * a_World, int a_ChunkX, int a_ChunkZ,
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_GENERATED];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CHUNK_GENERATED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc, cLuaState::Return, res);
@@ -240,6 +250,7 @@ bool cPluginLua::OnChunkGenerating(cWorld * a_World, int a_ChunkX, int a_ChunkZ,
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_GENERATING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CHUNK_GENERATING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc, cLuaState::Return, res);
@@ -260,6 +271,7 @@ bool cPluginLua::OnChunkUnloaded(cWorld * a_World, int a_ChunkX, int a_ChunkZ)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_UNLOADED];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CHUNK_UNLOADED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, cLuaState::Return, res);
@@ -280,6 +292,7 @@ bool cPluginLua::OnChunkUnloading(cWorld * a_World, int a_ChunkX, int a_ChunkZ)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_UNLOADING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CHUNK_UNLOADING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, cLuaState::Return, res);
@@ -300,6 +313,7 @@ bool cPluginLua::OnCollectingPickup(cPlayer * a_Player, cPickup * a_Pickup)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_COLLECTING_PICKUP];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_COLLECTING_PICKUP);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Pickup, cLuaState::Return, res);
@@ -320,6 +334,7 @@ bool cPluginLua::OnCraftingNoRecipe(const cPlayer * a_Player, const cCraftingGri
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CRAFTING_NO_RECIPE];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_CRAFTING_NO_RECIPE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), (cPlayer *)a_Player, a_Grid, a_Recipe, cLuaState::Return, res);
@@ -340,6 +355,7 @@ bool cPluginLua::OnDisconnect(cPlayer * a_Player, const AString & a_Reason)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_DISCONNECT];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_DISCONNECT);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Reason, cLuaState::Return, res);
@@ -360,6 +376,7 @@ bool cPluginLua::OnExecuteCommand(cPlayer * a_Player, const AStringVector & a_Sp
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_EXECUTE_COMMAND];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_EXECUTE_COMMAND);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Split, cLuaState::Return, res);
@@ -380,6 +397,7 @@ bool cPluginLua::OnExploded(cWorld & a_World, double a_ExplosionSize, bool a_Can
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_EXPLODED];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_EXPLODED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		switch (a_Source)
@@ -417,6 +435,7 @@ bool cPluginLua::OnExploding(cWorld & a_World, double & a_ExplosionSize, bool &
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_EXPLODING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_EXPLODING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		switch (a_Source)
@@ -454,6 +473,7 @@ bool cPluginLua::OnHandshake(cClientHandle * a_Client, const AString & a_Usernam
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_HANDSHAKE];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_HANDSHAKE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Client, a_Username, cLuaState::Return, res);
@@ -475,6 +495,7 @@ bool cPluginLua::OnHopperPullingItem(cWorld & a_World, cHopperEntity & a_Hopper,
 	bool res = false;
 
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_HOPPER_PULLING_ITEM];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_HOPPER_PULLING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Hopper, a_DstSlotNum, &a_SrcEntity, a_SrcSlotNum, cLuaState::Return, res);
@@ -495,6 +516,7 @@ bool cPluginLua::OnHopperPushingItem(cWorld & a_World, cHopperEntity & a_Hopper,
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_HOPPER_PUSHING_ITEM];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_HOPPER_PUSHING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Hopper, a_SrcSlotNum, &a_DstEntity, a_DstSlotNum, cLuaState::Return, res);
@@ -515,6 +537,7 @@ bool cPluginLua::OnKilling(cEntity & a_Victim, cEntity * a_Killer)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_KILLING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_KILLING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Victim, a_Killer, cLuaState::Return, res);
@@ -535,6 +558,7 @@ bool cPluginLua::OnLogin(cClientHandle * a_Client, int a_ProtocolVersion, const
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_LOGIN];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_LOGIN);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Client, a_ProtocolVersion, a_Username, cLuaState::Return, res);
@@ -555,6 +579,7 @@ bool cPluginLua::OnPlayerAnimation(cPlayer & a_Player, int a_Animation)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_ANIMATION];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_ANIMATION);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_Animation, cLuaState::Return, res);
@@ -575,6 +600,7 @@ bool cPluginLua::OnPlayerBreakingBlock(cPlayer & a_Player, int a_BlockX, int a_B
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_BREAKING_BLOCK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_BREAKING_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -595,6 +621,7 @@ bool cPluginLua::OnPlayerBrokenBlock(cPlayer & a_Player, int a_BlockX, int a_Blo
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_BROKEN_BLOCK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_BROKEN_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -615,6 +642,7 @@ bool cPluginLua::OnPlayerEating(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_EATING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_EATING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -635,6 +663,7 @@ bool cPluginLua::OnPlayerJoined(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_JOINED];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_JOINED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -655,6 +684,7 @@ bool cPluginLua::OnPlayerLeftClick(cPlayer & a_Player, int a_BlockX, int a_Block
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_LEFT_CLICK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_LEFT_CLICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_Status, cLuaState::Return, res);
@@ -675,6 +705,7 @@ bool cPluginLua::OnPlayerMoved(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_MOVING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_MOVING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -695,6 +726,7 @@ bool cPluginLua::OnPlayerPlacedBlock(cPlayer & a_Player, int a_BlockX, int a_Blo
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_PLACED_BLOCK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_PLACED_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -715,6 +747,7 @@ bool cPluginLua::OnPlayerPlacingBlock(cPlayer & a_Player, int a_BlockX, int a_Bl
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_PLACING_BLOCK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_PLACING_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -735,6 +768,7 @@ bool cPluginLua::OnPlayerRightClick(cPlayer & a_Player, int a_BlockX, int a_Bloc
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_RIGHT_CLICK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_RIGHT_CLICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, cLuaState::Return, res);
@@ -755,6 +789,7 @@ bool cPluginLua::OnPlayerRightClickingEntity(cPlayer & a_Player, cEntity & a_Ent
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_RIGHT_CLICKING_ENTITY];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_RIGHT_CLICKING_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, &a_Entity, cLuaState::Return, res);
@@ -775,6 +810,7 @@ bool cPluginLua::OnPlayerShooting(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_SHOOTING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_SHOOTING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -795,6 +831,7 @@ bool cPluginLua::OnPlayerSpawned(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_SPAWNED];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_SPAWNED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -815,6 +852,7 @@ bool cPluginLua::OnPlayerTossingItem(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_TOSSING_ITEM];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_TOSSING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -835,6 +873,7 @@ bool cPluginLua::OnPlayerUsedBlock(cPlayer & a_Player, int a_BlockX, int a_Block
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USED_BLOCK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_USED_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -855,6 +894,7 @@ bool cPluginLua::OnPlayerUsedItem(cPlayer & a_Player, int a_BlockX, int a_BlockY
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USED_ITEM];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_USED_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, cLuaState::Return, res);
@@ -875,6 +915,7 @@ bool cPluginLua::OnPlayerUsingBlock(cPlayer & a_Player, int a_BlockX, int a_Bloc
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USING_BLOCK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_USING_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -895,6 +936,7 @@ bool cPluginLua::OnPlayerUsingItem(cPlayer & a_Player, int a_BlockX, int a_Block
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USING_ITEM];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PLAYER_USING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, cLuaState::Return, res);
@@ -915,6 +957,7 @@ bool cPluginLua::OnPostCrafting(const cPlayer * a_Player, const cCraftingGrid *
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_POST_CRAFTING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_POST_CRAFTING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Grid, a_Recipe, cLuaState::Return, res);
@@ -935,6 +978,7 @@ bool cPluginLua::OnPreCrafting(const cPlayer * a_Player, const cCraftingGrid * a
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PRE_CRAFTING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_PRE_CRAFTING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Grid, a_Recipe, cLuaState::Return, res);
@@ -955,6 +999,7 @@ bool cPluginLua::OnSpawnedEntity(cWorld & a_World, cEntity & a_Entity)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNED_ENTITY];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_SPAWNED_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Entity, cLuaState::Return, res);
@@ -975,6 +1020,7 @@ bool cPluginLua::OnSpawnedMonster(cWorld & a_World, cMonster & a_Monster)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNED_MONSTER];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_SPAWNED_MONSTER);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Monster, cLuaState::Return, res);
@@ -995,6 +1041,7 @@ bool cPluginLua::OnSpawningEntity(cWorld & a_World, cEntity & a_Entity)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNING_ENTITY];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_SPAWNING_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Entity, cLuaState::Return, res);
@@ -1015,6 +1062,7 @@ bool cPluginLua::OnSpawningMonster(cWorld & a_World, cMonster & a_Monster)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNING_MONSTER];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_SPAWNING_MONSTER);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Monster, cLuaState::Return, res);
@@ -1035,6 +1083,7 @@ bool cPluginLua::OnTakeDamage(cEntity & a_Receiver, TakeDamageInfo & a_TDI)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_TAKE_DAMAGE];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_TAKE_DAMAGE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Receiver, &a_TDI, cLuaState::Return, res);
@@ -1060,6 +1109,7 @@ bool cPluginLua::OnUpdatedSign(
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_UPDATED_SIGN];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_UPDATED_SIGN);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player, cLuaState::Return, res);
@@ -1085,6 +1135,7 @@ bool cPluginLua::OnUpdatingSign(
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_UPDATING_SIGN];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_UPDATING_SIGN);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player, cLuaState::Return, res, a_Line1, a_Line2, a_Line3, a_Line4);
@@ -1105,6 +1156,7 @@ bool cPluginLua::OnWeatherChanged(cWorld & a_World)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WEATHER_CHANGED];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_WEATHER_CHANGED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, cLuaState::Return, res);
@@ -1126,6 +1178,7 @@ bool cPluginLua::OnWeatherChanging(cWorld & a_World, eWeather & a_NewWeather)
 	bool res = false;
 	int NewWeather = a_NewWeather;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WEATHER_CHANGING];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_WEATHER_CHANGING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, NewWeather, cLuaState::Return, res, NewWeather);
@@ -1147,6 +1200,7 @@ bool cPluginLua::OnWorldTick(cWorld & a_World, float a_Dt)
 {
 	cCSLock Lock(m_CriticalSection);
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WORLD_TICK];
+	cHookProfiler Profiler(*this, cPluginManager::HOOK_WORLD_TICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, a_Dt);
@@ -1469,3 +1523,103 @@ void cPluginLua::CallbackWindowSlotChanged(int a_FnRef, cWindow & a_Window, int
 
 
 
+
+void cPluginLua::GetHookStats(cHookStatsMap & a_Stats, int & a_LuaMemoryKiB)
+{
+	cCSLock Lock(m_CriticalSection);
+	a_Stats = m_HookStats;
+	a_LuaMemoryKiB = m_LuaState.IsValid() ? lua_gc(m_LuaState, LUA_GCCOUNT, 0) : 0;
+}
+
+
+
+
+
+void cPluginLua::ResetHookStats(void)
+{
+	cCSLock Lock(m_CriticalSection);
+	m_HookStats.clear();
+}
+
+
+
+
+
+void cPluginLua::OnInstructionLimitReached(lua_State * a_LuaState, lua_Debug * a_Debug)
+{
+	UNUSED(a_Debug);
+	
+	// Find the plugin that owns this LuaState:
+	lua_getglobal(a_LuaState, LUA_PLUGIN_INSTANCE_VAR_NAME);
+	cPluginLua * Plugin = (cPluginLua *)lua_touserdata(a_LuaState, -1);
+	lua_pop(a_LuaState, 1);
+	if (Plugin == NULL)
+	{
+		return;
+	}
+	
+	Plugin->m_IsHookAborted = true;
+	luaL_error(a_LuaState, "Hook execution exceeded the limit of %d instructions and was aborted", Plugin->m_HookInstructionLimit);
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cPluginLua::cHookProfiler:
+
+cPluginLua::cHookProfiler::cHookProfiler(cPluginLua & a_Plugin, int a_HookType) :
+	m_Plugin(a_Plugin),
+	m_HookType(a_HookType),
+	m_StartUSec(a_Plugin.m_ProfilerTimer.GetNowTimeUSec()),
+	m_StartMemKiB(lua_gc(a_Plugin.m_LuaState, LUA_GCCOUNT, 0))
+{
+	ASSERT(m_Plugin.m_CriticalSection.IsLockedByCurrentThread());
+	
+	// Arm the watchdog only for the outermost hook; nested hooks count against the outer hook's budget:
+	m_Plugin.m_HookNestingLevel += 1;
+	if ((m_Plugin.m_HookNestingLevel == 1) && (m_Plugin.m_HookInstructionLimit > 0))
+	{
+		m_Plugin.m_IsHookAborted = false;
+		lua_sethook(m_Plugin.m_LuaState, OnInstructionLimitReached, LUA_MASKCOUNT, m_Plugin.m_HookInstructionLimit);
+	}
+}
+
+
+
+
+
+cPluginLua::cHookProfiler::~cHookProfiler()
+{
+	long long Duration = m_Plugin.m_ProfilerTimer.GetNowTimeUSec() - m_StartUSec;
+	int MemDelta = lua_gc(m_Plugin.m_LuaState, LUA_GCCOUNT, 0) - m_StartMemKiB;
+	
+	sHookStats & Stats = m_Plugin.m_HookStats[m_HookType];
+	Stats.m_NumCalls += 1;
+	Stats.m_TotalTimeUSec += Duration;
+	Stats.m_MaxTimeUSec = std::max(Stats.m_MaxTimeUSec, Duration);
+	if (MemDelta > 0)
+	{
+		Stats.m_TotalMemDeltaKiB += MemDelta;
+		Stats.m_MaxMemDeltaKiB = std::max(Stats.m_MaxMemDeltaKiB, MemDelta);
+	}
+	
+	m_Plugin.m_HookNestingLevel -= 1;
+	if ((m_Plugin.m_HookNestingLevel == 0) && (m_Plugin.m_HookInstructionLimit > 0))
+	{
+		lua_sethook(m_Plugin.m_LuaState, NULL, 0, 0);
+		if (m_Plugin.m_IsHookAborted)
+		{
+			Stats.m_NumAborted += 1;
+			m_Plugin.m_IsHookAborted = false;
+			LOGWARNING("Plugin %s: hook %s was aborted for exceeding the instruction limit (%d).",
+				m_Plugin.GetName().c_str(), GetHookFnName(m_HookType), m_Plugin.m_HookInstructionLimit
+			);
+		}
+	}
+}
+
+
+
+
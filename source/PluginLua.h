@@ -12,6 +12,7 @@
 #include "Plugin.h"
 #include "WebPlugin.h"
 #include "LuaState.h"
+#include "OSSupport/Timer.h"
 
 // Names for the global variables through which the plugin is identified in its LuaState
 #define LUA_PLUGIN_NAME_VAR_NAME     "_MCServerInternal_PluginName"
@@ -35,6 +36,30 @@ class cPluginLua :
 public:
 	// tolua_end
 	
+	/// Execution statistics of a single hook type in a plugin, gathered by the built-in hook profiler
+	struct sHookStats
+	{
+		int       m_NumCalls;
+		int       m_NumAborted;         ///< Number of invocations aborted by the instruction-count watchdog
+		long long m_TotalTimeUSec;
+		long long m_MaxTimeUSec;
+		int       m_TotalMemDeltaKiB;   ///< Sum of the Lua memory growth over all invocations
+		int       m_MaxMemDeltaKiB;     ///< Largest Lua memory growth in a single invocation
+		
+		sHookStats(void) :
+			m_NumCalls(0),
+			m_NumAborted(0),
+			m_TotalTimeUSec(0),
+			m_MaxTimeUSec(0),
+			m_TotalMemDeltaKiB(0),
+			m_MaxMemDeltaKiB(0)
+		{
+		}
+	} ;
+	
+	/// Maps hook types to their statistics
+	typedef std::map<int, sHookStats> cHookStatsMap;
+	
 	cPluginLua( const AString & a_PluginDirectory );
 	~cPluginLua();
 
@@ -132,6 +157,18 @@ public:
 	/// Returns the name of Lua function that should handle the specified hook type in the older (#121) API
 	static const char * GetHookFnName(int a_HookType);
 	
+	/** Sets the maximum number of Lua VM instructions that a single hook invocation may execute.
+	When exceeded, the invocation is aborted with a Lua error instead of blocking the calling thread forever.
+	Zero disables the watchdog.
+	*/
+	void SetHookInstructionLimit(int a_Limit) { m_HookInstructionLimit = a_Limit; }
+	
+	/// Returns a copy of the per-hook statistics gathered so far, and the current size of the Lua memory, in KiB
+	void GetHookStats(cHookStatsMap & a_Stats, int & a_LuaMemoryKiB);
+	
+	/// Clears all gathered per-hook statistics
+	void ResetHookStats(void);
+	
 	/** Adds a Lua function to be called for the specified hook.
 	The function has to be on the Lua stack at the specified index a_FnRefIdx
 	Returns true if the hook was added successfully.
@@ -176,6 +213,25 @@ public:
 	}
 
 protected:
+	/** RAII helper that measures a single hook invocation and updates the plugin's statistics.
+	Also arms the instruction-count watchdog for the outermost invocation, if enabled.
+	Must be used only while holding m_CriticalSection.
+	*/
+	class cHookProfiler
+	{
+	public:
+		cHookProfiler(cPluginLua & a_Plugin, int a_HookType);
+		~cHookProfiler();
+		
+	protected:
+		cPluginLua & m_Plugin;
+		int          m_HookType;
+		long long    m_StartUSec;
+		int          m_StartMemKiB;
+	} ;
+	
+	friend class cHookProfiler;
+	
 	/// Maps command name into Lua function reference
 	typedef std::map<AString, int> CommandMap;
 	
@@ -193,8 +249,26 @@ protected:
 	
 	cHookMap m_HookMap;
 	
+	/// Statistics for each hook type called in this plugin. Protected by m_CriticalSection
+	cHookStatsMap m_HookStats;
+	
+	/// Timer used by the hook profiler
+	cTimer m_ProfilerTimer;
+	
+	/// Max number of Lua instructions a single hook invocation may execute; 0 = unlimited
+	int m_HookInstructionLimit;
+	
+	/// Number of hook invocations currently in progress (hooks may nest through API calls)
+	int m_HookNestingLevel;
+	
+	/// Set by the watchdog when it aborts the currently running hook invocation
+	bool m_IsHookAborted;
+	
 	/// Releases all Lua references and closes the LuaState
 	void Close(void);
+	
+	/// The Lua count hook that aborts a hook invocation that has run out of its instruction budget
+	static void OnInstructionLimitReached(lua_State * a_LuaState, lua_Debug * a_Debug);
 } ;  // tolua_export
 
 
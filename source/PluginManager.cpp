@@ -28,7 +28,8 @@ cPluginManager * cPluginManager::Get(void)
 
 
 cPluginManager::cPluginManager(void) :
-	m_bReloadPlugins(false)
+	m_bReloadPlugins(false),
+	m_HookInstructionLimit(0)
 {
 }
 
@@ -113,6 +114,8 @@ void cPluginManager::ReloadPluginsNow(cIniFile & a_SettingsIni)
 	FindPlugins();
 
 	cServer::BindBuiltInConsoleCommands();
+	
+	m_HookInstructionLimit = a_SettingsIni.GetValueSetI("PluginProfiler", "MaxHookInstructions", 0);
 
 	// Check if the Plugins section exists.
 	int KeyNum = a_SettingsIni.FindKey("Plugins");
@@ -1340,7 +1343,9 @@ bool cPluginManager::DisablePlugin(const AString & a_PluginName)
 
 bool cPluginManager::LoadPlugin(const AString & a_PluginName)
 {
-	return AddPlugin(new cPluginLua(a_PluginName.c_str()));
+	cPluginLua * Plugin = new cPluginLua(a_PluginName.c_str());
+	Plugin->SetHookInstructionLimit(m_HookInstructionLimit);
+	return AddPlugin(Plugin);
 }
 
 
@@ -1624,6 +1629,91 @@ bool cPluginManager::IsValidHookType(int a_HookType)
 
 
 
+void cPluginManager::LogHookStats(cCommandOutputCallback & a_Output)
+{
+	for (PluginMap::const_iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+	{
+		if ((itr->second == NULL) || (itr->second->GetLanguage() != cPlugin::E_LUA))
+		{
+			continue;
+		}
+		cPluginLua * Plugin = (cPluginLua *)(itr->second);
+		cPluginLua::cHookStatsMap Stats;
+		int LuaMemKiB = 0;
+		Plugin->GetHookStats(Stats, LuaMemKiB);
+		a_Output.Out("Plugin %s (Lua memory: %d KiB):", Plugin->GetName().c_str(), LuaMemKiB);
+		for (cPluginLua::cHookStatsMap::const_iterator itrS = Stats.begin(), endS = Stats.end(); itrS != endS; ++itrS)
+		{
+			const cPluginLua::sHookStats & HS = itrS->second;
+			a_Output.Out("  %-28s calls: %8d, total: %10.3f ms, avg: %8.3f ms, max: %8.3f ms, mem: %6d KiB (max %d KiB), aborted: %d",
+				cPluginLua::GetHookFnName(itrS->first), HS.m_NumCalls,
+				(double)HS.m_TotalTimeUSec / 1000,
+				(HS.m_NumCalls > 0) ? (double)HS.m_TotalTimeUSec / 1000 / HS.m_NumCalls : 0.0,
+				(double)HS.m_MaxTimeUSec / 1000,
+				HS.m_TotalMemDeltaKiB, HS.m_MaxMemDeltaKiB, HS.m_NumAborted
+			);
+		}  // for itrS - Stats[]
+	}  // for itr - m_Plugins[]
+}
+
+
+
+
+
+AString cPluginManager::GetHookStatsHTML(void)
+{
+	AString Content;
+	for (PluginMap::const_iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+	{
+		if ((itr->second == NULL) || (itr->second->GetLanguage() != cPlugin::E_LUA))
+		{
+			continue;
+		}
+		cPluginLua * Plugin = (cPluginLua *)(itr->second);
+		cPluginLua::cHookStatsMap Stats;
+		int LuaMemKiB = 0;
+		Plugin->GetHookStats(Stats, LuaMemKiB);
+		AppendPrintf(Content, "<h4>%s</h4><p>Lua memory: %d KiB</p>", Plugin->GetName().c_str(), LuaMemKiB);
+		if (Stats.empty())
+		{
+			continue;
+		}
+		Content += "<table><tr><th>Hook</th><th>Calls</th><th>Total ms</th><th>Avg ms</th><th>Max ms</th><th>Mem KiB</th><th>Max mem KiB</th><th>Aborted</th></tr>";
+		for (cPluginLua::cHookStatsMap::const_iterator itrS = Stats.begin(), endS = Stats.end(); itrS != endS; ++itrS)
+		{
+			const cPluginLua::sHookStats & HS = itrS->second;
+			AppendPrintf(Content, "<tr><td>%s</td><td>%d</td><td>%.3f</td><td>%.3f</td><td>%.3f</td><td>%d</td><td>%d</td><td>%d</td></tr>",
+				cPluginLua::GetHookFnName(itrS->first), HS.m_NumCalls,
+				(double)HS.m_TotalTimeUSec / 1000,
+				(HS.m_NumCalls > 0) ? (double)HS.m_TotalTimeUSec / 1000 / HS.m_NumCalls : 0.0,
+				(double)HS.m_MaxTimeUSec / 1000,
+				HS.m_TotalMemDeltaKiB, HS.m_MaxMemDeltaKiB, HS.m_NumAborted
+			);
+		}  // for itrS - Stats[]
+		Content += "</table>";
+	}  // for itr - m_Plugins[]
+	return Content;
+}
+
+
+
+
+
+void cPluginManager::ResetHookStats(void)
+{
+	for (PluginMap::const_iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+	{
+		if ((itr->second != NULL) && (itr->second->GetLanguage() == cPlugin::E_LUA))
+		{
+			((cPluginLua *)(itr->second))->ResetHookStats();
+		}
+	}
+}
+
+
+
+
+
 bool cPluginManager::AddPlugin(cPlugin * a_Plugin)
 {
 	m_Plugins[a_Plugin->GetDirectory()] = a_Plugin;
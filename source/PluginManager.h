@@ -246,6 +246,15 @@ public:																	// tolua_export
 	/// Returns true if the specified hook type is within the allowed range
 	static bool IsValidHookType(int a_HookType);
 	
+	/// Writes the per-plugin, per-hook execution statistics gathered by the hook profiler to the output callback
+	void LogHookStats(cCommandOutputCallback & a_Output);
+	
+	/// Returns the per-plugin, per-hook execution statistics as a HTML table, for the webadmin
+	AString GetHookStatsHTML(void);
+	
+	/// Clears the hook profiler statistics of all plugins
+	void ResetHookStats(void);
+	
 private:
 	friend class cRoot;
 	
@@ -267,6 +276,9 @@ private:
 	CommandMap m_ConsoleCommands;
 
 	bool m_bReloadPlugins;
+	
+	/// Max number of Lua instructions a single hook invocation may execute, passed to each loaded plugin; 0 = unlimited
+	int m_HookInstructionLimit;
 
 	cPluginManager();
 	~cPluginManager();
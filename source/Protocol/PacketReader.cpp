@@ -0,0 +1,226 @@
+
+// PacketReader.cpp
+
+// Implements the cPacketReader class representing a read-only view into contiguous packet data
+
+#include "Globals.h"
+
+#include "PacketReader.h"
+#include "../Endianness.h"
+
+
+
+
+
+// If a string sent over the protocol is larger than this, a warning is emitted to the console
+#define MAX_STRING_SIZE (512 KiB)
+
+#define NEEDBYTES(Num) if (!NeedBytes(Num)) return false;  // Check if at least Num bytes can be read from the span, return false if not
+
+
+
+
+
+bool cPacketReader::ReadChar(char & a_Value)
+{
+	NEEDBYTES(1);
+	a_Value = m_Data[m_ReadPos];
+	m_ReadPos += 1;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadByte(unsigned char & a_Value)
+{
+	NEEDBYTES(1);
+	a_Value = (unsigned char)m_Data[m_ReadPos];
+	m_ReadPos += 1;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadBEShort(short & a_Value)
+{
+	NEEDBYTES(2);
+	const unsigned char * Src = (const unsigned char *)(m_Data + m_ReadPos);
+	a_Value = (short)((Src[0] << 8) | Src[1]);
+	m_ReadPos += 2;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadBEInt(int & a_Value)
+{
+	NEEDBYTES(4);
+	const unsigned char * Src = (const unsigned char *)(m_Data + m_ReadPos);
+	a_Value = (int)(((UInt32)Src[0] << 24) | ((UInt32)Src[1] << 16) | ((UInt32)Src[2] << 8) | (UInt32)Src[3]);
+	m_ReadPos += 4;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadBEInt64(Int64 & a_Value)
+{
+	NEEDBYTES(8);
+	Int64 Value;
+	memcpy(&Value, m_Data + m_ReadPos, 8);
+	a_Value = NetworkToHostLong8(&Value);
+	m_ReadPos += 8;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadBEFloat(float & a_Value)
+{
+	NEEDBYTES(4);
+	a_Value = NetworkToHostFloat4(m_Data + m_ReadPos);
+	m_ReadPos += 4;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadBEDouble(double & a_Value)
+{
+	NEEDBYTES(8);
+	a_Value = NetworkToHostDouble8(m_Data + m_ReadPos);
+	m_ReadPos += 8;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadBool(bool & a_Value)
+{
+	NEEDBYTES(1);
+	a_Value = (m_Data[m_ReadPos] != 0);
+	m_ReadPos += 1;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadVarInt(UInt32 & a_Value)
+{
+	// Decode into a local position first, so that a partial VarInt doesn't move the read position:
+	UInt32 Value = 0;
+	int Shift = 0;
+	int Pos = m_ReadPos;
+	unsigned char b = 0;
+	do
+	{
+		if (Pos >= m_Size)
+		{
+			m_HasOverrun = true;
+			return false;
+		}
+		b = (unsigned char)m_Data[Pos++];
+		Value = Value | (((Int64)(b & 0x7f)) << Shift);
+		Shift += 7;
+	} while ((b & 0x80) != 0);
+	m_ReadPos = Pos;
+	a_Value = Value;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadVarUTF8String(AString & a_Value)
+{
+	UInt32 Size = 0;
+	if (!ReadVarInt(Size))
+	{
+		return false;
+	}
+	if (Size > MAX_STRING_SIZE)
+	{
+		LOGWARNING("%s: String too large: %u (%u KiB)", __FUNCTION__, Size, Size / 1024);
+	}
+	return ReadString(a_Value, (int)Size);
+}
+
+
+
+
+
+bool cPacketReader::ReadBuf(void * a_Buffer, int a_Count)
+{
+	ASSERT(a_Count >= 0);
+	NEEDBYTES(a_Count);
+	memcpy(a_Buffer, m_Data + m_ReadPos, a_Count);
+	m_ReadPos += a_Count;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadString(AString & a_String, int a_Count)
+{
+	ASSERT(a_Count >= 0);
+	NEEDBYTES(a_Count);
+	a_String.assign(m_Data + m_ReadPos, a_Count);
+	m_ReadPos += a_Count;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::SkipRead(int a_Count)
+{
+	ASSERT(a_Count >= 0);
+	NEEDBYTES(a_Count);
+	m_ReadPos += a_Count;
+	return true;
+}
+
+
+
+
+
+bool cPacketReader::ReadPacket(cPacketReader & a_Packet)
+{
+	// An incomplete packet is the normal case here, so don't flag it as an overrun:
+	int Start = m_ReadPos;
+	bool HadOverrun = m_HasOverrun;
+	UInt32 PacketLen;
+	if (!ReadVarInt(PacketLen) || !CanReadBytes((int)PacketLen))
+	{
+		m_ReadPos = Start;
+		m_HasOverrun = HadOverrun;
+		return false;
+	}
+	a_Packet = cPacketReader(m_Data + m_ReadPos, (int)PacketLen);
+	m_ReadPos += (int)PacketLen;
+	return true;
+}
+
+
+
+
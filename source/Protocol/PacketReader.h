@@ -0,0 +1,123 @@
+
+// PacketReader.h
+
+// Interfaces to the cPacketReader class representing a read-only view into contiguous packet data
+
+
+
+
+
+#pragma once
+
+
+
+
+
+/** A lightweight reader over a contiguous span of bytes, used for parsing complete incoming packets.
+The reader doesn't own the data, it only references it; the data must stay valid while the reader is used.
+The ReadXXX functions mirror those of cByteBuffer so that packet handlers can be written against either;
+since the whole packet is in contiguous memory, each read is a single bounds check and (at most) one memcpy.
+Reading past the end of the span fails and sets the overrun flag, which can be checked using HasOverrun().
+*/
+class cPacketReader
+{
+public:
+	/// Creates an empty reader; any read will fail
+	cPacketReader(void) :
+		m_Data(NULL),
+		m_Size(0),
+		m_ReadPos(0),
+		m_HasOverrun(false)
+	{
+	}
+
+	/// Creates a reader spanning the specified memory
+	cPacketReader(const char * a_Data, int a_Size) :
+		m_Data(a_Data),
+		m_Size(a_Size),
+		m_ReadPos(0),
+		m_HasOverrun(false)
+	{
+		ASSERT(a_Size >= 0);
+	}
+
+	/// Returns the number of bytes that are still available for reading
+	int GetReadableSpace(void) const { return m_Size - m_ReadPos; }
+
+	/// Returns the number of bytes that have been read so far
+	int GetReadPos(void) const { return m_ReadPos; }
+
+	/// Returns the pointer to the next byte to be read
+	const char * GetReadPtr(void) const { return m_Data + m_ReadPos; }
+
+	/// Returns true if the specified amount of bytes are available for reading
+	bool CanReadBytes(int a_Count) const { return (a_Count >= 0) && (m_Size - m_ReadPos >= a_Count); }
+
+	/// Returns true if any of the reads so far has failed due to the span being too short
+	bool HasOverrun(void) const { return m_HasOverrun; }
+
+	// Read the specified datatype and advance the read pointer; return true if successfully read:
+	bool ReadChar         (char & a_Value);
+	bool ReadByte         (unsigned char & a_Value);
+	bool ReadBEShort      (short & a_Value);
+	bool ReadBEInt        (int & a_Value);
+	bool ReadBEInt64      (Int64 & a_Value);
+	bool ReadBEFloat      (float & a_Value);
+	bool ReadBEDouble     (double & a_Value);
+	bool ReadBool         (bool & a_Value);
+	bool ReadVarInt       (UInt32 & a_Value);
+	bool ReadVarUTF8String(AString & a_Value);  // string length as VarInt, then string as UTF-8
+
+	/// Reads VarInt, assigns it to anything that can be assigned from an UInt32 (unsigned short, char, Byte, double, ...)
+	template <typename T> bool ReadVarInt(T & a_Value)
+	{
+		UInt32 v;
+		bool res = ReadVarInt(v);
+		if (res)
+		{
+			a_Value = v;
+		}
+		return res;
+	}
+
+	/// Reads a_Count bytes into a_Buffer; returns true if successful
+	bool ReadBuf(void * a_Buffer, int a_Count);
+
+	/// Reads a_Count bytes into a_String; returns true if successful
+	bool ReadString(AString & a_String, int a_Count);
+
+	/// Skips reading by a_Count bytes; returns false if not enough bytes in the span
+	bool SkipRead(int a_Count);
+
+	/** Splits one length-prefixed packet off the front of the remaining data.
+	If a complete packet is available, sets a_Packet to span the packet (type VarInt and body, without the length),
+	advances past it and returns true. Otherwise returns false and doesn't move the read position,
+	so that the caller can keep the remaining bytes until more data arrives.
+	*/
+	bool ReadPacket(cPacketReader & a_Packet);
+
+	// Provided so that handlers written for cByteBuffer can use this class unchanged; there's nothing to commit or check:
+	void CommitRead(void) {}
+	void CheckValid(void) const {}
+
+protected:
+	const char * m_Data;
+	int m_Size;
+	int m_ReadPos;
+	bool m_HasOverrun;
+
+	/// Returns true if a_Count bytes can be read; otherwise sets the overrun flag and returns false
+	bool NeedBytes(int a_Count)
+	{
+		if (CanReadBytes(a_Count))
+		{
+			return true;
+		}
+		m_HasOverrun = true;
+		return false;
+	}
+} ;
+
+
+
+
@@ -41,7 +41,8 @@ class cProtocol
 {
 public:
 	cProtocol(cClientHandle * a_Client) :
-		m_Client(a_Client)
+		m_Client(a_Client),
+		m_CSPacket("Protocol packet")
 	{
 	}
 	virtual ~cProtocol() {}
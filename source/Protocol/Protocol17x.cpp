@@ -28,9 +28,16 @@ Implements the 1.7.x protocol classes:
 
 
 
+/// If more than this many bytes are received without forming a complete packet, the client is kicked
+#define MAX_RECEIVED_DATA_SIZE (32 KiB)
+
+
+
+
+
 #define HANDLE_READ(Proc, Type, Var) \
 	Type Var; \
-	m_ReceivedData.Proc(Var);
+	m_PacketData.Proc(Var);
 
 
 
@@ -39,12 +46,12 @@ Implements the 1.7.x protocol classes:
 #define HANDLE_PACKET_READ(Proc, Type, Var) \
 	Type Var; \
 	{ \
-		if (!m_ReceivedData.Proc(Var)) \
+		if (!m_PacketData.Proc(Var)) \
 		{ \
-			m_ReceivedData.CheckValid(); \
+			m_PacketData.CheckValid(); \
 			return false; \
 		} \
-		m_ReceivedData.CheckValid(); \
+		m_PacketData.CheckValid(); \
 	}
 
 
@@ -56,7 +63,6 @@ cProtocol172::cProtocol172(cClientHandle * a_Client, const AString & a_ServerAdd
 	m_ServerAddress(a_ServerAddress),
 	m_ServerPort(a_ServerPort),
 	m_State(a_State),
-	m_ReceivedData(32 KiB),
 	m_OutPacketBuffer(64 KiB),
 	m_OutPacketLenBuffer(20),  // 20 bytes is more than enough for one VarInt
 	m_IsEncrypted(false)
@@ -69,22 +75,31 @@ cProtocol172::cProtocol172(cClientHandle * a_Client, const AString & a_ServerAdd
 
 void cProtocol172::DataReceived(const char * a_Data, int a_Size)
 {
+	if (a_Size <= 0)
+	{
+		return;
+	}
+	
 	if (m_IsEncrypted)
 	{
-		byte Decrypted[512];
-		while (a_Size > 0)
-		{
-			int NumBytes = (a_Size > sizeof(Decrypted)) ? sizeof(Decrypted) : a_Size;
-			m_Decryptor.ProcessData(Decrypted, (byte *)a_Data, NumBytes);
-			AddReceivedData((const char *)Decrypted, NumBytes);
-			a_Size -= NumBytes;
-			a_Data += NumBytes;
-		}
+		// Queue the data and decrypt it in place, all in a single call:
+		size_t Start = m_ReceivedData.size();
+		m_ReceivedData.append(a_Data, a_Size);
+		byte * Data = (byte *)&m_ReceivedData[Start];
+		m_Decryptor.ProcessData(Data, Data, a_Size);
+	}
+	else if (m_ReceivedData.empty())
+	{
+		// Nothing is queued, parse the packets directly from the incoming data and only queue the incomplete rest:
+		int NumParsed = ParsePackets(a_Data, a_Size);
+		m_ReceivedData.assign(a_Data + NumParsed, a_Size - NumParsed);
+		return;
 	}
 	else
 	{
-		AddReceivedData(a_Data, a_Size);
+		m_ReceivedData.append(a_Data, a_Size);
 	}
+	ParseReceivedData();
 }
 
 
@@ -908,57 +923,55 @@ void cProtocol172::SendWindowProperty(const cWindow & a_Window, short a_Property
 
 
 
-void cProtocol172::AddReceivedData(const char * a_Data, int a_Size)
+void cProtocol172::ParseReceivedData(void)
 {
-	if (!m_ReceivedData.Write(a_Data, a_Size))
+	int NumParsed = ParsePackets(m_ReceivedData.data(), (int)m_ReceivedData.size());
+	m_ReceivedData.erase(0, NumParsed);
+	
+	if (m_ReceivedData.size() > MAX_RECEIVED_DATA_SIZE)
 	{
 		// Too much data in the incoming queue, report to caller:
+		m_ReceivedData.clear();
 		m_Client->PacketBufferFull();
-		return;
 	}
-	
+}
+
+
+
+
+
+int cProtocol172::ParsePackets(const char * a_Data, int a_Size)
+{
 	// Handle all complete packets:
-	while (true)
+	cPacketReader Data(a_Data, a_Size);
+	while (Data.ReadPacket(m_PacketData))
 	{
-		UInt32 PacketLen;
-		if (!m_ReceivedData.ReadVarInt(PacketLen))
-		{
-			// Not enough data
-			return;
-		}
-		if (!m_ReceivedData.CanReadBytes(PacketLen))
-		{
-			// The full packet hasn't been received yet
-			return;
-		}
 		UInt32 PacketType;
-		UInt32 Mark1 = m_ReceivedData.GetReadableSpace();
-		if (!m_ReceivedData.ReadVarInt(PacketType))
+		if (!m_PacketData.ReadVarInt(PacketType))
 		{
-			// Not enough data
-			return;
+			// Zero-length packet, there's not even the packet type
+			m_Client->PacketError(0);
+			continue;
 		}
-
-		UInt32 NumBytesRead = Mark1 - m_ReceivedData.GetReadableSpace();
-		HandlePacket(PacketType, PacketLen - NumBytesRead);
 		
-		if (Mark1 - m_ReceivedData.GetReadableSpace() > PacketLen)
+		HandlePacket(PacketType, m_PacketData.GetReadableSpace());
+		
+		if (m_PacketData.HasOverrun())
 		{
-			// Read more than packet length, report as error
+			// Tried reading more than packet length, report as error
 			m_Client->PacketError(PacketType);
 		}
-
-		// Go to packet end in any case:
-		m_ReceivedData.ResetRead();
-		m_ReceivedData.ReadVarInt(PacketType);
-		m_ReceivedData.SkipRead(PacketLen);
-		m_ReceivedData.CommitRead();
-	}  // while (true)
+	}
+	
+	// The data span will not be valid after returning, don't let anyone read from it:
+	m_PacketData = cPacketReader();
+	return Data.GetReadPos();
 }
 
 
 
 
+
 void cProtocol172::HandlePacket(UInt32 a_PacketType, UInt32 a_RemainingBytes)
 {
 	switch (m_State)
@@ -1020,8 +1033,8 @@ void cProtocol172::HandlePacket(UInt32 a_PacketType, UInt32 a_RemainingBytes)
 	
 	// Unknown packet type, report to the client:
 	m_Client->PacketUnknown(a_PacketType);
-	m_ReceivedData.SkipRead(a_RemainingBytes);
-	m_ReceivedData.CommitRead();
+	m_PacketData.SkipRead(a_RemainingBytes);
+	m_PacketData.CommitRead();
 }
 
 
@@ -1034,13 +1047,13 @@ void cProtocol172::HandlePacketStatusPing(UInt32 a_RemainingBytes)
 	if (a_RemainingBytes != 8)
 	{
 		m_Client->PacketError(0x01);
-		m_ReceivedData.SkipRead(a_RemainingBytes);
-		m_ReceivedData.CommitRead();
+		m_PacketData.SkipRead(a_RemainingBytes);
+		m_PacketData.CommitRead();
 		return;
 	}
 	Int64 Timestamp;
-	m_ReceivedData.ReadBEInt64(Timestamp);
-	m_ReceivedData.CommitRead();
+	m_PacketData.ReadBEInt64(Timestamp);
+	m_PacketData.CommitRead();
 	
 	cPacketizer Pkt(*this, 0x01);  // Ping packet
 	Pkt.WriteInt64(Timestamp);
@@ -1054,7 +1067,7 @@ void cProtocol172::HandlePacketStatusRequest(UInt32 a_RemainingBytes)
 {
 	// No more bytes in this packet
 	ASSERT(a_RemainingBytes == 0);
-	m_ReceivedData.CommitRead();
+	m_PacketData.CommitRead();
 	
 	// Send the response:
 	AString Response = "{\"version\":{\"name\":\"1.7.2\",\"protocol\":4},\"players\":{";
@@ -1087,7 +1100,7 @@ void cProtocol172::HandlePacketLoginEncryptionResponse(UInt32 a_RemainingBytes)
 void cProtocol172::HandlePacketLoginStart(UInt32 a_RemainingBytes)
 {
 	AString Username;
-	m_ReceivedData.ReadVarUTF8String(Username);
+	m_PacketData.ReadVarUTF8String(Username);
 	
 	// TODO: Protocol encryption should be set up here if not localhost / auth
 	
@@ -1308,7 +1321,7 @@ void cProtocol172::HandlePacketPluginMessage(UInt32 a_RemainingBytes)
 	HANDLE_READ(ReadVarUTF8String, AString, Channel);
 	HANDLE_READ(ReadBEShort,       short,   Length);
 	AString Data;
-	m_ReceivedData.ReadString(Data, Length);
+	m_PacketData.ReadString(Data, Length);
 	// TODO: m_Client->HandlePluginMessage(Channel, Data);
 }
 
@@ -1506,7 +1519,7 @@ bool cProtocol172::ReadItem(cItem & a_Item)
 	
 	// Read the metadata
 	AString Metadata;
-	if (!m_ReceivedData.ReadString(Metadata, MetadataLength))
+	if (!m_PacketData.ReadString(Metadata, MetadataLength))
 	{
 		return false;
 	}
@@ -16,6 +16,7 @@ Declares the 1.7.x protocol classes:
 
 #include "Protocol.h"
 #include "../ByteBuffer.h"
+#include "PacketReader.h"
 #include "../../CryptoPP/modes.h"
 #include "../../CryptoPP/aes.h"
 
@@ -186,8 +187,11 @@ protected:
 	/// State of the protocol. 1 = status, 2 = login, 3 = game
 	UInt32 m_State;
 
-	/// Buffer for the received data
-	cByteBuffer m_ReceivedData;
+	/// Received data (already decrypted) that doesn't form a complete packet yet, kept in contiguous memory
+	AString m_ReceivedData;
+	
+	/// The packet currently being handled; the packet handlers read their data from here
+	cPacketReader m_PacketData;
 	
 	/// Buffer for composing the outgoing packets, through cPacketizer
 	cByteBuffer m_OutPacketBuffer;
@@ -200,8 +204,11 @@ protected:
 	CryptoPP::CFB_Mode<CryptoPP::AES>::Encryption m_Encryptor;
 	
 	
-	/// Adds the received (unencrypted) data to m_ReceivedData, parses complete packets
-	void AddReceivedData(const char * a_Data, int a_Size);
+	/// Parses and handles all complete packets in m_ReceivedData, removes them from the buffer
+	void ParseReceivedData(void);
+	
+	/// Parses and handles all complete packets in the specified data. Returns the number of bytes consumed.
+	int ParsePackets(const char * a_Data, int a_Size);
 	
 	/// Reads and handles the packet. The packet length and type have already been read.
 	void HandlePacket(UInt32 a_PacketType, UInt32 a_RemainingBytes);
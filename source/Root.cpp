@@ -151,6 +151,9 @@ void cRoot::Start(void)
 		m_CraftingRecipes = new cCraftingRecipes;
 		m_FurnaceRecipe   = new cFurnaceRecipe();
 		
+		LOGD("Starting player saver...");
+		m_PlayerSaver.Start();
+		
 		LOGD("Loading worlds...");
 		LoadWorlds(IniFile);
 
@@ -222,6 +225,9 @@ void cRoot::Start(void)
 		LOGD("Unloading worlds...");
 		UnloadWorlds();
 		
+		LOGD("Stopping player saver...");
+		m_PlayerSaver.Stop();
+		
 		LOGD("Stopping plugin manager...");
 		delete m_PluginManager; m_PluginManager = NULL;
 
@@ -715,7 +721,8 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.Out("  Num chunks in generator queue: %d", NumInGenerator);
 		a_Output.Out("  Num chunks in storage load queue: %d", NumInLoadQueue);
 		a_Output.Out("  Num chunks in storage save queue: %d", NumInSaveQueue);
-		int Mem = NumValid * sizeof(cChunk);
+		const int ChunkSize = sizeof(cChunk) + sizeof(cChunkBuffer);  // The block data is in a separate buffer
+		int Mem = NumValid * ChunkSize;
 		a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (Mem + 1023) / 1024, (Mem + 1024 * 1024 - 1) / (1024 * 1024));
 		a_Output.Out("  Per-chunk memory size breakdown:");
 		a_Output.Out("    block types:    %6d bytes (%3d KiB)", sizeof(cChunkDef::BlockTypes), (sizeof(cChunkDef::BlockTypes) + 1023) / 1024);
@@ -723,8 +730,23 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.Out("    block lighting: %6d bytes (%3d KiB)", 2 * sizeof(cChunkDef::BlockNibbles), (2 * sizeof(cChunkDef::BlockNibbles) + 1023) / 1024);
 		a_Output.Out("    heightmap:      %6d bytes (%3d KiB)", sizeof(cChunkDef::HeightMap), (sizeof(cChunkDef::HeightMap) + 1023) / 1024);
 		a_Output.Out("    biomemap:       %6d bytes (%3d KiB)", sizeof(cChunkDef::BiomeMap), (sizeof(cChunkDef::BiomeMap) + 1023) / 1024);
-		int Rest = sizeof(cChunk) - sizeof(cChunkDef::BlockTypes) - 3 * sizeof(cChunkDef::BlockNibbles) - sizeof(cChunkDef::HeightMap) - sizeof(cChunkDef::BiomeMap);
+		int Rest = ChunkSize - sizeof(cChunkDef::BlockTypes) - 3 * sizeof(cChunkDef::BlockNibbles) - sizeof(cChunkDef::HeightMap) - sizeof(cChunkDef::BiomeMap);
 		a_Output.Out("    other:          %6d bytes (%3d KiB)", Rest, (Rest + 1023) / 1024);
+		int NumPooled = 0, PoolSize = 0, NumAllocations = 0, NumReuses = 0, NumReleases = 0;
+		World->GetChunkMap()->GetChunkPoolStats(NumPooled, PoolSize, NumAllocations, NumReuses, NumReleases);
+		int PoolMem = NumPooled * ChunkSize;
+		a_Output.Out("  Chunk pool: %d / %d chunks, %d KiB (%d MiB)", NumPooled, PoolSize, (PoolMem + 1023) / 1024, (PoolMem + 1024 * 1024 - 1) / (1024 * 1024));
+		a_Output.Out("  Chunk pool allocations: %d, reuses: %d, releases: %d", NumAllocations, NumReuses, NumReleases);
+		int NumCached = 0, CacheSize = 0, CacheMaxSize = 0, NumLookups = 0, NumHits = 0, NumEvictions = 0;
+		World->GetStorage().GetWarmCache().GetStats(NumCached, CacheSize, CacheMaxSize, NumLookups, NumHits, NumEvictions);
+		a_Output.Out("  Warm chunk cache: %d chunks, %d / %d KiB", NumCached, (CacheSize + 1023) / 1024, (CacheMaxSize + 1023) / 1024);
+		a_Output.Out("  Warm chunk cache lookups: %d, hits: %d (%d %%), evictions: %d",
+			NumLookups, NumHits, (NumLookups > 0) ? (100 * NumHits / NumLookups) : 0, NumEvictions
+		);
+		int NumActiveBlockEntities = 0, NumSleepingBlockEntities = 0, NumActiveHoppers = 0, NumSleepingHoppers = 0;
+		World->GetBlockEntityStats(NumActiveBlockEntities, NumSleepingBlockEntities, NumActiveHoppers, NumSleepingHoppers);
+		a_Output.Out("  Block entities: %d active, %d sleeping", NumActiveBlockEntities, NumSleepingBlockEntities);
+		a_Output.Out("  Hoppers: %d active, %d sleeping", NumActiveHoppers, NumSleepingHoppers);
 		SumNumValid += NumValid;
 		SumNumDirty += NumDirty;
 		SumNumInLighting += NumInLighting;
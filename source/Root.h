@@ -2,6 +2,7 @@
 #pragma once
 
 #include "Authenticator.h"
+#include "PlayerSaver.h"
 #include "HTTPServer/HTTPServer.h"
 
 
@@ -60,6 +61,7 @@ public:
 	cWebAdmin *        GetWebAdmin       (void) { return m_WebAdmin; }         // tolua_export
 	cPluginManager *   GetPluginManager  (void) { return m_PluginManager; }    // tolua_export
 	cAuthenticator &   GetAuthenticator  (void) { return m_Authenticator; }
+	cPlayerSaver &     GetPlayerSaver    (void) { return m_PlayerSaver; }
 
 	/** Queues a console command for execution through the cServer class.
 	The command will be executed in the tick thread
@@ -152,6 +154,7 @@ private:
 	cWebAdmin *        m_WebAdmin;
 	cPluginManager *   m_PluginManager;
 	cAuthenticator     m_Authenticator;
+	cPlayerSaver       m_PlayerSaver;
 	cHTTPServer        m_HTTPServer;
 
 	cMCLogger *      m_Log;
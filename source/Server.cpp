@@ -105,6 +105,7 @@ void cServer::cTickThread::Execute(void)
 cServer::cServer(void) :
 	m_ListenThreadIPv4(*this, cSocket::IPv4, "Client IPv4"),
 	m_ListenThreadIPv6(*this, cSocket::IPv6, "Client IPv6"),
+	m_CSClients("Server clients"),
 	m_bIsConnected(false),
 	m_bRestarting(false),
 	m_RCONServer(*this),
@@ -266,6 +267,8 @@ bool cServer::InitServer(cIniFile & a_SettingsIni)
 		LOGINFO("Setting default viewdistance to the maximum of %d", m_ClientViewDistance);
 	}
 	
+	m_LoadGovernor.Init(a_SettingsIni);
+	
 	m_NotifyWriteThread.Start(this);
 	
 	PrepareKeys();
@@ -362,6 +365,8 @@ bool cServer::Tick(float a_Dt)
 	
 	// Tick all clients not yet assigned to a world:
 	TickClients(a_Dt);
+	
+	m_LoadGovernor.Tick(a_Dt);
 
 	if (!m_bRestarting)
 	{
@@ -481,6 +486,59 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		a_Output.Finished();
 		return;
 	}
+	if (split[0].compare("storagebench") == 0)
+	{
+		cWorld * World = (split.size() > 1) ? cRoot::Get()->GetWorld(split[1]) : cRoot::Get()->GetDefaultWorld();
+		int Size = (split.size() > 2) ? atoi(split[2].c_str()) : 16;
+		int Repeats = (split.size() > 3) ? atoi(split[3].c_str()) : 3;
+		if (World == NULL)
+		{
+			a_Output.Out(Printf("No such world: \"%s\"", split[1].c_str()));
+		}
+		else if ((Size < 1) || (Size > 64) || (Repeats < 1))
+		{
+			a_Output.Out("The size must be between 1 and 64 chunks and the number of repeats at least 1");
+		}
+		else
+		{
+			World->GetStorage().QueueBenchmark(Size, Repeats);
+			a_Output.Out(Printf("The storage benchmark has been queued in world %s, the results will be logged", World->GetName().c_str()));
+		}
+		a_Output.Finished();
+		return;
+	}
+	if (split[0].compare("locks") == 0)
+	{
+		if ((split.size() > 1) && (split[1] == "reset"))
+		{
+			cCriticalSection::ResetProfiling();
+			a_Output.Out("Lock statistics have been reset.");
+		}
+		else
+		{
+			AStringVector Report = cCriticalSection::GetProfilingReport();
+			for (AStringVector::const_iterator itr = Report.begin(), end = Report.end(); itr != end; ++itr)
+			{
+				a_Output.Out("%s", itr->c_str());
+			}
+		}
+		a_Output.Finished();
+		return;
+	}
+	if (split[0].compare("pluginstats") == 0)
+	{
+		if ((split.size() > 1) && (split[1] == "reset"))
+		{
+			cPluginManager::Get()->ResetHookStats();
+			a_Output.Out("Plugin hook statistics have been reset.");
+		}
+		else
+		{
+			cPluginManager::Get()->LogHookStats(a_Output);
+		}
+		a_Output.Finished();
+		return;
+	}
 	#if defined(_MSC_VER) && defined(_DEBUG) && defined(ENABLE_LEAK_FINDER)
 	if (split[0].compare("dumpmem") == 0)
 	{
@@ -561,6 +619,9 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("restart", NULL, " - Restarts the server cleanly");
 	PlgMgr->BindConsoleCommand("stop", NULL, " - Stops the server cleanly");
 	PlgMgr->BindConsoleCommand("chunkstats", NULL, " - Displays detailed chunk memory statistics");
+	PlgMgr->BindConsoleCommand("storagebench", NULL, " - Measures chunk loading and saving in each storage schema; \"storagebench [world] [size] [repeats]\". Uses synthetic chunks and a scratch folder, the world's files are not touched");
+	PlgMgr->BindConsoleCommand("locks", NULL, " - Displays the lock contention statistics (needs a LOCK_PROFILING build); \"locks reset\" clears them");
+	PlgMgr->BindConsoleCommand("pluginstats", NULL, " - Displays execution time and memory statistics of plugin hooks; \"pluginstats reset\" clears them");
 	#if defined(_MSC_VER) && defined(_DEBUG) && defined(ENABLE_LEAK_FINDER)
 	PlgMgr->BindConsoleCommand("dumpmem", NULL, " - Dumps all used memory blocks together with their callstacks into memdump.xml");
 	#endif
@@ -14,6 +14,8 @@
 #include "CryptoPP/rsa.h"
 #include "CryptoPP/randpool.h"
 #include "RCONServer.h"
+#include "LoadGovernor.h"
+#include "Metrics.h"
 
 
 
@@ -93,6 +95,12 @@ public:												// tolua_export
 	CryptoPP::RSA::PrivateKey & GetPrivateKey(void) { return m_PrivateKey; }
 	CryptoPP::RSA::PublicKey  & GetPublicKey (void) { return m_PublicKey; }
 	
+	/// Returns the governor that limits the clients' view distance while the server is overloaded
+	cLoadGovernor & GetLoadGovernor(void) { return m_LoadGovernor; }
+	
+	/// Returns the collector of the server internals, served by the webadmin's "/metrics" page
+	cMetrics & GetMetrics(void) { return m_Metrics; }
+	
 private:
 
 	friend class cRoot; // so cRoot can create and destroy cServer
@@ -165,6 +173,10 @@ private:
 	
 	cRCONServer m_RCONServer;
 	
+	cLoadGovernor m_LoadGovernor;
+	
+	cMetrics m_Metrics;
+	
 	AString m_Description;
 	int m_MaxPlayers;
 	bool m_bIsHardcore;
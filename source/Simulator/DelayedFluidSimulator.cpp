@@ -44,7 +44,8 @@ bool cDelayedFluidSimulatorChunkData::cSlot::Add(int a_RelX, int a_RelY, int a_R
 // cDelayedFluidSimulatorChunkData:
 
 cDelayedFluidSimulatorChunkData::cDelayedFluidSimulatorChunkData(int a_TickDelay) :
-	m_Slots(new cSlot[a_TickDelay])
+	m_Slots(new cSlot[a_TickDelay]),
+	m_NumSlots(a_TickDelay)
 {
 }
 
@@ -62,6 +63,22 @@ cDelayedFluidSimulatorChunkData::~cDelayedFluidSimulatorChunkData()
 
 
 
+void cDelayedFluidSimulatorChunkData::Clear(void)
+{
+	// Only clear the vectors, their capacity is kept for the next chunk:
+	for (int i = 0; i < m_NumSlots; i++)
+	{
+		for (size_t z = 0; z < ARRAYCOUNT(m_Slots[i].m_Blocks); z++)
+		{
+			m_Slots[i].m_Blocks[z].clear();
+		}
+	}
+}
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cDelayedFluidSimulator:
 
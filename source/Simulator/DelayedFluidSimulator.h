@@ -37,8 +37,14 @@ public:
 	cDelayedFluidSimulatorChunkData(int a_TickDelay);
 	virtual ~cDelayedFluidSimulatorChunkData();
 	
+	// cFluidSimulatorData overrides:
+	virtual void Clear(void) override;
+	
 	/// Slots, one for each delay tick, each containing the blocks to simulate
 	cSlot * m_Slots;
+	
+	/// Number of items in m_Slots[]
+	int m_NumSlots;
 } ;
 
 
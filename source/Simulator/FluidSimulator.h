@@ -29,6 +29,9 @@ class cFluidSimulatorData
 {
 public:
 	virtual ~cFluidSimulatorData() {}
+	
+	/// Removes all the data, so that the object can be reused for another chunk
+	virtual void Clear(void) {}
 } ;
 
 
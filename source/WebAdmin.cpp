@@ -14,6 +14,7 @@
 
 #include "HTTPServer/HTTPMessage.h"
 #include "HTTPServer/HTTPConnection.h"
+#include "StringCompression.h"
 
 
 
@@ -42,7 +43,12 @@ public:
 
 cWebAdmin::cWebAdmin(void) :
 	m_IsInitialized(false),
-	m_TemplateScript("<webadmin_template>")
+	m_TemplateScript("<webadmin_template>"),
+	m_ShouldCompress(true),
+	m_FileCacheTTL(5000),
+	m_PageCacheTTL(1000),
+	m_IsMetricsEnabled(true),
+	m_DoesMetricsNeedAuth(true)
 {
 }
 
@@ -102,6 +108,12 @@ bool cWebAdmin::Init(void)
 
 	AString PortsIPv4 = m_IniFile.GetValueSet("WebAdmin", "Port", "8080");
 	AString PortsIPv6 = m_IniFile.GetValueSet("WebAdmin", "PortsIPv6", "");
+	
+	m_ShouldCompress = m_IniFile.GetValueSetB("WebAdmin", "CompressResponses",      true);
+	m_FileCacheTTL   = m_IniFile.GetValueSetI("WebAdmin", "StaticFileCacheSeconds", 5) * 1000;
+	m_PageCacheTTL   = m_IniFile.GetValueSetI("WebAdmin", "PageCacheMilliseconds",  1000);
+	m_IsMetricsEnabled    = m_IniFile.GetValueSetB("WebAdmin", "Metrics",          true);
+	m_DoesMetricsNeedAuth = m_IniFile.GetValueSetB("WebAdmin", "MetricsNeedAuth",  true);
 
 	if (!m_HTTPServer.Initialize(PortsIPv4, PortsIPv6))
 	{
@@ -163,19 +175,31 @@ AString cWebAdmin::GetTemplate()
 
 
 
-void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
+bool cWebAdmin::CheckAuth(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
 {
 	if (!a_Request.HasAuth())
 	{
 		a_Connection.SendNeedAuth("MCServer WebAdmin");
-		return;
+		return false;
 	}
 
-	// Check auth:
 	AString UserPassword = m_IniFile.GetValue("User:" + a_Request.GetAuthUsername(), "Password", "");
 	if ((UserPassword == "") || (a_Request.GetAuthPassword() != UserPassword))
 	{
 		a_Connection.SendNeedAuth("MCServer WebAdmin - bad username or password");
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
+{
+	if (!CheckAuth(a_Connection, a_Request))
+	{
 		return;
 	}
 
@@ -224,15 +248,30 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 		}
 	}
 
+	// Pages requested without any parameters (dashboards polling) are served from the cache for a short while;
+	// requests with parameters may have side effects and are always rendered. The raw URL is checked rather than
+	// the parsed params, a query string that doesn't parse into any params mustn't be served under the bare path:
+	AString CacheKey;
+	if (
+		(m_PageCacheTTL > 0) &&
+		(a_Request.GetMethod() == "GET") &&
+		(a_Request.GetURL().find('?') == AString::npos) &&
+		TemplateRequest.Request.PostParams.empty()
+	)
+	{
+		CacheKey = a_Request.GetAuthUsername() + "\n" + URL;
+		if (SendCachedPage(a_Connection, a_Request, CacheKey))
+		{
+			return;
+		}
+	}
+
 	// Try to get the template from the Lua template script
 	if (ShouldWrapInTemplate)
 	{
 		if (m_TemplateScript.Call("ShowPage", this, &TemplateRequest, cLuaState::Return, Template))
 		{
-			cHTTPResponse Resp;
-			Resp.SetContentType("text/html");
-			a_Connection.Send(Resp);
-			a_Connection.Send(Template.c_str(), Template.length());
+			SendPage(a_Connection, a_Request, CacheKey, Template);
 			return;
 		}
 		a_Connection.SendStatusAndReason(500, "m_TemplateScript failed");
@@ -253,6 +292,7 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 			Menu += "<li><a href='" + BaseURL + WebPlugin->GetWebTitle().c_str() + "/" + (*Names).second + "'>" + (*Names).first + "</a></li>";
 		}
 	}
+	Menu += "<li>Server</li><li><a href='" + BaseURL + "Server/PluginStats'>Plugin statistics</a></li>";
 
 	sWebAdminPage Page = GetPage(TemplateRequest.Request);
 	AString Content = Page.Content;
@@ -293,10 +333,7 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 	Printf(NumChunks, "%d", cRoot::Get()->GetTotalChunkCount());
 	ReplaceString(Template, "{NUMCHUNKS}", NumChunks);
 
-	cHTTPResponse Resp;
-	Resp.SetContentType("text/html");
-	a_Connection.Send(Resp);
-	a_Connection.Send(Template.c_str(), Template.length());
+	SendPage(a_Connection, a_Request, CacheKey, Template);
 }
 
 
@@ -323,6 +360,248 @@ void cWebAdmin::HandleRootRequest(cHTTPConnection & a_Connection, cHTTPRequest &
 
 
 
+void cWebAdmin::HandleMetricsRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
+{
+	if (m_DoesMetricsNeedAuth && !CheckAuth(a_Connection, a_Request))
+	{
+		return;
+	}
+	
+	// The metrics are formatted from the published snapshots only, no world is locked here:
+	sCachedContent Content;
+	Content.m_ContentType = "text/plain; version=0.0.4";
+	Content.m_Data = cRoot::Get()->GetServer()->GetMetrics().GetPrometheusText();
+	Content.m_Timestamp = m_Timer.GetNowTime();
+	PrepareContent(Content, false);
+	SendContent(a_Connection, a_Request, Content);
+}
+
+
+
+
+
+void cWebAdmin::HandleFileRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
+{
+	// Only serve files from within the webadmin/files folder:
+	AString URL = a_Request.GetBareURL();
+	if (
+		(URL.empty()) || (URL[0] != '/') ||
+		(URL.find("..") != AString::npos) ||
+		(URL.find('\\') != AString::npos)
+	)
+	{
+		a_Connection.SendStatusAndReason(cHTTPMessage::HTTP_BAD_REQUEST, "Bad Request");
+		return;
+	}
+	AString FileName = FILE_IO_PREFIX "webadmin/files" + URL;
+
+	sCachedContent Content;
+	{
+		cCSLock Lock(m_CSCache);
+		long long Now = m_Timer.GetNowTime();
+		cCachedContents::iterator itr = m_FileCache.find(FileName);
+		if ((itr == m_FileCache.end()) || (Now - itr->second.m_Timestamp > m_FileCacheTTL))
+		{
+			// Not cached or too old, (re-)read from the disk:
+			AString Data;
+			cFile f;
+			if (!cFile::IsFile(FileName) || !f.Open(FileName, cFile::fmRead) || (f.ReadRestOfFile(Data) < 0))
+			{
+				if (itr != m_FileCache.end())
+				{
+					m_FileCache.erase(itr);
+				}
+				Lock.Unlock();
+				a_Connection.SendStatusAndReason(cHTTPMessage::HTTP_NOT_FOUND, "Not Found");
+				return;
+			}
+			sCachedContent & Entry = m_FileCache[FileName];
+			size_t LastDot = FileName.rfind('.');
+			Entry.m_ContentType = GetContentTypeFromFileExt((LastDot == AString::npos) ? AString() : FileName.substr(LastDot + 1));
+			Entry.m_Data.swap(Data);
+			Entry.m_Timestamp = Now;
+			PrepareContent(Entry, true);
+			Content = Entry;
+		}
+		else
+		{
+			Content = itr->second;
+		}
+	}
+	
+	SendContent(a_Connection, a_Request, Content);
+}
+
+
+
+
+
+void cWebAdmin::PrepareContent(sCachedContent & a_Content, bool a_ShouldUseETag)
+{
+	a_Content.m_GzippedData.clear();
+	if (m_ShouldCompress && (a_Content.m_Data.size() >= 256) && IsCompressibleContentType(a_Content.m_ContentType))
+	{
+		if (CompressStringGZIP(a_Content.m_Data.data(), (int)a_Content.m_Data.size(), a_Content.m_GzippedData) != Z_OK)
+		{
+			a_Content.m_GzippedData.clear();
+		}
+	}
+	
+	a_Content.m_ETag.clear();
+	if (a_ShouldUseETag)
+	{
+		// The tag depends only on the contents, so that a re-read unchanged file keeps validating the clients' copies:
+		uLong CRC = crc32(0, (const Bytef *)a_Content.m_Data.data(), (uInt)a_Content.m_Data.size());
+		Printf(a_Content.m_ETag, "\"%08lx-%x\"", (unsigned long)CRC, (unsigned)a_Content.m_Data.size());
+	}
+}
+
+
+
+
+
+void cWebAdmin::SendContent(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const sCachedContent & a_Content)
+{
+	cHTTPResponse Resp;
+	if (!a_Content.m_ETag.empty())
+	{
+		Resp.AddHeader("ETag", a_Content.m_ETag);
+		AString IfNoneMatch = a_Request.GetHeader("If-None-Match");
+		if (!IfNoneMatch.empty() && ((IfNoneMatch.find(a_Content.m_ETag) != AString::npos) || (IfNoneMatch == "*")))
+		{
+			// The client has the current version already:
+			Resp.SetStatus(cHTTPMessage::HTTP_NOT_MODIFIED, "Not Modified");
+			a_Connection.SendWholeResponse(Resp, AString());
+			return;
+		}
+	}
+	Resp.SetContentType(a_Content.m_ContentType);
+	
+	if (!a_Content.m_GzippedData.empty())
+	{
+		Resp.AddHeader("Vary", "Accept-Encoding");
+		if (a_Request.GetHeader("Accept-Encoding").find("gzip") != AString::npos)
+		{
+			Resp.AddHeader("Content-Encoding", "gzip");
+			a_Connection.SendWholeResponse(Resp, a_Content.m_GzippedData);
+			return;
+		}
+	}
+	a_Connection.SendWholeResponse(Resp, a_Content.m_Data);
+}
+
+
+
+
+
+void cWebAdmin::SendPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_CacheKey, const AString & a_Page)
+{
+	sCachedContent Content;
+	Content.m_ContentType = "text/html";
+	Content.m_Data = a_Page;
+	Content.m_Timestamp = m_Timer.GetNowTime();
+	PrepareContent(Content, false);
+	SendContent(a_Connection, a_Request, Content);
+	
+	if (a_CacheKey.empty())
+	{
+		return;
+	}
+	cCSLock Lock(m_CSCache);
+	if (m_PageCache.size() >= 64)
+	{
+		// Drop the expired pages so that the cache doesn't grow with each visited page:
+		for (cCachedContents::iterator itr = m_PageCache.begin(); itr != m_PageCache.end();)
+		{
+			if (Content.m_Timestamp - itr->second.m_Timestamp > m_PageCacheTTL)
+			{
+				cCachedContents::iterator itr2 = itr;
+				++itr;
+				m_PageCache.erase(itr2);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+	}
+	m_PageCache[a_CacheKey] = Content;
+}
+
+
+
+
+
+bool cWebAdmin::SendCachedPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_CacheKey)
+{
+	sCachedContent Content;
+	{
+		cCSLock Lock(m_CSCache);
+		cCachedContents::const_iterator itr = m_PageCache.find(a_CacheKey);
+		if ((itr == m_PageCache.end()) || (m_Timer.GetNowTime() - itr->second.m_Timestamp > m_PageCacheTTL))
+		{
+			return false;
+		}
+		Content = itr->second;
+	}
+	SendContent(a_Connection, a_Request, Content);
+	return true;
+}
+
+
+
+
+
+AString cWebAdmin::GetContentTypeFromFileExt(const AString & a_FileExtension)
+{
+	static const struct
+	{
+		const char * m_Extension;
+		const char * m_ContentType;
+	} ContentTypes[] =
+	{
+		{ "html", "text/html" },
+		{ "htm",  "text/html" },
+		{ "css",  "text/css" },
+		{ "js",   "application/javascript" },
+		{ "json", "application/json" },
+		{ "txt",  "text/plain" },
+		{ "xml",  "text/xml" },
+		{ "svg",  "image/svg+xml" },
+		{ "png",  "image/png" },
+		{ "jpg",  "image/jpeg" },
+		{ "jpeg", "image/jpeg" },
+		{ "gif",  "image/gif" },
+		{ "ico",  "image/x-icon" },
+	} ;
+	for (size_t i = 0; i < ARRAYCOUNT(ContentTypes); i++)
+	{
+		if (NoCaseCompare(a_FileExtension, ContentTypes[i].m_Extension) == 0)
+		{
+			return ContentTypes[i].m_ContentType;
+		}
+	}
+	return "application/octet-stream";
+}
+
+
+
+
+
+bool cWebAdmin::IsCompressibleContentType(const AString & a_ContentType)
+{
+	return (
+		(strncmp(a_ContentType.c_str(), "text/", 5) == 0) ||
+		(a_ContentType == "application/javascript") ||
+		(a_ContentType == "application/json") ||
+		(a_ContentType == "image/svg+xml")
+	);
+}
+
+
+
+
+
 sWebAdminPage cWebAdmin::GetPage(const HTTPRequest & a_Request)
 {
 	sWebAdminPage Page;
@@ -347,6 +626,18 @@ sWebAdminPage cWebAdmin::GetPage(const HTTPRequest & a_Request)
 		}
 	}
 
+	// Built-in server pages, if no plugin claimed the path:
+	if (FoundPlugin.empty() && (Split.size() > 2) && (Split[1] == "Server") && (Split[2] == "PluginStats"))
+	{
+		Page.PluginName = "Server";
+		Page.TabName = "Plugin statistics";
+		Page.Content = cPluginManager::Get()->GetHookStatsHTML();
+		if (Page.Content.empty())
+		{
+			Page.Content = "<p>No Lua plugins are loaded.</p>";
+		}
+	}
+
 	// Return the page contents
 	return Page;
 }
@@ -464,7 +755,7 @@ void cWebAdmin::OnRequestBegun(cHTTPConnection & a_Connection, cHTTPRequest & a_
 		// The root needs no body handler and is fully handled in the OnRequestFinished() call
 		return;
 	}
-	// TODO: Handle other requests
+	// Other requests are for the static files, they need no body handler either
 }
 
 
@@ -500,9 +791,13 @@ void cWebAdmin::OnRequestFinished(cHTTPConnection & a_Connection, cHTTPRequest &
 		// The root needs no body handler and is fully handled in the OnRequestFinished() call
 		HandleRootRequest(a_Connection, a_Request);
 	}
+	else if (m_IsMetricsEnabled && (a_Request.GetBareURL() == "/metrics"))
+	{
+		HandleMetricsRequest(a_Connection, a_Request);
+	}
 	else
 	{
-		// TODO: Handle other requests
+		HandleFileRequest(a_Connection, a_Request);
 	}
 
 	// Delete any request data assigned to the request:
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "OSSupport/Socket.h"
+#include "OSSupport/Timer.h"
 #include "LuaState.h"
 #include "../iniFile/iniFile.h"
 #include "HTTPServer/HTTPServer.h"
@@ -172,6 +173,19 @@ protected:
 	} ;
 
 
+	/// A response body kept in memory so that it needn't be re-read or re-rendered for each request
+	struct sCachedContent
+	{
+		AString   m_ContentType;
+		AString   m_Data;
+		AString   m_GzippedData;  ///< m_Data compressed using gzip; empty if not worth compressing
+		AString   m_ETag;         ///< Entity tag for conditional requests; empty if not used for this content
+		long long m_Timestamp;    ///< m_Timer time when the content was read / rendered
+	} ;
+	
+	typedef std::map<AString, sCachedContent> cCachedContents;
+
+
 	/// Set to true if Init() succeeds and the webadmin isn't to be disabled
 	bool m_IsInitialized;
 
@@ -185,15 +199,73 @@ protected:
 
 	/// The HTTP server which provides the underlying HTTP parsing, serialization and events
 	cHTTPServer m_HTTPServer;
+	
+	/// If true, the responses are gzip-compressed for the clients that accept it
+	bool m_ShouldCompress;
+	
+	/// How long the static files are served from the memory before being re-read from the disk, in msec
+	int m_FileCacheTTL;
+	
+	/// How long a rendered page is served to further requests for it, in msec; 0 to disable
+	int m_PageCacheTTL;
+	
+	/// If true, the "/metrics" page is served
+	bool m_IsMetricsEnabled;
+	
+	/// If true, the "/metrics" page requires the same login as the webadmin
+	bool m_DoesMetricsNeedAuth;
+	
+	/// Protects m_FileCache and m_PageCache, the requests are handled in multiple socket threads
+	cCriticalSection m_CSCache;
+	
+	/// The static files, keyed by the file path
+	cCachedContents m_FileCache;
+	
+	/// The rendered webadmin pages, keyed by the username and the URL
+	cCachedContents m_PageCache;
+	
+	/// The time source for the cache entries
+	cTimer m_Timer;
 
 
 	AString GetTemplate(void);
+	
+	/// Fills in the gzipped data and the ETag (if requested) of the content, based on its m_Data
+	void PrepareContent(sCachedContent & a_Content, bool a_ShouldUseETag);
+	
+	/** Sends the content as the whole response. Uses the gzipped data if the client accepts it,
+	answers with "304 Not Modified" if the client already has the content with the same ETag
+	*/
+	void SendContent(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const sCachedContent & a_Content);
+	
+	/** Sends a rendered webadmin page and stores it in the page cache under a_CacheKey.
+	If a_CacheKey is empty, the page is not cached
+	*/
+	void SendPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_CacheKey, const AString & a_Page);
+	
+	/// Sends the page stored in the page cache under a_CacheKey, if it is still fresh. Returns true if sent
+	bool SendCachedPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_CacheKey);
+	
+	/// Handles requests for the static files in the webadmin/files folder
+	void HandleFileRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
+	
+	/// Returns the MIME type to be used for a file with the specified extension
+	static AString GetContentTypeFromFileExt(const AString & a_FileExtension);
+	
+	/// Returns true if the content of the specified MIME type is worth compressing
+	static bool IsCompressibleContentType(const AString & a_ContentType);
 
 	/// Handles requests coming to the "/webadmin" or "/~webadmin" URLs
 	void HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
 
 	/// Handles requests for the root page
 	void HandleRootRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
+	
+	/// Handles requests for the "/metrics" page, the server internals in the Prometheus text format
+	void HandleMetricsRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
+	
+	/// Returns true if the request carries a valid webadmin login; otherwise sends the auth request and returns false
+	bool CheckAuth(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
 
 	// cHTTPServer::cCallbacks overrides:
 	virtual void OnRequestBegun   (cHTTPConnection & a_Connection, cHTTPRequest & a_Request) override;
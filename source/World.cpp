@@ -205,6 +205,8 @@ void cWorld::cTickThread::Execute(void)
 		float DeltaTime = (float)(NowTime - LastTime);
 		m_World.Tick(DeltaTime);
 		long long TickTime = Timer.GetNowTime() - NowTime;
+		cRoot::Get()->GetServer()->GetLoadGovernor().ReportTickTime((int)TickTime);
+		cRoot::Get()->GetServer()->GetMetrics().ReportTickTime(m_World.GetName(), (int)TickTime);
 		
 		if (TickTime < msPerTick)
 		{
@@ -233,9 +235,13 @@ cWorld::cWorld(const AString & a_WorldName) :
 	m_TimeOfDay(0),
 	m_LastTimeUpdate(0),
 	m_RSList(0),
+	m_CSPlayers("World players"),
 	m_Weather(eWeather_Sunny),
 	m_WeatherInterval(24000),  // Guaranteed 1 day of sunshine at server start :)
+	m_CSFastSetBlock("World fast-set queue"),
 	m_TickThread(*this),
+	m_CSTasks("World tasks"),
+	m_CSClients("World clients"),
 	m_SkyDarkness(0)
 {
 	LOGD("cWorld::cWorld(\"%s\")", a_WorldName.c_str());
@@ -477,6 +483,9 @@ void cWorld::Start(void)
 	m_SpawnY                    = IniFile.GetValueSetF("SpawnPosition", "Y",                         m_SpawnY);
 	m_SpawnZ                    = IniFile.GetValueSetF("SpawnPosition", "Z",                         m_SpawnZ);
 	m_StorageSchema             = IniFile.GetValueSet ("Storage",       "Schema",                    m_StorageSchema);
+	int WarmCacheSizeMiB        = IniFile.GetValueSetI("Storage",       "WarmCacheSizeMiB",          32);
+	m_AutosaveMinDirtyAge       = IniFile.GetValueSetI("Autosave",      "MinDirtySeconds",           30) * 20;
+	m_AutosaveChunksPerSec      = IniFile.GetValueSetI("Autosave",      "ChunksPerSecond",           20);
 	m_MaxCactusHeight           = IniFile.GetValueSetI("Plants",        "MaxCactusHeight",           3);
 	m_MaxSugarcaneHeight        = IniFile.GetValueSetI("Plants",        "MaxSugarcaneHeight",        3);
 	m_IsCactusBonemealable      = IniFile.GetValueSetB("Plants",        "IsCactusBonemealable",      false);
@@ -492,6 +501,7 @@ void cWorld::Start(void)
 	m_IsSugarcaneBonemealable   = IniFile.GetValueSetB("Plants",        "IsSugarcaneBonemealable",   false);
 	m_bEnabledPVP               = IniFile.GetValueSetB("PVP",           "Enabled",                   true);
 	m_IsDeepSnowEnabled         = IniFile.GetValueSetB("Physics",       "DeepSnow",                  false);
+	m_MaxExplosionsPerTick      = IniFile.GetValueSetI("Physics",       "MaxExplosionsPerTick",      32);
 
 	m_GameMode = (eGameMode)IniFile.GetValueSetI("GameMode", "GameMode", m_GameMode);
 
@@ -510,6 +520,9 @@ void cWorld::Start(void)
 		}
 	}
 	m_bAnimals = IniFile.GetValueSetB("Monsters", "AnimalsOn", true);
+	m_MobFullTickDistance = IniFile.GetValueSetF("Monsters", "FullTickDistance", 32);
+	m_MobHalfTickDistance = IniFile.GetValueSetF("Monsters", "HalfTickDistance", 64);
+	m_MobFarTickInterval  = std::max(1, IniFile.GetValueSetI("Monsters", "FarTickInterval", 4));
 	AString AllMonsters = IniFile.GetValueSet("Monsters", "Types", DefaultMonsters);
 	AStringVector SplitList = StringSplitAndTrim(AllMonsters, ",");
 	for (AStringVector::const_iterator itr = SplitList.begin(), end = SplitList.end(); itr != end; ++itr)
@@ -527,9 +540,11 @@ void cWorld::Start(void)
 	}
 
 	m_ChunkMap = new cChunkMap(this);
+	m_ChunkMap->SetChunkPoolSize(IniFile.GetValueSetI("General", "ChunkPoolSize", 128));
 	
 	m_LastSave = 0;
 	m_LastUnload = 0;
+	m_LastMetricsUpdate = 0;
 
 	// preallocate some memory for ticking blocks so we don't need to allocate that often
 	m_BlockTickQueue.reserve(1000);
@@ -549,7 +564,8 @@ void cWorld::Start(void)
 	m_SimulatorManager->RegisterSimulator(m_RedstoneSimulator, 1);
 
 	m_Lighting.Start(this);
-	m_Storage.Start(this, m_StorageSchema);
+	m_Storage.GetWarmCache().SetMaxSize(WarmCacheSizeMiB * 1024 * 1024);
+	m_Storage.Start(this, m_StorageSchema, IniFile);
 	m_Generator.Start(this, IniFile);
 	m_ChunkSender.Start(this);
 	m_TickThread.Start();
@@ -590,6 +606,9 @@ void cWorld::Stop(void)
 	m_Lighting.Stop();
 	m_Generator.Stop();
 	m_ChunkSender.Stop();
+	
+	// The autosave only saves chunks gradually; queue all the remaining dirty chunks, the storage saves them all before stopping:
+	SaveAllChunks();
 	m_Storage.Stop();
 }
 
@@ -648,16 +667,23 @@ void cWorld::Tick(float a_Dt)
 		cCSLock Lock(m_CSFastSetBlock);
 		m_FastSetBlockQueue.splice(m_FastSetBlockQueue.end(), FastSetBlockQueueCopy);
 	}
+	
+	TickExplosions();
 
-	if (m_WorldAge - m_LastSave > 60 * 5 * 20) // Save each 5 minutes
+	if (m_WorldAge - m_LastSave >= 20)  // Autosave pass each second
 	{
-		SaveAllChunks();
+		TickAutosave();
 	}
 
 	if (m_WorldAge - m_LastUnload > 10 * 20) // Unload every 10 seconds
 	{
 		UnloadUnusedChunks();
 	}
+	
+	if (m_WorldAge - m_LastMetricsUpdate >= 20)  // Publish the metrics each second
+	{
+		UpdateMetrics();
+	}
 
 	TickMobs(a_Dt);
 
@@ -689,6 +715,22 @@ void cWorld::Tick(float a_Dt)
 
 
 
+void cWorld::TickAutosave(void)
+{
+	m_LastSave = m_WorldAge;
+	
+	// The chunks still waiting in the storage queue count against the budget, so that a slow disk doesn't get the queue growing:
+	int NumToSave = m_AutosaveChunksPerSec - m_Storage.GetSaveQueueLength();
+	if (NumToSave > 0)
+	{
+		m_ChunkMap->SaveOldestDirtyChunks(m_WorldAge, m_AutosaveMinDirtyAge, NumToSave);
+	}
+}
+
+
+
+
+
 void cWorld::TickWeather(float a_Dt)
 {
 	// There are no weather changes anywhere but in the Overworld:
@@ -750,7 +792,8 @@ void cWorld::TickMobs(float a_Dt)
 	cWorld::cLock Lock(*this);
 
 	// before every Mob action, we have to count them depending on the distance to players, on their family ...
-	cMobCensus MobCensus;
+	cMobCensus & MobCensus = m_MobCensus;
+	MobCensus.Clear();
 	m_ChunkMap->CollectMobCensus(MobCensus);
 	if (m_bAnimals)
 	{
@@ -787,18 +830,21 @@ void cWorld::TickMobs(float a_Dt)
 		} // for i - AllFamilies[]
 	} // if (Spawning enabled)
 
-	// move close mobs
+	// move close mobs; the mobs are sorted by distance, the farther ones are ticked less often:
+	double FullTickSqrDistance = m_MobFullTickDistance * m_MobFullTickDistance;
+	double HalfTickSqrDistance = m_MobHalfTickDistance * m_MobHalfTickDistance;
 	cMobProximityCounter::sIterablePair allCloseEnoughToMoveMobs = MobCensus.GetProximityCounter().getMobWithinThosesDistances(-1, 64 * 16);// MG TODO : deal with this magic number (the 16 is the size of a block)
 	for(cMobProximityCounter::tDistanceToMonster::const_iterator itr = allCloseEnoughToMoveMobs.m_Begin; itr != allCloseEnoughToMoveMobs.m_End; itr++)
 	{
-		itr->second.m_Monster.Tick(a_Dt, itr->second.m_Chunk);
+		int TickInterval = (itr->m_Distance <= FullTickSqrDistance) ? 1 : ((itr->m_Distance <= HalfTickSqrDistance) ? 2 : m_MobFarTickInterval);
+		itr->m_Monster->TickAtInterval(a_Dt, *itr->m_Chunk, TickInterval, m_WorldAge);
 	}
 
 	// remove too far mobs
 	cMobProximityCounter::sIterablePair allTooFarMobs = MobCensus.GetProximityCounter().getMobWithinThosesDistances(128 * 16, -1);// MG TODO : deal with this magic number (the 16 is the size of a block)
 	for(cMobProximityCounter::tDistanceToMonster::const_iterator itr = allTooFarMobs.m_Begin; itr != allTooFarMobs.m_End; itr++)
 	{
-		itr->second.m_Monster.Destroy(true);
+		itr->m_Monster->Destroy(true);
 	}
 }
 
@@ -974,36 +1020,136 @@ void cWorld::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_Blo
 		return;
 	}
 	
+	sQueuedExplosion Explosion;
+	Explosion.m_Size = a_ExplosionSize;
+	Explosion.m_X = a_BlockX;
+	Explosion.m_Y = a_BlockY;
+	Explosion.m_Z = a_BlockZ;
+	Explosion.m_CanCauseFire = a_CanCauseFire;
+	Explosion.m_Source = a_Source;
+	if (((a_Source == esBed) || (a_Source == esEnderCrystal)) && (a_SourceData != NULL))
+	{
+		Explosion.m_SourceCoords = *((Vector3i *)a_SourceData);
+	}
+	
+	cCSLock Lock(m_CSExplosions);
+	m_QueuedExplosions.push_back(Explosion);
+}
+
+
+
+
+
+void cWorld::UpdateMetrics(void)
+{
+	m_LastMetricsUpdate = m_WorldAge;
+	
+	cMetrics::sWorldStats Stats;
+	GetChunkStats(Stats.m_NumChunksValid, Stats.m_NumChunksDirty, Stats.m_NumChunksInLighting);
+	Stats.m_GeneratorQueueLength   = GetGeneratorQueueLength();
+	Stats.m_LightingQueueLength    = GetLightingQueueLength();
+	Stats.m_StorageLoadQueueLength = GetStorageLoadQueueLength();
+	Stats.m_StorageSaveQueueLength = GetStorageSaveQueueLength();
+	
+	class cEntityCounter :
+		public cEntityCallback
+	{
+	public:
+		cEntityCounter(cMetrics::cEntityCounts & a_Counts) : m_Counts(a_Counts) {}
+		
+		virtual bool Item(cEntity * a_Entity) override
+		{
+			m_Counts[a_Entity->GetClass()] += 1;
+			return false;
+		}
+		
+	protected:
+		cMetrics::cEntityCounts & m_Counts;
+	} EntityCounter(Stats.m_NumEntities);
+	ForEachEntity(EntityCounter);
+	
+	{
+		cCSLock Lock(m_CSClients);
+		Stats.m_Clients.reserve(m_Clients.size());
+		for (cClientHandleList::const_iterator itr = m_Clients.begin(), end = m_Clients.end(); itr != end; ++itr)
+		{
+			cMetrics::sClientStats Client;
+			Client.m_Name = (*itr)->GetUsername();
+			Client.m_OutgoingBacklog = (*itr)->GetOutgoingBacklog();
+			Stats.m_Clients.push_back(Client);
+		}  // for itr - m_Clients[]
+	}
+	
+	cRoot::Get()->GetServer()->GetMetrics().SetWorldStats(m_WorldName, Stats);
+}
+
+
+
+
+
+void cWorld::TickExplosions(void)
+{
+	// Take the explosions to process in this tick:
+	std::vector<sQueuedExplosion> Queued;
+	{
+		cCSLock Lock(m_CSExplosions);
+		if (m_QueuedExplosions.empty())
+		{
+			return;
+		}
+		size_t NumToProcess = std::min(m_QueuedExplosions.size(), (size_t)std::max(m_MaxExplosionsPerTick, 1));
+		Queued.assign(m_QueuedExplosions.begin(), m_QueuedExplosions.begin() + NumToProcess);
+		m_QueuedExplosions.erase(m_QueuedExplosions.begin(), m_QueuedExplosions.begin() + NumToProcess);
+	}
+	
 	// TODO: Add damage to entities, add support for pickups, and implement block hardiness
-	Vector3d explosion_pos = Vector3d(a_BlockX, a_BlockY, a_BlockZ);
-	cVector3iArray BlocksAffected;
-	m_ChunkMap->DoExplosionAt(a_ExplosionSize, a_BlockX, a_BlockY, a_BlockZ, BlocksAffected);
-	BroadcastSoundEffect("random.explode", (int)floor(a_BlockX * 8), (int)floor(a_BlockY * 8), (int)floor(a_BlockZ * 8), 1.0f, 0.6f);
+	sExplosionVector Explosions;
+	Explosions.reserve(Queued.size());
+	for (std::vector<sQueuedExplosion>::const_iterator itr = Queued.begin(), end = Queued.end(); itr != end; ++itr)
 	{
-		cCSLock Lock(m_CSPlayers);
-		for (cPlayerList::iterator itr = m_Players.begin(); itr != m_Players.end(); ++itr)
+		Explosions.push_back(sExplosion(itr->m_Size, itr->m_X, itr->m_Y, itr->m_Z));
+	}
+	m_ChunkMap->DoExplosions(Explosions);
+	
+	// The changed blocks are sent to the clients by the chunks anyway; the block lists in the explosion packets
+	// only make the client remove the blocks sooner. For a batch of explosions, skip them to keep the packets small:
+	const cVector3iArray NoBlocks;
+	bool ShouldSendBlocks = (Explosions.size() == 1);
+	
+	for (size_t i = 0; i < Queued.size(); i++)
+	{
+		const sQueuedExplosion & Explosion = Queued[i];
+		Vector3d explosion_pos = Vector3d(Explosion.m_X, Explosion.m_Y, Explosion.m_Z);
+		BroadcastSoundEffect("random.explode", (int)floor(Explosion.m_X * 8), (int)floor(Explosion.m_Y * 8), (int)floor(Explosion.m_Z * 8), 1.0f, 0.6f);
 		{
-			cClientHandle * ch = (*itr)->GetClientHandle();
-			if ((ch == NULL) || !ch->IsLoggedIn() || ch->IsDestroyed())
-			{
-				continue;
-			}
-			Vector3d distance_explosion = (*itr)->GetPosition() - explosion_pos;
-			if (distance_explosion.SqrLength() < 4096.0)
+			cCSLock Lock(m_CSPlayers);
+			for (cPlayerList::iterator itr = m_Players.begin(); itr != m_Players.end(); ++itr)
 			{
-				double real_distance = std::max(0.004, sqrt(distance_explosion.SqrLength()));
-				double power = a_ExplosionSize / real_distance;
-				if (power <= 1)
+				cClientHandle * ch = (*itr)->GetClientHandle();
+				if ((ch == NULL) || !ch->IsLoggedIn() || ch->IsDestroyed())
+				{
+					continue;
+				}
+				Vector3d distance_explosion = (*itr)->GetPosition() - explosion_pos;
+				if (distance_explosion.SqrLength() < 4096.0)
 				{
-					power = 0;
+					double real_distance = std::max(0.004, sqrt(distance_explosion.SqrLength()));
+					double power = Explosion.m_Size / real_distance;
+					if (power <= 1)
+					{
+						power = 0;
+					}
+					distance_explosion.Normalize();
+					distance_explosion *= power;
+					ch->SendExplosion(Explosion.m_X, Explosion.m_Y, Explosion.m_Z, (float)Explosion.m_Size, ShouldSendBlocks ? Explosions[i].m_BlocksAffected : NoBlocks, distance_explosion);
 				}
-				distance_explosion.Normalize();
-				distance_explosion *= power;
-				ch->SendExplosion(a_BlockX, a_BlockY, a_BlockZ, (float)a_ExplosionSize, BlocksAffected, distance_explosion);
 			}
 		}
+		
+		Vector3i SourceCoords(Explosion.m_SourceCoords);
+		void * SourceData = ((Explosion.m_Source == esBed) || (Explosion.m_Source == esEnderCrystal)) ? &SourceCoords : NULL;
+		cPluginManager::Get()->CallHookExploded(*this, Explosion.m_Size, Explosion.m_CanCauseFire, Explosion.m_X, Explosion.m_Y, Explosion.m_Z, Explosion.m_Source, SourceData);
 	}
-	cPluginManager::Get()->CallHookExploded(*this, a_ExplosionSize, a_CanCauseFire, a_BlockX, a_BlockY, a_BlockZ, a_Source, a_SourceData);
 }
 
 
@@ -1572,6 +1718,15 @@ bool cWorld::GetBlocks(sSetBlockVector & a_Blocks, bool a_ContinueOnFailure)
 
 
 
+int cWorld::SetBlocks(sSetBlockVector & a_Blocks, bool a_ShouldFastSet)
+{
+	return m_ChunkMap->SetBlocks(a_Blocks, a_ShouldFastSet);
+}
+
+
+
+
+
 bool cWorld::DigBlock(int a_X, int a_Y, int a_Z)
 {
 	cBlockHandler *Handler = cBlockHandler::GetBlockHandler(GetBlock(a_X, a_Y, a_Z));
@@ -1897,6 +2052,15 @@ void cWorld::SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClientHa
 
 
 
+void cWorld::SendChunkBlockEntities(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
+{
+	m_ChunkMap->SendChunkBlockEntities(a_ChunkX, a_ChunkZ, a_Client);
+}
+
+
+
+
+
 void cWorld::MarkChunkDirty (int a_ChunkX, int a_ChunkZ)
 {
 	m_ChunkMap->MarkChunkDirty (a_ChunkX, a_ChunkZ);
@@ -1997,6 +2161,15 @@ bool cWorld::GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Cal
 
 
 
+bool cWorld::GetChunkSnapshot(int a_ChunkX, int a_ChunkZ, cChunkSnapshot & a_Snapshot)
+{
+	return m_ChunkMap->GetChunkSnapshot(a_ChunkX, a_ChunkZ, a_Snapshot);
+}
+
+
+
+
+
 bool cWorld::GetChunkBlockTypes(int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_BlockTypes)
 {
 	return m_ChunkMap->GetChunkBlockTypes(a_ChunkX, a_ChunkZ, a_BlockTypes);
@@ -2415,7 +2588,6 @@ bool cWorld::ForEachChunkInRect(int a_MinChunkX, int a_MaxChunkX, int a_MinChunk
 void cWorld::SaveAllChunks(void)
 {
 	LOGINFO("Saving all chunks...");
-	m_LastSave = m_WorldAge;
 	m_ChunkMap->SaveAllChunks();
 	m_Storage.QueueSavedMessage();
 }
@@ -2501,6 +2673,15 @@ void cWorld::GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLigh
 
 
 
+void cWorld::GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers)
+{
+	m_ChunkMap->GetBlockEntityStats(a_NumActive, a_NumSleeping, a_NumActiveHoppers, a_NumSleepingHoppers);
+}
+
+
+
+
+
 void cWorld::TickQueuedBlocks(void)
 {
 	if (m_BlockTickQueue.empty())
@@ -21,6 +21,7 @@
 #include "LightingThread.h"
 #include "Item.h"
 #include "Mobs/Monster.h"
+#include "MobCensus.h"
 #include "Entities/ProjectileEntity.h"
 
 
@@ -42,7 +43,6 @@ class cChunkGenerator;  // The thread responsible for generating chunks
 class cChestEntity;
 class cDispenserEntity;
 class cFurnaceEntity;
-class cMobCensus;
 
 typedef std::list< cPlayer * > cPlayerList;
 
@@ -171,6 +171,9 @@ public:
 	/// If there is a block entity at the specified coords, sends it to the client specified
 	void SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClientHandle & a_Client);
 	
+	/// Sends all the block entities in the chunk to a_Client, or to all the chunk's clients if a_Client is NULL
+	void SendChunkBlockEntities(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+	
 	void MarkChunkDirty (int a_ChunkX, int a_ChunkZ);
 	void MarkChunkSaving(int a_ChunkX, int a_ChunkZ);
 	void MarkChunkSaved (int a_ChunkX, int a_ChunkZ);
@@ -202,6 +205,11 @@ public:
 	
 	bool GetChunkData      (int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback);
 	
+	/** Takes a read-only snapshot of the chunk's block data (no entities or block entities) without waiting for the world tick;
+	returns false if the chunk is not valid. For the background threads, they can read the snapshot without any locks.
+	*/
+	bool GetChunkSnapshot  (int a_ChunkX, int a_ChunkZ, cChunkSnapshot & a_Snapshot);
+	
 	/// Gets the chunk's blocks, only the block types
 	bool GetChunkBlockTypes(int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_BlockTypes);
 	
@@ -364,6 +372,12 @@ public:
 	/// Retrieves block types of the specified blocks. If a chunk is not loaded, doesn't modify the block. Returns true if all blocks were read.
 	bool GetBlocks(sSetBlockVector & a_Blocks, bool a_ContinueOnFailure);
 	
+	/** Sets many blocks at once, grouped by chunk so that each chunk is locked only once; see cChunkMap::SetBlocks() for details.
+	Much faster than calling SetBlock() or FastSetBlock() for each block. a_Blocks gets reordered in the process.
+	Returns the number of blocks that weren't set because their chunk is not loaded or their Y coord is out of range.
+	*/
+	int SetBlocks(sSetBlockVector & a_Blocks, bool a_ShouldFastSet);  // Exported in ManualBindings.cpp
+	
 	// tolua_begin
 	bool DigBlock   (int a_X, int a_Y, int a_Z);
 	void SendBlockTo(int a_X, int a_Y, int a_Z, cPlayer * a_Player );
@@ -401,6 +415,8 @@ public:
 	bool ForEachFurnaceInChunk(int a_ChunkX, int a_ChunkZ, cFurnaceCallback & a_Callback);  // Exported in ManualBindings.cpp
 	
 	/** Does an explosion with the specified strength at the specified coordinate
+	The HOOK_EXPLODING is called right away; if not cancelled, the explosion is queued and processed at the end of the tick,
+	together with all the other explosions queued in the same tick, and then the HOOK_EXPLODED is called.
 	a_SourceData exact type depends on the a_Source:
 	| esOther | void * |
 	| esPrimedTNT | cTNTEntity * |
@@ -516,6 +532,9 @@ public:
 
 	/// Returns the number of chunks loaded and dirty, and in the lighting queue
 	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue);
+	
+	/// Returns the number of block entities (and of hoppers among them) that are ticking and that are sleeping until woken up
+	void GetBlockEntityStats(int & a_NumActive, int & a_NumSleeping, int & a_NumActiveHoppers, int & a_NumSleepingHoppers);
 
 	// Various queues length queries (cannot be const, they lock their CS):
 	inline int GetGeneratorQueueLength  (void) { return m_Generator.GetQueueLength();   }    // tolua_export
@@ -599,6 +618,24 @@ private:
 
 	friend class cRoot;
 	
+	/// An explosion that has passed the HOOK_EXPLODING and is waiting to be processed by TickExplosions()
+	struct sQueuedExplosion
+	{
+		double           m_Size;
+		double           m_X;
+		double           m_Y;
+		double           m_Z;
+		bool             m_CanCauseFire;
+		eExplosionSource m_Source;
+		
+		/** The source coords for esBed and esEnderCrystal, copied because the caller's data doesn't live long enough.
+		The source data of the other sources isn't kept at all, the source objects may be gone by the time the explosion is processed.
+		*/
+		Vector3i         m_SourceCoords;
+	} ;
+	
+	typedef std::deque<sQueuedExplosion> cQueuedExplosions;
+	
 	class cTickThread :
 		public cIsThread
 	{
@@ -636,7 +673,10 @@ private:
 	Int64  m_TimeOfDay;         // Time in ticks, calculated off of m_TimeOfDaySecs
 	Int64  m_LastTimeUpdate;    // The tick in which the last time update has been sent.
 	Int64  m_LastUnload;        // The last WorldAge (in ticks) in which unloading was triggerred
-	Int64  m_LastSave;          // The last WorldAge (in ticks) in which save-all was triggerred
+	Int64  m_LastSave;          // The last WorldAge (in ticks) in which an autosave pass was done
+	Int64  m_LastMetricsUpdate; // The last WorldAge (in ticks) in which the metrics were published
+	Int64  m_AutosaveMinDirtyAge;    // Chunks dirty for at least this many ticks are autosaved
+	int    m_AutosaveChunksPerSec;   // Max number of chunks queued for autosaving per second, including those still waiting in the storage queue
 	std::map<cMonster::eFamily,Int64> m_LastSpawnMonster; // The last WorldAge (in ticks) in which a monster was spawned (for each megatype of monster) // MG TODO : find a way to optimize without creating unmaintenability (if mob IDs are becoming unrowed)
 
 	NIBBLETYPE m_SkyDarkness;
@@ -670,6 +710,18 @@ private:
 
 	bool m_bAnimals;
 	std::set<cMonster::eType> m_AllowedMobs;
+	
+	/// The census of the mobs, refilled each tick in TickMobs(); kept between the ticks so that its buffers are reused
+	cMobCensus m_MobCensus;
+	
+	/// Mobs closer than this to a player (in blocks) are ticked every tick
+	double m_MobFullTickDistance;
+	
+	/// Mobs closer than this to a player (in blocks), but not within m_MobFullTickDistance, are ticked every other tick
+	double m_MobHalfTickDistance;
+	
+	/// Mobs farther than m_MobHalfTickDistance from any player are ticked once every this many ticks
+	int m_MobFarTickInterval;
 
 	eWeather m_Weather;
 	int m_WeatherInterval;
@@ -690,6 +742,15 @@ private:
 	
 	cCriticalSection m_CSFastSetBlock;
 	sSetBlockList    m_FastSetBlockQueue;
+	
+	/// Guards m_QueuedExplosions
+	cCriticalSection  m_CSExplosions;
+	
+	/// Explosions waiting to be processed, in the order in which they happened
+	cQueuedExplosions m_QueuedExplosions;
+	
+	/// Maximum number of explosions processed in a single tick; the rest waits for the next ticks
+	int m_MaxExplosionsPerTick;
 
 	cChunkGenerator  m_Generator;
 	
@@ -724,6 +785,15 @@ private:
 	/// Handles the weather in each tick
 	void TickWeather(float a_Dt);
 	
+	/// Queues the chunks that have been dirty the longest for saving, within the autosave budget. Called once per second.
+	void TickAutosave(void);
+	
+	/// Processes the queued explosions, up to m_MaxExplosionsPerTick of them
+	void TickExplosions(void);
+	
+	/// Publishes the world's statistics into the server's cMetrics, so that scraping them needn't lock the world. Called once per second.
+	void UpdateMetrics(void);
+	
 	/// Handles the mob spawning/moving/destroying each tick
 	void TickMobs(float a_Dt);
 	
@@ -0,0 +1,708 @@
+
+// AnvilChunkCodec.cpp
+
+// Implements the cAnvilChunkCodec class that converts between the Anvil chunk NBT and the chunk data arrays without building a NBT tree
+
+#include "Globals.h"
+#include "AnvilChunkCodec.h"
+
+
+
+
+
+/// Sizes of the per-section arrays
+static const int SECTION_BLOCK_SIZE  = cChunkDef::Width * cChunkDef::Width * 16;
+static const int SECTION_NIBBLE_SIZE = SECTION_BLOCK_SIZE / 2;
+
+/// Number of sections in a chunk
+static const int NUM_SECTIONS = cChunkDef::Height / 16;
+
+/// Maximum nesting of the tags that are skipped; deeper data is considered malformed, to keep the recursion bounded
+static const int MAX_SKIP_DEPTH = 512;
+
+
+
+
+
+/// Reads a big-endian int from unaligned data
+static inline UInt32 GetBEInt(const char * a_Data)
+{
+	UInt32 Value;
+	memcpy(&Value, a_Data, 4);
+	return ntohl(Value);
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cNBTScanner:
+
+/// A bounds-checked sequential reader of the raw NBT data; all the functions return false if the data is too short or malformed
+class cNBTScanner
+{
+public:
+	cNBTScanner(const char * a_Data, size_t a_Length) :
+		m_Data(a_Data),
+		m_Length(a_Length),
+		m_Pos(0)
+	{
+	}
+
+	size_t       GetPos (void) const { return m_Pos; }
+	const char * GetData(void) const { return m_Data + m_Pos; }
+
+	bool Skip(size_t a_NumBytes)
+	{
+		if (a_NumBytes > m_Length - m_Pos)
+		{
+			return false;
+		}
+		m_Pos += a_NumBytes;
+		return true;
+	}
+
+	bool ReadByte(unsigned char & a_Value)
+	{
+		if (m_Pos >= m_Length)
+		{
+			return false;
+		}
+		a_Value = (unsigned char)m_Data[m_Pos];
+		m_Pos += 1;
+		return true;
+	}
+
+	bool ReadInt(Int32 & a_Value)
+	{
+		if (m_Length - m_Pos < 4)
+		{
+			return false;
+		}
+		a_Value = (Int32)GetBEInt(m_Data + m_Pos);
+		m_Pos += 4;
+		return true;
+	}
+
+	/// Reads the length of a byte array or an int array and returns the pointer to its data, skipping it
+	bool ReadArray(size_t a_ItemSize, const char *& a_ArrayData, Int32 & a_NumItems)
+	{
+		if (!ReadInt(a_NumItems) || (a_NumItems < 0))
+		{
+			return false;
+		}
+		a_ArrayData = GetData();
+		return SkipItems(a_ItemSize, a_NumItems);
+	}
+
+	/// Reads the type and name of the next tag in a compound; the name isn't read for TAG_End
+	bool ReadTagHeader(eTagType & a_Type, const char *& a_Name, size_t & a_NameLength)
+	{
+		unsigned char Type;
+		if (!ReadByte(Type) || (Type > TAG_Max))
+		{
+			return false;
+		}
+		a_Type = (eTagType)Type;
+		if (a_Type == TAG_End)
+		{
+			return true;
+		}
+		return ReadString(a_Name, a_NameLength);
+	}
+
+	/// Reads a string (2 bytes length + data), as used for the tag names and TAG_String payloads
+	bool ReadString(const char *& a_String, size_t & a_Length)
+	{
+		if (m_Length - m_Pos < 2)
+		{
+			return false;
+		}
+		Int16 Length = (Int16)((((unsigned char)m_Data[m_Pos]) << 8) | ((unsigned char)m_Data[m_Pos + 1]));
+		m_Pos += 2;
+		if (Length < 0)
+		{
+			return false;
+		}
+		a_String = GetData();
+		a_Length = (size_t)Length;
+		return Skip(a_Length);
+	}
+
+	/// Skips the payload of a tag of the specified type
+	bool SkipPayload(eTagType a_Type, int a_Depth)
+	{
+		switch (a_Type)
+		{
+			case TAG_Byte:   return Skip(1);
+			case TAG_Short:  return Skip(2);
+			case TAG_Int:    return Skip(4);
+			case TAG_Long:   return Skip(8);
+			case TAG_Float:  return Skip(4);
+			case TAG_Double: return Skip(8);
+			case TAG_ByteArray:
+			case TAG_IntArray:
+			{
+				const char * Data;
+				Int32 NumItems;
+				return ReadArray((a_Type == TAG_IntArray) ? 4 : 1, Data, NumItems);
+			}
+			case TAG_String:
+			{
+				const char * String;
+				size_t Length;
+				return ReadString(String, Length);
+			}
+			case TAG_List:
+			{
+				return SkipList(a_Depth);
+			}
+			case TAG_Compound:
+			{
+				if (a_Depth >= MAX_SKIP_DEPTH)
+				{
+					return false;
+				}
+				for (;;)
+				{
+					eTagType Type;
+					const char * Name;
+					size_t NameLength;
+					if (!ReadTagHeader(Type, Name, NameLength))
+					{
+						return false;
+					}
+					if (Type == TAG_End)
+					{
+						return true;
+					}
+					if (!SkipPayload(Type, a_Depth + 1))
+					{
+						return false;
+					}
+				}
+			}
+			default:
+			{
+				return false;
+			}
+		}
+	}
+
+protected:
+	const char * m_Data;
+	size_t       m_Length;
+	size_t       m_Pos;
+
+	bool SkipItems(size_t a_ItemSize, Int32 a_NumItems)
+	{
+		if ((size_t)a_NumItems > (m_Length - m_Pos) / a_ItemSize)
+		{
+			return false;
+		}
+		m_Pos += (size_t)a_NumItems * a_ItemSize;
+		return true;
+	}
+
+	bool SkipList(int a_Depth)
+	{
+		unsigned char ItemType;
+		Int32 NumItems;
+		if (!ReadByte(ItemType) || (ItemType > TAG_Max) || !ReadInt(NumItems) || (NumItems < 0) || (a_Depth >= MAX_SKIP_DEPTH))
+		{
+			return false;
+		}
+		switch (ItemType)
+		{
+			case TAG_End:    return (NumItems == 0);
+			case TAG_Byte:   return SkipItems(1, NumItems);
+			case TAG_Short:  return SkipItems(2, NumItems);
+			case TAG_Int:    return SkipItems(4, NumItems);
+			case TAG_Long:   return SkipItems(8, NumItems);
+			case TAG_Float:  return SkipItems(4, NumItems);
+			case TAG_Double: return SkipItems(8, NumItems);
+		}
+		for (Int32 i = 0; i < NumItems; i++)
+		{
+			if (!SkipPayload((eTagType)ItemType, a_Depth + 1))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+} ;
+
+
+
+
+
+/// Returns true if the tag name matches the expected name
+static inline bool IsTagName(const char * a_Name, size_t a_NameLength, const char * a_Expected)
+{
+	return (strlen(a_Expected) == a_NameLength) && (memcmp(a_Name, a_Expected, a_NameLength) == 0);
+}
+
+
+
+
+
+/// Size of a tag's type and name, as they are stored in a compound
+static inline size_t TagHeaderSize(const char * a_Name)
+{
+	return 3 + strlen(a_Name);
+}
+
+
+
+
+
+static inline void WriteTagHeader(char *& a_Dst, eTagType a_Type, const char * a_Name)
+{
+	size_t NameLength = strlen(a_Name);
+	a_Dst[0] = (char)a_Type;
+	a_Dst[1] = (char)(NameLength >> 8);
+	a_Dst[2] = (char)(NameLength & 0xff);
+	memcpy(a_Dst + 3, a_Name, NameLength);
+	a_Dst += 3 + NameLength;
+}
+
+
+
+
+
+static inline void WriteInt(char *& a_Dst, Int32 a_Value)
+{
+	UInt32 Value = htonl((UInt32)a_Value);
+	memcpy(a_Dst, &Value, 4);
+	a_Dst += 4;
+}
+
+
+
+
+
+static inline void WriteByteArray(char *& a_Dst, const char * a_Name, const void * a_Data, int a_Length)
+{
+	WriteTagHeader(a_Dst, TAG_ByteArray, a_Name);
+	WriteInt(a_Dst, a_Length);
+	memcpy(a_Dst, a_Data, a_Length);
+	a_Dst += a_Length;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cAnvilChunkCodec:
+
+cAnvilChunkCodec::cAnvilChunkCodec(void) :
+	m_VanillaBiomes(NULL),
+	m_MCSBiomes(NULL),
+	m_IsLightValid(false),
+	m_EntitiesTag(NULL),
+	m_EntitiesTagLength(0),
+	m_TileEntitiesTag(NULL),
+	m_TileEntitiesTagLength(0)
+{
+}
+
+
+
+
+
+bool cAnvilChunkCodec::Decode(
+	const char * a_Data, size_t a_Length,
+	BLOCKTYPE * a_BlockTypes, NIBBLETYPE * a_BlockMetas,
+	NIBBLETYPE * a_BlockLight, NIBBLETYPE * a_SkyLight
+)
+{
+	m_VanillaBiomes = NULL;
+	m_MCSBiomes = NULL;
+	m_IsLightValid = false;
+	m_EntitiesTag = NULL;
+	m_EntitiesTagLength = 0;
+	m_TileEntitiesTag = NULL;
+	m_TileEntitiesTagLength = 0;
+
+	cNBTScanner Scanner(a_Data, a_Length);
+	eTagType Type;
+	const char * Name;
+	size_t NameLength;
+
+	// The root compound:
+	if (!Scanner.ReadTagHeader(Type, Name, NameLength) || (Type != TAG_Compound))
+	{
+		return false;
+	}
+
+	// Find the Level compound inside the root; everything else in the root is ignored:
+	for (;;)
+	{
+		if (!Scanner.ReadTagHeader(Type, Name, NameLength) || (Type == TAG_End))
+		{
+			return false;
+		}
+		if ((Type == TAG_Compound) && IsTagName(Name, NameLength, "Level"))
+		{
+			break;
+		}
+		if (!Scanner.SkipPayload(Type, 1))
+		{
+			return false;
+		}
+	}
+
+	// Walk the Level's children:
+	bool HasSections = false;
+	for (;;)
+	{
+		const char * TagStart = Scanner.GetData();
+		if (!Scanner.ReadTagHeader(Type, Name, NameLength))
+		{
+			return false;
+		}
+		if (Type == TAG_End)
+		{
+			break;
+		}
+
+		if (!HasSections && IsTagName(Name, NameLength, "Sections"))
+		{
+			HasSections = true;
+			unsigned char ItemType;
+			Int32 NumSections;
+			if (
+				(Type != TAG_List) ||
+				!Scanner.ReadByte(ItemType) ||
+				!Scanner.ReadInt(NumSections) || (NumSections < 0)
+			)
+			{
+				return false;
+			}
+			if (NumSections == 0)
+			{
+				// An all-air chunk (such as above a void world); the destination buffers already hold air.
+				// The empty list may have been written with any item type, usually TAG_End:
+				continue;
+			}
+			if (ItemType != TAG_Compound)
+			{
+				return false;
+			}
+			for (Int32 i = 0; i < NumSections; i++)
+			{
+				// Remember where the arrays are, the Y tag may come after them:
+				const char * Blocks     = NULL;
+				const char * Data       = NULL;
+				const char * SkyLight   = NULL;
+				const char * BlockLight = NULL;
+				int Y = -1;
+				for (;;)
+				{
+					if (!Scanner.ReadTagHeader(Type, Name, NameLength))
+					{
+						return false;
+					}
+					if (Type == TAG_End)
+					{
+						break;
+					}
+					if (Type == TAG_ByteArray)
+					{
+						const char * ArrayData;
+						Int32 ArrayLength;
+						if (!Scanner.ReadArray(1, ArrayData, ArrayLength))
+						{
+							return false;
+						}
+						if (ArrayLength == SECTION_BLOCK_SIZE)
+						{
+							if ((Blocks == NULL) && IsTagName(Name, NameLength, "Blocks"))
+							{
+								Blocks = ArrayData;
+							}
+						}
+						else if (ArrayLength == SECTION_NIBBLE_SIZE)
+						{
+							if ((Data == NULL) && IsTagName(Name, NameLength, "Data"))
+							{
+								Data = ArrayData;
+							}
+							else if ((SkyLight == NULL) && IsTagName(Name, NameLength, "SkyLight"))
+							{
+								SkyLight = ArrayData;
+							}
+							else if ((BlockLight == NULL) && IsTagName(Name, NameLength, "BlockLight"))
+							{
+								BlockLight = ArrayData;
+							}
+						}
+						continue;
+					}
+					if ((Type == TAG_Byte) && (Y < 0) && IsTagName(Name, NameLength, "Y"))
+					{
+						unsigned char SectionY;
+						if (!Scanner.ReadByte(SectionY))
+						{
+							return false;
+						}
+						Y = SectionY;
+						continue;
+					}
+					if (!Scanner.SkipPayload(Type, 2))
+					{
+						return false;
+					}
+				}  // for - section's children
+
+				if ((Y < 0) || (Y >= NUM_SECTIONS))
+				{
+					continue;
+				}
+				if (Blocks != NULL)
+				{
+					memcpy(a_BlockTypes + Y * SECTION_BLOCK_SIZE, Blocks, SECTION_BLOCK_SIZE);
+				}
+				if (Data != NULL)
+				{
+					memcpy(a_BlockMetas + Y * SECTION_NIBBLE_SIZE, Data, SECTION_NIBBLE_SIZE);
+				}
+				if (SkyLight != NULL)
+				{
+					memcpy(a_SkyLight + Y * SECTION_NIBBLE_SIZE, SkyLight, SECTION_NIBBLE_SIZE);
+				}
+				if (BlockLight != NULL)
+				{
+					memcpy(a_BlockLight + Y * SECTION_NIBBLE_SIZE, BlockLight, SECTION_NIBBLE_SIZE);
+				}
+			}  // for i - Sections[]
+			continue;
+		}
+
+		if ((Type == TAG_ByteArray) || (Type == TAG_IntArray))
+		{
+			const char * ArrayData;
+			Int32 ArrayLength;
+			if (!Scanner.ReadArray((Type == TAG_IntArray) ? 4 : 1, ArrayData, ArrayLength))
+			{
+				return false;
+			}
+			if ((ArrayLength == cChunkDef::Width * cChunkDef::Width) && (m_VanillaBiomes == NULL) && (Type == TAG_ByteArray) && IsTagName(Name, NameLength, "Biomes"))
+			{
+				m_VanillaBiomes = ArrayData;
+			}
+			else if ((ArrayLength == cChunkDef::Width * cChunkDef::Width) && (m_MCSBiomes == NULL) && (Type == TAG_IntArray) && IsTagName(Name, NameLength, "MCSBiomes"))
+			{
+				m_MCSBiomes = ArrayData;
+			}
+			continue;
+		}
+
+		if (!Scanner.SkipPayload(Type, 1))
+		{
+			return false;
+		}
+		size_t TagLength = Scanner.GetData() - TagStart;
+		if ((m_EntitiesTag == NULL) && IsTagName(Name, NameLength, "Entities"))
+		{
+			m_EntitiesTag = TagStart;
+			m_EntitiesTagLength = TagLength;
+		}
+		else if ((m_TileEntitiesTag == NULL) && IsTagName(Name, NameLength, "TileEntities"))
+		{
+			m_TileEntitiesTag = TagStart;
+			m_TileEntitiesTagLength = TagLength;
+		}
+		else if (IsTagName(Name, NameLength, "MCSIsLightValid"))
+		{
+			m_IsLightValid = true;
+		}
+	}  // for - Level's children
+
+	return HasSections;
+}
+
+
+
+
+
+bool cAnvilChunkCodec::GetBiomes(cChunkDef::BiomeMap & a_Biomes) const
+{
+	// Prefer the MCS biomes, they can hold the biomes that vanilla doesn't know:
+	if (m_MCSBiomes != NULL)
+	{
+		bool IsValid = true;
+		for (size_t i = 0; i < ARRAYCOUNT(a_Biomes); i++)
+		{
+			UInt32 Biome = GetBEInt(m_MCSBiomes + 4 * i);
+			if (Biome == 0xff)
+			{
+				// Unassigned biomes
+				IsValid = false;
+				break;
+			}
+			a_Biomes[i] = (EMCSBiome)Biome;
+		}
+		if (IsValid)
+		{
+			return true;
+		}
+	}
+
+	if (m_VanillaBiomes == NULL)
+	{
+		return false;
+	}
+	const unsigned char * VanillaBiomes = (const unsigned char *)m_VanillaBiomes;
+	for (size_t i = 0; i < ARRAYCOUNT(a_Biomes); i++)
+	{
+		if (VanillaBiomes[i] == 0xff)
+		{
+			// Unassigned biomes
+			return false;
+		}
+		a_Biomes[i] = (EMCSBiome)VanillaBiomes[i];
+	}
+	return true;
+}
+
+
+
+
+
+const AString & cAnvilChunkCodec::GetEntitiesNBT(void)
+{
+	// An unnamed root compound containing just the two tags:
+	m_EntitiesNBT.clear();
+	m_EntitiesNBT.append("\x0a\x00\x00", 3);
+	if (m_EntitiesTag != NULL)
+	{
+		m_EntitiesNBT.append(m_EntitiesTag, m_EntitiesTagLength);
+	}
+	if (m_TileEntitiesTag != NULL)
+	{
+		m_EntitiesNBT.append(m_TileEntitiesTag, m_TileEntitiesTagLength);
+	}
+	m_EntitiesNBT.push_back(TAG_End);
+	return m_EntitiesNBT;
+}
+
+
+
+
+
+cFastNBTWriter & cAnvilChunkCodec::GetEntitiesWriter(void)
+{
+	m_EntitiesWriter.Reset();
+	return m_EntitiesWriter;
+}
+
+
+
+
+
+const AString & cAnvilChunkCodec::Encode(
+	int a_ChunkX, int a_ChunkZ,
+	const BLOCKTYPE * a_BlockTypes, const NIBBLETYPE * a_BlockMetas,
+	const NIBBLETYPE * a_BlockLight, const NIBBLETYPE * a_SkyLight,
+	const unsigned char * a_VanillaBiomes, const cChunkDef::BiomeMap * a_Biomes,
+	bool a_IsLightValid
+)
+{
+	// The entities are the contents of the writer's unnamed root compound, without its header:
+	const AString & EntitiesNBT = m_EntitiesWriter.GetResult();
+	const size_t EntitiesStart = TagHeaderSize("");
+	ASSERT(EntitiesNBT.size() >= EntitiesStart);
+	const size_t EntitiesLength = EntitiesNBT.size() - EntitiesStart;
+
+	const int NumBiomes = cChunkDef::Width * cChunkDef::Width;
+
+	// Calculate the exact size of the output:
+	size_t Size = TagHeaderSize("") + TagHeaderSize("Level");
+	Size += TagHeaderSize("xPos") + 4 + TagHeaderSize("zPos") + 4;
+	Size += EntitiesLength;
+	if (a_Biomes != NULL)
+	{
+		Size += TagHeaderSize("Biomes") + 4 + NumBiomes;
+		Size += TagHeaderSize("MCSBiomes") + 4 + 4 * NumBiomes;
+	}
+	Size += TagHeaderSize("Sections") + 1 + 4;
+	Size += NUM_SECTIONS * (
+		TagHeaderSize("Blocks")     + 4 + SECTION_BLOCK_SIZE +
+		TagHeaderSize("Data")       + 4 + SECTION_NIBBLE_SIZE +
+		TagHeaderSize("SkyLight")   + 4 + SECTION_NIBBLE_SIZE +
+		TagHeaderSize("BlockLight") + 4 + SECTION_NIBBLE_SIZE +
+		TagHeaderSize("Y")          + 1 +
+		1  // TAG_End of the section compound
+	);
+	if (a_IsLightValid)
+	{
+		Size += TagHeaderSize("MCSIsLightValid") + 1;
+	}
+	Size += 2;  // TAG_End of Level and of the root
+
+	// The buffer keeps its capacity, so this only allocates until it has grown to the chunk size:
+	m_Encoded.resize(Size);
+	char * Dst = &m_Encoded[0];
+
+	WriteTagHeader(Dst, TAG_Compound, "");
+	WriteTagHeader(Dst, TAG_Compound, "Level");
+	WriteTagHeader(Dst, TAG_Int, "xPos");
+	WriteInt(Dst, a_ChunkX);
+	WriteTagHeader(Dst, TAG_Int, "zPos");
+	WriteInt(Dst, a_ChunkZ);
+
+	if (EntitiesLength > 0)
+	{
+		memcpy(Dst, EntitiesNBT.data() + EntitiesStart, EntitiesLength);
+		Dst += EntitiesLength;
+	}
+
+	// Save biomes, both MCS (IntArray) and MC-vanilla (ByteArray):
+	if (a_Biomes != NULL)
+	{
+		WriteByteArray(Dst, "Biomes", a_VanillaBiomes, NumBiomes);
+		WriteTagHeader(Dst, TAG_IntArray, "MCSBiomes");
+		WriteInt(Dst, NumBiomes);
+		for (int i = 0; i < NumBiomes; i++)
+		{
+			WriteInt(Dst, (*a_Biomes)[i]);
+		}
+	}
+
+	// Save blockdata:
+	WriteTagHeader(Dst, TAG_List, "Sections");
+	*Dst++ = TAG_Compound;
+	WriteInt(Dst, NUM_SECTIONS);
+	for (int Y = 0; Y < NUM_SECTIONS; Y++)
+	{
+		WriteByteArray(Dst, "Blocks",     a_BlockTypes + Y * SECTION_BLOCK_SIZE,  SECTION_BLOCK_SIZE);
+		WriteByteArray(Dst, "Data",       a_BlockMetas + Y * SECTION_NIBBLE_SIZE, SECTION_NIBBLE_SIZE);
+		WriteByteArray(Dst, "SkyLight",   a_SkyLight   + Y * SECTION_NIBBLE_SIZE, SECTION_NIBBLE_SIZE);
+		WriteByteArray(Dst, "BlockLight", a_BlockLight + Y * SECTION_NIBBLE_SIZE, SECTION_NIBBLE_SIZE);
+		WriteTagHeader(Dst, TAG_Byte, "Y");
+		*Dst++ = (char)Y;
+		*Dst++ = TAG_End;
+	}
+
+	// Store the information that the lighting is valid.
+	// For compatibility reason, the default is "invalid" (missing) - this means older data is re-lighted upon loading.
+	if (a_IsLightValid)
+	{
+		WriteTagHeader(Dst, TAG_Byte, "MCSIsLightValid");
+		*Dst++ = 1;
+	}
+
+	*Dst++ = TAG_End;  // "Level"
+	*Dst++ = TAG_End;  // root
+	ASSERT(Dst == m_Encoded.data() + Size);
+
+	return m_Encoded;
+}
+
+
+
+
@@ -0,0 +1,104 @@
+
+// AnvilChunkCodec.h
+
+// Interfaces to the cAnvilChunkCodec class that converts between the Anvil chunk NBT and the chunk data arrays without building a NBT tree
+
+/*
+The generic NBT parser (cParsedNBT) builds a tag tree for the whole chunk, and the generic writer (cFastNBTWriter)
+appends the data piece by piece into a growing string. For the bulk of the chunk data, the 16 sections with their
+four arrays each, this is wasteful: the structure is always the same and the arrays only need to be copied.
+
+The decoder walks the inflated NBT data once, copying the section arrays straight into the destination buffers
+and remembering where the biomes and the entity lists are. Only the entities and block entities, if there are any,
+are then given to cParsedNBT, because their structure is too varied to be worth special-casing.
+
+The encoder calculates the exact size of the output first, then writes all the tags into a buffer that is kept
+between the calls, so once it has grown to the size of a typical chunk, no more allocations are needed.
+The entities and block entities are serialized by cNBTChunkSerializer into a reusable cFastNBTWriter provided
+by the codec and spliced into the output as-is. The output is byte-for-byte the same as what the generic writer produced.
+
+A codec object is not thread-safe; each storage thread should use its own.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+#include "FastNBT.h"
+
+
+
+
+
+class cAnvilChunkCodec
+{
+public:
+	cAnvilChunkCodec(void);
+
+	/** Decodes the inflated chunk NBT data. The section arrays are copied into the destination buffers
+	(in the MCA-native y/z/x ordering); the parts of the buffers for sections not present in the data are left untouched.
+	Returns false if the data is malformed or isn't an Anvil chunk.
+	The biomes and entities are available through the getters below until the next call; a_Data must stay valid until then, too.
+	*/
+	bool Decode(
+		const char * a_Data, size_t a_Length,
+		BLOCKTYPE * a_BlockTypes, NIBBLETYPE * a_BlockMetas,
+		NIBBLETYPE * a_BlockLight, NIBBLETYPE * a_SkyLight
+	);
+
+	/// Fills in the biomes of the last decoded chunk, MCS-style if available, vanilla-style otherwise. Returns false if neither is present and valid
+	bool GetBiomes(cChunkDef::BiomeMap & a_Biomes) const;
+
+	/// Returns true if the last decoded chunk has the MCS lighting-is-valid marker
+	bool IsLightValid(void) const { return m_IsLightValid; }
+
+	/// Returns true if the last decoded chunk has an Entities or TileEntities tag
+	bool HasEntities(void) const { return (m_EntitiesTag != NULL) || (m_TileEntitiesTag != NULL); }
+
+	/** Returns the NBT document containing only the Entities and TileEntities tags of the last decoded chunk, for parsing with cParsedNBT.
+	The returned string is reused by the next call.
+	*/
+	const AString & GetEntitiesNBT(void);
+
+	/// Returns the writer into which cNBTChunkSerializer should write the entities and block entities for the next Encode() call; the writer is emptied
+	cFastNBTWriter & GetEntitiesWriter(void);
+
+	/** Encodes the chunk into the Anvil NBT format, uncompressed. The entities are taken from the writer returned by GetEntitiesWriter().
+	The arrays are in the MCA-native y/z/x ordering. If a_Biomes is NULL, no biomes are stored.
+	The returned string is reused by the next call.
+	*/
+	const AString & Encode(
+		int a_ChunkX, int a_ChunkZ,
+		const BLOCKTYPE * a_BlockTypes, const NIBBLETYPE * a_BlockMetas,
+		const NIBBLETYPE * a_BlockLight, const NIBBLETYPE * a_SkyLight,
+		const unsigned char * a_VanillaBiomes, const cChunkDef::BiomeMap * a_Biomes,
+		bool a_IsLightValid
+	);
+
+protected:
+
+	// Decoder state, pointing into the data given to Decode():
+	const char * m_VanillaBiomes;    ///< The Biomes byte array's data, or NULL if not present or the wrong size
+	const char * m_MCSBiomes;        ///< The MCSBiomes int array's data, or NULL if not present or the wrong size
+	bool         m_IsLightValid;
+	const char * m_EntitiesTag;      ///< The whole Entities tag, including its type and name; NULL if not present
+	size_t       m_EntitiesTagLength;
+	const char * m_TileEntitiesTag;  ///< The whole TileEntities tag, including its type and name; NULL if not present
+	size_t       m_TileEntitiesTagLength;
+
+	/// The buffer for GetEntitiesNBT()
+	AString m_EntitiesNBT;
+
+	/// The writer for the entities to be encoded
+	cFastNBTWriter m_EntitiesWriter;
+
+	/// The buffer for the encoded data
+	AString m_Encoded;
+} ;
+
+
+
+
@@ -222,6 +222,9 @@ class cFastNBTWriter
 public:
 	cFastNBTWriter(const AString & a_RootTagName = "");
 	
+	/// Discards all the data written so far and starts a new root compound; keeps the allocated buffer for reuse
+	void Reset(const AString & a_RootTagName = "");
+	
 	void BeginCompound(const AString & a_Name);
 	void EndCompound(void);
 	
@@ -48,13 +48,26 @@ void cNBTChunkSerializer::Finish(void)
 	{
 		m_Writer.EndList();
 	}
-	
-	// If light not valid, reset it to all zeroes:
-	if (!m_IsLightValid)
-	{
-		memset(m_BlockLight,    0, sizeof(m_BlockLight));
-		memset(m_BlockSkyLight, 0, sizeof(m_BlockSkyLight));
-	}
+}
+
+
+
+
+
+const NIBBLETYPE * cNBTChunkSerializer::GetBlockLight(void) const
+{
+	static const cChunkDef::BlockNibbles NoLight = {0};
+	return m_IsLightValid ? m_Snapshot.GetBlockLight() : NoLight;
+}
+
+
+
+
+
+const NIBBLETYPE * cNBTChunkSerializer::GetSkyLight(void) const
+{
+	static const cChunkDef::BlockNibbles NoLight = {0};
+	return m_IsLightValid ? m_Snapshot.GetSkyLight() : NoLight;
 }
 
 
@@ -419,25 +432,27 @@ void cNBTChunkSerializer::AddMinecartChestContents(cMinecartWithChest * a_Mineca
 
 
 
-bool cNBTChunkSerializer::LightIsValid(bool a_IsLightValid)
+bool cNBTChunkSerializer::BlockDataSnapshot(const cChunkSnapshot & a_Snapshot)
 {
-	m_IsLightValid = a_IsLightValid;
-	return a_IsLightValid;  // We want lighting only if it's valid, otherwise don't bother
+	m_Snapshot = a_Snapshot;
+	m_IsLightValid = a_Snapshot.IsLightValid();
+	SetBiomes(a_Snapshot.GetBiomeMap());
+	return true;
 }
 
 
 
 
 
-void cNBTChunkSerializer::BiomeData(const cChunkDef::BiomeMap * a_BiomeMap)
+void cNBTChunkSerializer::SetBiomes(const cChunkDef::BiomeMap & a_BiomeMap)
 {
 	memcpy(m_Biomes, a_BiomeMap, sizeof(m_Biomes));
 	for (int i = 0; i < ARRAYCOUNT(m_Biomes); i++)
 	{
-		if ((*a_BiomeMap)[i] < 255)
+		if (a_BiomeMap[i] < 255)
 		{
 			// Normal MC biome, copy as-is:
-			m_VanillaBiomes[i] = (unsigned char)((*a_BiomeMap)[i]);
+			m_VanillaBiomes[i] = (unsigned char)(a_BiomeMap[i]);
 		}
 		else
 		{
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "../ChunkDef.h"
+#include "../ChunkSnapshot.h"
 
 
 
@@ -44,7 +45,7 @@ class cProjectileEntity;
 
 
 class cNBTChunkSerializer :
-	public cChunkDataSeparateCollector
+	public cChunkDataCallback
 {
 public:
 	cChunkDef::BiomeMap m_Biomes;
@@ -58,15 +59,17 @@ public:
 	void Finish(void);
 	
 	bool IsLightValid(void) const {return m_IsLightValid; }
+	
+	// The block data to save, read from the chunk's snapshot; the light is all zeroes if it isn't valid:
+	const BLOCKTYPE *  GetBlockTypes(void) const { return m_Snapshot.GetBlockTypes(); }
+	const NIBBLETYPE * GetBlockMetas(void) const { return m_Snapshot.GetBlockMetas(); }
+	const NIBBLETYPE * GetBlockLight(void) const;
+	const NIBBLETYPE * GetSkyLight  (void) const;
 
 protected:
 	
-	/* From cChunkDataSeparateCollector we inherit:
-	- m_BlockTypes[]
-	- m_BlockMetas[]
-	- m_BlockLight[]
-	- m_BlockSkyLight[]
-	*/
+	/// The chunk's block data; it is read after the world is unlocked, so the saving doesn't need to copy it
+	cChunkSnapshot m_Snapshot;
 	
 	cFastNBTWriter & m_Writer;
 	
@@ -104,9 +107,11 @@ protected:
 	
 	void AddMinecartChestContents(cMinecartWithChest * a_Minecart);
 	
-	// cChunkDataSeparateCollector overrides:
-	virtual bool LightIsValid(bool a_IsLightValid) override;
-	virtual void BiomeData(const cChunkDef::BiomeMap * a_BiomeMap) override;
+	/// Converts the biomes into m_Biomes[] and m_VanillaBiomes[]
+	void SetBiomes(const cChunkDef::BiomeMap & a_BiomeMap);
+	
+	// cChunkDataCallback overrides:
+	virtual bool BlockDataSnapshot(const cChunkSnapshot & a_Snapshot) override;
 	virtual void Entity(cEntity * a_Entity) override;
 	virtual void BlockEntity(cBlockEntity * a_Entity) override;
 } ;  // class cNBTChunkSerializer
@@ -0,0 +1,366 @@
+
+// StorageBenchmark.cpp
+
+// Implements the cStorageBenchmark class that measures the chunk loading and saving performance of the storage schemas
+
+#include "Globals.h"
+#include "StorageBenchmark.h"
+#include "WSSAnvil.h"
+#include "WSSCompact.h"
+#include "WSSLog.h"
+#include "../World.h"
+#include "../ChunkMap.h"
+#include "../Noise.h"
+#include "../BlockEntities/ChestEntity.h"
+#include "../../iniFile/iniFile.h"
+
+#ifndef _WIN32
+	#include <unistd.h>
+#endif
+
+
+
+
+
+/// Coords of the first benchmark chunk; far away from the spawn, so that the benchmark doesn't touch any real chunks
+static const int BENCHMARK_CHUNK_X = 100000;
+static const int BENCHMARK_CHUNK_Z = 100000;
+
+/// Seed for the synthetic chunks, so that they are the same in each run
+static const int BENCHMARK_SEED = 1234;
+
+
+
+
+
+/// Deletes the folder with all its contents; returns true if successful
+static bool DeleteFolderRecursive(const AString & a_Folder)
+{
+	bool res = true;
+	AStringList Contents = GetDirectoryContents((a_Folder + "/").c_str());
+	for (AStringList::const_iterator itr = Contents.begin(), end = Contents.end(); itr != end; ++itr)
+	{
+		if ((*itr == ".") || (*itr == ".."))
+		{
+			continue;
+		}
+		AString Path = a_Folder + "/" + *itr;
+		if (cFile::IsFolder(Path))
+		{
+			res = DeleteFolderRecursive(Path) && res;
+		}
+		else
+		{
+			res = cFile::Delete(Path) && res;
+		}
+	}
+	#ifdef _WIN32
+		return (RemoveDirectory(a_Folder.c_str()) != 0) && res;
+	#else
+		return (rmdir(a_Folder.c_str()) == 0) && res;
+	#endif
+}
+
+
+
+
+
+cStorageBenchmark::cStorageBenchmark(cWorld & a_World) :
+	m_World(a_World),
+	m_Folder(a_World.GetName() + "_storagebench")
+{
+}
+
+
+
+
+
+cStorageBenchmark::~cStorageBenchmark()
+{
+	RemoveSchemas();
+}
+
+
+
+
+
+void cStorageBenchmark::Run(int a_Size, int a_Repeats)
+{
+	LOG("Running the storage benchmark in world %s: %d chunks, %d repeats...",
+		m_World.GetName().c_str(), a_Size * a_Size, a_Repeats
+	);
+
+	InitSchemas();
+	
+	// Keep the chunks in memory for the whole benchmark, the world would unload them otherwise.
+	// The stay only creates the (invalid) chunks, it doesn't queue them for loading or generating;
+	// the synthetic data is set into them before anything else can touch them:
+	cChunkStay Stay(&m_World);
+	for (int z = 0; z < a_Size; z++) for (int x = 0; x < a_Size; x++)
+	{
+		m_Chunks.push_back(cChunkCoords(BENCHMARK_CHUNK_X + x, ZERO_CHUNK_Y, BENCHMARK_CHUNK_Z + z));
+		Stay.Add(BENCHMARK_CHUNK_X + x, ZERO_CHUNK_Y, BENCHMARK_CHUNK_Z + z);
+	}
+	Stay.Enable();
+	for (cChunkCoordsList::const_iterator itr = m_Chunks.begin(), end = m_Chunks.end(); itr != end; ++itr)
+	{
+		SetSyntheticChunk(itr->m_ChunkX, itr->m_ChunkZ);
+	}
+
+	sStatsArray SaveStats(m_Schemas.size());
+	sStatsArray LoadStats(m_Schemas.size());
+	for (int Repeat = 0; Repeat < a_Repeats; Repeat++)
+	{
+		// Reset the chunks, in case anything changed them in the meantime:
+		if (Repeat > 0)
+		{
+			for (cChunkCoordsList::const_iterator itr = m_Chunks.begin(), end = m_Chunks.end(); itr != end; ++itr)
+			{
+				SetSyntheticChunk(itr->m_ChunkX, itr->m_ChunkZ);
+			}
+		}
+
+		int Idx = 0;
+		for (cWSSchemaList::const_iterator itr = m_Schemas.begin(), end = m_Schemas.end(); itr != end; ++itr, ++Idx)
+		{
+			SaveStats[Idx].m_Name = (*itr)->GetName() + " save";
+			MeasureSave(**itr, SaveStats[Idx]);
+		}
+		Idx = 0;
+		for (cWSSchemaList::const_iterator itr = m_Schemas.begin(), end = m_Schemas.end(); itr != end; ++itr, ++Idx)
+		{
+			LoadStats[Idx].m_Name = (*itr)->GetName() + " load";
+			MeasureLoad(**itr, LoadStats[Idx]);
+		}
+	}  // for Repeat
+
+	// Remove all traces of the synthetic chunks from the disk, and don't let the world save them either:
+	RemoveSchemas();
+	DiscardChunks();
+
+	LOG("Storage benchmark results in world %s (time per chunk):", m_World.GetName().c_str());
+	for (size_t i = 0; i < SaveStats.size(); i++)
+	{
+		LogStats(SaveStats[i]);
+		LogStats(LoadStats[i]);
+	}
+}
+
+
+
+
+
+void cStorageBenchmark::InitSchemas(void)
+{
+	// Start from an empty folder, in case a previous run didn't get to clean up:
+	if (cFile::IsFolder(FILE_IO_PREFIX + m_Folder))
+	{
+		DeleteFolderRecursive(FILE_IO_PREFIX + m_Folder);
+	}
+	cFile::CreateFolder(FILE_IO_PREFIX + m_Folder);
+	
+	// The same schemas that the world storage uses, with the default settings:
+	cIniFile IniFile;
+	m_Schemas.push_back(new cWSSAnvil  (&m_World, m_Folder, m_WarmCache));
+	m_Schemas.push_back(new cWSSCompact(&m_World, m_Folder));
+	m_Schemas.push_back(new cWSSLog    (&m_World, m_Folder, m_WarmCache, IniFile));
+}
+
+
+
+
+
+void cStorageBenchmark::RemoveSchemas(void)
+{
+	if (m_Schemas.empty())
+	{
+		return;
+	}
+	
+	// The schemas keep their files open, delete them before the files:
+	for (cWSSchemaList::iterator itr = m_Schemas.begin(), end = m_Schemas.end(); itr != end; ++itr)
+	{
+		delete *itr;
+	}
+	m_Schemas.clear();
+	
+	if (!DeleteFolderRecursive(FILE_IO_PREFIX + m_Folder))
+	{
+		LOGWARNING("Storage benchmark: cannot delete the scratch folder \"%s\", please delete it manually", m_Folder.c_str());
+	}
+}
+
+
+
+
+
+void cStorageBenchmark::DiscardChunks(void)
+{
+	// This runs in the storage thread, so none of the chunks can be in the middle of saving
+	for (cChunkCoordsList::const_iterator itr = m_Chunks.begin(), end = m_Chunks.end(); itr != end; ++itr)
+	{
+		m_World.MarkChunkSaving(itr->m_ChunkX, itr->m_ChunkZ);
+		m_World.MarkChunkSaved(itr->m_ChunkX, itr->m_ChunkZ);
+		m_World.GetStorage().UnqueueSave(*itr);
+	}
+}
+
+
+
+
+
+void cStorageBenchmark::SetSyntheticChunk(int a_ChunkX, int a_ChunkZ)
+{
+	cChunkDef::BlockTypes   BlockTypes;
+	cChunkDef::BlockNibbles BlockMetas;
+	cChunkDef::BlockNibbles BlockLight;
+	cChunkDef::BlockNibbles SkyLight;
+	cChunkDef::BiomeMap     Biomes;
+	memset(BlockTypes, E_BLOCK_AIR, sizeof(BlockTypes));
+	memset(BlockMetas, 0,           sizeof(BlockMetas));
+	memset(BlockLight, 0,           sizeof(BlockLight));
+	memset(SkyLight,   0,           sizeof(SkyLight));
+
+	// Rolling terrain: bedrock, stone with ores, dirt, grass, some tall grass on top, skylight above the terrain
+	cNoise Noise(BENCHMARK_SEED);
+	int BaseX = a_ChunkX * cChunkDef::Width;
+	int BaseZ = a_ChunkZ * cChunkDef::Width;
+	int ChestHeight = 0;
+	for (int z = 0; z < cChunkDef::Width; z++) for (int x = 0; x < cChunkDef::Width; x++)
+	{
+		int BlockX = BaseX + x;
+		int BlockZ = BaseZ + z;
+		int Height = 62 + (int)(6 * sin(BlockX / 11.0) + 6 * cos(BlockZ / 13.0));
+		cChunkDef::SetBlock(BlockTypes, x, 0, z, E_BLOCK_BEDROCK);
+		for (int y = 1; y < Height - 3; y++)
+		{
+			int Rnd = Noise.IntNoise3DInt(BlockX, y, BlockZ) % 100;
+			cChunkDef::SetBlock(BlockTypes, x, y, z, (Rnd < 2) ? E_BLOCK_COAL_ORE : ((Rnd < 3) ? E_BLOCK_IRON_ORE : E_BLOCK_STONE));
+		}
+		for (int y = Height - 3; y < Height; y++)
+		{
+			cChunkDef::SetBlock(BlockTypes, x, y, z, E_BLOCK_DIRT);
+		}
+		cChunkDef::SetBlock(BlockTypes, x, Height, z, E_BLOCK_GRASS);
+		if ((x == 8) && (z == 8))
+		{
+			ChestHeight = Height + 1;
+			cChunkDef::SetBlock(BlockTypes, x, ChestHeight, z, E_BLOCK_CHEST);
+			cChunkDef::SetNibble(BlockMetas, x, ChestHeight, z, E_META_CHEST_FACING_ZM);
+		}
+		else if (Noise.IntNoise2DInt(BlockX, BlockZ) % 8 == 0)
+		{
+			cChunkDef::SetBlock(BlockTypes, x, Height + 1, z, E_BLOCK_TALL_GRASS);
+			cChunkDef::SetNibble(BlockMetas, x, Height + 1, z, E_META_TALL_GRASS_GRASS);
+		}
+		for (int y = Height + 1; y < cChunkDef::Height; y++)
+		{
+			cChunkDef::SetNibble(SkyLight, x, y, z, 15);
+		}
+		cChunkDef::SetBiome(Biomes, x, z, ((BlockX / 64 + BlockZ / 64) % 2 == 0) ? biPlains : biForest);
+	}  // for z, x
+
+	// A chest with some items, to have the block entities stored, too:
+	cChestEntity * Chest = new cChestEntity(BaseX + 8, ChestHeight, BaseZ + 8, &m_World);
+	Chest->SetSlot(0, cItem(E_BLOCK_PLANKS, 64));
+	Chest->SetSlot(1, cItem(E_ITEM_COAL, 32));
+	Chest->SetSlot(2, cItem(E_ITEM_IRON_PICKAXE, 1, 100));
+	Chest->SetSlot(3, cItem(E_ITEM_BREAD, 16));
+	Chest->SetSlot(4, cItem(E_ITEM_DIAMOND, 3));
+	cEntityList Entities;
+	cBlockEntityList BlockEntities;
+	BlockEntities.push_back(Chest);
+
+	m_World.SetChunkData(
+		a_ChunkX, a_ChunkZ,
+		BlockTypes, BlockMetas, BlockLight, SkyLight,
+		NULL, &Biomes,
+		Entities, BlockEntities,
+		false
+	);
+}
+
+
+
+
+
+void cStorageBenchmark::MeasureSave(cWSSchema & a_Schema, sStats & a_Stats)
+{
+	a_Schema.ResetPhaseTimes();
+	for (cChunkCoordsList::const_iterator itr = m_Chunks.begin(), end = m_Chunks.end(); itr != end; ++itr)
+	{
+		Int64 Start = m_Timer.GetNowTimeUSec();
+		bool IsSaved = a_Schema.SaveChunk(*itr);
+		Int64 End = m_Timer.GetNowTimeUSec();
+		if (IsSaved)
+		{
+			a_Stats.m_Latencies.push_back((int)(End - Start));
+		}
+		else
+		{
+			a_Stats.m_NumFailed += 1;
+		}
+	}
+	a_Stats.m_PhaseTimes.Add(a_Schema.GetPhaseTimes());
+}
+
+
+
+
+
+void cStorageBenchmark::MeasureLoad(cWSSchema & a_Schema, sStats & a_Stats)
+{
+	a_Schema.ResetPhaseTimes();
+	for (cChunkCoordsList::const_iterator itr = m_Chunks.begin(), end = m_Chunks.end(); itr != end; ++itr)
+	{
+		// Make the schema read the data from its files:
+		m_WarmCache.Remove(itr->m_ChunkX, itr->m_ChunkZ);
+
+		Int64 Start = m_Timer.GetNowTimeUSec();
+		bool IsLoaded = a_Schema.LoadChunk(*itr);
+		Int64 End = m_Timer.GetNowTimeUSec();
+		if (IsLoaded)
+		{
+			a_Stats.m_Latencies.push_back((int)(End - Start));
+		}
+		else
+		{
+			a_Stats.m_NumFailed += 1;
+		}
+	}
+	a_Stats.m_PhaseTimes.Add(a_Schema.GetPhaseTimes());
+}
+
+
+
+
+
+void cStorageBenchmark::LogStats(sStats & a_Stats)
+{
+	std::vector<int> & Latencies = a_Stats.m_Latencies;
+	if (Latencies.empty())
+	{
+		LOG("  %s: no chunk succeeded (%d failed)", a_Stats.m_Name.c_str(), a_Stats.m_NumFailed);
+		return;
+	}
+
+	std::sort(Latencies.begin(), Latencies.end());
+	Int64 Total = 0;
+	for (std::vector<int>::const_iterator itr = Latencies.begin(), end = Latencies.end(); itr != end; ++itr)
+	{
+		Total += *itr;
+	}
+	int Count = (int)Latencies.size();
+	const sStoragePhaseTimes & Phases = a_Stats.m_PhaseTimes;
+	LOG("  %s: %.0f chunks/sec; latency p50 %d, p90 %d, p99 %d, max %d usec; file %d, compression %d, codec %d, world %d usec; %d failed",
+		a_Stats.m_Name.c_str(),
+		(Total > 0) ? (double)Count * 1000000 / Total : 0.0,
+		Latencies[Count / 2], Latencies[Count * 9 / 10], Latencies[Count * 99 / 100], Latencies[Count - 1],
+		(int)(Phases.m_FileIO / Count), (int)(Phases.m_Compression / Count), (int)(Phases.m_Codec / Count), (int)(Phases.m_World / Count),
+		a_Stats.m_NumFailed
+	);
+}
+
+
+
+
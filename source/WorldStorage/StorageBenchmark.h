@@ -0,0 +1,96 @@
+
+// StorageBenchmark.h
+
+// Interfaces to the cStorageBenchmark class that measures the chunk loading and saving performance of the storage schemas
+
+/*
+The benchmark is started by the "storagebench" console command and runs in the world's storage thread, so that
+there is no other storage work in between.
+
+A square of synthetic chunks (terrain with ores, a chest with items in each chunk) is put into the world far away
+from the spawn. Then, in each repeat, each schema saves all the chunks and then loads them all back. The schemas
+are separate instances of the world's schemas, with their own warm cache, that keep their files in a scratch
+folder next to the world's folder ("<world>_storagebench"); the folder is deleted when the benchmark finishes,
+so neither the world's files nor its warm cache ever see the synthetic chunks. The chunks are removed from
+the benchmark's warm cache before loading, so that the loads read the storage files; the files are likely
+in the OS cache, though. For each schema and operation, the throughput and the latency percentiles are logged,
+together with the time per chunk spent in each phase (file I/O, compression, format encoding or decoding,
+copying from or into the world) as reported by the schema.
+
+The synthetic chunks are only kept in the world's memory, with a cChunkStay; the stay doesn't queue them for
+loading or generating. After the benchmark, the chunks are marked as saved and taken out of the world storage's
+save queue, so the world unloads them without saving them. Since the chunks are synthetic and always the same, the results are comparable between runs.
+*/
+
+
+
+
+
+#pragma once
+
+#include "WorldStorage.h"
+
+
+
+
+
+class cStorageBenchmark
+{
+public:
+	cStorageBenchmark(cWorld & a_World);
+	~cStorageBenchmark();
+
+	/// Runs the benchmark on a_Size x a_Size chunks, a_Repeats times, and logs the results
+	void Run(int a_Size, int a_Repeats);
+
+protected:
+
+	/// The measurements of one operation (load or save) in one schema
+	struct sStats
+	{
+		AString            m_Name;
+		std::vector<int>   m_Latencies;  ///< Time of each successful operation, in usec
+		sStoragePhaseTimes m_PhaseTimes;
+		int                m_NumFailed;
+
+		sStats(void) : m_NumFailed(0) {}
+	} ;
+
+	typedef std::vector<sStats> sStatsArray;
+
+	cWorld &        m_World;
+	AString         m_Folder;     ///< The scratch folder where the schemas keep their files
+	cWarmChunkCache m_WarmCache;  ///< The schemas' own warm cache, so that the world's one isn't polluted with the synthetic chunks
+	cWSSchemaList   m_Schemas;    ///< The schemas being measured, owned by this object
+	cTimer          m_Timer;
+
+	/// The chunks used for the benchmark
+	cChunkCoordsList m_Chunks;
+
+	/// Creates the schemas, storing their files in m_Folder
+	void InitSchemas(void);
+	
+	/// Deletes the schemas and the whole m_Folder, with all the files they have written
+	void RemoveSchemas(void);
+	
+	/** Marks the chunks as saved and removes them from the world storage's save queue, so that the world doesn't save them.
+	The chunks get dirty while the benchmark sets them up and loads them, by setting the chest items.
+	*/
+	void DiscardChunks(void);
+	
+	/// Sets the synthetic data for the specified chunk into the world
+	void SetSyntheticChunk(int a_ChunkX, int a_ChunkZ);
+
+	/// Saves all the chunks through the schema, adding the measurements to a_Stats
+	void MeasureSave(cWSSchema & a_Schema, sStats & a_Stats);
+
+	/// Loads all the chunks through the schema, adding the measurements to a_Stats
+	void MeasureLoad(cWSSchema & a_Schema, sStats & a_Stats);
+
+	/// Logs the summary of the measurements
+	void LogStats(sStats & a_Stats);
+} ;
+
+
+
+
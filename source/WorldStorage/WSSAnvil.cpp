@@ -5,6 +5,7 @@
 
 #include "Globals.h"
 #include "WSSAnvil.h"
+#include "WarmChunkCache.h"
 #include "NBTChunkSerializer.h"
 #include "../World.h"
 #include "zlib.h"
@@ -53,12 +54,14 @@ Since only the header is actually in the memory, this number can be high, but st
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cWSSAnvil:
 
-cWSSAnvil::cWSSAnvil(cWorld * a_World) :
-	super(a_World)
+cWSSAnvil::cWSSAnvil(cWorld * a_World, const AString & a_StorageFolder, cWarmChunkCache & a_WarmCache) :
+	super(a_World, a_StorageFolder),
+	m_CS("Storage region files"),
+	m_WarmCache(a_WarmCache)
 {
 	// Create a level.dat file for mapping tools, if it doesn't already exist:
 	AString fnam;
-	Printf(fnam, "%s/level.dat", a_World->GetName().c_str());
+	Printf(fnam, "%s/level.dat", m_StorageFolder.c_str());
 	if (!cFile::Exists(fnam))
 	{
 		cFastNBTWriter Writer;
@@ -102,12 +105,14 @@ cWSSAnvil::~cWSSAnvil()
 
 bool cWSSAnvil::LoadChunk(const cChunkCoords & a_Chunk)
 {
+	cStoragePhaseTimer Timer;
 	AString ChunkData;
 	if (!GetChunkData(a_Chunk, ChunkData))
 	{
 		// The reason for failure is already printed in GetChunkData()
 		return false;
 	}
+	Timer.Lap(m_PhaseTimes.m_FileIO);
 	
 	return LoadChunkFromData(a_Chunk, ChunkData);
 }
@@ -124,11 +129,13 @@ bool cWSSAnvil::SaveChunk(const cChunkCoords & a_Chunk)
 		LOGWARNING("Cannot serialize chunk [%d, %d] into data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
 	}
+	cStoragePhaseTimer Timer;
 	if (!SetChunkData(a_Chunk, ChunkData))
 	{
 		LOGWARNING("Cannot store chunk [%d, %d] data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
 	}
+	Timer.Lap(m_PhaseTimes.m_FileIO);
 	
 	// Everything successful
 	return true;
@@ -140,13 +147,19 @@ bool cWSSAnvil::SaveChunk(const cChunkCoords & a_Chunk)
 
 bool cWSSAnvil::GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data)
 {
+	if (m_WarmCache.Get(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, a_Data))
+	{
+		return true;
+	}
+	
 	cCSLock Lock(m_CS);
 	cMCAFile * File = LoadMCAFile(a_Chunk);
-	if (File == NULL)
+	if ((File == NULL) || !File->GetChunkData(a_Chunk, a_Data))
 	{
 		return false;
 	}
-	return File->GetChunkData(a_Chunk, a_Data);
+	m_WarmCache.Set(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, a_Data);
+	return true;
 }
 
 
@@ -157,11 +170,14 @@ bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Dat
 {
 	cCSLock Lock(m_CS);
 	cMCAFile * File = LoadMCAFile(a_Chunk);
-	if (File == NULL)
+	if ((File == NULL) || !File->SetChunkData(a_Chunk, a_Data))
 	{
+		// The cache mustn't hold data that isn't on the disk:
+		m_WarmCache.Remove(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
 	}
-	return File->SetChunkData(a_Chunk, a_Data);
+	m_WarmCache.Set(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, a_Data);
+	return true;
 }
 
 
@@ -198,7 +214,7 @@ cWSSAnvil::cMCAFile * cWSSAnvil::LoadMCAFile(const cChunkCoords & a_Chunk)
 	
 	// Load it anew:
 	AString FileName;
-	Printf(FileName, "%s/region", m_World->GetName().c_str());
+	Printf(FileName, "%s/region", m_StorageFolder.c_str());
 	cFile::CreateFolder(FILE_IO_PREFIX + FileName);
 	AppendPrintf(FileName, "/r.%d.%d.mca", RegionX, RegionZ);
 	cMCAFile * f = new cMCAFile(FileName, RegionX, RegionZ);
@@ -223,6 +239,8 @@ cWSSAnvil::cMCAFile * cWSSAnvil::LoadMCAFile(const cChunkCoords & a_Chunk)
 
 bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const AString & a_Data)
 {
+	cStoragePhaseTimer Timer;
+	
 	// Decompress the data:
 	char Uncompressed[CHUNK_INFLATE_MAX];
 	z_stream strm;
@@ -240,43 +258,8 @@ bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const AString &
 	{
 		return false;
 	}
+	Timer.Lap(m_PhaseTimes.m_Compression);
 	
-	// Parse the NBT data:
-	cParsedNBT NBT(Uncompressed, strm.total_out);
-	if (!NBT.IsValid())
-	{
-		// NBT Parsing failed
-		return false;
-	}
-
-	// Load the data from NBT:
-	return LoadChunkFromNBT(a_Chunk, NBT);
-}
-
-
-
-
-
-bool cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk, AString & a_Data)
-{
-	cFastNBTWriter Writer;
-	if (!SaveChunkToNBT(a_Chunk, Writer))
-	{
-		LOGWARNING("Cannot save chunk [%d, %d] to NBT", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
-		return false;
-	}
-	Writer.Finish();
-	
-	CompressString(Writer.GetResult().data(), Writer.GetResult().size(), a_Data);
-	return true;
-}
-
-
-
-
-
-bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT)
-{
 	// The data arrays, in MCA-native y/z/x ordering (will be reordered for the final chunk data)
 	cChunkDef::BlockTypes   BlockTypes;
 	cChunkDef::BlockNibbles MetaData;
@@ -288,52 +271,34 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 	memset(SkyLight,   0xff,        sizeof(SkyLight));  // By default, data not present in the NBT means air, which means full skylight
 	memset(BlockLight, 0x00,        sizeof(BlockLight));
 	
-	// Load the blockdata, blocklight and skylight:
-	int Level = a_NBT.FindChildByName(0, "Level");
-	if (Level < 0)
+	// Load the blockdata, blocklight and skylight straight from the NBT data:
+	if (!m_Codec.Decode(Uncompressed, strm.total_out, BlockTypes, MetaData, BlockLight, SkyLight))
 	{
 		return false;
 	}
-	int Sections = a_NBT.FindChildByName(Level, "Sections");
-	if ((Sections < 0) || (a_NBT.GetType(Sections) != TAG_List) || (a_NBT.GetChildrenType(Sections) != TAG_Compound))
-	{
-		return false;
-	}
-	for (int Child = a_NBT.GetFirstChild(Sections); Child >= 0; Child = a_NBT.GetNextSibling(Child))
-	{
-		int y = 0;
-		int SectionY = a_NBT.FindChildByName(Child, "Y");
-		if ((SectionY < 0) || (a_NBT.GetType(SectionY) != TAG_Byte))
-		{
-			continue;
-		}
-		y = a_NBT.GetByte(SectionY);
-		if ((y < 0) || (y > 15))
-		{
-			continue;
-		}
-		CopyNBTData(a_NBT, Child, "Blocks",     (char *)&(BlockTypes[y * 4096]), 4096);
-		CopyNBTData(a_NBT, Child, "Data",       (char *)&(MetaData[y   * 2048]), 2048);
-		CopyNBTData(a_NBT, Child, "SkyLight",   (char *)&(SkyLight[y   * 2048]), 2048);
-		CopyNBTData(a_NBT, Child, "BlockLight", (char *)&(BlockLight[y * 2048]), 2048);
-	}  // for itr - LevelSections[]
 	
-	// Load the biomes from NBT, if present and valid. First try MCS-style, then Vanilla-style:
+	// Load the biomes, if present and valid:
 	cChunkDef::BiomeMap BiomeMap;
-	cChunkDef::BiomeMap * Biomes = LoadBiomeMapFromNBT(&BiomeMap, a_NBT, a_NBT.FindChildByName(Level, "MCSBiomes"));
-	if (Biomes == NULL)
-	{
-		// MCS-style biomes not available, load vanilla-style:
-		Biomes = LoadVanillaBiomeMapFromNBT(&BiomeMap, a_NBT, a_NBT.FindChildByName(Level, "Biomes"));
-	}
+	cChunkDef::BiomeMap * Biomes = m_Codec.GetBiomes(BiomeMap) ? &BiomeMap : NULL;
 	
-	// Load the entities from NBT:
+	// Load the entities; only these need the generic NBT parser:
 	cEntityList      Entities;
 	cBlockEntityList BlockEntities;
-	LoadEntitiesFromNBT     (Entities,      a_NBT, a_NBT.FindChildByName(Level, "Entities"));
-	LoadBlockEntitiesFromNBT(BlockEntities, a_NBT, a_NBT.FindChildByName(Level, "TileEntities"), BlockTypes, MetaData);
+	if (m_Codec.HasEntities())
+	{
+		const AString & EntitiesData = m_Codec.GetEntitiesNBT();
+		cParsedNBT NBT(EntitiesData.data(), EntitiesData.size());
+		if (!NBT.IsValid())
+		{
+			// NBT Parsing failed
+			return false;
+		}
+		LoadEntitiesFromNBT     (Entities,      NBT, NBT.FindChildByName(0, "Entities"));
+		LoadBlockEntitiesFromNBT(BlockEntities, NBT, NBT.FindChildByName(0, "TileEntities"), BlockTypes, MetaData);
+	}
 	
-	bool IsLightValid = (a_NBT.FindChildByName(Level, "MCSIsLightValid") > 0);
+	bool IsLightValid = m_Codec.IsLightValid();
+	Timer.Lap(m_PhaseTimes.m_Codec);
 	
 	/*
 	// Uncomment this block for really cool stuff :)
@@ -379,77 +344,44 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 		Entities, BlockEntities,
 		false
 	);
+	Timer.Lap(m_PhaseTimes.m_World);
 	return true;
 }
 
 
 
 
-void cWSSAnvil::CopyNBTData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, char * a_Destination, int a_Length)
-{
-	int Child = a_NBT.FindChildByName(a_Tag, a_ChildName);
-	if ((Child >= 0) && (a_NBT.GetType(Child) == TAG_ByteArray) && (a_NBT.GetDataLength(Child) == a_Length))
-	{
-		memcpy(a_Destination, a_NBT.GetData(Child), a_Length);
-	}
-}
 
-
-
-
-
-bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_Writer)
+bool cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk, AString & a_Data)
 {
-	a_Writer.BeginCompound("Level");
-	a_Writer.AddInt("xPos", a_Chunk.m_ChunkX);
-	a_Writer.AddInt("zPos", a_Chunk.m_ChunkZ);
-	cNBTChunkSerializer Serializer(a_Writer);
+	cStoragePhaseTimer Timer;
+	
+	// The entities and block entities are serialized by the generic NBT writer, the codec writes the rest directly:
+	cNBTChunkSerializer Serializer(m_Codec.GetEntitiesWriter());
 	if (!m_World->GetChunkData(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Serializer))
 	{
 		LOGWARNING("Cannot get chunk [%d, %d] data for NBT saving", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
 	}
 	Serializer.Finish();  // Close NBT tags
+	Timer.Lap(m_PhaseTimes.m_World);
 	
-	// Save biomes, both MCS (IntArray) and MC-vanilla (ByteArray):
-	if (Serializer.m_BiomesAreValid)
-	{
-		a_Writer.AddByteArray("Biomes",    (const char *)(Serializer.m_VanillaBiomes), ARRAYCOUNT(Serializer.m_VanillaBiomes));
-		a_Writer.AddIntArray ("MCSBiomes", (const int *)(Serializer.m_Biomes),         ARRAYCOUNT(Serializer.m_Biomes));
-	}
-	
-	// Save blockdata:
-	a_Writer.BeginList("Sections", TAG_Compound);
-	int SliceSizeBlock  = cChunkDef::Width * cChunkDef::Width * 16;
-	int SliceSizeNibble = SliceSizeBlock / 2;
-	const char * BlockTypes    = (const char *)(Serializer.m_BlockTypes);
-	const char * BlockMetas    = (const char *)(Serializer.m_BlockMetas);
 	#ifdef DEBUG_SKYLIGHT
-		const char * BlockLight  = (const char *)(Serializer.m_BlockSkyLight);
+		const NIBBLETYPE * BlockLight = Serializer.GetSkyLight();
 	#else
-		const char * BlockLight  = (const char *)(Serializer.m_BlockLight);
-	#endif 
-	const char * BlockSkyLight = (const char *)(Serializer.m_BlockSkyLight);
-	for (int Y = 0; Y < 16; Y++)
-	{
-		a_Writer.BeginCompound("");
-		a_Writer.AddByteArray("Blocks",     BlockTypes    + Y * SliceSizeBlock,  SliceSizeBlock);
-		a_Writer.AddByteArray("Data",       BlockMetas    + Y * SliceSizeNibble, SliceSizeNibble);
-		a_Writer.AddByteArray("SkyLight",   BlockSkyLight + Y * SliceSizeNibble, SliceSizeNibble);
-		a_Writer.AddByteArray("BlockLight", BlockLight    + Y * SliceSizeNibble, SliceSizeNibble);
-		a_Writer.AddByte("Y", (unsigned char)Y);
-		a_Writer.EndCompound();
-	}
-	a_Writer.EndList();  // "Sections"
-	
-	// Store the information that the lighting is valid. 
-	// For compatibility reason, the default is "invalid" (missing) - this means older data is re-lighted upon loading.
-	if (Serializer.IsLightValid())
-	{
-		a_Writer.AddByte("MCSIsLightValid", 1);
-	}
+		const NIBBLETYPE * BlockLight = Serializer.GetBlockLight();
+	#endif
+	const AString & NBT = m_Codec.Encode(
+		a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ,
+		Serializer.GetBlockTypes(), Serializer.GetBlockMetas(),
+		BlockLight, Serializer.GetSkyLight(),
+		Serializer.m_VanillaBiomes, Serializer.m_BiomesAreValid ? &Serializer.m_Biomes : NULL,
+		Serializer.IsLightValid()
+	);
+	Timer.Lap(m_PhaseTimes.m_Codec);
 	
-	a_Writer.EndCompound();  // "Level"
+	CompressString(NBT.data(), NBT.size(), a_Data);
+	Timer.Lap(m_PhaseTimes.m_Compression);
 	return true;
 }
 
@@ -457,62 +389,6 @@ bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_
 
 
 
-cChunkDef::BiomeMap * cWSSAnvil::LoadVanillaBiomeMapFromNBT(cChunkDef::BiomeMap * a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx)
-{
-	if ((a_TagIdx < 0) || (a_NBT.GetType(a_TagIdx) != TAG_ByteArray))
-	{
-		return NULL;
-	}
-	if (a_NBT.GetDataLength(a_TagIdx) != 16 * 16)
-	{
-		// The biomes stored don't match in size
-		return NULL;
-	}
-	const unsigned char * VanillaBiomeData = (const unsigned char *)(a_NBT.GetData(a_TagIdx));
-	for (int i = 0; i < ARRAYCOUNT(*a_BiomeMap); i++)
-	{
-		if ((VanillaBiomeData)[i] == 0xff)
-		{
-			// Unassigned biomes
-			return NULL;
-		}
-		(*a_BiomeMap)[i] = (EMCSBiome)(VanillaBiomeData[i]);
-	}
-	return a_BiomeMap;
-}
-
-
-
-
-
-cChunkDef::BiomeMap * cWSSAnvil::LoadBiomeMapFromNBT(cChunkDef::BiomeMap * a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx)
-{
-	if ((a_TagIdx < 0) || (a_NBT.GetType(a_TagIdx) != TAG_IntArray))
-	{
-		return NULL;
-	}
-	if (a_NBT.GetDataLength(a_TagIdx) != sizeof(*a_BiomeMap))
-	{
-		// The biomes stored don't match in size
-		return NULL;
-	}
-	const int * BiomeData = (const int *)(a_NBT.GetData(a_TagIdx));
-	for (int i = 0; i < ARRAYCOUNT(*a_BiomeMap); i++)
-	{
-		(*a_BiomeMap)[i] = (EMCSBiome)(ntohl(BiomeData[i]));
-		if ((*a_BiomeMap)[i] == 0xff)
-		{
-			// Unassigned biomes
-			return NULL;
-		}
-	}
-	return a_BiomeMap;
-}
-
-
-
-
-
 void cWSSAnvil::LoadEntitiesFromNBT(cEntityList & a_Entities, const cParsedNBT & a_NBT, int a_TagIdx)
 {
 	if ((a_TagIdx < 0) || (a_NBT.GetType(a_TagIdx) != TAG_List))
@@ -1433,6 +1309,11 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, AString & a
 	}
 	unsigned ChunkLocation = ntohl(m_Header[LocalX + 32 * LocalZ]);
 	unsigned ChunkOffset = ChunkLocation >> 8;
+	if (ChunkOffset < 2)
+	{
+		// The chunk isn't stored in the file (the first two sectors are the header)
+		return false;
+	}
 	
 	m_File.Seek(ChunkOffset * 4096);
 	
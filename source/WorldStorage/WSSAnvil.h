@@ -10,6 +10,7 @@
 
 #include "WorldStorage.h"
 #include "FastNBT.h"
+#include "AnvilChunkCodec.h"
 
 
 
@@ -18,6 +19,8 @@
 // fwd: ItemGrid.h
 class cItemGrid;
 
+class cWarmChunkCache;
+
 class cProjectileEntity;
 
 
@@ -47,7 +50,7 @@ class cWSSAnvil :
 	
 public:
 
-	cWSSAnvil(cWorld * a_World);
+	cWSSAnvil(cWorld * a_World, const AString & a_StorageFolder, cWarmChunkCache & a_WarmCache);
 	virtual ~cWSSAnvil();
 	
 protected:
@@ -89,31 +92,25 @@ protected:
 	
 	cCriticalSection m_CS;
 	cMCAFiles        m_Files;  // a MRU cache of MCA files
+	
+	/// Compressed data of recently used chunks, consulted before reading the MCA files
+	cWarmChunkCache & m_WarmCache;
 
-	/// Gets chunk data from the correct file; locks file CS as needed
+	/// Gets chunk data from the warm cache or the correct file; locks file CS as needed
 	bool GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data);
 
-	/// Sets chunk data into the correct file; locks file CS as needed
+	/// Sets chunk data into the correct file and the warm cache; locks file CS as needed
 	bool SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Data);
 
+	/// Converts between the chunk NBT and the chunk data; used only by the storage thread, and reused so that its buffers don't need reallocating
+	cAnvilChunkCodec m_Codec;
+
 	/// Loads the chunk from the data (no locking needed)
 	bool LoadChunkFromData(const cChunkCoords & a_Chunk, const AString & a_Data);
 	
 	/// Saves the chunk into datastream (no locking needed)
 	bool SaveChunkToData(const cChunkCoords & a_Chunk, AString & a_Data);
 	
-	/// Loads the chunk from NBT data (no locking needed)
-	bool LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT);
-	
-	/// Saves the chunk into NBT data using a_Writer; returns true on success
-	bool SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_Writer);
-	
-	/// Loads the chunk's biome map from vanilla-format; returns a_BiomeMap if biomes present and valid, NULL otherwise
-	cChunkDef::BiomeMap * LoadVanillaBiomeMapFromNBT(cChunkDef::BiomeMap * a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx);
-	
-	/// Loads the chunk's biome map from MCS format; returns a_BiomeMap if biomes present and valid, NULL otherwise
-	cChunkDef::BiomeMap * LoadBiomeMapFromNBT(cChunkDef::BiomeMap * a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx);
-	
 	/// Loads the chunk's entities from NBT data (a_Tag is the Level\\Entities list tag; may be -1)
 	void LoadEntitiesFromNBT(cEntityList & a_Entitites, const cParsedNBT & a_NBT, int a_Tag);
 	
@@ -170,9 +167,6 @@ protected:
 	/// Gets the correct MCA file either from cache or from disk, manages the m_MCAFiles cache; assumes m_CS is locked
 	cMCAFile * LoadMCAFile(const cChunkCoords & a_Chunk);
 	
-	/// Copies a_Length bytes of data from the specified NBT Tag's Child into the a_Destination buffer
-	void CopyNBTData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, char * a_Destination, int a_Length);
-		
 	// cWSSchema overrides:
 	virtual bool LoadChunk(const cChunkCoords & a_Chunk) override;
 	virtual bool SaveChunk(const cChunkCoords & a_Chunk) override;
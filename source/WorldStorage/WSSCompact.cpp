@@ -133,6 +133,7 @@ cWSSCompact::~cWSSCompact()
 
 bool cWSSCompact::LoadChunk(const cChunkCoords & a_Chunk)
 {
+	cStoragePhaseTimer Timer;
 	AString ChunkData;
 	int UncompressedSize = 0;
 	if (!GetChunkData(a_Chunk, UncompressedSize, ChunkData))
@@ -140,6 +141,7 @@ bool cWSSCompact::LoadChunk(const cChunkCoords & a_Chunk)
 		// The reason for failure is already printed in GetChunkData()
 		return false;
 	}
+	Timer.Lap(m_PhaseTimes.m_FileIO);
 	
 	return LoadChunkFromData(a_Chunk, UncompressedSize, ChunkData, m_World);
 }
@@ -159,7 +161,7 @@ bool cWSSCompact::SaveChunk(const cChunkCoords & a_Chunk)
 		LOG("Cannot locate a proper PAK file for chunk [%d, %d]", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
 	}
-	return f->SaveChunk(a_Chunk, m_World);
+	return f->SaveChunk(a_Chunk, m_World, m_PhaseTimes);
 }
 
 
@@ -192,7 +194,7 @@ cWSSCompact::cPAKFile * cWSSCompact::LoadPAKFile(const cChunkCoords & a_Chunk)
 	
 	// Load it anew:
 	AString FileName;
-	Printf(FileName, "%s/X%i_Z%i.pak", m_World->GetName().c_str(), LayerX, LayerZ );
+	Printf(FileName, "%s/X%i_Z%i.pak", m_StorageFolder.c_str(), LayerX, LayerZ );
 	cPAKFile * f = new cPAKFile(FileName, LayerX, LayerZ);
 	if (f == NULL)
 	{
@@ -516,15 +518,17 @@ bool cWSSCompact::cPAKFile::GetChunkData(const cChunkCoords & a_Chunk, int & a_U
 
 
 
-bool cWSSCompact::cPAKFile::SaveChunk(const cChunkCoords & a_Chunk, cWorld * a_World)
+bool cWSSCompact::cPAKFile::SaveChunk(const cChunkCoords & a_Chunk, cWorld * a_World, sStoragePhaseTimes & a_PhaseTimes)
 {
-	if (!SaveChunkToData(a_Chunk, a_World))
+	if (!SaveChunkToData(a_Chunk, a_World, a_PhaseTimes))
 	{
 		return false;
 	}
 	if (m_NumDirty > MAX_DIRTY_CHUNKS)
 	{
+		cStoragePhaseTimer Timer;
 		SynchronizeFile();
+		Timer.Lap(a_PhaseTimes.m_FileIO);
 	}
 	return true;
 }
@@ -828,6 +832,8 @@ bool cWSSCompact::LoadChunkFromData(const cChunkCoords & a_Chunk, int & a_Uncomp
 		return false;
 	}
 	
+	cStoragePhaseTimer Timer;
+	
 	// Decompress the data:
 	AString UncompressedData;
 	int errorcode = UncompressString(a_Data.data(), a_Data.size(), UncompressedData, a_UncompressedSize);
@@ -848,6 +854,7 @@ bool cWSSCompact::LoadChunkFromData(const cChunkCoords & a_Chunk, int & a_Uncomp
 		);
 		return false;
 	}
+	Timer.Lap(m_PhaseTimes.m_Compression);
 
 	cEntityList      Entities;
 	cBlockEntityList BlockEntities;
@@ -874,6 +881,7 @@ bool cWSSCompact::LoadChunkFromData(const cChunkCoords & a_Chunk, int & a_Uncomp
 	NIBBLETYPE * MetaData   = (NIBBLETYPE *)(BlockData + cChunkDef::MetaOffset);
 	NIBBLETYPE * BlockLight = (NIBBLETYPE *)(BlockData + cChunkDef::LightOffset);
 	NIBBLETYPE * SkyLight   = (NIBBLETYPE *)(BlockData + cChunkDef::SkyLightOffset);
+	Timer.Lap(m_PhaseTimes.m_Codec);
 	
 	a_World->SetChunkData(
 		a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ,
@@ -884,6 +892,7 @@ bool cWSSCompact::LoadChunkFromData(const cChunkCoords & a_Chunk, int & a_Uncomp
 		Entities, BlockEntities,
 		false
 	);
+	Timer.Lap(m_PhaseTimes.m_World);
 
 	return true;
 }
@@ -916,8 +925,10 @@ bool cWSSCompact::cPAKFile::EraseChunkData(const cChunkCoords & a_Chunk)
 
 
 
-bool cWSSCompact::cPAKFile::SaveChunkToData(const cChunkCoords & a_Chunk, cWorld * a_World)
+bool cWSSCompact::cPAKFile::SaveChunkToData(const cChunkCoords & a_Chunk, cWorld * a_World, sStoragePhaseTimes & a_PhaseTimes)
 {
+	cStoragePhaseTimer Timer;
+	
 	// Serialize the chunk:
 	cJsonChunkSerializer Serializer;
 	if (!a_World->GetChunkData(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Serializer))
@@ -926,6 +937,7 @@ bool cWSSCompact::cPAKFile::SaveChunkToData(const cChunkCoords & a_Chunk, cWorld
 		LOG("cWSSCompact: Trying to save chunk [%d, %d, %d] that has no data, ignoring request.", a_Chunk.m_ChunkX, a_Chunk.m_ChunkY, a_Chunk.m_ChunkZ);
 		return false;
 	}
+	Timer.Lap(a_PhaseTimes.m_World);
 
 	AString Data;
 	Data.assign((const char *)Serializer.GetBlockData(), cChunkDef::BlockDataSize);
@@ -936,6 +948,7 @@ bool cWSSCompact::cPAKFile::SaveChunkToData(const cChunkCoords & a_Chunk, cWorld
 		JsonData = writer.write(Serializer.GetRoot());
 		Data.append(JsonData);
 	}
+	Timer.Lap(a_PhaseTimes.m_Codec);
 	
 	// Compress the data:
 	AString CompressedData;
@@ -945,6 +958,7 @@ bool cWSSCompact::cPAKFile::SaveChunkToData(const cChunkCoords & a_Chunk, cWorld
 		LOGERROR("Error %i compressing data for chunk [%d, %d, %d]", errorcode, a_Chunk.m_ChunkX, a_Chunk.m_ChunkY, a_Chunk.m_ChunkZ);
 		return false;
 	}
+	Timer.Lap(a_PhaseTimes.m_Compression);
 	
 	// Erase any existing data for the chunk:
 	EraseChunkData(a_Chunk);
@@ -965,6 +979,7 @@ bool cWSSCompact::cPAKFile::SaveChunkToData(const cChunkCoords & a_Chunk, cWorld
 	m_DataContents.append(CompressedData.data(), CompressedData.size());
 	
 	m_NumDirty++;
+	Timer.Lap(a_PhaseTimes.m_FileIO);
 	return true;
 }
 
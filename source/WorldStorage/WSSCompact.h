@@ -52,7 +52,7 @@ class cWSSCompact :
 	public cWSSchema
 {
 public:
-	cWSSCompact(cWorld * a_World) : cWSSchema(a_World) {}
+	cWSSCompact(cWorld * a_World, const AString & a_StorageFolder) : cWSSchema(a_World, a_StorageFolder) {}
 	virtual ~cWSSCompact();
 	
 protected:
@@ -72,7 +72,7 @@ protected:
 		bool SetChunkData(const cChunkCoords & a_Chunk, int a_UncompressedSize, const AString & a_Data);
 		bool EraseChunkData(const cChunkCoords & a_Chunk);
 		
-		bool SaveChunk(const cChunkCoords & a_Chunk, cWorld * a_World);
+		bool SaveChunk(const cChunkCoords & a_Chunk, cWorld * a_World, sStoragePhaseTimes & a_PhaseTimes);
 		
 		int GetLayerX(void) const {return m_LayerX; }
 		int GetLayerZ(void) const {return m_LayerZ; }
@@ -98,7 +98,7 @@ protected:
 		char          m_ChunkVersion;
 		char          m_PakVersion;
 		
-		bool SaveChunkToData(const cChunkCoords & a_Chunk, cWorld * a_World);  // Saves the chunk to m_DataContents, updates headers and m_NumDirty
+		bool SaveChunkToData(const cChunkCoords & a_Chunk, cWorld * a_World, sStoragePhaseTimes & a_PhaseTimes);  // Saves the chunk to m_DataContents, updates headers and m_NumDirty; adds the time spent to a_PhaseTimes
 		void SynchronizeFile(void);  // Writes m_DataContents along with the headers to file, resets m_NumDirty
 
 		void UpdateChunk1To2(void); // Height from 128 to 256
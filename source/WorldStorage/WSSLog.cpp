@@ -0,0 +1,736 @@
+
+// WSSLog.cpp
+
+// Implements the cWSSLog class representing the log-structured world storage schema
+
+#include "Globals.h"
+#include "WSSLog.h"
+#include "WarmChunkCache.h"
+#include "../World.h"
+#include "../../iniFile/iniFile.h"
+#include "zlib.h"
+
+
+
+
+
+/// The signature at the start of each segment file
+static const char SEGMENT_SIGNATURE[] = "MCSLOG\x00\x01";
+static const int SEGMENT_SIGNATURE_SIZE = 8;
+
+/// The first four bytes of each record, "MCSL"
+static const UInt32 RECORD_MAGIC = 0x4d43534c;
+
+/// Size of the record header: magic, ChunkX, ChunkZ, DataSize and Checksum
+static const int RECORD_HEADER_SIZE = 20;
+
+/// Records with more data than this are considered damaged; a chunk's compressed data is much smaller
+static const UInt32 MAX_RECORD_DATA_SIZE = 4 * 1024 * 1024;
+
+/// How often the compactor thread looks for segments to compact, in msec
+static const int COMPACTION_INTERVAL = 10000;
+
+
+
+
+
+static inline UInt32 GetBEUInt32(const char * a_Data)
+{
+	UInt32 Value;
+	memcpy(&Value, a_Data, 4);
+	return ntohl(Value);
+}
+
+
+
+
+
+static inline void SetBEUInt32(char * a_Data, UInt32 a_Value)
+{
+	a_Value = htonl(a_Value);
+	memcpy(a_Data, &a_Value, 4);
+}
+
+
+
+
+
+/// Returns the checksum of the record; a_Header is the record header, only the ChunkX, ChunkZ and DataSize fields are used
+static UInt32 CalcRecordChecksum(const char * a_Header, const char * a_Data, UInt32 a_DataSize)
+{
+	uLong Checksum = crc32(0L, Z_NULL, 0);
+	Checksum = crc32(Checksum, (const Bytef *)(a_Header + 4), 12);
+	Checksum = crc32(Checksum, (const Bytef *)a_Data, a_DataSize);
+	return (UInt32)Checksum;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cWSSLog::cCompactor:
+
+cWSSLog::cCompactor::cCompactor(cWSSLog & a_Log) :
+	super("cWSSLog::cCompactor"),
+	m_Log(a_Log)
+{
+}
+
+
+
+
+
+cWSSLog::cCompactor::~cCompactor()
+{
+	Stop();
+}
+
+
+
+
+
+void cWSSLog::cCompactor::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_evtStop.Set();
+	Wait();
+}
+
+
+
+
+
+void cWSSLog::cCompactor::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		m_evtStop.Wait(COMPACTION_INTERVAL);
+		while (!m_ShouldTerminate && m_Log.CompactOneSegment())
+		{
+			// Compact all the segments that need it
+		}
+	}
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cWSSLog:
+
+cWSSLog::cWSSLog(cWorld * a_World, const AString & a_StorageFolder, cWarmChunkCache & a_WarmCache, cIniFile & a_IniFile) :
+	super(a_World, a_StorageFolder, a_WarmCache),
+	m_CSLog("Storage log"),
+	m_ActiveSegment(-1),
+	m_NextSegment(0),
+	m_Folder(a_StorageFolder + "/chunklog"),
+	m_MaxSegmentSize(64 * 1024 * 1024),
+	m_CompactionThreshold(50),
+	m_Compactor(*this)
+{
+	int SegmentSizeMiB    = a_IniFile.GetValueSetI("Storage", "LogSegmentSizeMiB",      64);
+	m_CompactionThreshold = a_IniFile.GetValueSetI("Storage", "LogCompactionThreshold", 50);
+	bool ShouldImport     = a_IniFile.GetValueSetB("Storage", "LogImportAnvil",         false);
+	bool ShouldExport     = a_IniFile.GetValueSetB("Storage", "LogExportAnvil",         false);
+
+	// The cFile offsets are ints, keep the segments well below 2 GiB:
+	m_MaxSegmentSize = std::min(std::max(SegmentSizeMiB, 1), 1024) * 1024 * 1024;
+	m_CompactionThreshold = std::min(std::max(m_CompactionThreshold, 0), 100);
+
+	LoadSegments();
+	m_Compactor.Start();
+
+	// The import and export are one-shot, the world writes the ini file back after the storage has started.
+	// Running the export again on the next start would overwrite the newer Anvil chunks with the stale log records.
+	// The values are overwritten in place (no "create"), SetValue() would add a duplicate value otherwise:
+	if (ShouldImport && ImportAnvil())
+	{
+		a_IniFile.SetValueB("Storage", "LogImportAnvil", false, false);
+	}
+	if (ShouldExport && ExportAnvil())
+	{
+		a_IniFile.SetValueB("Storage", "LogExportAnvil", false, false);
+	}
+}
+
+
+
+
+
+cWSSLog::~cWSSLog()
+{
+	m_Compactor.Stop();
+
+	cCSLock Lock(m_CSLog);
+	for (cSegments::iterator itr = m_Segments.begin(), end = m_Segments.end(); itr != end; ++itr)
+	{
+		delete itr->second.m_File;
+	}
+	m_Segments.clear();
+}
+
+
+
+
+
+bool cWSSLog::LoadChunk(const cChunkCoords & a_Chunk)
+{
+	cStoragePhaseTimer Timer;
+	AString ChunkData;
+	if (!m_WarmCache.Get(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, ChunkData))
+	{
+		if (!ReadChunkData(a_Chunk, ChunkData))
+		{
+			return false;
+		}
+		m_WarmCache.Set(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, ChunkData);
+	}
+	Timer.Lap(m_PhaseTimes.m_FileIO);
+
+	return LoadChunkFromData(a_Chunk, ChunkData);
+}
+
+
+
+
+
+bool cWSSLog::SaveChunk(const cChunkCoords & a_Chunk)
+{
+	AString ChunkData;
+	if (!SaveChunkToData(a_Chunk, ChunkData))
+	{
+		LOGWARNING("Cannot serialize chunk [%d, %d] into data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+		return false;
+	}
+	cStoragePhaseTimer Timer;
+	if (!AppendChunkData(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, ChunkData))
+	{
+		// The cache mustn't hold data that isn't on the disk:
+		m_WarmCache.Remove(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+		LOGWARNING("Cannot store chunk [%d, %d] data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+		return false;
+	}
+	m_WarmCache.Set(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, ChunkData);
+	Timer.Lap(m_PhaseTimes.m_FileIO);
+
+	// Everything successful
+	return true;
+}
+
+
+
+
+
+void cWSSLog::LoadSegments(void)
+{
+	if (!cFile::IsFolder(m_Folder))
+	{
+		// No chunks saved in the log yet
+		return;
+	}
+
+	// Find all the segment files:
+	std::vector<int> SegmentNums;
+	AStringList Files = GetDirectoryContents((m_Folder + "/").c_str());
+	for (AStringList::const_iterator itr = Files.begin(), end = Files.end(); itr != end; ++itr)
+	{
+		int SegmentNum;
+		if ((sscanf(itr->c_str(), "seg.%d.dat", &SegmentNum) == 1) && (SegmentNum >= 0) && (GetSegmentFileName(SegmentNum) == m_Folder + "/" + *itr))
+		{
+			SegmentNums.push_back(SegmentNum);
+		}
+	}
+	std::sort(SegmentNums.begin(), SegmentNums.end());
+
+	// Walk the segments in the order they were written, so that newer records replace older ones in the index:
+	cCSLock Lock(m_CSLog);
+	for (std::vector<int>::const_iterator itr = SegmentNums.begin(), end = SegmentNums.end(); itr != end; ++itr)
+	{
+		m_NextSegment = *itr + 1;
+		AString FileName = GetSegmentFileName(*itr);
+		cFile * File = new cFile;
+		char Signature[SEGMENT_SIGNATURE_SIZE];
+		if (
+			!File->Open(FileName, cFile::fmReadWrite) ||
+			(File->Read(Signature, SEGMENT_SIGNATURE_SIZE) != SEGMENT_SIGNATURE_SIZE) ||
+			(memcmp(Signature, SEGMENT_SIGNATURE, SEGMENT_SIGNATURE_SIZE) != 0)
+		)
+		{
+			LOGWARNING("Cannot read chunk log segment \"%s\", the chunks in it will be lost", FileName.c_str());
+			delete File;
+			continue;
+		}
+		sSegment & Segment = m_Segments[*itr];
+		Segment.m_File = File;
+		Segment.m_Size = SEGMENT_SIGNATURE_SIZE;
+		Segment.m_LiveBytes = 0;
+		Segment.m_IsDamaged = false;
+
+		// Only the last segment can have been interrupted while writing, verify its data fully:
+		ScanSegment(*itr, Segment, (itr + 1 == end));
+	}
+
+	// Continue appending to the last segment, if it is intact and not full:
+	if (!m_Segments.empty())
+	{
+		cSegments::iterator Last = --m_Segments.end();
+		if (!Last->second.m_IsDamaged && (Last->second.m_Size < m_MaxSegmentSize))
+		{
+			m_ActiveSegment = Last->first;
+		}
+	}
+
+	LOG("Loaded the chunk log of world %s: %d chunks in %d segments",
+		m_World->GetName().c_str(), (int)m_Index.size(), (int)m_Segments.size()
+	);
+}
+
+
+
+
+
+void cWSSLog::ScanSegment(int a_SegmentNum, sSegment & a_Segment, bool a_ShouldVerify)
+{
+	int FileSize = a_Segment.m_File->GetSize();
+	int Pos = SEGMENT_SIGNATURE_SIZE;
+	AString Data;
+	while (Pos < FileSize)
+	{
+		char Header[RECORD_HEADER_SIZE];
+		if (
+			(FileSize - Pos < RECORD_HEADER_SIZE) ||
+			(a_Segment.m_File->Seek(Pos) < 0) ||
+			(a_Segment.m_File->Read(Header, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE) ||
+			(GetBEUInt32(Header) != RECORD_MAGIC)
+		)
+		{
+			a_Segment.m_IsDamaged = true;
+			break;
+		}
+		UInt32 DataSize = GetBEUInt32(Header + 12);
+		if ((DataSize > MAX_RECORD_DATA_SIZE) || ((int)DataSize > FileSize - Pos - RECORD_HEADER_SIZE))
+		{
+			a_Segment.m_IsDamaged = true;
+			break;
+		}
+		if (a_ShouldVerify)
+		{
+			Data.resize(DataSize);
+			if (
+				((DataSize > 0) && (a_Segment.m_File->Read((void *)Data.data(), (int)DataSize) != (int)DataSize)) ||
+				(CalcRecordChecksum(Header, Data.data(), DataSize) != GetBEUInt32(Header + 16))
+			)
+			{
+				a_Segment.m_IsDamaged = true;
+				break;
+			}
+		}
+
+		sRecordLocation Location;
+		Location.m_Segment = a_SegmentNum;
+		Location.m_Offset = Pos;
+		Location.m_Size = RECORD_HEADER_SIZE + (int)DataSize;
+		IndexRecord((int)GetBEUInt32(Header + 4), (int)GetBEUInt32(Header + 8), Location);
+		Pos += Location.m_Size;
+	}
+	a_Segment.m_Size = Pos;
+
+	if (!a_Segment.m_IsDamaged)
+	{
+		return;
+	}
+
+	// Cut the bad tail off a verified segment. Once a newer segment exists, this one is scanned without verification,
+	// and a torn record with an intact header would replace the chunk's older good record in the index:
+	if (a_ShouldVerify && a_Segment.m_File->Truncate(Pos))
+	{
+		a_Segment.m_IsDamaged = false;
+		LOGWARNING("Chunk log segment \"%s\" is damaged at offset %d, the rest of it has been cut off",
+			GetSegmentFileName(a_SegmentNum).c_str(), Pos
+		);
+		return;
+	}
+	LOGWARNING("Chunk log segment \"%s\" is damaged at offset %d, the rest of it is ignored",
+		GetSegmentFileName(a_SegmentNum).c_str(), Pos
+	);
+}
+
+
+
+
+
+void cWSSLog::IndexRecord(int a_ChunkX, int a_ChunkZ, const sRecordLocation & a_Location)
+{
+	std::pair<cIndex::iterator, bool> Inserted = m_Index.insert(cIndex::value_type(std::make_pair(a_ChunkX, a_ChunkZ), a_Location));
+	if (!Inserted.second)
+	{
+		// The chunk already had a record, it is not live anymore:
+		sRecordLocation & Old = Inserted.first->second;
+		m_Segments[Old.m_Segment].m_LiveBytes -= Old.m_Size;
+		Old = a_Location;
+	}
+	m_Segments[a_Location.m_Segment].m_LiveBytes += a_Location.m_Size;
+}
+
+
+
+
+
+bool cWSSLog::ReadRecord(const sRecordLocation & a_Location, AString & a_Record)
+{
+	cSegments::iterator itr = m_Segments.find(a_Location.m_Segment);
+	if (itr == m_Segments.end())
+	{
+		return false;
+	}
+	cFile & File = *(itr->second.m_File);
+
+	// HACK: This depends on the internal knowledge that AString's data() function returns the internal buffer directly
+	a_Record.assign(a_Location.m_Size, '\0');
+	if (
+		(File.Seek(a_Location.m_Offset) < 0) ||
+		(File.Read((void *)a_Record.data(), a_Location.m_Size) != a_Location.m_Size)
+	)
+	{
+		return false;
+	}
+	const char * Header = a_Record.data();
+	UInt32 DataSize = GetBEUInt32(Header + 12);
+	return (
+		(GetBEUInt32(Header) == RECORD_MAGIC) &&
+		((int)DataSize == a_Location.m_Size - RECORD_HEADER_SIZE) &&
+		(CalcRecordChecksum(Header, Header + RECORD_HEADER_SIZE, DataSize) == GetBEUInt32(Header + 16))
+	);
+}
+
+
+
+
+
+bool cWSSLog::ReadChunkData(const cChunkCoords & a_Chunk, AString & a_Data)
+{
+	cCSLock Lock(m_CSLog);
+	cIndex::const_iterator itr = m_Index.find(std::make_pair(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ));
+	if (itr == m_Index.end())
+	{
+		return false;
+	}
+	if (!ReadRecord(itr->second, a_Data))
+	{
+		LOGWARNING("Chunk [%d, %d] in the chunk log of world %s is damaged",
+			a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, m_World->GetName().c_str()
+		);
+		return false;
+	}
+	a_Data.erase(0, RECORD_HEADER_SIZE);
+	return true;
+}
+
+
+
+
+
+bool cWSSLog::AppendChunkData(int a_ChunkX, int a_ChunkZ, const AString & a_Data)
+{
+	// Compose the record:
+	char Header[RECORD_HEADER_SIZE];
+	SetBEUInt32(Header,      RECORD_MAGIC);
+	SetBEUInt32(Header + 4,  (UInt32)a_ChunkX);
+	SetBEUInt32(Header + 8,  (UInt32)a_ChunkZ);
+	SetBEUInt32(Header + 12, (UInt32)a_Data.size());
+	SetBEUInt32(Header + 16, CalcRecordChecksum(Header, a_Data.data(), (UInt32)a_Data.size()));
+	AString Record;
+	Record.reserve(RECORD_HEADER_SIZE + a_Data.size());
+	Record.assign(Header, RECORD_HEADER_SIZE);
+	Record.append(a_Data);
+
+	cCSLock Lock(m_CSLog);
+	return AppendRecord(a_ChunkX, a_ChunkZ, Record);
+}
+
+
+
+
+
+bool cWSSLog::AppendRecord(int a_ChunkX, int a_ChunkZ, const AString & a_Record)
+{
+	ASSERT(m_CSLog.IsLocked());
+
+	if (
+		(m_ActiveSegment < 0) ||
+		(
+			(m_Segments[m_ActiveSegment].m_Size + (int)a_Record.size() > m_MaxSegmentSize) &&
+			(m_Segments[m_ActiveSegment].m_Size > SEGMENT_SIGNATURE_SIZE)  // A record larger than the whole segment still needs to go somewhere
+		)
+	)
+	{
+		if (!StartNewSegment())
+		{
+			return false;
+		}
+	}
+
+	sSegment & Segment = m_Segments[m_ActiveSegment];
+	if (
+		(Segment.m_File->Seek(Segment.m_Size) < 0) ||
+		(Segment.m_File->Write(a_Record.data(), (int)a_Record.size()) != (int)a_Record.size()) ||
+		!Segment.m_File->Flush()
+	)
+	{
+		// The segment may now end with a partial record, don't append to it anymore:
+		LOGWARNING("Cannot write to chunk log segment \"%s\"", GetSegmentFileName(m_ActiveSegment).c_str());
+		Segment.m_IsDamaged = true;
+		m_ActiveSegment = -1;
+		return false;
+	}
+
+	sRecordLocation Location;
+	Location.m_Segment = m_ActiveSegment;
+	Location.m_Offset = Segment.m_Size;
+	Location.m_Size = (int)a_Record.size();
+	Segment.m_Size += Location.m_Size;
+	IndexRecord(a_ChunkX, a_ChunkZ, Location);
+	return true;
+}
+
+
+
+
+
+bool cWSSLog::StartNewSegment(void)
+{
+	ASSERT(m_CSLog.IsLocked());
+
+	cFile::CreateFolder(FILE_IO_PREFIX + m_Folder);
+	int SegmentNum = m_NextSegment++;
+	AString FileName = GetSegmentFileName(SegmentNum);
+	cFile * File = new cFile;
+	if (
+		!File->Open(FileName, cFile::fmReadWrite) ||
+		(File->Write(SEGMENT_SIGNATURE, SEGMENT_SIGNATURE_SIZE) != SEGMENT_SIGNATURE_SIZE) ||
+		!File->Flush()
+	)
+	{
+		LOGWARNING("Cannot create chunk log segment \"%s\"", FileName.c_str());
+		delete File;
+		return false;
+	}
+
+	sSegment & Segment = m_Segments[SegmentNum];
+	Segment.m_File = File;
+	Segment.m_Size = SEGMENT_SIGNATURE_SIZE;
+	Segment.m_LiveBytes = 0;
+	Segment.m_IsDamaged = false;
+	m_ActiveSegment = SegmentNum;
+	return true;
+}
+
+
+
+
+
+bool cWSSLog::CompactOneSegment(void)
+{
+	// Pick the segment with the lowest ratio of live records, out of those under the threshold:
+	int SegmentNum = -1;
+	std::vector<std::pair<int, int> > Chunks;
+	{
+		cCSLock Lock(m_CSLog);
+		Int64 BestLive = 0, BestSize = 1;
+		for (cSegments::const_iterator itr = m_Segments.begin(), end = m_Segments.end(); itr != end; ++itr)
+		{
+			if (itr->first == m_ActiveSegment)
+			{
+				continue;
+			}
+			Int64 Live = itr->second.m_LiveBytes;
+			Int64 Size = std::max(itr->second.m_Size - SEGMENT_SIGNATURE_SIZE, 1);
+			if (!itr->second.m_IsDamaged && (Live * 100 >= Size * m_CompactionThreshold))
+			{
+				continue;
+			}
+			if ((SegmentNum < 0) || (Live * BestSize < BestLive * Size))
+			{
+				SegmentNum = itr->first;
+				BestLive = Live;
+				BestSize = Size;
+			}
+		}
+		if (SegmentNum < 0)
+		{
+			return false;
+		}
+		for (cIndex::const_iterator itr = m_Index.begin(), end = m_Index.end(); itr != end; ++itr)
+		{
+			if (itr->second.m_Segment == SegmentNum)
+			{
+				Chunks.push_back(itr->first);
+			}
+		}
+	}
+
+	// Move the live records to the end of the log, one by one, so that the storage thread can work in between:
+	AString Record;
+	for (std::vector<std::pair<int, int> >::const_iterator itr = Chunks.begin(), end = Chunks.end(); itr != end; ++itr)
+	{
+		cCSLock Lock(m_CSLog);
+		cIndex::iterator Chunk = m_Index.find(*itr);
+		if ((Chunk == m_Index.end()) || (Chunk->second.m_Segment != SegmentNum))
+		{
+			// The chunk has been saved again in the meantime
+			continue;
+		}
+		if (!ReadRecord(Chunk->second, Record))
+		{
+			LOGWARNING("Chunk [%d, %d] in the chunk log of world %s is damaged, dropping it",
+				itr->first, itr->second, m_World->GetName().c_str()
+			);
+			m_Segments[SegmentNum].m_LiveBytes -= Chunk->second.m_Size;
+			m_Index.erase(Chunk);
+			continue;
+		}
+		if (!AppendRecord(itr->first, itr->second, Record))
+		{
+			// Keep the segment, it still has live records; AppendRecord() has already logged the failure
+			return false;
+		}
+	}
+
+	// All the records in the segment are now dead (and their copies flushed), delete it:
+	cCSLock Lock(m_CSLog);
+	sSegment & Segment = m_Segments[SegmentNum];
+	ASSERT(Segment.m_LiveBytes == 0);
+	delete Segment.m_File;
+	AString FileName = GetSegmentFileName(SegmentNum);
+	m_Segments.erase(SegmentNum);
+	if (!cFile::Delete(FileName))
+	{
+		LOGWARNING("Cannot delete compacted chunk log segment \"%s\"", FileName.c_str());
+	}
+	LOGD("Compacted chunk log segment \"%s\", %d chunks moved", FileName.c_str(), (int)Chunks.size());
+	return true;
+}
+
+
+
+
+
+bool cWSSLog::ImportAnvil(void)
+{
+	AString RegionFolder = m_StorageFolder + "/region";
+	if (!cFile::IsFolder(RegionFolder))
+	{
+		LOG("World %s has no Anvil region files to import into the chunk log", m_World->GetName().c_str());
+		return true;
+	}
+
+	LOG("Importing the Anvil region files of world %s into the chunk log...", m_World->GetName().c_str());
+	int NumImported = 0;
+	int NumSkipped = 0;
+	int NumFailed = 0;
+	AStringList Files = GetDirectoryContents((RegionFolder + "/").c_str());
+	for (AStringList::const_iterator itr = Files.begin(), end = Files.end(); itr != end; ++itr)
+	{
+		int RegionX, RegionZ;
+		if (sscanf(itr->c_str(), "r.%d.%d.mca", &RegionX, &RegionZ) != 2)
+		{
+			continue;
+		}
+		for (int z = 0; z < 32; z++) for (int x = 0; x < 32; x++)
+		{
+			cChunkCoords Coords(RegionX * 32 + x, 0, RegionZ * 32 + z);
+			{
+				cCSLock Lock(m_CSLog);
+				if (m_Index.find(std::make_pair(Coords.m_ChunkX, Coords.m_ChunkZ)) != m_Index.end())
+				{
+					// The log has a newer version of the chunk
+					NumSkipped += 1;
+					continue;
+				}
+			}
+			AString Data;
+			{
+				cCSLock Lock(m_CS);
+				cMCAFile * File = LoadMCAFile(Coords);
+				if ((File == NULL) || !File->GetChunkData(Coords, Data))
+				{
+					continue;
+				}
+			}
+			if (AppendChunkData(Coords.m_ChunkX, Coords.m_ChunkZ, Data))
+			{
+				NumImported += 1;
+			}
+			else
+			{
+				NumFailed += 1;
+			}
+		}  // for z, x
+	}  // for itr - Files[]
+	LOG("Imported %d chunks into the chunk log of world %s, %d chunks were already in the log, %d failed",
+		NumImported, m_World->GetName().c_str(), NumSkipped, NumFailed
+	);
+	return (NumFailed == 0);
+}
+
+
+
+
+
+bool cWSSLog::ExportAnvil(void)
+{
+	LOG("Exporting the chunk log of world %s into the Anvil region files...", m_World->GetName().c_str());
+	std::vector<std::pair<int, int> > Chunks;
+	{
+		cCSLock Lock(m_CSLog);
+		Chunks.reserve(m_Index.size());
+		for (cIndex::const_iterator itr = m_Index.begin(), end = m_Index.end(); itr != end; ++itr)
+		{
+			Chunks.push_back(itr->first);
+		}
+	}
+
+	int NumExported = 0;
+	int NumFailed = 0;
+	AString Data;
+	for (std::vector<std::pair<int, int> >::const_iterator itr = Chunks.begin(), end = Chunks.end(); itr != end; ++itr)
+	{
+		cChunkCoords Coords(itr->first, 0, itr->second);
+		if (!ReadChunkData(Coords, Data))
+		{
+			// Damaged record, ReadChunkData() has already logged it; another attempt wouldn't read it either
+			continue;
+		}
+		cCSLock Lock(m_CS);
+		cMCAFile * File = LoadMCAFile(Coords);
+		if ((File != NULL) && File->SetChunkData(Coords, Data))
+		{
+			NumExported += 1;
+		}
+		else
+		{
+			NumFailed += 1;
+		}
+	}
+	LOG("Exported %d chunks out of %d from the chunk log of world %s, %d failed to write",
+		NumExported, (int)Chunks.size(), m_World->GetName().c_str(), NumFailed
+	);
+	return (NumFailed == 0);
+}
+
+
+
+
+
+AString cWSSLog::GetSegmentFileName(int a_SegmentNum) const
+{
+	AString res;
+	Printf(res, "%s/seg.%08d.dat", m_Folder.c_str(), a_SegmentNum);
+	return res;
+}
+
+
+
+
@@ -0,0 +1,183 @@
+
+// WSSLog.h
+
+// Interfaces to the cWSSLog class representing the log-structured world storage schema
+
+/*
+The chunks are stored as records appended to the end of segment files, "<world>/chunklog/seg.<number>.dat".
+A chunk that is saved again simply gets a new record; the index in memory tells which record is the current one,
+so saving never needs to look for free space or rewrite any headers. The index is rebuilt on startup by walking
+the record headers of all the segments, in the order they were written.
+
+Each record is a header followed by the chunk data, which is the same compressed NBT that Anvil uses (and is produced
+by the inherited cWSSAnvil code), so the records can be copied between the two schemas without re-encoding:
+	UInt32 Magic     ("MCSL")
+	Int32  ChunkX
+	Int32  ChunkZ
+	UInt32 DataSize
+	UInt32 Checksum  (crc32 of the ChunkX, ChunkZ and DataSize fields and of the data)
+	char   Data[DataSize]
+All the numbers are big-endian. Each segment file starts with an 8-byte signature.
+
+The records are flushed to the OS after each write. If the server crashes in the middle of writing a record, the last
+segment ends with an incomplete record; on startup, the records in the last segment are verified and the segment
+is cut off at the first bad one (if it cannot be cut off, the rest is ignored and the segment is not appended to anymore).
+
+When a segment has less than the configured percentage of live (current) records, a background thread copies
+the live records to the end of the log and deletes the segment. The copies are flushed before the segment is deleted,
+and since the copies are later in the log, a crash at any point leaves a consistent state.
+
+The world.ini [Storage] section has settings for importing all the chunks from the Anvil region files on startup
+(so that the world doesn't need the Anvil schema as a fallback) and for exporting all the chunks back to Anvil
+(before switching the world back to the Anvil schema). Both are done once, the setting is turned off afterwards. Without the import, chunks not found in the log are still
+loaded from the Anvil files and are moved into the log as they are saved.
+*/
+
+
+
+
+
+#pragma once
+
+#include "WSSAnvil.h"
+
+
+
+
+
+// fwd:
+class cIniFile;
+
+
+
+
+
+class cWSSLog :
+	public cWSSAnvil
+{
+	typedef cWSSAnvil super;
+
+public:
+
+	cWSSLog(cWorld * a_World, const AString & a_StorageFolder, cWarmChunkCache & a_WarmCache, cIniFile & a_IniFile);
+	virtual ~cWSSLog();
+
+protected:
+
+	/// Location of a record in the log
+	struct sRecordLocation
+	{
+		int m_Segment;
+		int m_Offset;  ///< Offset of the record's header in the segment file
+		int m_Size;    ///< Size of the whole record, including the header
+	} ;
+
+	/// The index, maps chunk coords to the location of the chunk's current record
+	typedef std::map<std::pair<int, int>, sRecordLocation> cIndex;
+
+	/// A single segment file
+	struct sSegment
+	{
+		cFile * m_File;
+		int     m_Size;        ///< Size of the valid data in the file, including the signature
+		int     m_LiveBytes;   ///< Total size of the records that the index points to
+		bool    m_IsDamaged;   ///< If true, the file has invalid data after m_Size and it mustn't be appended to
+	} ;
+	typedef std::map<int, sSegment> cSegments;
+
+
+	/// The background thread that compacts the segments
+	class cCompactor :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cCompactor(cWSSLog & a_Log);
+		virtual ~cCompactor();
+
+		/// Stops the thread and waits for it to finish
+		void Stop(void);
+
+	protected:
+		cWSSLog & m_Log;
+
+		/// Set when the thread should terminate
+		cEvent m_evtStop;
+
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+	} ;
+
+
+	/// Guards the index and the segments; the compactor and the storage thread access them concurrently
+	cCriticalSection m_CSLog;
+
+	cIndex    m_Index;
+	cSegments m_Segments;
+
+	/// Number of the segment that the records are appended to; -1 if no segment is open for appending yet
+	int m_ActiveSegment;
+
+	/// Number of the segment to be created next
+	int m_NextSegment;
+
+	/// The folder with the segment files
+	AString m_Folder;
+
+	/// Maximum size of a segment file; when the active segment would grow over this, a new one is started
+	int m_MaxSegmentSize;
+
+	/// Segments with less than this percentage of live records are compacted
+	int m_CompactionThreshold;
+
+	cCompactor m_Compactor;
+
+
+	/// Opens all the existing segments and builds the index from their records
+	void LoadSegments(void);
+
+	/// Walks the records in the specified segment and adds them to the index; if a_ShouldVerify is true, the data checksums are verified as well
+	void ScanSegment(int a_SegmentNum, sSegment & a_Segment, bool a_ShouldVerify);
+
+	/// Adds the record to the index, replacing the chunk's previous record; assumes m_CSLog is locked
+	void IndexRecord(int a_ChunkX, int a_ChunkZ, const sRecordLocation & a_Location);
+
+	/// Reads the whole record (header and data) at the specified location and verifies it; returns false if the record is damaged. Assumes m_CSLog is locked
+	bool ReadRecord(const sRecordLocation & a_Location, AString & a_Record);
+
+	/// Reads the data of the chunk's current record; returns false if the chunk isn't in the log or the record is damaged
+	bool ReadChunkData(const cChunkCoords & a_Chunk, AString & a_Data);
+
+	/// Appends a new record for the chunk; returns true on success
+	bool AppendChunkData(int a_ChunkX, int a_ChunkZ, const AString & a_Data);
+
+	/// Appends the whole record (header and data) to the active segment and indexes it; assumes m_CSLog is locked
+	bool AppendRecord(int a_ChunkX, int a_ChunkZ, const AString & a_Record);
+
+	/// Creates a new segment file to append to; assumes m_CSLog is locked
+	bool StartNewSegment(void);
+
+	/** Compacts one segment that has too few live records, if there is any; returns true if a segment was compacted.
+	Called from the compactor thread; locks m_CSLog only for the individual records, so that the storage thread isn't blocked for long.
+	*/
+	bool CompactOneSegment(void);
+
+	/// Copies all the chunks from the Anvil region files that aren't in the log yet into the log; returns false if any chunk failed to copy
+	bool ImportAnvil(void);
+
+	/// Copies all the chunks in the log into the Anvil region files; returns false if any chunk failed to copy
+	bool ExportAnvil(void);
+
+	/// Returns the filename of the specified segment
+	AString GetSegmentFileName(int a_SegmentNum) const;
+
+	// cWSSchema overrides:
+	virtual bool LoadChunk(const cChunkCoords & a_Chunk) override;
+	virtual bool SaveChunk(const cChunkCoords & a_Chunk) override;
+	virtual const AString GetName(void) const override {return "log"; }
+} ;
+
+
+
+
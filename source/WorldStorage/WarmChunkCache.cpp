@@ -0,0 +1,156 @@
+
+// WarmChunkCache.cpp
+
+// Implements the cWarmChunkCache class representing a memory-budgeted LRU cache of compressed chunk data
+
+#include "Globals.h"
+
+#include "WarmChunkCache.h"
+
+
+
+
+
+cWarmChunkCache::cWarmChunkCache(void) :
+	m_CS("Storage warm cache"),
+	m_Size(0),
+	m_MaxSize(0),
+	m_NumLookups(0),
+	m_NumHits(0),
+	m_NumEvictions(0)
+{
+}
+
+
+
+
+
+void cWarmChunkCache::SetMaxSize(int a_MaxSize)
+{
+	cCSLock Lock(m_CS);
+	m_MaxSize = std::max(a_MaxSize, 0);
+	Trim();
+}
+
+
+
+
+
+bool cWarmChunkCache::Get(int a_ChunkX, int a_ChunkZ, AString & a_Data)
+{
+	cCSLock Lock(m_CS);
+	m_NumLookups++;
+	cEntryMap::iterator itr = m_EntryMap.find(cChunkXZ(a_ChunkX, a_ChunkZ));
+	if (itr == m_EntryMap.end())
+	{
+		return false;
+	}
+	m_NumHits++;
+	m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+	a_Data = itr->second->m_Data;
+	return true;
+}
+
+
+
+
+
+void cWarmChunkCache::Set(int a_ChunkX, int a_ChunkZ, const AString & a_Data)
+{
+	cCSLock Lock(m_CS);
+	cChunkXZ Coords(a_ChunkX, a_ChunkZ);
+	cEntryMap::iterator itr = m_EntryMap.find(Coords);
+	if ((int)a_Data.size() > m_MaxSize)
+	{
+		// Doesn't fit at all; drop any older data so that it isn't returned instead:
+		if (itr != m_EntryMap.end())
+		{
+			m_Size -= (int)itr->second->m_Data.size();
+			m_Entries.erase(itr->second);
+			m_EntryMap.erase(itr);
+		}
+		return;
+	}
+
+	if (itr != m_EntryMap.end())
+	{
+		m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+		m_Size -= (int)itr->second->m_Data.size();
+	}
+	else
+	{
+		sEntry Entry;
+		Entry.m_ChunkX = a_ChunkX;
+		Entry.m_ChunkZ = a_ChunkZ;
+		m_Entries.push_front(Entry);
+		m_EntryMap[Coords] = m_Entries.begin();
+	}
+	m_Entries.front().m_Data = a_Data;
+	m_Size += (int)a_Data.size();
+	Trim();
+}
+
+
+
+
+
+void cWarmChunkCache::Touch(int a_ChunkX, int a_ChunkZ)
+{
+	cCSLock Lock(m_CS);
+	cEntryMap::iterator itr = m_EntryMap.find(cChunkXZ(a_ChunkX, a_ChunkZ));
+	if (itr != m_EntryMap.end())
+	{
+		m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+	}
+}
+
+
+
+
+
+void cWarmChunkCache::Remove(int a_ChunkX, int a_ChunkZ)
+{
+	cCSLock Lock(m_CS);
+	cEntryMap::iterator itr = m_EntryMap.find(cChunkXZ(a_ChunkX, a_ChunkZ));
+	if (itr != m_EntryMap.end())
+	{
+		m_Size -= (int)itr->second->m_Data.size();
+		m_Entries.erase(itr->second);
+		m_EntryMap.erase(itr);
+	}
+}
+
+
+
+
+
+void cWarmChunkCache::GetStats(int & a_NumChunks, int & a_Size, int & a_MaxSize, int & a_NumLookups, int & a_NumHits, int & a_NumEvictions)
+{
+	cCSLock Lock(m_CS);
+	a_NumChunks    = (int)m_EntryMap.size();
+	a_Size         = m_Size;
+	a_MaxSize      = m_MaxSize;
+	a_NumLookups   = m_NumLookups;
+	a_NumHits      = m_NumHits;
+	a_NumEvictions = m_NumEvictions;
+}
+
+
+
+
+
+void cWarmChunkCache::Trim(void)
+{
+	while ((m_Size > m_MaxSize) && !m_Entries.empty())
+	{
+		sEntry & Entry = m_Entries.back();
+		m_Size -= (int)Entry.m_Data.size();
+		m_EntryMap.erase(cChunkXZ(Entry.m_ChunkX, Entry.m_ChunkZ));
+		m_Entries.pop_back();
+		m_NumEvictions++;
+	}
+}
+
+
+
+
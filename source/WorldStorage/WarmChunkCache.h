@@ -0,0 +1,79 @@
+
+// WarmChunkCache.h
+
+// Interfaces to the cWarmChunkCache class representing a memory-budgeted LRU cache of compressed chunk data
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+
+
+
+
+
+/** Keeps the compressed, storage-ready data of recently used chunks in memory, so that a chunk that is unloaded
+and requested again shortly after (such as when a player walks back and forth across the view distance boundary)
+doesn't need to be read from the disk again.
+The data is the same as what the storage schema stores on disk, including the lighting, so the cache is write-through:
+the schema stores each chunk it saves or reads from the disk in here, and the cached data is never newer than the disk data.
+When the total size of the cached data exceeds the budget, the least recently used chunks are evicted.
+The chunkmap touches the chunks it unloads, so that the recently unloaded chunks are the last ones to be evicted.
+All the functions are thread-safe.
+*/
+class cWarmChunkCache
+{
+public:
+	cWarmChunkCache(void);
+
+	/// Sets the memory budget for the cached data, in bytes. 0 disables the cache.
+	void SetMaxSize(int a_MaxSize);
+
+	/// Retrieves the data for the specified chunk; returns true if it was cached. Updates the hit-rate statistics.
+	bool Get(int a_ChunkX, int a_ChunkZ, AString & a_Data);
+
+	/// Stores the data for the specified chunk, replacing any older data, and evicts the least recently used chunks over the budget
+	void Set(int a_ChunkX, int a_ChunkZ, const AString & a_Data);
+
+	/// Marks the specified chunk, if cached, as the most recently used one
+	void Touch(int a_ChunkX, int a_ChunkZ);
+
+	/// Removes the specified chunk from the cache
+	void Remove(int a_ChunkX, int a_ChunkZ);
+
+	/// Returns the statistics of the cache
+	void GetStats(int & a_NumChunks, int & a_Size, int & a_MaxSize, int & a_NumLookups, int & a_NumHits, int & a_NumEvictions);
+
+protected:
+	struct sEntry
+	{
+		int     m_ChunkX;
+		int     m_ChunkZ;
+		AString m_Data;
+	} ;
+
+	/// Entries, ordered from the most recently used to the least recently used
+	typedef std::list<sEntry> cEntries;
+
+	typedef std::pair<int, int> cChunkXZ;
+	typedef std::map<cChunkXZ, cEntries::iterator> cEntryMap;
+
+	cCriticalSection m_CS;
+	cEntries  m_Entries;
+	cEntryMap m_EntryMap;   ///< Map of chunk coords -> entry in m_Entries
+	int       m_Size;       ///< Total size of the cached data, in bytes
+	int       m_MaxSize;    ///< Memory budget for the cached data, in bytes
+	int       m_NumLookups;
+	int       m_NumHits;
+	int       m_NumEvictions;
+
+	/// Evicts the least recently used entries until the size is within the budget. Assumes m_CS is locked.
+	void Trim(void);
+} ;
+
+
+
+
@@ -9,6 +9,8 @@
 #include "WorldStorage.h"
 #include "WSSCompact.h"
 #include "WSSAnvil.h"
+#include "WSSLog.h"
+#include "StorageBenchmark.h"
 #include "../World.h"
 #include "../Generating/ChunkGenerator.h"
 #include "../Entities/Entity.h"
@@ -30,7 +32,7 @@ class cWSSForgetful :
 	public cWSSchema
 {
 public:
-	cWSSForgetful(cWorld * a_World) : cWSSchema(a_World) {}
+	cWSSForgetful(cWorld * a_World) : cWSSchema(a_World, a_World->GetName()) {}
 	
 protected:
 	// cWSSchema overrides:
@@ -49,7 +51,10 @@ protected:
 cWorldStorage::cWorldStorage(void) :
 	super("cWorldStorage"),
 	m_World(NULL),
-	m_SaveSchema(NULL)
+	m_CSQueues("Storage queues"),
+	m_SaveSchema(NULL),
+	m_BenchmarkSize(0),
+	m_BenchmarkRepeats(0)
 {
 }
 
@@ -71,11 +76,11 @@ cWorldStorage::~cWorldStorage()
 
 
 
-bool cWorldStorage::Start(cWorld * a_World, const AString & a_StorageSchemaName)
+bool cWorldStorage::Start(cWorld * a_World, const AString & a_StorageSchemaName, cIniFile & a_IniFile)
 {
 	m_World = a_World;
 	m_StorageSchemaName = a_StorageSchemaName;
-	InitSchemas();
+	InitSchemas(a_IniFile);
 	
 	return super::Start();
 }
@@ -204,6 +209,20 @@ void cWorldStorage::QueueSavedMessage(void)
 
 
 
+void cWorldStorage::QueueBenchmark(int a_Size, int a_Repeats)
+{
+	{
+		cCSLock Lock(m_CSQueues);
+		m_BenchmarkSize = a_Size;
+		m_BenchmarkRepeats = a_Repeats;
+	}
+	m_Event.Set();
+}
+
+
+
+
+
 void cWorldStorage::UnqueueLoad(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
 	cCSLock Lock(m_CSQueues);
@@ -237,11 +256,13 @@ void cWorldStorage::UnqueueSave(const cChunkCoords & a_Chunk)
 
 
 
-void cWorldStorage::InitSchemas(void)
+void cWorldStorage::InitSchemas(cIniFile & a_IniFile)
 {
 	// The first schema added is considered the default
-	m_Schemas.push_back(new cWSSAnvil    (m_World));
-	m_Schemas.push_back(new cWSSCompact  (m_World));
+	const AString & Folder = m_World->GetName();
+	m_Schemas.push_back(new cWSSAnvil    (m_World, Folder, m_WarmCache));
+	m_Schemas.push_back(new cWSSCompact  (m_World, Folder));
+	m_Schemas.push_back(new cWSSLog      (m_World, Folder, m_WarmCache, a_IniFile));
 	m_Schemas.push_back(new cWSSForgetful(m_World));
 	// Add new schemas here
 	
@@ -294,6 +315,8 @@ void cWorldStorage::Execute(void)
 			HasMore = HasMore | SaveOneChunk();
 			m_evtRemoved.Set();
 		} while (HasMore);
+		
+		RunQueuedBenchmark();
 	}
 }
 
@@ -372,6 +395,28 @@ bool cWorldStorage::SaveOneChunk(void)
 
 
 
+void cWorldStorage::RunQueuedBenchmark(void)
+{
+	int Size, Repeats;
+	{
+		cCSLock Lock(m_CSQueues);
+		Size = m_BenchmarkSize;
+		Repeats = m_BenchmarkRepeats;
+		m_BenchmarkSize = 0;
+	}
+	if (Size <= 0)
+	{
+		return;
+	}
+	
+	cStorageBenchmark Benchmark(*m_World);
+	Benchmark.Run(Size, Repeats);
+}
+
+
+
+
+
 bool cWorldStorage::LoadChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
 	if (m_World->IsChunkValid(a_ChunkX, a_ChunkZ))
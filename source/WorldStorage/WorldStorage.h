@@ -16,6 +16,8 @@
 
 #include "../ChunkDef.h"
 #include "../OSSupport/IsThread.h"
+#include "../OSSupport/Timer.h"
+#include "WarmChunkCache.h"
 #include <json/json.h>
 
 
@@ -24,6 +26,60 @@
 
 // fwd:
 class cWorld;
+class cIniFile;
+
+
+
+
+
+/// Total time spent in the individual phases of loading and saving chunks, in microseconds
+struct sStoragePhaseTimes
+{
+	Int64 m_FileIO;       ///< Reading and writing the storage files, including the warm cache lookups
+	Int64 m_Compression;  ///< Compressing and decompressing the chunk data
+	Int64 m_Codec;        ///< Converting between the chunk arrays and the storage format (NBT, JSON)
+	Int64 m_World;        ///< Getting the chunk data from the world and setting it into the world
+	
+	sStoragePhaseTimes(void) { Reset(); }
+	
+	void Reset(void)
+	{
+		m_FileIO = 0;
+		m_Compression = 0;
+		m_Codec = 0;
+		m_World = 0;
+	}
+	
+	void Add(const sStoragePhaseTimes & a_Other)
+	{
+		m_FileIO      += a_Other.m_FileIO;
+		m_Compression += a_Other.m_Compression;
+		m_Codec       += a_Other.m_Codec;
+		m_World       += a_Other.m_World;
+	}
+} ;
+
+
+
+
+
+/// Adds the time elapsed since the previous Lap() call (or since the construction) to a phase counter
+class cStoragePhaseTimer
+{
+public:
+	cStoragePhaseTimer(void) : m_Last(m_Timer.GetNowTimeUSec()) {}
+	
+	void Lap(Int64 & a_PhaseTime)
+	{
+		Int64 Now = m_Timer.GetNowTimeUSec();
+		a_PhaseTime += Now - m_Last;
+		m_Last = Now;
+	}
+	
+protected:
+	cTimer m_Timer;
+	Int64  m_Last;
+} ;
 
 
 
@@ -33,16 +89,27 @@ class cWorld;
 class cWSSchema abstract
 {
 public:
-	cWSSchema(cWorld * a_World) : m_World(a_World) {}
+	cWSSchema(cWorld * a_World, const AString & a_StorageFolder) : m_World(a_World), m_StorageFolder(a_StorageFolder) {}
 	virtual ~cWSSchema() {}  // Force the descendants' destructors to be virtual
 	
 	virtual bool LoadChunk(const cChunkCoords & a_Chunk) = 0;
 	virtual bool SaveChunk(const cChunkCoords & a_Chunk) = 0;
 	virtual const AString GetName(void) const = 0;
 	
+	/// Returns the time spent in the phases of loading and saving since the last ResetPhaseTimes() call. Only to be called from the storage thread
+	const sStoragePhaseTimes & GetPhaseTimes(void) const { return m_PhaseTimes; }
+	
+	void ResetPhaseTimes(void) { m_PhaseTimes.Reset(); }
+	
 protected:
 
 	cWorld * m_World;
+	
+	/// The folder where the schema keeps its files; the world's folder, except for the schemas of cStorageBenchmark
+	AString m_StorageFolder;
+	
+	/// The schemas add the time spent in each phase of their LoadChunk() and SaveChunk() here
+	sStoragePhaseTimes m_PhaseTimes;
 } ;
 
 typedef std::list<cWSSchema *> cWSSchemaList;
@@ -68,13 +135,18 @@ public:
 	/// Signals that a message should be output to the console when all the chunks have been saved
 	void QueueSavedMessage(void);
 	
+	/** Queues a storage benchmark on a_Size x a_Size synthetic chunks, repeated a_Repeats times; see StorageBenchmark.h.
+	The benchmark runs in the storage thread after the queued chunks are processed, the results are logged.
+	*/
+	void QueueBenchmark(int a_Size, int a_Repeats);
+	
 	/// Loads the chunk specified; returns true on success, false on failure
 	bool LoadChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ);
 
 	void UnqueueLoad(int a_ChunkX, int a_ChunkY, int a_ChunkZ);
 	void UnqueueSave(const cChunkCoords & a_Chunk);
 	
-	bool Start(cWorld * a_World, const AString & a_StorageSchemaName);  // Hide the cIsThread's Start() method, we need to provide args
+	bool Start(cWorld * a_World, const AString & a_StorageSchemaName, cIniFile & a_IniFile);  // Hide the cIsThread's Start() method, we need to provide args
 	void Stop(void);  // Hide the cIsThread's Stop() method, we need to signal the event
 	void WaitForFinish(void);
 	void WaitForQueuesEmpty(void);
@@ -82,6 +154,9 @@ public:
 	int GetLoadQueueLength(void);
 	int GetSaveQueueLength(void);
 	
+	/// Returns the cache of recently used chunk data; the chunkmap touches chunks in it as they are unloaded
+	cWarmChunkCache & GetWarmCache(void) { return m_WarmCache; }
+	
 protected:
 
 	struct sChunkLoad
@@ -113,7 +188,14 @@ protected:
 	/// The one storage schema used for saving
 	cWSSchema *   m_SaveSchema;
 	
-	void InitSchemas(void);
+	/// Compressed data of recently used chunks, shared by the schemas that support it
+	cWarmChunkCache m_WarmCache;
+	
+	/// Parameters of the benchmark queued by QueueBenchmark(); m_BenchmarkSize is 0 if there's none. Protected by m_CSQueues
+	int m_BenchmarkSize;
+	int m_BenchmarkRepeats;
+	
+	void InitSchemas(cIniFile & a_IniFile);
 	
 	virtual void Execute(void) override;
 	
@@ -122,6 +204,9 @@ protected:
 	
 	/// Saves one chunk from the queue (if any queued); returns true if there are more chunks in the save queue
 	bool SaveOneChunk(void);
+	
+	/// Runs the benchmark queued by QueueBenchmark(), if any
+	void RunQueuedBenchmark(void);
 } ;
 
 